@@ -1,69 +1,135 @@
-/*! \project Vorpal Hexapod on TIVA 
-*
-* \brief
-*   The project is based on the project designed Vorpal Robotics, LLC.
-*   Control functionality was ported from the Arduino to TIVA, while new driver
-*   functions (I2C, Bluetooth, Servo Driving, UART) were written by the authors 
-*   stated below.
-*
-*  \original codebase:
-*   Copyright (C) 2017, 2018 Vorpal Robotics, LLC.
-*   https://github.com/vorpalrobotics/VorpalHexapod
-*
-*
-* \author Vlad Simontov
-*         Lauren Ivey
-*         Carlos Lopez
-* \info
-* All licesning agreements defined by Vorpal Robotics, LLC are in effect
-*
-*
-* For details on programming, refer to TM4C123G datasheet :
-* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
-*
-******************************************************************************/ 
-
-#include <stdint.h>
-#include <stdbool.h>
-#include <stdio.h>
-#include "tm4c123gh6pm.h"
-#include "src/I2C.h"
-#include "src/Timer.h"
-#include "src/PCA9685.h"
-#include "src/Gaits.h"
-#include "src/UART.h"
-#include "src/Bluetooth.h"
-
- // Other initializations
-
- //==============================================================================
-
-int main(void) {
-  
-  //Initialize Timer for millis() function
-  Timer_setUp();
-  
-  //Initialize I2C to 100kHz clock and Servo Driver to 60Hz PWM
-   I2C_InitPort1();
-   PCA9685_Init();
-   PCA9685_UpdatePWMFrequency(60u);
-   PCA9685_Restart();
-   
-   //Stand the Hexapod, run a demo
-   stand();
-   demo();
-   
-   //Initialize UART module 1, pin PC4 is Rx
-   BlueTooth_Init(); 
-   
-   //Confirm UART: stand up and get ready to move
-   gaitCommand_t lastCmd = BOT_STAND;
-  
-  //Main loop: polls for Bluetooth commands and sends them to a single high-level state machine
-   while(1){
-
-     checkBlueTooth(&lastCmd);
-     runGaitFSM(lastCmd);
-   }
- return 0;
+/*! \project Vorpal Hexapod on TIVA 
+*
+* \brief
+*   The project is based on the project designed Vorpal Robotics, LLC.
+*   Control functionality was ported from the Arduino to TIVA, while new driver
+*   functions (I2C, Bluetooth, Servo Driving, UART) were written by the authors 
+*   stated below.
+*
+*  \original codebase:
+*   Copyright (C) 2017, 2018 Vorpal Robotics, LLC.
+*   https://github.com/vorpalrobotics/VorpalHexapod
+*
+*
+* \author Vlad Simontov
+*         Lauren Ivey
+*         Carlos Lopez
+* \info
+* All licesning agreements defined by Vorpal Robotics, LLC are in effect
+*
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/ 
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "tm4c123gh6pm.h"
+#include "src/I2C.h"
+#include "src/Timer.h"
+#include "src/PCA9685.h"
+#include "src/Gaits.h"
+#include "src/UART.h"
+#include "src/Bluetooth.h"
+#include "src/CPG.h"
+#include "src/BodyPose.h"
+#include "src/Control.h"
+#include "src/ServoModel.h"
+#include "src/ADC.h"
+#include "src/Telemetry.h"
+#include "src/ServoStream.h"
+#include "src/Script.h"
+#include "src/Profile.h"
+#include "src/Recorder.h"
+#include "src/Config.h"
+#include "src/Battery.h"
+#include "src/Contact.h"
+
+ // Other initializations
+
+ //==============================================================================
+
+int main(void) {
+  
+  //Initialize Timer for millis() function
+  Timer_setUp();
+  
+#if RECORDER_ENABLE
+  //Keep the flight recorder log of the last run if this was a warm reset
+  Recorder_Init();
+#endif
+  
+  //Load calibration and tuning from the EEPROM (defaults if none stored)
+  Config_Init();
+  
+  //Initialize I2C to 100kHz clock and Servo Driver to the configured PWM rate (60Hz)
+   I2C_InitPort1();
+   PCA9685_Init();
+   PCA9685_UpdatePWMFrequency(Config_Get()->pwmHz);
+   PCA9685_Restart();
+   Config_Apply();
+   
+   //Servo positions are unknown until the first command
+   ServoModel_Init();
+   
+#if POSITION_FEEDBACK_ENABLED
+   //Start sampling the servo feedback pots
+   ADC_Init();
+#endif
+   
+#if PROFILE_ENABLE
+   //Start the DWT cycle counter for the hot path statistics
+   Profile_Init();
+#endif
+   
+   //Load the default (tripod) oscillator parameters for the CPG gait engine
+   CPG_Init();
+   
+   //Build the pose lookup tables, the bot starts in the neutral pose
+   BodyPose_Init();
+   
+   //No joint stream until a host sends one
+   ServoStream_Init();
+   
+   //Index the motion scripts stored in flash, slot 0 replaces the demo
+   Script_Init();
+   
+   //Stand the Hexapod from the sit pose within the servo inrush budget, run a demo
+   softStart();
+   demo();
+   
+   //Initialize UART module 1, pin PC4 is Rx
+   BlueTooth_Init(); 
+   
+   //Confirm UART: stand up and get ready to move
+   gaitCommand_t lastCmd = BOT_STAND;
+   
+   //Start the fixed-rate control tick, one servo frame per PWM period
+   Control_Init();
+   
+   //Sample the pack voltage on every control tick, derate or sit when it sags
+   Battery_Init();
+   
+#if FOOT_CONTACT_ENABLED
+   //Sample the knee currents on every control tick to see the feet land
+   Contact_Init();
+#endif
+  
+  //Main loop: the gait state machine runs once per control tick, Bluetooth
+  //commands are polled and telemetry is queued in the time left over
+   while(1){
+
+     PROFILE_BEGIN(PROF_LOOP);
+     Battery_Service();
+#if FOOT_CONTACT_ENABLED
+     Contact_Service(Timer_millis());
+#endif
+     Control_Service(Battery_LimitCommand(lastCmd));
+     checkBlueTooth(&lastCmd);
+     Telemetry_Service(Timer_millis(), lastCmd);
+     PROFILE_END(PROF_LOOP);
+   }
+ return 0;
  }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#if !defined(SIM_H)
+#define SIM_H
+
+#include <stdint.h>
+#include "SimRegs.h"
+
+#define SIM_SYSCLK_HZ      (16000000u)   /*same clock as the firmware, no PLL*/
+#define SIM_CYCLES_PER_US  (SIM_SYSCLK_HZ / 1000000u)
+#define SIM_ACCESS_CYCLES  (4u)          /*cycles charged per register access*/
+#define SIM_IDLE_CYCLES    (16u)         /*smallest step of SimReg_Idle*/
+#define SIM_WRITE_MARK     (0x80000000u) /*set in presented values of registers with write side effects*/
+#define SIM_MAX_IRQ_BURST  (64u)         /*ISRs run back to back before the caller gets the CPU again*/
+
+#define SIM_FLASH_SIZE     (0x40000u)
+
+ // NVIC lines of the modelled peripherals
+#define SIM_IRQ_UART0      (5)
+#define SIM_IRQ_UART1      (6)
+#define SIM_IRQ_TIMER0A    (19)
+#define SIM_IRQ_TIMER1A    (21)
+
+ // One peripheral model. Offsets are relative to base; unit tells instances
+ // of the same model apart. nextEvent returns the cycle of the next internal
+ // state change after the current time, 0 if there is none. fullWidth is set
+ // by models whose data registers use bit 31, which then never carries
+ // SIM_WRITE_MARK.
+typedef struct simModel
+{
+  uint32_t base;
+  uint32_t size;
+  uint8_t  unit;
+  void     (*reset)( uint8_t unit );
+  uint32_t (*read)( uint8_t unit, uint32_t offset );
+  void     (*write)( uint8_t unit, uint32_t offset, uint32_t value );
+  void     (*readDone)( uint8_t unit, uint32_t offset );
+  void     (*update)( uint8_t unit, uint64_t now );
+  uint64_t (*nextEvent)( uint8_t unit );
+  uint32_t (*irqLines)( uint8_t unit );
+  uint8_t  fullWidth;
+} simModel_t;
+
+typedef struct simCoreStats
+{
+  uint64_t accesses;     //!<Register accesses made by the firmware
+  uint64_t writes;       //!<... of which were writes
+  uint64_t irqs;         //!<ISRs dispatched
+  uint64_t idleCycles;   //!<Cycles skipped in SimReg_Idle
+} simCoreStats_t;
+
+typedef struct simUartStats
+{
+  uint32_t rxBytes;      //!<Bytes that reached the RX FIFO
+  uint32_t rxDropped;    //!<Bytes lost on a full RX FIFO
+  uint32_t rxDisabled;   //!<Bytes that arrived while the port was disabled
+  uint32_t txBytes;      //!<Bytes shifted out
+} simUartStats_t;
+
+typedef struct simI2cStats
+{
+  uint32_t transactions; //!<START conditions
+  uint32_t bytes;        //!<Address and data bytes on the bus
+  uint32_t nacks;        //!<Address or data bytes nobody acknowledged
+  uint32_t frames;       //!<Transactions that changed at least one PCA9685 output
+  uint32_t channelWrites;//!<PCA9685 outputs changed
+  uint64_t busyCycles;   //!<Time SCL was running
+} simI2cStats_t;
+
+ // Called once per PCA9685 output that changed, at the STOP that latched it
+typedef void (*simServoHook_t)( uint64_t cycle, uint8_t channel, uint16_t onCount, uint16_t offCount );
+typedef void (*simTxSink_t)( uint8_t port, uint8_t data );
+
+ //core
+void Sim_Reset( void );
+uint64_t Sim_Now( void );
+uint32_t Sim_Micros( void );
+void Sim_Advance( uint32_t cycles );
+void Sim_RunUntil( uint64_t cycle );
+void Sim_SetAccessCycles( uint32_t cycles );
+void Sim_GetStats( simCoreStats_t * stats );
+
+ //peripheral models
+extern const simModel_t simTimerModel[2];
+extern const simModel_t simUartModel[2];
+extern const simModel_t simI2cModel;
+extern const simModel_t simFlashModel;
+extern const simModel_t simEepromModel;
+extern const simModel_t simAdcModel;
+
+void SimUART_Inject( uint8_t port, const uint8_t * data, uint32_t length );
+uint32_t SimUART_Pending( uint8_t port );
+void SimUART_SetTxSink( simTxSink_t sink );
+void SimUART_GetStats( uint8_t port, simUartStats_t * stats );
+
+void SimI2C_SetServoHook( simServoHook_t hook );
+void SimI2C_GetStats( simI2cStats_t * stats );
+uint8_t SimI2C_PcaReg( uint8_t reg );
+
+uint8_t * SimFlash_Mem( void );
+
+void SimADC_TimerTrigger( uint64_t cycle );
+void SimADC_SetInput( uint8_t ain, uint16_t mv );
+
+#endif
@@ -0,0 +1,197 @@
+/*! \file  SimADC.c
+*
+* \brief
+* ADC1 sample sequencer model for the host simulator
+*
+* \details
+*  What Battery.c and Contact.c use: sequencers 1 to 3 with the timer
+*  trigger (a GPTM time-out with TnOTE set, see SimTimer.c), hardware
+*  averaging, the step mux and END/IE bits, the FIFOs and the raw status
+*  bits. A sequence takes one microsecond per averaged sample per step and
+*  reads the millivolts last set for each input with SimADC_SetInput; a full
+*  FIFO drops the new results. Inputs keep their values over resets, like
+*  the voltages on the pins. Sequencer 0 and ADC0 are not modelled.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stddef.h>
+#include "Sim.h"
+
+#define ADC_ACTSS    0x000
+#define ADC_RIS      0x004
+#define ADC_IM       0x008
+#define ADC_ISC      0x00C
+#define ADC_EMUX     0x014
+#define ADC_SAC      0x030
+#define ADC_SS_FIRST 0x060    //sequencer 1, 0x20 per sequencer
+#define ADC_SS_LAST  0x0BF
+#define SS_MUX       0x00
+#define SS_CTL       0x04
+#define SS_FIFO      0x08
+#define SS_FSTAT     0x0C
+
+#define EM_TIMER     0x05
+#define SSCTL_END    0x02
+#define SSCTL_IE     0x04
+#define FSTAT_EMPTY  (0x01 << 8)
+#define FSTAT_FULL   (0x01 << 12)
+#define ADC_INPUTS   12
+#define REF_MV       3300u
+#define FULL_SCALE   4095u
+
+typedef struct simSequencer
+{
+  uint32_t mux;
+  uint32_t ctl;
+  uint16_t fifo[4];
+  uint8_t  depth;      //4 for sequencers 1 and 2, 1 for sequencer 3
+  uint8_t  count;
+  uint8_t  head;
+  uint64_t doneAt;     //cycle the sequence under way finishes, 0 if none
+} simSequencer_t;
+
+static uint32_t actss, ris, im, emux, sac;
+static simSequencer_t ss[4];
+static uint16_t inputMv[ADC_INPUTS];
+
+static void adcReset( uint8_t unit )
+{
+  (void)unit;
+  actss = ris = im = emux = sac = 0;
+  for (uint8_t n = 1; n < 4; n++) {
+    ss[n].mux = ss[n].ctl = 0;
+    ss[n].count = ss[n].head = 0;
+    ss[n].depth = (n == 3) ? 1 : 4;
+    ss[n].doneAt = 0;
+  }
+}
+
+static uint8_t steps( const simSequencer_t * s )
+{
+  for (uint8_t step = 0; step < s->depth; step++) {
+    if ((s->ctl >> (4 * step)) & SSCTL_END) return step + 1;
+  }
+  return s->depth;
+}
+
+static uint32_t adcRead( uint8_t unit, uint32_t reg )
+{
+  (void)unit;
+  if ((reg >= ADC_SS_FIRST) && (reg <= ADC_SS_LAST)) {
+    simSequencer_t * s = &ss[1 + ((reg - ADC_SS_FIRST) >> 5)];
+    switch (reg & 0x1F) {
+      case SS_MUX:   return s->mux;
+      case SS_CTL:   return s->ctl;
+      case SS_FIFO:  return s->count ? s->fifo[s->head] : 0;
+      case SS_FSTAT: return (s->count ? 0 : FSTAT_EMPTY) | ((s->count == s->depth) ? FSTAT_FULL : 0) |
+                            s->head | (((s->head + s->count) % s->depth) << 4);
+      default:       return 0;
+    }
+  }
+  switch (reg) {
+    case ADC_ACTSS: return actss;
+    case ADC_RIS:   return ris;
+    case ADC_IM:    return im;
+    case ADC_EMUX:  return emux;
+    case ADC_SAC:   return sac;
+    default:        return 0;   //ISC reads back the masked status, never used
+  }
+}
+
+static void adcWrite( uint8_t unit, uint32_t reg, uint32_t value )
+{
+  (void)unit;
+  if ((reg >= ADC_SS_FIRST) && (reg <= ADC_SS_LAST)) {
+    simSequencer_t * s = &ss[1 + ((reg - ADC_SS_FIRST) >> 5)];
+    switch (reg & 0x1F) {
+      case SS_MUX: s->mux = value; break;
+      case SS_CTL: s->ctl = value; break;
+      default:     break;
+    }
+    return;
+  }
+  switch (reg) {
+    case ADC_ACTSS: actss = value & 0x0F; break;
+    case ADC_IM:    im = value; break;
+    case ADC_ISC:   ris &= ~value; break;
+    case ADC_EMUX:  emux = value; break;
+    case ADC_SAC:   sac = value & 0x07; break;
+    default:        break;
+  }
+}
+
+static void adcReadDone( uint8_t unit, uint32_t reg )
+{
+  (void)unit;
+  if ((reg >= ADC_SS_FIRST) && (reg <= ADC_SS_LAST) && ((reg & 0x1F) == SS_FIFO)) {
+    simSequencer_t * s = &ss[1 + ((reg - ADC_SS_FIRST) >> 5)];
+    if (s->count) {
+      s->head = (s->head + 1) % s->depth;
+      s->count--;
+    }
+  }
+}
+
+static void adcUpdate( uint8_t unit, uint64_t now )
+{
+  (void)unit;
+  for (uint8_t n = 1; n < 4; n++) {
+    simSequencer_t * s = &ss[n];
+    uint8_t last = steps(s);
+
+    if (!s->doneAt || (s->doneAt > now)) continue;
+    s->doneAt = 0;
+    for (uint8_t step = 0; step < last; step++) {
+      uint8_t ain = (s->mux >> (4 * step)) & 0x0F;
+      uint32_t mv = (ain < ADC_INPUTS) ? inputMv[ain] : 0;
+
+      if (mv > REF_MV) mv = REF_MV;
+      if (s->count < s->depth) {
+        s->fifo[(s->head + s->count) % s->depth] = (uint16_t)((mv * FULL_SCALE + (REF_MV / 2)) / REF_MV);
+        s->count++;
+      }
+      if ((s->ctl >> (4 * step)) & SSCTL_IE) ris |= (0x01u << n);
+    }
+  }
+}
+
+static uint64_t adcNextEvent( uint8_t unit )
+{
+  uint64_t next = 0;
+
+  (void)unit;
+  for (uint8_t n = 1; n < 4; n++) {
+    if (ss[n].doneAt && (!next || (ss[n].doneAt < next))) next = ss[n].doneAt;
+  }
+  return next;
+}
+
+void SimADC_TimerTrigger( uint64_t cycle )
+/*!\brief   A timer with TnOTE set timed out
+\param cycle[in]: when it did
+\return none
+*/
+{
+  for (uint8_t n = 1; n < 4; n++) {
+    simSequencer_t * s = &ss[n];
+
+    if (!(actss & (0x01u << n)) || (((emux >> (4 * n)) & 0x0F) != EM_TIMER) || s->doneAt) continue;
+    s->doneAt = cycle + ((uint64_t)steps(s) * (0x01u << sac) * SIM_CYCLES_PER_US);
+  }
+}
+
+void SimADC_SetInput( uint8_t ain, uint16_t mv )
+/*!\brief   Voltage on an analog input pin
+\param ain[in]: AIN number
+       mv[in]: millivolts, clipped to the 3.3V reference when converted
+\return none
+*/
+{
+  if (ain < ADC_INPUTS) inputMv[ain] = mv;
+}
+
+const simModel_t simAdcModel = {
+  0x40039000u, 0x1000u, 1, adcReset, adcRead, adcWrite, adcReadDone, adcUpdate, adcNextEvent, NULL
+};
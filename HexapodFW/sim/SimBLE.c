@@ -0,0 +1,234 @@
+/*! \file  SimBLE.c
+*
+* \brief
+* Scripted HM-10 / CC-41-A Bluetooth module for BLE_Configure, host simulator
+*
+* \details
+*  A bleTransport_t in front of a fake module that keeps its baud rate like
+*  the real ones do: bytes sent at any other rate are lost, and so are its
+*  replies if the host has moved on to another rate by the time they come.
+*  The two dialects are modelled as BLEModule.c describes them:
+*    HM-10   a command ends when the line has been idle SIM_HM10_IDLE_MS,
+*            replies "OK", "OK+Set:n", "OK+RESET", unknown commands get none
+*    CC-41   commands end with CR LF, replies "OK", "+BAUD=n" then "OK",
+*            "ERROR" for anything else
+*  A new AT+BAUD rate only takes over after AT+RESET, once the module has
+*  rebooted (SIM_BLE_BOOT_MS, deaf meanwhile). A script can leave the
+*  module silent from then on, as one that failed to come back up.
+*
+*  Time is a virtual millisecond counter moved on by every millis() call,
+*  so a whole negotiation runs in no time and always the same way. With a
+*  log every command and reply is printed with its time and baud rate.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <string.h>
+#include "SimBLE.h"
+
+#define SIM_HM10_IDLE_MS   100u   //HM-10 takes the line as a command after this much idle
+#define SIM_CC41_REPLY_MS  10u
+#define SIM_BLE_BOOT_MS    500u
+#define SIM_BLE_LINE       32u
+
+typedef struct simBleBaud
+{
+  char     digit;
+  uint32_t baud;
+} simBleBaud_t;
+
+// AT+BAUD digits as the module datasheets list them, kept apart from the
+// table in BLEModule.c on purpose
+static const simBleBaud_t hm10Bauds[] = {
+  {'0', 9600}, {'1', 19200}, {'2', 38400}, {'3', 57600}, {'4', 115200},
+  {'5', 4800}, {'6', 2400}, {'7', 1200}, {'8', 230400}, {0, 0}
+};
+static const simBleBaud_t cc41Bauds[] = {
+  {'1', 1200}, {'2', 2400}, {'3', 4800}, {'4', 9600}, {'5', 19200},
+  {'6', 38400}, {'7', 57600}, {'8', 115200}, {0, 0}
+};
+
+static simBleScript_t script;
+static FILE * logOut;
+static uint32_t nowMs;
+static uint32_t hostBaud, moduleBaud, pendingBaud;
+static uint8_t  silent;
+static uint32_t bootAt;          //reboot finishes, 0 while running
+static char     line[SIM_BLE_LINE];
+static uint8_t  lineLength;
+static uint32_t lineIdleAt;      //HM-10: command complete at this time
+static char     reply[SIM_BLE_LINE];
+static uint8_t  replyLength, replyPos;
+static uint32_t replyAt, replyBaud;
+
+static uint32_t baudFor( char digit )
+{
+  const simBleBaud_t * table = (script.type == BLE_MODULE_HM10) ? hm10Bauds : cc41Bauds;
+
+  for (; table->digit; table++) {
+    if (table->digit == digit) return table->baud;
+  }
+  return 0;
+}
+
+static void answer( const char * text, uint32_t delayMs )
+{
+  strncpy(reply, text, sizeof(reply) - 1);
+  reply[sizeof(reply) - 1] = '\0';
+  replyLength = (uint8_t)strlen(reply);
+  replyPos = 0;
+  replyAt = nowMs + delayMs;
+  replyBaud = moduleBaud;
+  if (logOut) fprintf(logOut, "%6u ms %6u baud  < %.*s\n", (unsigned)replyAt, (unsigned)moduleBaud,
+                      (int)strcspn(reply, "\r\n"), reply);
+}
+
+static void execute( void )
+{
+  uint8_t hm10 = (script.type == BLE_MODULE_HM10);
+  uint32_t delayMs = hm10 ? 0 : SIM_CC41_REPLY_MS;
+  char text[SIM_BLE_LINE];
+
+  line[lineLength] = '\0';
+  lineLength = 0;
+  if (logOut) fprintf(logOut, "%6u ms %6u baud  > %s\n", (unsigned)nowMs, (unsigned)moduleBaud, line);
+
+  if (!strcmp(line, "AT")) {
+    answer(hm10 ? "OK" : "OK\r\n", delayMs);
+  }
+  else if (!strcmp(line, "AT+RESET")) {
+    answer(hm10 ? "OK+RESET" : "OK\r\n", delayMs);
+    bootAt = nowMs + delayMs + SIM_BLE_BOOT_MS;
+  }
+  else if (!strncmp(line, "AT+BAUD", 7) && (strlen(line) == 8) && baudFor(line[7])) {
+    pendingBaud = baudFor(line[7]);
+    strcpy(text, hm10 ? "OK+Set:0" : "+BAUD=0\r\nOK\r\n");
+    text[hm10 ? 7 : 6] = line[7];
+    answer(text, delayMs);
+  }
+  else if (hm10 && (strlen(line) == 8) && (!strncmp(line, "AT+COMI", 7) || !strncmp(line, "AT+COMA", 7) ||
+                                           !strncmp(line, "AT+COUP", 7))) {
+    strcpy(text, "OK+Set:0");
+    text[7] = line[7];
+    answer(text, 0);
+  }
+  else if (!hm10) {
+    answer("ERROR\r\n", delayMs);
+  }
+}
+
+static void service( void )
+{
+  if (bootAt && ((int32_t)(nowMs - bootAt) >= 0)) {
+    bootAt = 0;
+    moduleBaud = pendingBaud;
+    silent = script.silentAfterReset;
+    lineLength = 0;
+    if (logOut) fprintf(logOut, "%6u ms %6u baud  rebooted%s\n", (unsigned)nowMs, (unsigned)moduleBaud,
+                        silent ? ", silent" : "");
+  }
+  if ((script.type == BLE_MODULE_HM10) && lineLength && ((int32_t)(nowMs - lineIdleAt) >= 0)) {
+    execute();
+  }
+}
+
+static void simSetBaud( uint32_t baud )
+{
+  hostBaud = baud;
+}
+
+static void simWrite( const uint8_t * data, uint16_t length )
+{
+  service();
+  if ((script.type == BLE_MODULE_NONE) || silent || bootAt) return;
+  if (hostBaud != moduleBaud) {
+    lineLength = 0;     //framing errors, whatever was building up is lost
+    return;
+  }
+  for (uint16_t i = 0; i < length; i++) {
+    if (script.type == BLE_MODULE_CC41) {
+      if ((data[i] == '\n') && lineLength && (line[lineLength - 1] == '\r')) {
+        lineLength--;
+        execute();
+        continue;
+      }
+    }
+    if (lineLength < (SIM_BLE_LINE - 1)) line[lineLength++] = (char)data[i];
+  }
+  lineIdleAt = nowMs + SIM_HM10_IDLE_MS;
+}
+
+static uint8_t simRead( uint8_t * data )
+{
+  service();
+  if ((replyPos >= replyLength) || ((int32_t)(nowMs - replyAt) < 0)) return 0;
+  if (replyBaud != hostBaud) {
+    replyPos = replyLength;   //garbled at the wrong rate, the parser never sees it
+    return 0;
+  }
+  *data = (uint8_t)reply[replyPos++];
+  return 1;
+}
+
+static void simFlush( void )
+{
+  service();
+  if ((int32_t)(nowMs - replyAt) >= 0) replyPos = replyLength;
+}
+
+static uint32_t simMillis( void )
+{
+  service();
+  return nowMs++;
+}
+
+const bleTransport_t SimBLE_Transport = {
+  simSetBaud,
+  simWrite,
+  simRead,
+  simFlush,
+  simMillis
+};
+
+void SimBLE_Load( const simBleScript_t * s, FILE * log )
+/*!\brief   Power the fake module up from a script
+\param s[in]: module type, starting baud rate and failure
+       log[in]: where to print the conversation, NULL for none
+\return none
+*/
+{
+  script = *s;
+  logOut = log;
+  nowMs = 0;
+  hostBaud = 0;
+  moduleBaud = pendingBaud = s->baud;
+  silent = 0;
+  bootAt = 0;
+  lineLength = 0;
+  replyLength = replyPos = 0;
+}
+
+uint32_t SimBLE_ModuleBaud( void )
+/*!\brief   Rate the module is on now
+\return baud, 0 without a module
+*/
+{
+  return (script.type == BLE_MODULE_NONE) ? 0 : moduleBaud;
+}
+
+uint32_t SimBLE_HostBaud( void )
+/*!\brief   Rate the host side was last set to
+\return baud
+*/
+{
+  return hostBaud;
+}
+
+uint32_t SimBLE_Millis( void )
+/*!\brief   Virtual time spent so far
+\return milliseconds since SimBLE_Load
+*/
+{
+  return nowMs;
+}
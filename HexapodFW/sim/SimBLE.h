@@ -0,0 +1,24 @@
+#if !defined(SIMBLE_H)
+#define SIMBLE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "BLEModule.h"
+
+ // Scripted HM-10 / CC-41-A module behind a bleTransport_t, for BLE_Configure
+ // on the host. Time is virtual: every millis() call moves it on 1ms.
+typedef struct simBleScript
+{
+  bleModuleType_t type;      //!<Dialect, BLE_MODULE_NONE for nothing on the line
+  uint32_t baud;             //!<Rate kept in the module's flash at power up
+  uint8_t  silentAfterReset; //!<Never answers again once AT+RESET went through
+} simBleScript_t;
+
+extern const bleTransport_t SimBLE_Transport;
+
+void SimBLE_Load( const simBleScript_t * script, FILE * log );
+uint32_t SimBLE_ModuleBaud( void );
+uint32_t SimBLE_HostBaud( void );
+uint32_t SimBLE_Millis( void );
+
+#endif
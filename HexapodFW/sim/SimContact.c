@@ -0,0 +1,144 @@
+/*! \file  SimContact.c
+*
+* \brief
+* Knee servo current waveforms for the foot contact sensing, host simulator
+*
+* \details
+*  Each knee servo follows its PCA9685 output at a fixed speed and draws a
+*  current that depends on what it is doing:
+*    - holding in the air                    SIM_IDLE_MA
+*    - swinging                              SIM_MOVE_MA
+*    - the first SIM_START_MS of a large move SIM_START_MA
+*    - foot on the ground, pushing            SIM_LOAD_MA
+*  A knee cannot go below the ground angle of its leg (SimContact_SetGround,
+*  lower knee angles are further down): the foot lands there and the servo
+*  carries the body's share from then on. Each tripod's three knees are
+*  summed into the shunt amplifier voltage on its analog input (Contact.h).
+*
+*  Pulse widths are turned into angles with the default pulse range
+*  (1000-2000us for 0-180 degrees), trims are ignored.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <math.h>
+#include "Sim.h"
+#include "SimContact.h"
+#include "Gaits.h"
+#include "Contact.h"
+
+#define PCA_LED0       0x06
+#define PCA_PRESCALE   0xFE
+#define PCA_FULL_OFF   0x10    //OFF_H bit 4, output disabled
+#define PCA_OSC_MHZ    25.0
+
+#define SIM_KNEE_DPS   400.0   //same speed the firmware's servo model assumes
+#define SIM_START_DEG  30.0
+#define SIM_START_MS   20u
+#define SIM_IDLE_MA    20
+#define SIM_MOVE_MA    200
+#define SIM_START_MA   700
+#define SIM_LOAD_MA    600
+
+typedef struct simKnee
+{
+  double   pos;
+  double   target;
+  uint8_t  known;        //a pulse has been seen since the reset
+  uint64_t moveStart;    //cycle the last large move was commanded
+} simKnee_t;
+
+static simKnee_t knee[NUM_LEGS];
+static double ground[NUM_LEGS];
+static uint64_t lastUpdate;
+static uint16_t groupMa[CONTACT_GROUPS];
+
+void SimContact_Reset( void )
+/*!\brief   Knee positions unknown, flat ground at SIM_GROUND_DEG
+\return none
+*/
+{
+  for (uint8_t leg = 0; leg < NUM_LEGS; leg++) {
+    knee[leg].known = 0;
+    ground[leg] = SIM_GROUND_DEG;
+  }
+  groupMa[0] = groupMa[1] = 0;
+  lastUpdate = Sim_Now();
+}
+
+void SimContact_SetGround( uint8_t leg, uint8_t kneeDeg )
+/*!\brief   Knee angle at which a leg's foot meets the ground
+\param leg[in]: 0-5
+       kneeDeg[in]: higher is higher ground, the foot lands earlier
+\return none
+*/
+{
+  if (leg < NUM_LEGS) ground[leg] = kneeDeg;
+}
+
+static uint16_t kneeCurrent( simKnee_t * k, double floorDeg, uint64_t now, double step )
+{
+  uint16_t ma = SIM_IDLE_MA;
+
+  if (k->pos < k->target) {
+    k->pos = fmin(k->pos + step, k->target);
+    ma = SIM_MOVE_MA;
+  }
+  else if (k->pos > k->target) {
+    k->pos = fmax(k->pos - step, fmax(k->target, floorDeg));
+    ma = SIM_MOVE_MA;
+  }
+  if (k->pos < floorDeg) k->pos = floorDeg;   //the ground was raised under it
+
+  if ((k->target < floorDeg) && (k->pos <= floorDeg)) {
+    ma = SIM_LOAD_MA;
+  }
+  if ((ma == SIM_MOVE_MA) && (now < k->moveStart + ((uint64_t)SIM_START_MS * (SIM_SYSCLK_HZ / 1000u)))) {
+    ma = SIM_START_MA;
+  }
+  return ma;
+}
+
+void SimContact_Update( uint64_t now )
+/*!\brief   Move the knees on to now and set the shunt amplifier outputs
+\details Call at least once per control tick.
+\return none
+*/
+{
+  double step = SIM_KNEE_DPS * (double)(now - lastUpdate) / SIM_SYSCLK_HZ;
+  double usPerCount = (SimI2C_PcaReg(PCA_PRESCALE) + 1) / PCA_OSC_MHZ;
+
+  lastUpdate = now;
+  groupMa[0] = groupMa[1] = 0;
+  for (uint8_t leg = 0; leg < NUM_LEGS; leg++) {
+    uint8_t reg = PCA_LED0 + (4 * (KNEE_OFFSET + leg));
+    uint16_t on = SimI2C_PcaReg(reg) | ((SimI2C_PcaReg(reg + 1) & 0x0F) << 8);
+    uint16_t off = SimI2C_PcaReg(reg + 2) | ((SimI2C_PcaReg(reg + 3) & 0x0F) << 8);
+    simKnee_t * k = &knee[leg];
+
+    if (SimI2C_PcaReg(reg + 3) & PCA_FULL_OFF) continue;   //unpowered, limp
+
+    double deg = ((((off - on - 1) & 0xFFF) * usPerCount) - 1000.0) * 0.18;
+    if (!k->known) {
+      k->pos = fmax(deg, ground[leg]);
+      k->target = deg;
+      k->known = 1;
+    }
+    if (fabs(deg - k->target) >= SIM_START_DEG) k->moveStart = now;
+    k->target = deg;
+
+    groupMa[((0x01 << leg) & TRIPOD1_LEGS) ? 0 : 1] += kneeCurrent(k, ground[leg], now, step);
+  }
+  SimADC_SetInput(CONTACT_AIN_TRIPOD1, (uint16_t)((groupMa[0] * CONTACT_MV_PER_A) / 1000));
+  SimADC_SetInput(CONTACT_AIN_TRIPOD2, (uint16_t)((groupMa[1] * CONTACT_MV_PER_A) / 1000));
+}
+
+uint16_t SimContact_GroupMa( uint8_t group )
+/*!\brief   Current last synthesized for a tripod's knees
+\param group[in]: 0 TRIPOD1, 1 TRIPOD2
+\return mA
+*/
+{
+  return (group < CONTACT_GROUPS) ? groupMa[group] : 0;
+}
@@ -0,0 +1,14 @@
+#if !defined(SIMCONTACT_H)
+#define SIMCONTACT_H
+
+#include <stdint.h>
+
+ // Knee current synthesized from the PCA9685 outputs for Contact.c
+#define SIM_GROUND_DEG  (35)   // flat ground: the feet land just before KNEE_DOWN
+
+void SimContact_Reset( void );
+void SimContact_SetGround( uint8_t leg, uint8_t kneeDeg );
+void SimContact_Update( uint64_t now );
+uint16_t SimContact_GroupMa( uint8_t group );
+
+#endif
@@ -0,0 +1,102 @@
+/*! \file  SimEEPROM.c
+*
+* \brief
+* EEPROM module model for the host simulator
+*
+* \details
+*  512 words starting erased (0xFFFFFFFF) on the first reset of the process
+*  and kept over later resets, like the real array. EEBLOCK/EEOFFSET select
+*  a word, EERDWR reads or writes it and EERDWRINC does the same and steps
+*  the offset (wrapping inside the block). A write keeps EEDONE.WORKING set
+*  for the typical write time. Writing the value a word already holds looks
+*  like a read to the register map, which steps the offset all the same.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <string.h>
+#include "Sim.h"
+
+#define EE_EESIZE      0x000
+#define EE_EEBLOCK     0x004
+#define EE_EEOFFSET    0x008
+#define EE_EERDWR      0x010
+#define EE_EERDWRINC   0x014
+#define EE_EEDONE      0x018
+#define EE_EESUPP      0x01C
+
+#define WORDS_PER_BLOCK 16u
+#define BLOCKS          32u
+#define EEDONE_WORKING  0x01
+#define WRITE_CYCLES    (110u * SIM_CYCLES_PER_US)
+
+static uint32_t words[WORDS_PER_BLOCK * BLOCKS];
+static uint8_t  formatted = 0;
+static uint32_t block, offset;
+static uint64_t busyUntil;
+
+static uint32_t * current( void )
+{
+  return &words[((block % BLOCKS) * WORDS_PER_BLOCK) + (offset % WORDS_PER_BLOCK)];
+}
+
+static void eepromReset( uint8_t unit )
+{
+  (void)unit;
+  if (!formatted) {
+    memset(words, 0xFF, sizeof(words));
+    formatted = 1;
+  }
+  block = 0;
+  offset = 0;
+  busyUntil = 0;
+}
+
+static uint32_t eepromRead( uint8_t unit, uint32_t reg )
+{
+  (void)unit;
+  switch (reg) {
+    case EE_EESIZE:    return (BLOCKS << 16) | (WORDS_PER_BLOCK * BLOCKS);
+    case EE_EEBLOCK:   return block;
+    case EE_EEOFFSET:  return offset;
+    case EE_EERDWR:
+    case EE_EERDWRINC: return *current();
+    case EE_EEDONE:    return (Sim_Now() < busyUntil) ? EEDONE_WORKING : 0;
+    default:           return 0;   //EESUPP, no failed recovery
+  }
+}
+
+static void eepromWrite( uint8_t unit, uint32_t reg, uint32_t value )
+{
+  (void)unit;
+  switch (reg) {
+    case EE_EEBLOCK:  block = value & 0xFFFF; offset = 0; break;
+    case EE_EEOFFSET: offset = value & 0x0F; break;
+    case EE_EERDWR:
+    case EE_EERDWRINC:
+      if (Sim_Now() < busyUntil) break;   //WRBUSY, the write is lost
+      *current() = value;
+      busyUntil = Sim_Now() + WRITE_CYCLES;
+      if (reg == EE_EERDWRINC) offset = (offset + 1) % WORDS_PER_BLOCK;
+      break;
+    default:
+      break;
+  }
+}
+
+static void eepromReadDone( uint8_t unit, uint32_t reg )
+{
+  (void)unit;
+  if (reg == EE_EERDWRINC) offset = (offset + 1) % WORDS_PER_BLOCK;
+}
+
+static uint64_t eepromNextEvent( uint8_t unit )
+{
+  (void)unit;
+  return (busyUntil > Sim_Now()) ? busyUntil : 0;
+}
+
+const simModel_t simEepromModel = {
+  0x400AF000u, 0x100u, 0, eepromReset, eepromRead, eepromWrite, eepromReadDone, NULL, eepromNextEvent, NULL, 1
+};
@@ -0,0 +1,155 @@
+/*! \file  SimFeedback.c
+*
+* \brief
+* Servo feedback pot waveforms for the position feedback, host simulator
+*
+* \details
+*  ADC0, its sequencer 0 and the uDMA ring of ADC.c are not modelled. Instead
+*  every SIM_FB_BLOCK_US a block of FB_FRAMES_PER_HALF frames is built and
+*  handed to Feedback_ProcessBlock, as the sequencer ISR does when a ring
+*  half fills. Each servo follows its PCA9685 output at the speed given to
+*  SimFeedback_Start; its pot reads the default calibration (FB_RAW_AT_0 to
+*  FB_RAW_AT_180) plus a few counts of noise. The wiring is the one
+*  Feedback_Init sets up: knees on steps 0-5, the front hips on 6 and 7.
+*
+*  A blocked servo sits at a fixed angle whatever it is told, for a joint
+*  held by an obstacle or a dead servo. Pick one away from the stand and
+*  walk angles so it never comes within FB_DEFAULT_TOLERANCE_DEG of its
+*  target; SIM_FB_STUCK_DEG, the horn centre at assembly, is for knees
+*  and for hips while walking.
+*
+*  Nothing is fed until SimFeedback_Start, so by default the firmware sees
+*  a bot without pots and falls back to the servo model.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <math.h>
+#include "Sim.h"
+#include "SimFeedback.h"
+#include "ServoModel.h"
+#include "Timer.h"
+
+#define PCA_LED0       0x06
+#define PCA_PRESCALE   0xFE
+#define PCA_FULL_OFF   0x10    //OFF_H bit 4, output disabled
+#define PCA_OSC_MHZ    25.0
+#define SIM_POT_NOISE  6       //counts either way
+
+typedef struct simPot
+{
+  double  pos;
+  uint8_t known;       //a pulse has been seen since the pots started
+} simPot_t;
+
+// servo channel on each sequencer step, as Feedback_Init maps them
+static const uint8_t stepChannel[FB_NUM_STEPS] = { 6, 7, 8, 9, 10, 11, 0, 5 };
+
+static simPot_t pot[SERVO_COUNT];
+static double speedDps;
+static uint8_t blocked;
+static double blockedDeg;
+static uint8_t running;
+static uint64_t lastUpdate, nextBlock;
+static uint32_t blocks;
+static uint32_t noise;
+
+void SimFeedback_Reset( void )
+/*!\brief   Pots off, servo positions unknown
+\return none
+*/
+{
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) pot[ch].known = 0;
+  running = 0;
+  blocks = 0;
+  noise = 1;
+}
+
+void SimFeedback_Start( uint16_t dps, uint8_t blockedChannel, uint8_t stuckDeg )
+/*!\brief   Start feeding pot blocks to the firmware
+\param dps[in]: speed the servos really move at, the model assumes SERVO_DEFAULT_SPEED_DPS
+       blockedChannel[in]: servo that cannot move, SIM_FB_NONE for none
+       stuckDeg[in]: where the blocked servo sits
+\return none
+*/
+{
+  speedDps = dps;
+  blocked = blockedChannel;
+  blockedDeg = stuckDeg;
+  running = 1;
+  lastUpdate = Sim_Now();
+  nextBlock = lastUpdate + ((uint64_t)SIM_FB_BLOCK_US * SIM_CYCLES_PER_US);
+}
+
+static uint16_t potSample( double deg )
+{
+  noise = (noise * 1103515245u) + 12345u;
+  double raw = FB_RAW_AT_0 + ((deg * (FB_RAW_AT_180 - FB_RAW_AT_0)) / 180.0) +
+               (double)((int32_t)((noise >> 16) % (2 * SIM_POT_NOISE + 1)) - SIM_POT_NOISE);
+  return (uint16_t)fmin(fmax(raw, 0.0), 4095.0);
+}
+
+void SimFeedback_Update( uint64_t now )
+/*!\brief   Move the servos on to now and deliver the blocks that are due
+\details Call at least once per control tick. Blocks missed by a slow loop
+         are not made up, the next one carries the current positions.
+\return none
+*/
+{
+  if (!running) return;
+
+  double step = speedDps * (double)(now - lastUpdate) / SIM_SYSCLK_HZ;
+  double usPerCount = (SimI2C_PcaReg(PCA_PRESCALE) + 1) / PCA_OSC_MHZ;
+
+  lastUpdate = now;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+    uint8_t reg = PCA_LED0 + (4 * ch);
+    uint16_t on = SimI2C_PcaReg(reg) | ((SimI2C_PcaReg(reg + 1) & 0x0F) << 8);
+    uint16_t off = SimI2C_PcaReg(reg + 2) | ((SimI2C_PcaReg(reg + 3) & 0x0F) << 8);
+    simPot_t * p = &pot[ch];
+
+    if (SimI2C_PcaReg(reg + 3) & PCA_FULL_OFF) continue;   //unpowered, stays put
+
+    double deg = ((((off - on - 1) & 0xFFF) * usPerCount) - 1000.0) * 0.18;
+    if (!p->known) {
+      p->pos = deg;
+      p->known = 1;
+    }
+    if (ch == blocked) {
+      p->pos = blockedDeg;
+      continue;
+    }
+    if (p->pos < deg) p->pos = fmin(p->pos + step, deg);
+    else p->pos = fmax(p->pos - step, deg);
+  }
+
+  if (now < nextBlock) return;
+  while (nextBlock <= now) nextBlock += (uint64_t)SIM_FB_BLOCK_US * SIM_CYCLES_PER_US;
+
+  uint16_t samples[FB_FRAMES_PER_HALF * FB_NUM_STEPS];
+  for (uint8_t f = 0; f < FB_FRAMES_PER_HALF; f++) {
+    for (uint8_t s = 0; s < FB_NUM_STEPS; s++) {
+      samples[(f * FB_NUM_STEPS) + s] = potSample(pot[stepChannel[s]].pos);
+    }
+  }
+  Feedback_ProcessBlock(samples, FB_FRAMES_PER_HALF, Timer_millis());
+  blocks++;
+}
+
+uint32_t SimFeedback_Blocks( void )
+/*!\brief   Blocks delivered since the pots started
+\return count
+*/
+{
+  return blocks;
+}
+
+int16_t SimFeedback_Angle( uint8_t channel )
+/*!\brief   Where a servo really is
+\param channel[in]: servo channel 0-11
+\return degrees
+*/
+{
+  return (channel < SERVO_COUNT) ? (int16_t)lround(pot[channel].pos) : 0;
+}
@@ -0,0 +1,19 @@
+#if !defined(SIMFEEDBACK_H)
+#define SIMFEEDBACK_H
+
+#include <stdint.h>
+#include "ADC.h"
+
+ // Servo feedback pot waveforms synthesized from the PCA9685 outputs, handed
+ // to Feedback_ProcessBlock the way the ADC0 sequencer 0 ISR does on the bot
+#define SIM_FB_BLOCK_US  (FB_FRAMES_PER_HALF * FB_NUM_STEPS * 64u)   // 64x averaged, 1us per sample
+#define SIM_FB_NONE      (0xFF)
+#define SIM_FB_STUCK_DEG (90u)   // where a blocked servo sits unless told otherwise
+
+void SimFeedback_Reset( void );
+void SimFeedback_Start( uint16_t speedDps, uint8_t blockedChannel, uint8_t stuckDeg );
+void SimFeedback_Update( uint64_t now );
+uint32_t SimFeedback_Blocks( void );
+int16_t SimFeedback_Angle( uint8_t channel );
+
+#endif
@@ -0,0 +1,117 @@
+/*! \file  SimFlash.c
+*
+* \brief
+* Flash memory and flash controller model for the host simulator
+*
+* \details
+*  256KB of flash starting erased (0xFF). FMA/FMD/FMC program one word or
+*  erase one 1KB block when written with the default key; FMC keeps the
+*  operation bit set for the typical program/erase time so Flash.c polls as
+*  it does on the chip. Programming a 0 bit back to 1 is refused with
+*  INVDRIS in FCRIS, the word keeps the AND of old and new like the array.
+*
+*  HWMEM reads (Script.c slot headers) come straight from the array through
+*  SimMem_Ptr.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <string.h>
+#include "Sim.h"
+
+#define FLASH_FMA      0x000
+#define FLASH_FMD      0x004
+#define FLASH_FMC      0x008
+#define FLASH_FCRIS    0x00C
+#define FLASH_FCMISC   0x014
+
+#define FMC_WRITE      0x01
+#define FMC_ERASE      0x02
+#define FMC_KEY        0xA4420000u   //BOOTCFG reads with the KEY bit set
+#define FCRIS_INVDRIS  (0x01 << 10)
+#define BLOCK_SIZE     1024u
+#define WRITE_CYCLES   (50u * SIM_CYCLES_PER_US)
+#define ERASE_CYCLES   (10000u * SIM_CYCLES_PER_US)
+
+static uint8_t mem[SIM_FLASH_SIZE];
+static uint32_t fma, fmd, fcris;
+static uint32_t busyBit;
+static uint64_t busyUntil;
+
+static void flashReset( uint8_t unit )
+{
+  (void)unit;
+  memset(mem, 0xFF, sizeof(mem));
+  fma = 0;
+  fmd = 0;
+  fcris = 0;
+  busyBit = 0;
+  busyUntil = 0;
+}
+
+static uint32_t flashRead( uint8_t unit, uint32_t offset )
+{
+  (void)unit;
+  switch (offset) {
+    case FLASH_FMA:   return fma;
+    case FLASH_FMD:   return fmd;
+    case FLASH_FMC:   return (Sim_Now() < busyUntil) ? busyBit : 0;
+    case FLASH_FCRIS: return fcris;
+    default:          return 0;   //FCMISC is write to clear
+  }
+}
+
+static void flashProgram( void )
+{
+  uint32_t addr = fma & (SIM_FLASH_SIZE - 4u);
+  uint32_t old;
+
+  memcpy(&old, &mem[addr], sizeof(old));
+  if ((old & fmd) != fmd) fcris |= FCRIS_INVDRIS;
+  old &= fmd;
+  memcpy(&mem[addr], &old, sizeof(old));
+}
+
+static void flashWrite( uint8_t unit, uint32_t offset, uint32_t value )
+{
+  (void)unit;
+  switch (offset) {
+    case FLASH_FMA:    fma = value; break;
+    case FLASH_FMD:    fmd = value; break;
+    case FLASH_FCMISC: fcris &= ~value; break;
+    case FLASH_FMC:
+      if ((value & 0xFFFF0000u) != FMC_KEY) break;
+      if (Sim_Now() < busyUntil) break;
+      if (value & FMC_WRITE) {
+        flashProgram();
+        busyBit = FMC_WRITE;
+        busyUntil = Sim_Now() + WRITE_CYCLES;
+      } else if (value & FMC_ERASE) {
+        memset(&mem[fma & (SIM_FLASH_SIZE - BLOCK_SIZE)], 0xFF, BLOCK_SIZE);
+        busyBit = FMC_ERASE;
+        busyUntil = Sim_Now() + ERASE_CYCLES;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static uint64_t flashNextEvent( uint8_t unit )
+{
+  (void)unit;
+  return (busyUntil > Sim_Now()) ? busyUntil : 0;
+}
+
+const simModel_t simFlashModel = {
+  0x400FD000u, 0x1000u, 0, flashReset, flashRead, flashWrite, NULL, NULL, flashNextEvent, NULL
+};
+
+uint8_t * SimFlash_Mem( void )
+/*!\brief   The simulated flash array
+\return pointer to SIM_FLASH_SIZE bytes
+*/
+{
+  return mem;
+}
@@ -0,0 +1,73 @@
+/*! \file  SimGoBLE.c
+*
+* \brief
+* Builds GoBLE controller packets for the host simulator
+*
+* \details
+*  Same layout the phone app sends and Bluetooth.c parses:
+*    0x55 0xAA 0x11 count flag button[count] joyX joyY tag_l tag_h checksum
+*  with the checksum the byte sum of everything before it. The two spare
+*  analog bytes are 0 from the phone; the firmware ignores them, so the load
+*  generator numbers its frames there.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "SimGoBLE.h"
+
+#define GOBLE_ADDRESS  (0x11)
+
+uint8_t SimGoBLE_Build( uint8_t * frame, uint8_t buttonMask, uint8_t joyX, uint8_t joyY )
+/*!\brief   Encode one controller state, as the phone sends it
+\param frame[out]: at least GOBLE_MAX_FRAME bytes
+       buttonMask[in]: bit b set for every pressed button 1-6
+       joyX, joyY[in]: joystick, GOBLE_JOY_CENTRE when released
+\return frame length in bytes
+*/
+{
+  return SimGoBLE_BuildTagged(frame, buttonMask, joyX, joyY, 0);
+}
+
+uint8_t SimGoBLE_BuildTagged( uint8_t * frame, uint8_t buttonMask, uint8_t joyX, uint8_t joyY, uint16_t tag )
+/*!\brief   Encode one controller state with a tag in the spare analog bytes
+\param tag[in]: read back from packetData with SimGoBLE_Tag
+\return frame length in bytes, see SimGoBLE_Build
+*/
+{
+  uint8_t n = 0;
+  uint8_t count = 0;
+  uint8_t sum = 0;
+
+  frame[n++] = 0x55;
+  frame[n++] = 0xAA;
+  frame[n++] = GOBLE_ADDRESS;
+  frame[n++] = 0;   //button count, filled in below
+  frame[n++] = ((joyX != GOBLE_JOY_CENTRE) || (joyY != GOBLE_JOY_CENTRE)) ? 1 : 0;
+  for (uint8_t b = 1; b <= 6; b++) {
+    if (buttonMask & (0x01 << b)) {
+      frame[n++] = b;
+      count++;
+    }
+  }
+  frame[3] = count;
+  frame[n++] = joyX;
+  frame[n++] = joyY;
+  frame[n++] = (uint8_t)(tag & 0xFF);
+  frame[n++] = (uint8_t)(tag >> 8);
+
+  for (uint8_t i = 0; i < n; i++) sum += frame[i];
+  frame[n++] = sum;
+  return n;
+}
+
+uint16_t SimGoBLE_Tag( const uint8_t * data )
+/*!\brief   Tag of a frame the parser accepted
+\param data[in]: the frame from the count byte on (packetData in Bluetooth.c)
+\return tag given to SimGoBLE_BuildTagged
+*/
+{
+  uint8_t tagAt = 2 + data[0] + 2;   //count, flag, buttons, joyX, joyY
+
+  return (uint16_t)(data[tagAt] | (data[tagAt + 1] << 8));
+}
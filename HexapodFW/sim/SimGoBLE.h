@@ -0,0 +1,13 @@
+#if !defined(SIMGOBLE_H)
+#define SIMGOBLE_H
+
+#include <stdint.h>
+
+#define GOBLE_MAX_FRAME   (16)   /*header, address, length, flag, 6 buttons, 4 analog, checksum*/
+#define GOBLE_JOY_CENTRE  (128)
+
+uint8_t SimGoBLE_Build( uint8_t * frame, uint8_t buttonMask, uint8_t joyX, uint8_t joyY );
+uint8_t SimGoBLE_BuildTagged( uint8_t * frame, uint8_t buttonMask, uint8_t joyX, uint8_t joyY, uint16_t tag );
+uint16_t SimGoBLE_Tag( const uint8_t * data );
+
+#endif
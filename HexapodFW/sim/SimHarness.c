@@ -0,0 +1,196 @@
+/*! \file  SimHarness.c
+*
+* \brief
+* Boot sequence and main loop of the firmware for the host tools
+*
+* \details
+*  SimHarness_Boot follows main.c, SimHarness_Step is one pass of its main
+*  loop with SimReg_Idle standing in for the spare CPU time. While a command
+*  is set, GoBLE packets for it are put on the wire at the requested rate.
+*
+*  Every PCA9685 output change goes to the trace recorder and is used to
+*  measure command latency: first byte of the first packet on the wire to
+*  the first output change after it. The knee currents the foot contact
+*  sensing reads are synthesized from the outputs (SimContact.c), so are the
+*  servo feedback pots once hexsim starts them (SimFeedback.c).
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Sim.h"
+#include "SimGoBLE.h"
+#include "SimTrace.h"
+#include "SimContact.h"
+#include "SimFeedback.h"
+#include "SimHarness.h"
+#include "I2C.h"
+#include "Timer.h"
+#include "PCA9685.h"
+#include "Gaits.h"
+#include "UART.h"
+#include "Bluetooth.h"
+#include "CPG.h"
+#include "BodyPose.h"
+#include "Control.h"
+#include "ServoModel.h"
+#include "Feedback.h"
+#include "Telemetry.h"
+#include "ServoStream.h"
+#include "Script.h"
+#include "Profile.h"
+#include "Recorder.h"
+#include "Config.h"
+#include "Battery.h"
+#include "Contact.h"
+
+#define SIM_PACK_MV (7800u)   //charged 2S pack, nothing derated
+
+static gaitCommand_t lastCmd = BOT_STAND;
+static phase_t lastPhase = FROZEN;
+static uint32_t gaitCycles = 0;
+
+static uint8_t  packet[GOBLE_MAX_FRAME];
+static uint8_t  packetLength = 0;    //0 = no command being sent
+static uint8_t  packetPort = 0;
+static uint64_t packetPeriod = 0;
+static uint64_t nextPacket = 0;
+static uint32_t packetsSent = 0;
+
+static uint64_t commandStart = 0;    //cycle the first packet went on the wire
+static uint64_t firstResponse = 0;   //first servo output change after that
+
+static void servoWritten( uint64_t cycle, uint8_t channel, uint16_t onCount, uint16_t offCount )
+{
+  SimTrace_Servo(cycle, channel, onCount, offCount);
+  if (commandStart && !firstResponse && (cycle > commandStart)) firstResponse = cycle;
+}
+
+void SimHarness_Boot( uint8_t runDemo )
+/*!\brief   Reset the simulator and bring the firmware up as main.c does
+\param runDemo[in]: 1 to run the demo after standing up
+\return none
+*/
+{
+  Sim_Reset();
+  SimI2C_SetServoHook(servoWritten);
+  SimADC_SetInput(BATTERY_AIN, SIM_PACK_MV / BATTERY_DIVIDER);
+  SimContact_Reset();
+  SimFeedback_Reset();
+  lastCmd = BOT_STAND;
+  gaitCycles = 0;
+  packetLength = 0;
+  packetsSent = 0;
+  commandStart = 0;
+  firstResponse = 0;
+
+  Timer_setUp();
+#if RECORDER_ENABLE
+  Recorder_Init();
+#endif
+  Config_Init();
+  I2C_InitPort1();
+  PCA9685_Init();
+  PCA9685_UpdatePWMFrequency(Config_Get()->pwmHz);
+  PCA9685_Restart();
+  Config_Apply();
+  ServoModel_Init();
+  Feedback_Init();   //what ADC_Init does besides starting ADC0, see SimFeedback.c
+#if PROFILE_ENABLE
+  Profile_Init();
+#endif
+  CPG_Init();
+  BodyPose_Init();
+  ServoStream_Init();
+  Script_Init();
+  softStart();
+  if (runDemo) demo();
+  BlueTooth_Init();
+  Control_Init();
+  Battery_Init();
+#if FOOT_CONTACT_ENABLED
+  Contact_Init();
+#endif
+  lastPhase = getGaitPhase();
+}
+
+void SimHarness_Command( uint8_t port, uint8_t buttons, uint8_t joyX, uint8_t joyY, uint32_t rate )
+/*!\brief   Start sending a controller state, first packet right away
+\details Latency is measured from the first command set after boot only.
+\param port[in]: UART_PORT_BT or UART_PORT_WIRED
+       buttons, joyX, joyY[in]: see SimGoBLE_Build
+       rate[in]: packets per second, 0 stops sending (the link goes quiet)
+\return none
+*/
+{
+  if (rate == 0) {
+    packetLength = 0;
+    return;
+  }
+  packetLength = SimGoBLE_Build(packet, buttons, joyX, joyY);
+  packetPort = port;
+  packetPeriod = SIM_SYSCLK_HZ / rate;
+  nextPacket = Sim_Now();
+}
+
+uint8_t SimHarness_Step( void )
+/*!\brief   One pass of the main loop
+\return 1 if a gait cycle started (TRIPOD1_LIFT entered), 0 otherwise
+*/
+{
+  uint8_t cycleStarted = 0;
+
+  if (packetLength && (Sim_Now() >= nextPacket)) {
+    if (commandStart == 0) commandStart = Sim_Now();
+    SimUART_Inject(packetPort, packet, packetLength);
+    packetsSent++;
+    nextPacket += packetPeriod;
+  }
+
+  SimContact_Update(Sim_Now());
+  SimFeedback_Update(Sim_Now());
+
+  PROFILE_BEGIN(PROF_LOOP);
+  Battery_Service();
+#if FOOT_CONTACT_ENABLED
+  Contact_Service(Timer_millis());
+#endif
+  Control_Service(Battery_LimitCommand(lastCmd));
+  checkBlueTooth(&lastCmd);
+  Telemetry_Service(Timer_millis(), lastCmd);
+  PROFILE_END(PROF_LOOP);
+
+  phase_t phase = getGaitPhase();
+  if ((phase == TRIPOD1_LIFT) && (lastPhase != TRIPOD1_LIFT)) {
+    gaitCycles++;
+    cycleStarted = 1;
+  }
+  lastPhase = phase;
+
+  SimReg_Idle();
+  return cycleStarted;
+}
+
+uint64_t SimHarness_Latency( void )
+/*!\brief   Command latency in cycles
+\return first packet on the wire to first output change, 0 if none yet
+*/
+{
+  return firstResponse ? (firstResponse - commandStart) : 0;
+}
+
+uint32_t SimHarness_GaitCycles( void )
+/*!\brief   Gait cycles started since boot
+\return count
+*/
+{
+  return gaitCycles;
+}
+
+uint32_t SimHarness_PacketsSent( void )
+/*!\brief   Packets put on the wire since boot
+\return count
+*/
+{
+  return packetsSent;
+}
@@ -0,0 +1,14 @@
+#if !defined(SIMHARNESS_H)
+#define SIMHARNESS_H
+
+#include <stdint.h>
+
+ // Main loop of main.c on the virtual register map, shared by hexsim and hexbench
+void SimHarness_Boot( uint8_t runDemo );
+void SimHarness_Command( uint8_t port, uint8_t buttons, uint8_t joyX, uint8_t joyY, uint32_t rate );
+uint8_t SimHarness_Step( void );
+uint64_t SimHarness_Latency( void );
+uint32_t SimHarness_GaitCycles( void );
+uint32_t SimHarness_PacketsSent( void );
+
+#endif
@@ -0,0 +1,307 @@
+/*! \file  SimI2C.c
+*
+* \brief
+* I2C1 master model with a PCA9685 on the bus, for the host simulator
+*
+* \details
+*  Bus timing follows the TM4C master: one SCL period is 20 * (MTPR + 1)
+*  system clocks (100 kHz at MTPR 7), START and STOP cost one bit, every
+*  address or data byte nine. MCS shows BUSY until the bits are out and
+*  BUSBSY from START to STOP.
+*
+*  The only client is the PCA9685 at 0x40 (and its all-call address 0x70).
+*  It keeps a full register file, honours MODE1.AI for bursts, ignores
+*  PRESCALE writes unless SLEEP is set and raises MODE1.RESTART when put to
+*  sleep with outputs running. Outputs change on STOP (MODE2.OCH = 0); every
+*  channel that changed is reported to the servo hook with the cycle the
+*  STOP completed.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <string.h>
+#include "Sim.h"
+
+#define I2C_MSA      0x000
+#define I2C_MCS      0x004
+#define I2C_MDR      0x008
+#define I2C_MTPR     0x00C
+#define I2C_MCR      0x020
+
+ // MCS as a status register
+#define MCS_BUSY     0x01
+#define MCS_ERROR    0x02
+#define MCS_ADRACK   0x04
+#define MCS_DATACK   0x08
+#define MCS_IDLE     0x20
+#define MCS_BUSBSY   0x40
+ // MCS as a control register
+#define MCS_RUN      0x01
+#define MCS_START    0x02
+#define MCS_STOP     0x04
+
+#define BYTE_BITS    9
+
+#define PCA_ADDR     0x40
+#define PCA_ALLCALL  0x70
+#define PCA_MODE1    0x00
+#define PCA_MODE2    0x01
+#define PCA_LED0     0x06
+#define PCA_LED_LAST 0x45
+#define PCA_ALL_LED  0xFA
+#define PCA_PRESCALE 0xFE
+#define PCA_CHANNELS 16
+#define MODE1_RESTART 0x80
+#define MODE1_AI     0x20
+#define MODE1_SLEEP  0x10
+
+typedef struct simI2c
+{
+  uint32_t msa, mdr, mtpr, mcr;
+  uint32_t status;        //ERROR/ADRACK/DATACK of the last operation
+  uint64_t busyUntil;
+  uint8_t  busBusy;
+  uint8_t  selected;      //PCA9685 acknowledged its address in this transaction
+  uint8_t  reading;
+} simI2c_t;
+
+typedef struct simPca
+{
+  uint8_t  regs[256];
+  uint8_t  ptr;
+  uint8_t  havePtr;       //first byte of a write transaction is the register pointer
+  uint16_t changed;       //channels written since the last STOP
+  uint16_t on[PCA_CHANNELS];
+  uint16_t off[PCA_CHANNELS];
+} simPca_t;
+
+static simI2c_t i2c;
+static simPca_t pca;
+static simI2cStats_t i2cStats;
+static simServoHook_t servoHook = NULL;
+
+static void pcaReset( void )
+{
+  memset(&pca, 0, sizeof(pca));
+  pca.regs[PCA_MODE1] = MODE1_SLEEP | 0x01;
+  pca.regs[PCA_MODE2] = 0x04;
+  pca.regs[PCA_PRESCALE] = 0x1E;
+  for (uint8_t ch = 0; ch < PCA_CHANNELS; ch++) {
+    pca.regs[PCA_LED0 + (ch * 4) + 3] = 0x10;   //full off
+    pca.off[ch] = 0x1000;
+  }
+}
+
+static void pcaStore( uint8_t reg, uint8_t value )
+{
+  if (reg == PCA_MODE1) {
+    uint8_t old = pca.regs[PCA_MODE1];
+    uint8_t restart = old & MODE1_RESTART;
+
+    if ((value & MODE1_SLEEP) && !(old & MODE1_SLEEP)) restart = MODE1_RESTART;
+    if ((value & MODE1_RESTART) && !(value & MODE1_SLEEP)) restart = 0;   //writing 1 restarts
+    pca.regs[PCA_MODE1] = (value & ~MODE1_RESTART) | restart;
+    return;
+  }
+  if (reg == PCA_PRESCALE) {
+    if (pca.regs[PCA_MODE1] & MODE1_SLEEP) pca.regs[PCA_PRESCALE] = value;
+    return;
+  }
+  if ((reg >= PCA_ALL_LED) && (reg < (PCA_ALL_LED + 4))) {
+    for (uint8_t ch = 0; ch < PCA_CHANNELS; ch++) {
+      pca.regs[PCA_LED0 + (ch * 4) + (reg - PCA_ALL_LED)] = value;
+    }
+    pca.changed = 0xFFFF;
+    return;
+  }
+  pca.regs[reg] = value;
+  if ((reg >= PCA_LED0) && (reg <= PCA_LED_LAST)) pca.changed |= (0x01u << ((reg - PCA_LED0) / 4));
+}
+
+static void pcaWrite( uint8_t value )
+{
+  if (!pca.havePtr) {
+    pca.ptr = value;
+    pca.havePtr = 1;
+    return;
+  }
+  pcaStore(pca.ptr, value);
+  if (pca.regs[PCA_MODE1] & MODE1_AI) {
+    pca.ptr = (pca.ptr == PCA_LED_LAST) ? 0 : (uint8_t)(pca.ptr + 1);
+  }
+}
+
+static uint8_t pcaRead( void )
+{
+  uint8_t value = ((pca.ptr >= PCA_ALL_LED) && (pca.ptr < PCA_PRESCALE)) ? 0 : pca.regs[pca.ptr];
+
+  if (pca.regs[PCA_MODE1] & MODE1_AI) {
+    pca.ptr = (pca.ptr == PCA_LED_LAST) ? 0 : (uint8_t)(pca.ptr + 1);
+  }
+  return value;
+}
+
+static void pcaStop( uint64_t at )
+{
+  uint16_t changed = pca.changed;
+
+  pca.changed = 0;
+  pca.havePtr = 0;
+  if (changed == 0) return;
+
+  i2cStats.frames++;
+  for (uint8_t ch = 0; ch < PCA_CHANNELS; ch++) {
+    const uint8_t * r = &pca.regs[PCA_LED0 + (ch * 4)];
+    uint16_t on = (uint16_t)(r[0] | ((r[1] & 0x1F) << 8));
+    uint16_t off = (uint16_t)(r[2] | ((r[3] & 0x1F) << 8));
+
+    if (!((changed >> ch) & 0x01)) continue;
+    if ((on == pca.on[ch]) && (off == pca.off[ch])) continue;
+    pca.on[ch] = on;
+    pca.off[ch] = off;
+    i2cStats.channelWrites++;
+    if (servoHook) servoHook(at, ch, on, off);
+  }
+}
+
+static uint64_t bitCycles( void )
+{
+  return 20u * ((uint64_t)(i2c.mtpr & 0x7F) + 1u);
+}
+
+static void i2cReset( uint8_t unit )
+{
+  (void)unit;
+  memset(&i2c, 0, sizeof(i2c));
+  memset(&i2cStats, 0, sizeof(i2cStats));
+  i2c.mtpr = 0x01;
+  pcaReset();
+}
+
+static void i2cControl( uint32_t value )
+{
+  uint64_t now = Sim_Now();
+  uint32_t bits = 0;
+
+  if (now < i2c.busyUntil) return;   //the master ignores commands while busy
+  if (!(i2c.mcr & 0x10)) return;     //master function disabled
+  i2c.status = 0;
+
+  if ((value & MCS_START) && (value & MCS_RUN)) {
+    uint8_t addr = (uint8_t)((i2c.msa >> 1) & 0x7F);
+
+    if (i2c.busBusy) pcaStop(now);   //repeated START ends the previous write
+    bits += 1 + BYTE_BITS;
+    i2cStats.transactions++;
+    i2cStats.bytes++;
+    i2c.busBusy = 1;
+    i2c.reading = (uint8_t)(i2c.msa & 0x01);
+    i2c.selected = ((addr == PCA_ADDR) || (addr == PCA_ALLCALL));
+    pca.havePtr = 0;
+
+    if (!i2c.selected) {
+      i2c.status = MCS_ERROR | MCS_ADRACK;
+      i2cStats.nacks++;
+    } else {
+      bits += BYTE_BITS;
+      i2cStats.bytes++;
+      if (i2c.reading) i2c.mdr = pcaRead();
+      else pcaWrite((uint8_t)i2c.mdr);
+    }
+  } else if ((value & MCS_RUN) && i2c.busBusy) {
+    bits += BYTE_BITS;
+    i2cStats.bytes++;
+    if (!i2c.selected) {
+      i2c.status = MCS_ERROR | MCS_DATACK;
+      i2cStats.nacks++;
+    } else if (i2c.reading) {
+      i2c.mdr = pcaRead();
+    } else {
+      pcaWrite((uint8_t)i2c.mdr);
+    }
+  }
+
+  if ((value & MCS_STOP) && i2c.busBusy) bits += 1;
+
+  i2c.busyUntil = now + (bits * bitCycles());
+  i2cStats.busyCycles += bits * bitCycles();
+
+  if ((value & MCS_STOP) && i2c.busBusy) {
+    if (i2c.selected && !i2c.reading) pcaStop(i2c.busyUntil);
+    i2c.busBusy = 0;
+    i2c.selected = 0;
+  }
+}
+
+static uint32_t i2cRead( uint8_t unit, uint32_t offset )
+{
+  uint32_t mcs;
+
+  (void)unit;
+  switch (offset) {
+    case I2C_MSA:  return i2c.msa;
+    case I2C_MDR:  return i2c.mdr;
+    case I2C_MTPR: return i2c.mtpr;
+    case I2C_MCR:  return i2c.mcr;
+    case I2C_MCS:
+      if (Sim_Now() < i2c.busyUntil) {
+        mcs = MCS_BUSY;
+      } else {
+        mcs = i2c.status;
+        if (!i2c.busBusy) mcs |= MCS_IDLE;
+      }
+      if (i2c.busBusy) mcs |= MCS_BUSBSY;
+      return mcs | SIM_WRITE_MARK;
+    default:
+      return 0;
+  }
+}
+
+static void i2cWrite( uint8_t unit, uint32_t offset, uint32_t value )
+{
+  (void)unit;
+  switch (offset) {
+    case I2C_MSA:  i2c.msa = value & 0xFF;  break;
+    case I2C_MDR:  i2c.mdr = value & 0xFF;  break;
+    case I2C_MTPR: i2c.mtpr = value & 0xFF; break;
+    case I2C_MCR:  i2c.mcr = value;         break;
+    case I2C_MCS:  i2cControl(value);       break;
+    default:       break;
+  }
+}
+
+static uint64_t i2cNextEvent( uint8_t unit )
+{
+  (void)unit;
+  return (i2c.busyUntil > Sim_Now()) ? i2c.busyUntil : 0;
+}
+
+const simModel_t simI2cModel = {
+  0x40021000u, 0x1000u, 0, i2cReset, i2cRead, i2cWrite, NULL, NULL, i2cNextEvent, NULL
+};
+
+void SimI2C_SetServoHook( simServoHook_t hook )
+/*!\brief   Get called for every PCA9685 output change
+\param hook[in]: callback, NULL to remove
+\return none
+*/
+{
+  servoHook = hook;
+}
+
+void SimI2C_GetStats( simI2cStats_t * stats )
+/*!\brief   Copy out the bus counters
+\return none
+*/
+{
+  *stats = i2cStats;
+}
+
+uint8_t SimI2C_PcaReg( uint8_t reg )
+/*!\brief   Read a PCA9685 register without touching the bus
+\return register value
+*/
+{
+  return pca.regs[reg];
+}
@@ -0,0 +1,350 @@
+/*! \file  SimRegs.c
+*
+* \brief
+* Virtual TM4C123 register map for the host build of the firmware
+*
+* \details
+*  With HOST_SIM defined every HWREG(addr) in the drivers becomes
+*  *SimReg_Access(addr). The access returns a single slot that holds the
+*  current value of the register; whatever the firmware does with it is
+*  resolved on the next access (or in SimReg_Idle):
+*    - slot unchanged: it was a read, models with read side effects (UART DR
+*      pops the FIFO) get readDone
+*    - slot changed: it was a write (read-modify-write looks the same), the
+*      model gets the new value
+*  Registers where writing the value just read must still do something (DR,
+*  MCS, NVIC EN0) are presented with SIM_WRITE_MARK set, write only registers
+*  (ICR, FMC) are presented as 0. Models flagged fullWidth (EEPROM data)
+*  never use the mark, a written bit 31 is kept as it is.
+*
+*  Time only moves in register accesses (SIM_ACCESS_CYCLES each) and in
+*  SimReg_Idle, which jumps to the next peripheral event. Code that runs
+*  between accesses is free, so measured loop times are the peripheral and
+*  bus waiting part of the real figure, not the arithmetic.
+*
+*  Interrupts are level sensitive: after every clock step the models report
+*  their asserted lines, enabled ones run the firmware ISR directly. ISRs do
+*  not nest, same as the firmware's single priority level.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+
+#define PLAIN_SLOTS      1024u          //registers without a model, power of two
+#define SYSCTL_PR_FIRST  0x400FEA00u    //peripheral ready registers, always ready
+#define SYSCTL_PR_LAST   0x400FEA9Cu
+#define SYSCTL_BOOTCFG   0x400FE1D0u
+#define NVIC_EN0         0xE000E100u
+#define NVIC_DIS0        0xE000E180u
+#define DWT_CYCCNT       0xE0001004u    //free running, counts simulated cycles
+
+void TimerA_Handler( void );
+void Timer1A_Handler( void );
+void UART0_Handler( void );
+void UART1_Handler( void );
+
+typedef void (*simIsr_t)( void );
+
+typedef struct plainReg
+{
+  uint32_t addr;
+  uint32_t value;
+  uint8_t  used;
+} plainReg_t;
+
+typedef struct pendingAccess
+{
+  const simModel_t * model;   //NULL for registers handled here
+  uint32_t addr;
+  uint32_t presented;
+  uint8_t  valid;
+} pendingAccess_t;
+
+static const simModel_t * const models[] = {
+  &simTimerModel[0], &simTimerModel[1],
+  &simUartModel[0], &simUartModel[1],
+  &simI2cModel, &simFlashModel, &simEepromModel, &simAdcModel
+};
+#define NUM_MODELS (sizeof(models) / sizeof(models[0]))
+
+static volatile uint32_t slot;
+static pendingAccess_t pending;
+static plainReg_t plain[PLAIN_SLOTS];
+static uint64_t now = 0;
+static uint32_t accessCycles = SIM_ACCESS_CYCLES;
+static uint32_t nvicEnabled = 0;
+static uint64_t cyccntBase = 0;
+static uint8_t inIsr = 0;
+static simCoreStats_t coreStats;
+
+static simIsr_t isrFor( uint8_t irq )
+{
+  switch (irq) {
+    case SIM_IRQ_UART0:   return UART0_Handler;
+    case SIM_IRQ_UART1:   return UART1_Handler;
+    case SIM_IRQ_TIMER0A: return TimerA_Handler;
+    case SIM_IRQ_TIMER1A: return Timer1A_Handler;
+    default:              return NULL;
+  }
+}
+
+static plainReg_t * plainFind( uint32_t addr )
+{
+  uint32_t i = ((addr >> 2) * 2654435761u) & (PLAIN_SLOTS - 1);
+
+  for (uint32_t n = 0; n < PLAIN_SLOTS; n++) {
+    plainReg_t * r = &plain[(i + n) & (PLAIN_SLOTS - 1)];
+    if (!r->used) {
+      r->used = 1;
+      r->addr = addr;
+      r->value = 0;   //reset value of everything without a model
+      return r;
+    }
+    if (r->addr == addr) return r;
+  }
+  fprintf(stderr, "sim: register map full at 0x%08X\n", (unsigned)addr);
+  exit(1);
+}
+
+static const simModel_t * modelFor( uint32_t addr )
+{
+  for (uint32_t i = 0; i < NUM_MODELS; i++) {
+    if ((addr >= models[i]->base) && (addr < (models[i]->base + models[i]->size))) return models[i];
+  }
+  return NULL;
+}
+
+static uint32_t readReg( const simModel_t * m, uint32_t addr )
+{
+  if (m) return m->read(m->unit, addr - m->base);
+
+  if ((addr >= SYSCTL_PR_FIRST) && (addr <= SYSCTL_PR_LAST)) return 0xFFFFFFFFu;
+  if (addr == SYSCTL_BOOTCFG) return 0xFFFFFFFEu;
+  if (addr == NVIC_EN0) return nvicEnabled | SIM_WRITE_MARK;
+  if (addr == NVIC_DIS0) return 0;
+  if (addr == DWT_CYCCNT) return (uint32_t)(now - cyccntBase);
+  return plainFind(addr)->value;
+}
+
+static void writeReg( const simModel_t * m, uint32_t addr, uint32_t value )
+{
+  if (m) {
+    m->write(m->unit, addr - m->base, value);
+    return;
+  }
+
+  if ((addr >= SYSCTL_PR_FIRST) && (addr <= SYSCTL_PR_LAST)) return;
+  if (addr == SYSCTL_BOOTCFG) return;
+  if (addr == NVIC_EN0) { nvicEnabled |= value; return; }
+  if (addr == NVIC_DIS0) { nvicEnabled &= ~value; return; }
+  if (addr == DWT_CYCCNT) { cyccntBase = now - value; return; }
+  plainFind(addr)->value = value;
+}
+
+static void flushAccess( void )
+{
+  uint32_t value = slot;
+
+  if (!pending.valid) return;
+  pending.valid = 0;
+
+  if (value == pending.presented) {
+    if (pending.model && pending.model->readDone) {
+      pending.model->readDone(pending.model->unit, pending.addr - pending.model->base);
+    }
+    return;
+  }
+
+  if ((pending.presented & SIM_WRITE_MARK) && !(pending.model && pending.model->fullWidth)) {
+    value &= ~SIM_WRITE_MARK;
+  }
+  coreStats.writes++;
+  writeReg(pending.model, pending.addr, value);
+}
+
+static uint64_t nextEvent( void )
+{
+  uint64_t next = 0;
+
+  for (uint32_t i = 0; i < NUM_MODELS; i++) {
+    uint64_t t = models[i]->nextEvent ? models[i]->nextEvent(models[i]->unit) : 0;
+    if ((t != 0) && ((next == 0) || (t < next))) next = t;
+  }
+  return next;
+}
+
+static void updateModels( void )
+{
+  for (uint32_t i = 0; i < NUM_MODELS; i++) {
+    if (models[i]->update) models[i]->update(models[i]->unit, now);
+  }
+}
+
+static void dispatchIrqs( void )
+{
+  if (inIsr) return;
+
+  for (uint32_t n = 0; n < SIM_MAX_IRQ_BURST; n++) {
+    uint32_t lines = 0;
+
+    for (uint32_t i = 0; i < NUM_MODELS; i++) {
+      if (models[i]->irqLines) lines |= models[i]->irqLines(models[i]->unit);
+    }
+    lines &= nvicEnabled;
+    if (lines == 0) return;
+
+    //equal priorities, the lowest vector wins
+    uint8_t irq = 0;
+    while (((lines >> irq) & 0x01) == 0) irq++;
+
+    simIsr_t isr = isrFor(irq);
+    if (isr == NULL) {
+      fprintf(stderr, "sim: no handler for IRQ %u, disabled\n", irq);
+      nvicEnabled &= ~(0x01u << irq);
+      continue;
+    }
+
+    inIsr = 1;
+    coreStats.irqs++;
+    isr();
+    flushAccess();
+    inIsr = 0;
+  }
+}
+
+void Sim_Reset( void )
+/*!\brief   Power on reset of the simulated chip
+\return none
+*/
+{
+  memset(plain, 0, sizeof(plain));
+  memset(&pending, 0, sizeof(pending));
+  memset(&coreStats, 0, sizeof(coreStats));
+  now = 0;
+  nvicEnabled = 0;
+  cyccntBase = 0;
+  inIsr = 0;
+  for (uint32_t i = 0; i < NUM_MODELS; i++) {
+    if (models[i]->reset) models[i]->reset(models[i]->unit);
+  }
+}
+
+uint64_t Sim_Now( void )
+/*!\brief   Simulated time in system clock cycles since reset
+\return cycle count
+*/
+{
+  return now;
+}
+
+uint32_t Sim_Micros( void )
+/*!\brief   Simulated time in microseconds since reset
+\return microseconds, wraps like Timer_micros
+*/
+{
+  return (uint32_t)(now / SIM_CYCLES_PER_US);
+}
+
+void Sim_Advance( uint32_t cycles )
+/*!\brief   Let simulated time pass
+\details Stops at every peripheral event on the way so models see them in
+         order, then runs whatever interrupts are asserted at the end.
+\param cycles[in]: system clock cycles to advance
+\return none
+*/
+{
+  uint64_t target = now + cycles;
+
+  for (;;) {
+    uint64_t next = nextEvent();
+    if ((next == 0) || (next > target)) {
+      now = target;
+      updateModels();
+      break;
+    }
+    now = (next > now) ? next : (now + 1);
+    updateModels();
+    if (now == target) break;
+  }
+  dispatchIrqs();
+}
+
+void Sim_RunUntil( uint64_t cycle )
+/*!\brief   Idle until a point in simulated time
+\param cycle[in]: absolute cycle count to reach
+\return none
+*/
+{
+  while (now < cycle) {
+    SimReg_Idle();
+  }
+}
+
+void Sim_SetAccessCycles( uint32_t cycles )
+/*!\brief   Change what one register access costs
+\param cycles[in]: cycles per access, 1 or more
+\return none
+*/
+{
+  accessCycles = (cycles == 0) ? 1 : cycles;
+}
+
+void Sim_GetStats( simCoreStats_t * stats )
+/*!\brief   Copy out the access and interrupt counters
+\return none
+*/
+{
+  *stats = coreStats;
+}
+
+volatile uint32_t * SimReg_Access( uint32_t addr )
+/*!\brief   One firmware register access, see the file header
+\param addr[in]: register address
+\return pointer the access reads or writes through
+*/
+{
+  flushAccess();
+  Sim_Advance(accessCycles);
+
+  pending.model = modelFor(addr);
+  pending.addr = addr;
+  pending.presented = readReg(pending.model, addr);
+  pending.valid = 1;
+  coreStats.accesses++;
+
+  slot = pending.presented;
+  return &slot;
+}
+
+const void * SimMem_Ptr( uint32_t addr )
+/*!\brief   Memory mapped flash contents
+\param addr[in]: flash address
+\return host pointer to the simulated flash
+*/
+{
+  if (addr >= SIM_FLASH_SIZE) {
+    fprintf(stderr, "sim: read outside flash at 0x%08X\n", (unsigned)addr);
+    exit(1);
+  }
+  return SimFlash_Mem() + addr;
+}
+
+void SimReg_Idle( void )
+/*!\brief   The firmware is waiting on time, skip to the next event
+\return none
+*/
+{
+  uint64_t next;
+  uint32_t cycles = SIM_IDLE_CYCLES;
+
+  flushAccess();
+  next = nextEvent();
+  if ((next > now) && ((next - now) < 0xFFFFFFFFu)) cycles = (uint32_t)(next - now);
+  coreStats.idleCycles += cycles;
+  Sim_Advance(cycles);
+}
@@ -0,0 +1,12 @@
+#if !defined(SIMREGS_H)
+#define SIMREGS_H
+
+#include <stdint.h>
+
+ // Entry points used by HWReg.h when the firmware is built with HOST_SIM.
+ // Everything else about the simulator is in Sim.h.
+volatile uint32_t * SimReg_Access( uint32_t addr );
+const void * SimMem_Ptr( uint32_t addr );
+void SimReg_Idle( void );
+
+#endif
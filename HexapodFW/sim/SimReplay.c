@@ -0,0 +1,243 @@
+/*! \file  SimReplay.c
+*
+* \brief
+* Flight recorder dumps in the host simulator
+*
+* \details
+*  SimReplay_Load reads a capture of the UART after a DUMP_RECORDER request
+*  (any bytes around the RECORDER_ADDRESS frames are skipped) and keeps one
+*  run of it, a run being everything from a REC_BOOT entry to the next.
+*  SimReplay_Service then sends the controller state behind every
+*  REC_COMMAND entry at the millisecond it was logged, and goes quiet where
+*  a REC_LINK_TIMEOUT shows the link dropped. Streams and scripts carry no
+*  content in the log and are skipped.
+*
+*  The simulated run logs into the same recorder, so the field log and the
+*  simulated one can be printed and compared entry by entry. Packet arrival
+*  times are not in the log; the replay sends at a fixed rate.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <string.h>
+#include "SimReplay.h"
+#include "SimGoBLE.h"
+#include "SimHarness.h"
+#include "SimTrace.h"
+#include "Gaits.h"
+
+static recEntry_t loaded[SIM_REPLAY_MAX];
+static uint32_t loadedCount = 0;
+static uint32_t nextEntry = 0;
+
+static const char * const eventNames[] = {
+  "?", "boot", "command", "fsm", "i2c error", "packet error", "overrun", "link timeout",
+  "battery"
+};
+
+static const char * const levelNames[] = {
+  "unknown", "ok", "low", "cutoff"
+};
+#define NUM_LEVEL_NAMES (sizeof(levelNames) / sizeof(levelNames[0]))
+
+static const char * const commandNames[] = {
+  "stop", "stand", "sit", "demo", "fwd", "back", "nw", "ne", "sw", "se",
+  "left", "right", "stream", "script", "fight", "parse error"
+};
+
+ // GoBLE buttons that parsePacket turns into each command, 0 when not replayable
+static const uint8_t commandButtons[] = {
+  0x00, 0x20, 0x00, 0x40, 0x02, 0x08, 0x00, 0x00, 0x00, 0x00,
+  0x10, 0x04, 0x00, 0x00, 0x60, 0x00
+};
+#define NUM_COMMAND_NAMES (sizeof(commandNames) / sizeof(commandNames[0]))
+
+static uint32_t get32( const uint8_t * p )
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t dueMs( const recEntry_t * e )
+{
+  //a timeout is logged when it expires, the link went quiet data ms before
+  if ((e->event == REC_LINK_TIMEOUT) && (e->timeMs >= e->data)) return e->timeMs - e->data;
+  return e->timeMs;
+}
+
+uint32_t SimReplay_Load( const char * path, uint32_t runsBack )
+/*!\brief   Read a recorder dump and keep one run for playback
+\param path[in]: raw capture of the dump frames
+       runsBack[in]: 0 for the newest run in the log, 1 for the one before...
+\return entries kept, 0 if the file has no such run
+*/
+{
+  static recEntry_t all[SIM_REPLAY_MAX];
+  static uint8_t buf[64 * 1024];
+  uint32_t count = 0;
+  uint32_t nextSeq = 0;
+  uint32_t first = 0;
+  uint32_t end;
+  FILE * in = fopen(path, "rb");
+
+  loadedCount = 0;
+  nextEntry = 0;
+  if (in == NULL) return 0;
+  size_t length = fread(buf, 1, sizeof(buf), in);
+  fclose(in);
+
+  for (size_t i = 0; (i + RECORDER_FRAME) <= length; i++) {
+    const uint8_t * f = &buf[i];
+    uint8_t sum = 0;
+
+    if ((f[0] != 0x55) || (f[1] != 0xAA) || (f[2] != RECORDER_ADDRESS) || (f[3] != RECORDER_PAYLOAD)) continue;
+    for (uint32_t k = 0; k < (RECORDER_FRAME - 1); k++) sum += f[k];
+    if (sum != f[RECORDER_FRAME - 1]) continue;
+
+    const uint8_t * p = &f[4];
+    uint32_t seq = get32(&p[RF_SEQ]);
+    for (uint8_t e = 0; (e < p[RF_COUNT]) && (e < RECORDER_PER_FRAME); e++, seq++) {
+      const uint8_t * q = &p[RF_ENTRIES + (e * RECORDER_ENTRY_SIZE)];
+      if (((count != 0) && (seq < nextSeq)) || (count == SIM_REPLAY_MAX)) continue;   //repeated dump
+      all[count].timeMs = get32(q);
+      all[count].event = q[4];
+      all[count].arg = q[5];
+      all[count].data = (uint16_t)(q[6] | (q[7] << 8));
+      count++;
+      nextSeq = seq + 1;
+    }
+    i += RECORDER_FRAME - 1;
+  }
+
+  //walk back over the REC_BOOT entries to the run asked for
+  end = count;
+  for (uint32_t i = count; i > 0; i--) {
+    if (all[i - 1].event != REC_BOOT) continue;
+    if (runsBack == 0) {
+      first = i - 1;
+      break;
+    }
+    runsBack--;
+    end = i - 1;
+  }
+  if (runsBack != 0) return 0;
+
+  memcpy(loaded, &all[first], (end - first) * sizeof(recEntry_t));
+  loadedCount = end - first;
+  return loadedCount;
+}
+
+uint32_t SimReplay_EndMs( void )
+/*!\brief   Time of the last entry of the loaded run
+\return milliseconds after boot
+*/
+{
+  return loadedCount ? loaded[loadedCount - 1].timeMs : 0;
+}
+
+void SimReplay_Service( uint8_t port, uint32_t rate, uint32_t nowMs )
+/*!\brief   Send the commands that are due, call once per main loop pass
+\param port[in]: UART_PORT_BT or UART_PORT_WIRED
+       rate[in]: packets per second while a command is held
+       nowMs[in]: Timer_millis
+\return none
+*/
+{
+  while ((nextEntry < loadedCount) && (dueMs(&loaded[nextEntry]) <= nowMs)) {
+    const recEntry_t * e = &loaded[nextEntry++];
+
+    if (e->event == REC_LINK_TIMEOUT) {
+      SimHarness_Command(port, 0, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE, 0);
+    }
+    else if ((e->event == REC_COMMAND) && (e->arg < NUM_COMMAND_NAMES) && commandButtons[e->arg]) {
+      SimHarness_Command(port, commandButtons[e->arg], (uint8_t)e->data, (uint8_t)(e->data >> 8), rate);
+    }
+    else if (e->event == REC_COMMAND) {
+      fprintf(stderr, "replay: %u ms, cannot replay command %u\n", e->timeMs, e->arg);
+    }
+  }
+}
+
+void SimReplay_Print( FILE * out, const recEntry_t * entries, uint32_t count )
+/*!\brief   Decode entries, one per line
+\return none
+*/
+{
+  for (uint32_t i = 0; i < count; i++) {
+    const recEntry_t * e = &entries[i];
+    const char * name = (e->event < (sizeof(eventNames) / sizeof(eventNames[0]))) ? eventNames[e->event] : "?";
+
+    fprintf(out, "%9u ms  %-13s", e->timeMs, name);
+    switch (e->event) {
+      case REC_BOOT:
+        fprintf(out, "reset cause 0x%02X, boot %u\n", e->arg, e->data);
+        break;
+      case REC_COMMAND:
+        fprintf(out, "%s, joystick %u,%u\n", (e->arg < NUM_COMMAND_NAMES) ? commandNames[e->arg] : "?",
+                e->data & 0xFF, e->data >> 8);
+        break;
+      case REC_FSM:
+        fprintf(out, "%s on %s\n", SimTrace_PhaseName(e->arg),
+                (e->data < NUM_COMMAND_NAMES) ? commandNames[e->data] : "?");
+        break;
+      case REC_I2C_ERROR:
+        fprintf(out, "status %u, %u errors\n", e->arg, e->data);
+        break;
+      case REC_PACKET_ERROR:
+        fprintf(out, "state %u, byte 0x%02X on UART%u\n", e->arg, e->data & 0xFF, e->data >> 8);
+        break;
+      case REC_OVERRUN:
+        fprintf(out, "%u ticks missed\n", e->data);
+        break;
+      case REC_LINK_TIMEOUT:
+        fprintf(out, "%u ms quiet\n", e->data);
+        break;
+      case REC_BATTERY:
+        fprintf(out, "%s, pack %u mV\n", (e->arg < NUM_LEVEL_NAMES) ? levelNames[e->arg] : "?", e->data);
+        break;
+      default:
+        fprintf(out, "arg %u, data %u\n", e->arg, e->data);
+        break;
+    }
+  }
+}
+
+void SimReplay_PrintLoaded( FILE * out )
+/*!\brief   Decode the run loaded by SimReplay_Load
+\return none
+*/
+{
+  SimReplay_Print(out, loaded, loadedCount);
+}
+
+void SimReplay_PrintSim( FILE * out, uint32_t fromSeq )
+/*!\brief   Decode the simulated firmware's own recorder log
+\param fromSeq[in]: first entry, see Recorder_Count
+\return none
+*/
+{
+  recEntry_t e;
+
+  for (uint32_t seq = fromSeq; seq < Recorder_Count(); seq++) {
+    if (Recorder_Get(seq, &e)) SimReplay_Print(out, &e, 1);
+  }
+}
+
+int SimReplay_WriteDump( const char * path )
+/*!\brief   Write the simulated recorder log as the firmware dumps it
+\return 0 on success, -1 if the file cannot be written
+*/
+{
+  uint8_t frame[RECORDER_FRAME];
+  uint32_t end = Recorder_Count();
+  uint32_t seq = (end > RECORDER_ENTRIES) ? (end - RECORDER_ENTRIES) : 0;
+  uint8_t length;
+  FILE * out = fopen(path, "wb");
+
+  if (out == NULL) return -1;
+  while ((length = Recorder_BuildFrame(&seq, end, frame)) != 0) {
+    fwrite(frame, 1, length, out);
+  }
+  fclose(out);
+  return 0;
+}
@@ -0,0 +1,20 @@
+#if !defined(SIMREPLAY_H)
+#define SIMREPLAY_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Recorder.h"
+
+ // Flight recorder dumps (RECORDER_ADDRESS frames captured off the UART)
+ // played back through SimHarness_Command
+#define SIM_REPLAY_MAX  (RECORDER_ENTRIES)
+
+uint32_t SimReplay_Load( const char * path, uint32_t runsBack );
+uint32_t SimReplay_EndMs( void );
+void SimReplay_Service( uint8_t port, uint32_t rate, uint32_t nowMs );
+void SimReplay_Print( FILE * out, const recEntry_t * entries, uint32_t count );
+void SimReplay_PrintLoaded( FILE * out );
+void SimReplay_PrintSim( FILE * out, uint32_t fromSeq );
+int SimReplay_WriteDump( const char * path );
+
+#endif
@@ -0,0 +1,118 @@
+/*! \file  SimTimer.c
+*
+* \brief
+* General purpose timer model (Timer 0A and 1A) for the host simulator
+*
+* \details
+*  Only what Timer.c uses: 32-bit periodic down counter on timer A, time-out
+*  raw status and mask, interrupt clear and the current count (GPTMTAV).
+*  The count is derived from the simulated clock, so Timer_micros sees the
+*  same sub-millisecond resolution as on the chip. A time-out with TAOTE
+*  set starts the ADC sequencers waiting on a timer trigger (SimADC.c).
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <string.h>
+#include "Sim.h"
+
+#define GPTM_CFG    0x000
+#define GPTM_TAMR   0x004
+#define GPTM_CTL    0x00C
+#define GPTM_IMR    0x018
+#define GPTM_RIS    0x01C
+#define GPTM_MIS    0x020
+#define GPTM_ICR    0x024
+#define GPTM_TAILR  0x028
+#define GPTM_TAV    0x050
+
+#define TAEN        0x01
+#define TAOTE       0x20
+#define TATO        0x01
+
+typedef struct simTimer
+{
+  uint32_t cfg;
+  uint32_t tamr;
+  uint32_t ctl;
+  uint32_t imr;
+  uint32_t ris;
+  uint32_t tailr;
+  uint64_t timeout;   //cycle of the next time-out, 0 while disabled
+} simTimer_t;
+
+static simTimer_t timer[2];
+static const uint8_t timerIrq[2] = { SIM_IRQ_TIMER0A, SIM_IRQ_TIMER1A };
+
+static void timerReset( uint8_t unit )
+{
+  memset(&timer[unit], 0, sizeof(timer[unit]));
+  timer[unit].tailr = 0xFFFFFFFFu;
+}
+
+static uint32_t timerRead( uint8_t unit, uint32_t offset )
+{
+  simTimer_t * t = &timer[unit];
+
+  switch (offset) {
+    case GPTM_CFG:   return t->cfg;
+    case GPTM_TAMR:  return t->tamr;
+    case GPTM_CTL:   return t->ctl;
+    case GPTM_IMR:   return t->imr;
+    case GPTM_RIS:   return t->ris;
+    case GPTM_MIS:   return t->ris & t->imr;
+    case GPTM_TAILR: return t->tailr;
+    case GPTM_TAV:   return t->timeout ? (uint32_t)(t->timeout - Sim_Now() - 1) : t->tailr;
+    default:         return 0;   //ICR is write only
+  }
+}
+
+static void timerWrite( uint8_t unit, uint32_t offset, uint32_t value )
+{
+  simTimer_t * t = &timer[unit];
+
+  switch (offset) {
+    case GPTM_CFG:   t->cfg = value;  break;
+    case GPTM_TAMR:  t->tamr = value; break;
+    case GPTM_IMR:   t->imr = value;  break;
+    case GPTM_ICR:   t->ris &= ~value; break;
+    case GPTM_TAILR: t->tailr = value; break;   //reloaded at the next time-out
+    case GPTM_CTL:
+      if ((value & TAEN) && !(t->ctl & TAEN)) {
+        t->timeout = Sim_Now() + (uint64_t)t->tailr + 1u;
+      } else if (!(value & TAEN)) {
+        t->timeout = 0;
+      }
+      t->ctl = value;
+      break;
+    default:
+      break;
+  }
+}
+
+static void timerUpdate( uint8_t unit, uint64_t now )
+{
+  simTimer_t * t = &timer[unit];
+
+  while (t->timeout && (t->timeout <= now)) {
+    t->ris |= TATO;
+    if (t->ctl & TAOTE) SimADC_TimerTrigger(t->timeout);
+    t->timeout += (uint64_t)t->tailr + 1u;
+  }
+}
+
+static uint64_t timerNextEvent( uint8_t unit )
+{
+  return timer[unit].timeout;
+}
+
+static uint32_t timerIrqLines( uint8_t unit )
+{
+  return (timer[unit].ris & timer[unit].imr & TATO) ? (0x01u << timerIrq[unit]) : 0;
+}
+
+const simModel_t simTimerModel[2] = {
+  { 0x40030000u, 0x1000u, 0, timerReset, timerRead, timerWrite, NULL, timerUpdate, timerNextEvent, timerIrqLines },
+  { 0x40031000u, 0x1000u, 1, timerReset, timerRead, timerWrite, NULL, timerUpdate, timerNextEvent, timerIrqLines }
+};
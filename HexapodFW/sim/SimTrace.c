@@ -0,0 +1,242 @@
+/*! \file  SimTrace.c
+*
+* \brief
+* Gait trace recorder for the host simulator
+*
+* \details
+*  Records two kinds of events on the simulated clock:
+*    - every phase GaitHandler executes and every state runGaitFSM moves to
+*      (GAIT_TRACE_PHASE in Gaits.c)
+*    - every PCA9685 output change, at the STOP that latched it
+*  and exports them as CSV or as Chrome trace JSON (chrome://tracing or
+*  ui.perfetto.dev). In the JSON each phase is a slice on the "gait" track
+*  that lasts until the next phase, each joint has its own track with one
+*  instant per write, so the gap between a phase starting and its last
+*  servo landing is visible directly.
+*
+*  SimTrace_Summary prints the same per phase: how long it lasted and how
+*  long its pose took to reach the servos.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stdlib.h>
+#include "Sim.h"
+#include "SimTrace.h"
+
+#define TRACE_GROW      4096u
+#define GAIT_TID        1
+#define SERVO_TID_BASE  10
+#define NUM_PHASES      (FIGHTING + 1)
+
+static const char * const phaseNames[NUM_PHASES] = {
+  "FROZEN", "SITTING", "STANDING", "INIT_WALK", "WALKING", "WALK_STOPPING",
+  "DONE_WALKING", "TRIPOD1_LIFT", "TRIPOD1_SWIVEL", "TRIPOD1_SET",
+  "TRIPOD2_LIFT", "TRIPOD2_SWIVEL", "TRIPOD2_SET", "DEMOING", "STREAMING",
+  "SCRIPTING", "FIGHTING"
+};
+
+static simTraceEvent_t * events = NULL;
+static uint32_t count = 0;
+static uint32_t capacity = 0;
+static uint8_t recording = 0;
+
+static void append( uint8_t kind, uint8_t id, uint16_t value, uint64_t cycle )
+{
+  if (!recording) return;
+  if (count == capacity) {
+    capacity += TRACE_GROW;
+    events = realloc(events, capacity * sizeof(simTraceEvent_t));
+    if (events == NULL) {
+      fprintf(stderr, "sim: out of memory for the trace\n");
+      exit(1);
+    }
+  }
+  events[count].cycle = cycle;
+  events[count].kind = kind;
+  events[count].id = id;
+  events[count].count = value;
+  count++;
+}
+
+static double toUs( uint64_t cycle )
+{
+  return (double)cycle / SIM_CYCLES_PER_US;
+}
+
+static void jointName( uint8_t channel, char * name, size_t size )
+{
+  if (channel < KNEE_OFFSET) snprintf(name, size, "hip%u", channel);
+  else if (channel < (2 * KNEE_OFFSET)) snprintf(name, size, "knee%u", channel - KNEE_OFFSET);
+  else snprintf(name, size, "ch%u", channel);
+}
+
+void SimTrace_Start( void )
+/*!\brief   Drop anything recorded so far and start recording
+\return none
+*/
+{
+  count = 0;
+  recording = 1;
+}
+
+void SimTrace_Stop( void )
+/*!\brief   Stop recording, the events stay available for export
+\return none
+*/
+{
+  recording = 0;
+}
+
+void SimTrace_Phase( phase_t phase )
+/*!\brief   Firmware hook, see GAIT_TRACE_PHASE in Gaits.h
+\return none
+*/
+{
+  append(TRACE_PHASE, (uint8_t)phase, 0, Sim_Now());
+}
+
+void SimTrace_Servo( uint64_t cycle, uint8_t channel, uint16_t onCount, uint16_t offCount )
+/*!\brief   Record a PCA9685 output change, same signature as simServoHook_t
+\details The pulse width is kept (OFF count of a pulse starting at 4095),
+         so a phase stagger (PCA9685_SetPhaseStagger) does not show up as a
+         different position. Full on/off values are kept as they are.
+\return none
+*/
+{
+  uint16_t width = offCount;
+
+  if (!(offCount & 0x1000) && !(onCount & 0x1000)) width = (offCount - onCount - 1) & 0x0FFF;
+  append(TRACE_SERVO, channel, width, cycle);
+}
+
+uint32_t SimTrace_Count( void )
+/*!\brief   Number of events recorded
+\return event count
+*/
+{
+  return count;
+}
+
+const simTraceEvent_t * SimTrace_Events( void )
+/*!\brief   The recorded events, in time order per kind
+\return SimTrace_Count() events
+*/
+{
+  return events;
+}
+
+const char * SimTrace_PhaseName( uint8_t phase )
+/*!\brief   Printable name of a phase_t
+\return name
+*/
+{
+  return (phase < NUM_PHASES) ? phaseNames[phase] : "?";
+}
+
+void SimTrace_WriteCsv( FILE * out )
+/*!\brief   Export as CSV: time_us,event,id,name,count
+\return none
+*/
+{
+  char name[16];
+
+  fprintf(out, "time_us,event,id,name,count\n");
+  for (uint32_t i = 0; i < count; i++) {
+    const simTraceEvent_t * e = &events[i];
+    if (e->kind == TRACE_PHASE) {
+      fprintf(out, "%.3f,phase,%u,%s,\n", toUs(e->cycle), e->id, SimTrace_PhaseName(e->id));
+    } else {
+      jointName(e->id, name, sizeof(name));
+      fprintf(out, "%.3f,servo,%u,%s,%u\n", toUs(e->cycle), e->id, name, e->count);
+    }
+  }
+}
+
+void SimTrace_WriteChrome( FILE * out )
+/*!\brief   Export as Chrome trace event JSON
+\return none
+*/
+{
+  char name[16];
+  uint16_t used = 0;
+  uint64_t end = count ? events[count - 1].cycle : 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (events[i].kind == TRACE_SERVO) used |= (uint16_t)(0x01u << (events[i].id & 0x0F));
+    if (events[i].cycle > end) end = events[i].cycle;
+  }
+
+  fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"hexapod\"}},\n");
+  fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"gait\"}}", GAIT_TID);
+  for (uint8_t ch = 0; ch < 16; ch++) {
+    if (!((used >> ch) & 0x01)) continue;
+    jointName(ch, name, sizeof(name));
+    fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            SERVO_TID_BASE + ch, name);
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    const simTraceEvent_t * e = &events[i];
+
+    if (e->kind == TRACE_PHASE) {
+      //a phase lasts until the next one starts
+      uint64_t stop = end;
+      for (uint32_t j = i + 1; j < count; j++) {
+        if (events[j].kind == TRACE_PHASE) { stop = events[j].cycle; break; }
+      }
+      fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"gait\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+              SimTrace_PhaseName(e->id), GAIT_TID, toUs(e->cycle), toUs(stop - e->cycle));
+    } else {
+      jointName(e->id, name, sizeof(name));
+      fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"servo\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"count\":%u}}",
+              name, SERVO_TID_BASE + e->id, toUs(e->cycle), e->count);
+    }
+  }
+  fprintf(out, "\n]}\n");
+}
+
+void SimTrace_Summary( FILE * out )
+/*!\brief   Per phase timing: duration, servos written and time for the pose
+           to reach the last of them
+\return none
+*/
+{
+  uint32_t seen[NUM_PHASES] = {0};
+  uint32_t servos[NUM_PHASES] = {0};
+  uint64_t duration[NUM_PHASES] = {0};
+  uint64_t reach[NUM_PHASES] = {0};
+  uint64_t maxReach[NUM_PHASES] = {0};
+
+  for (uint32_t i = 0; i < count; i++) {
+    const simTraceEvent_t * e = &events[i];
+    uint64_t last = 0;
+    uint32_t written = 0;
+    uint32_t j;
+
+    if ((e->kind != TRACE_PHASE) || (e->id >= NUM_PHASES)) continue;
+    for (j = i + 1; (j < count) && (events[j].kind != TRACE_PHASE); j++) {
+      written++;
+      last = events[j].cycle;
+    }
+    if (j == count) break;   //still running when the trace ended
+
+    seen[e->id]++;
+    servos[e->id] += written;
+    duration[e->id] += events[j].cycle - e->cycle;
+    if (written) {
+      reach[e->id] += last - e->cycle;
+      if ((last - e->cycle) > maxReach[e->id]) maxReach[e->id] = last - e->cycle;
+    }
+  }
+
+  fprintf(out, "%-16s %6s %12s %8s %14s %14s\n", "phase", "count", "mean ms", "servos", "mean reach ms", "max reach ms");
+  for (uint8_t p = 0; p < NUM_PHASES; p++) {
+    if (seen[p] == 0) continue;
+    fprintf(out, "%-16s %6u %12.2f %8.1f %14.2f %14.2f\n", phaseNames[p], seen[p],
+            toUs(duration[p]) / 1000.0 / seen[p], (double)servos[p] / seen[p],
+            toUs(reach[p]) / 1000.0 / seen[p], toUs(maxReach[p]) / 1000.0);
+  }
+}
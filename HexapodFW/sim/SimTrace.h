@@ -0,0 +1,32 @@
+#if !defined(SIMTRACE_H)
+#define SIMTRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Gaits.h"
+
+typedef enum simTraceKind
+{
+  TRACE_PHASE,     //!<GaitHandler or runGaitFSM entered a phase
+  TRACE_SERVO      //!<a PCA9685 output changed
+} simTraceKind_t;
+
+typedef struct simTraceEvent
+{
+  uint64_t cycle;
+  uint8_t  kind;
+  uint8_t  id;     //!<phase_t or PCA9685 channel
+  uint16_t count;  //!<OFF count of a servo event
+} simTraceEvent_t;
+
+void SimTrace_Start( void );
+void SimTrace_Stop( void );
+void SimTrace_Servo( uint64_t cycle, uint8_t channel, uint16_t onCount, uint16_t offCount );
+uint32_t SimTrace_Count( void );
+const simTraceEvent_t * SimTrace_Events( void );
+const char * SimTrace_PhaseName( uint8_t phase );
+void SimTrace_WriteCsv( FILE * out );
+void SimTrace_WriteChrome( FILE * out );
+void SimTrace_Summary( FILE * out );
+
+#endif
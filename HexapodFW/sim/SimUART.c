@@ -0,0 +1,293 @@
+/*! \file  SimUART.c
+*
+* \brief
+* UART0/UART1 model for the host simulator
+*
+* \details
+*  Bytes handed to SimUART_Inject wait "on the wire" and enter the 16 entry
+*  RX FIFO one character time (10 bits at the programmed divisor) apart, so a
+*  slow reader overruns exactly like the real port: the byte is lost, OE is
+*  raised and the next byte read from DR carries the OE flag.
+*
+*  Interrupts follow UARTIM: RX at the IFLS half full level, receive timeout
+*  after 32 idle bit times with data left in the FIFO, TX when the FIFO is
+*  down to 2 entries, overrun. Transmitted bytes are shifted out at line rate
+*  and passed to the TX sink.
+*
+*  The uDMA is not modelled, the host build uses the interrupt RX path.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+
+#define UART_DR      0x000
+#define UART_FR      0x018
+#define UART_IBRD    0x024
+#define UART_FBRD    0x028
+#define UART_LCRH    0x02C
+#define UART_CTL     0x030
+#define UART_IFLS    0x034
+#define UART_IM      0x038
+#define UART_RIS     0x03C
+#define UART_MIS     0x040
+#define UART_ICR     0x044
+#define UART_DMACTL  0x048
+#define UART_CC      0xFC8
+
+#define FR_BUSY      0x08
+#define FR_RXFE      0x10
+#define FR_TXFF      0x20
+#define FR_RXFF      0x40
+#define FR_TXFE      0x80
+#define INT_RX       (0x01 << 4)
+#define INT_TX       (0x01 << 5)
+#define INT_RT       (0x01 << 6)
+#define INT_OE       (0x01 << 10)
+#define DR_OE        (0x01 << 11)
+#define CTL_UARTEN   0x01
+
+#define FIFO_DEPTH   16
+#define WIRE_SIZE    (64u * 1024u)   //injected bytes not yet received, power of two
+#define RT_BITS      32
+
+typedef struct simUart
+{
+  uint32_t ibrd, fbrd, lcrh, ctl, ifls, im, dmactl, cc;
+  uint32_t oeRis;                    //latched overrun status
+  uint16_t rxFifo[FIFO_DEPTH];       //data plus DR error flags
+  uint8_t  rxCount;
+  uint8_t  rxRead;
+  uint8_t  oePending;                //next byte into the FIFO carries DR_OE
+  uint8_t  txFifo[FIFO_DEPTH];
+  uint8_t  txCount;
+  uint8_t  txRead;
+  uint64_t txNext;                   //cycle the current TX byte finishes, 0 idle
+  uint64_t rxNext;                   //cycle the next wire byte arrives, 0 none
+  uint64_t rxLast;                   //cycle the last byte entered the FIFO
+  uint8_t  wire[WIRE_SIZE];
+  uint32_t wireHead, wireTail;
+  simUartStats_t stats;
+} simUart_t;
+
+static simUart_t uart[2];
+static simTxSink_t txSink = NULL;
+static const uint8_t uartIrq[2] = { SIM_IRQ_UART0, SIM_IRQ_UART1 };
+
+static uint64_t bitCycles( const simUart_t * u )
+{
+  //BRD = SYSCLK / (16 * baud), one bit lasts 16 * BRD cycles
+  uint64_t brd64 = ((uint64_t)u->ibrd * 64u) + u->fbrd;
+
+  if (brd64 == 0) brd64 = 64;
+  return (brd64 * 16u + 32u) / 64u;
+}
+
+static uint8_t rxLevel( const simUart_t * u )
+{
+  static const uint8_t level[5] = { 2, 4, 8, 12, 14 };
+  uint8_t sel = (u->ifls >> 3) & 0x07;
+  return level[(sel < 5) ? sel : 2];
+}
+
+static uint32_t uartRis( uint8_t unit )
+{
+  simUart_t * u = &uart[unit];
+  uint32_t ris = u->oeRis;
+  uint64_t now = Sim_Now();
+
+  if (u->rxCount >= rxLevel(u)) ris |= INT_RX;
+  if (u->rxCount && (now >= (u->rxLast + (RT_BITS * bitCycles(u))))) ris |= INT_RT;
+  if (u->txCount <= 2) ris |= INT_TX;
+  return ris;
+}
+
+static void uartReset( uint8_t unit )
+{
+  memset(&uart[unit], 0, sizeof(uart[unit]));
+  uart[unit].ifls = 0x12;   //reset value, both FIFOs at half
+}
+
+static uint32_t uartRead( uint8_t unit, uint32_t offset )
+{
+  simUart_t * u = &uart[unit];
+  uint32_t fr = 0;
+
+  switch (offset) {
+    case UART_DR:
+      if (u->rxCount == 0) return SIM_WRITE_MARK;
+      return u->rxFifo[u->rxRead] | SIM_WRITE_MARK;
+    case UART_FR:
+      if (u->rxCount == 0) fr |= FR_RXFE;
+      if (u->rxCount == FIFO_DEPTH) fr |= FR_RXFF;
+      if (u->txCount == 0) fr |= FR_TXFE;
+      if (u->txCount == FIFO_DEPTH) fr |= FR_TXFF;
+      if (u->txCount || u->txNext) fr |= FR_BUSY;
+      return fr;
+    case UART_IBRD:   return u->ibrd;
+    case UART_FBRD:   return u->fbrd;
+    case UART_LCRH:   return u->lcrh;
+    case UART_CTL:    return u->ctl;
+    case UART_IFLS:   return u->ifls;
+    case UART_IM:     return u->im;
+    case UART_RIS:    return uartRis(unit);
+    case UART_MIS:    return uartRis(unit) & u->im;
+    case UART_DMACTL: return u->dmactl;
+    case UART_CC:     return u->cc;
+    default:          return 0;   //ICR is write only
+  }
+}
+
+static void uartReadDone( uint8_t unit, uint32_t offset )
+{
+  simUart_t * u = &uart[unit];
+
+  if ((offset == UART_DR) && u->rxCount) {
+    u->rxRead = (u->rxRead + 1) % FIFO_DEPTH;
+    u->rxCount--;
+  }
+}
+
+static void uartWrite( uint8_t unit, uint32_t offset, uint32_t value )
+{
+  simUart_t * u = &uart[unit];
+
+  switch (offset) {
+    case UART_DR:
+      if (u->txCount == FIFO_DEPTH) break;   //lost, same as the chip
+      u->txFifo[(u->txRead + u->txCount) % FIFO_DEPTH] = (uint8_t)value;
+      u->txCount++;
+      if ((u->txNext == 0) && (u->ctl & CTL_UARTEN)) u->txNext = Sim_Now() + (10u * bitCycles(u));
+      break;
+    case UART_IBRD:   u->ibrd = value & 0xFFFF; break;
+    case UART_FBRD:   u->fbrd = value & 0x3F;   break;
+    case UART_LCRH:   u->lcrh = value;          break;
+    case UART_IFLS:   u->ifls = value;          break;
+    case UART_IM:     u->im = value;            break;
+    case UART_ICR:    u->oeRis &= ~value;       break;
+    case UART_DMACTL:
+      u->dmactl = value;
+      if (value) fprintf(stderr, "sim: UART%u uDMA is not modelled\n", unit);
+      break;
+    case UART_CC:     u->cc = value;            break;
+    case UART_CTL:
+      if ((value & CTL_UARTEN) && u->txCount && (u->txNext == 0)) {
+        u->txNext = Sim_Now() + (10u * bitCycles(u));
+      }
+      u->ctl = value;
+      break;
+    default:
+      break;
+  }
+}
+
+static void uartUpdate( uint8_t unit, uint64_t now )
+{
+  simUart_t * u = &uart[unit];
+  uint64_t charCycles = 10u * bitCycles(u);
+
+  while (u->rxNext && (u->rxNext <= now)) {
+    uint8_t data = u->wire[u->wireTail & (WIRE_SIZE - 1)];
+    u->wireTail++;
+
+    if (!(u->ctl & CTL_UARTEN)) {
+      u->stats.rxDisabled++;
+    } else if (u->rxCount == FIFO_DEPTH) {
+      u->stats.rxDropped++;
+      u->oePending = 1;
+      u->oeRis |= INT_OE;
+    } else {
+      u->rxFifo[(u->rxRead + u->rxCount) % FIFO_DEPTH] = data | (u->oePending ? DR_OE : 0);
+      u->rxCount++;
+      u->oePending = 0;
+      u->rxLast = u->rxNext;
+      u->stats.rxBytes++;
+    }
+    u->rxNext = (u->wireTail != u->wireHead) ? (u->rxNext + charCycles) : 0;
+  }
+
+  while (u->txNext && (u->txNext <= now)) {
+    uint8_t data = u->txFifo[u->txRead];
+    u->txRead = (u->txRead + 1) % FIFO_DEPTH;
+    u->txCount--;
+    u->stats.txBytes++;
+    if (txSink) txSink(unit, data);
+    u->txNext = u->txCount ? (u->txNext + charCycles) : 0;
+  }
+}
+
+static uint64_t uartNextEvent( uint8_t unit )
+{
+  simUart_t * u = &uart[unit];
+  uint64_t next = u->rxNext;
+  uint64_t rt;
+
+  if (u->txNext && ((next == 0) || (u->txNext < next))) next = u->txNext;
+  if (u->rxCount) {
+    rt = u->rxLast + (RT_BITS * bitCycles(u));
+    if ((rt > Sim_Now()) && ((next == 0) || (rt < next))) next = rt;
+  }
+  return next;
+}
+
+static uint32_t uartIrqLines( uint8_t unit )
+{
+  return (uartRis(unit) & uart[unit].im) ? (0x01u << uartIrq[unit]) : 0;
+}
+
+const simModel_t simUartModel[2] = {
+  { 0x4000C000u, 0x1000u, 0, uartReset, uartRead, uartWrite, uartReadDone, uartUpdate, uartNextEvent, uartIrqLines },
+  { 0x4000D000u, 0x1000u, 1, uartReset, uartRead, uartWrite, uartReadDone, uartUpdate, uartNextEvent, uartIrqLines }
+};
+
+void SimUART_Inject( uint8_t port, const uint8_t * data, uint32_t length )
+/*!\brief   Put bytes on the RX line of a port
+\details They arrive back to back at the port's current line rate, after
+         anything injected earlier.
+\param port[in]: 0 or 1
+       data[in]: bytes
+       length[in]: number of bytes
+\return none
+*/
+{
+  simUart_t * u = &uart[port];
+
+  if ((u->wireHead - u->wireTail + length) > WIRE_SIZE) {
+    fprintf(stderr, "sim: UART%u wire buffer full\n", port);
+    exit(1);
+  }
+  for (uint32_t i = 0; i < length; i++) {
+    u->wire[u->wireHead & (WIRE_SIZE - 1)] = data[i];
+    u->wireHead++;
+  }
+  if ((u->rxNext == 0) && (length != 0)) u->rxNext = Sim_Now() + (10u * bitCycles(u));
+}
+
+uint32_t SimUART_Pending( uint8_t port )
+/*!\brief   Injected bytes that have not reached the FIFO yet
+\return byte count
+*/
+{
+  return uart[port].wireHead - uart[port].wireTail;
+}
+
+void SimUART_SetTxSink( simTxSink_t sink )
+/*!\brief   Receive every byte either port transmits
+\param sink[in]: callback, NULL to discard
+\return none
+*/
+{
+  txSink = sink;
+}
+
+void SimUART_GetStats( uint8_t port, simUartStats_t * stats )
+/*!\brief   Copy out the byte counters of a port
+\return none
+*/
+{
+  *stats = uart[port].stats;
+}
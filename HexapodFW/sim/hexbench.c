@@ -0,0 +1,335 @@
+/*! \file  hexbench.c
+*
+* \brief
+* Performance regression benchmark for the control stack, host build
+*
+* \details
+*  Runs fixed command sequences through checkBlueTooth/runGaitFSM on the
+*  virtual register map, each from a fresh boot:
+*    stand    boot and hold the stand command for a second
+*    walk     walk forward for N gait cycles
+*    rotate   rotate left for N gait cycles
+*    demo     the boot demo
+*    servo    PCA9685_setServo and the queued frame path in isolation
+*    cpg      CPG_Update walking forward for N tripod cycles, one servo
+*             frame per control tick as runGaitFSM does it
+*  and reports I2C bytes and transactions per gait cycle, command latency,
+*  control loop time, cycles per servo write and the CPG update time.
+*
+*  Built with USE_CPG_GAIT (make CPG=1) the walk and rotate scenarios run
+*  on the oscillators, which have no tripod phases to count: they walk for
+*  N tripod cycle times and report per second instead.
+*
+*  usage: hexbench [-n cycles] [-o results.json] [-l limits.txt]
+*
+*  Results go to a flat JSON object. Every "name max" line of the limits
+*  file is checked against it; the exit status is 1 if any result is above
+*  its limit or missing, so a change that makes the hot path slower fails
+*  the run.
+*
+*  All figures are simulated and deterministic: cycles are charged for
+*  register accesses and peripheral waits, not for arithmetic. So
+*  cpg.update_us holds the 100us CPG budget to the time CPG_Update spends
+*  on the registers and the bus, which is none while its servo writes go
+*  into the frame; its own integer arithmetic (a few hundred cycles, see
+*  CPG.c) comes on top on the bot.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "SimGoBLE.h"
+#include "SimHarness.h"
+#include "PCA9685.h"
+#include "Gaits.h"
+#include "UART.h"
+#include "Control.h"
+#include "CPG.h"
+#include "Timer.h"
+
+#define MAX_RESULTS     48
+#define NAME_LEN        48
+#define PACKET_RATE     10u
+#define IDLE_SECONDS    1u
+#define CYCLE_TIMEOUT_S 10u    //per gait cycle before a walk counts as stuck
+#define SERVO_REPEAT    100u
+
+typedef struct benchResult
+{
+  char   name[NAME_LEN];
+  double value;
+} benchResult_t;
+
+static benchResult_t results[MAX_RESULTS];
+static uint32_t numResults = 0;
+
+static void record( const char * scenario, const char * metric, double value )
+{
+  if (numResults == MAX_RESULTS) {
+    fprintf(stderr, "hexbench: too many results\n");
+    exit(1);
+  }
+  snprintf(results[numResults].name, NAME_LEN, "%s.%s", scenario, metric);
+  results[numResults].value = value;
+  printf("%-36s %12.2f\n", results[numResults].name, value);
+  numResults++;
+}
+
+static const benchResult_t * findResult( const char * name )
+{
+  for (uint32_t i = 0; i < numResults; i++) {
+    if (!strcmp(results[i].name, name)) return &results[i];
+  }
+  return NULL;
+}
+
+static double toMs( uint64_t cycles )
+{
+  return (double)cycles / (SIM_SYSCLK_HZ / 1000u);
+}
+
+static void runFor( uint64_t cycles )
+{
+  uint64_t end = Sim_Now() + cycles;
+  while (Sim_Now() < end) SimHarness_Step();
+}
+
+static void benchStand( void )
+{
+  simI2cStats_t boot;
+  simI2cStats_t bus;
+  controlStats_t control;
+
+  SimHarness_Boot(0);
+  SimI2C_GetStats(&boot);
+  record("stand", "boot_ms", toMs(Sim_Now()));
+  record("stand", "boot_i2c_bytes", boot.bytes);
+
+  Control_ResetStats();
+  SimHarness_Command(UART_PORT_BT, 0x20, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE, PACKET_RATE);
+  runFor((uint64_t)IDLE_SECONDS * SIM_SYSCLK_HZ);
+
+  SimI2C_GetStats(&bus);
+  Control_GetStats(&control);
+  record("stand", "hold_i2c_bytes", bus.bytes - boot.bytes);
+  record("stand", "max_loop_us", control.maxLoopUs);
+}
+
+#if !USE_CPG_GAIT
+static void benchGait( const char * scenario, uint8_t buttons, uint32_t cycles )
+{
+  simI2cStats_t first;
+  simI2cStats_t last;
+  controlStats_t control;
+  uint64_t firstAt = 0;
+  uint64_t timeout;
+  uint32_t started = 0;
+
+  SimHarness_Boot(0);
+  runFor((uint64_t)IDLE_SECONDS * SIM_SYSCLK_HZ);
+  Control_ResetStats();
+  SimHarness_Command(UART_PORT_BT, buttons, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE, PACKET_RATE);
+  timeout = Sim_Now() + ((uint64_t)(cycles + 1) * CYCLE_TIMEOUT_S * SIM_SYSCLK_HZ);
+
+  //count whole cycles only: from the first TRIPOD1_LIFT to the one after the last
+  while ((started <= cycles) && (Sim_Now() < timeout)) {
+    if (!SimHarness_Step()) continue;
+    if (started++ == 0) {
+      SimI2C_GetStats(&first);
+      firstAt = Sim_Now();
+    }
+  }
+  if (started <= cycles) {
+    fprintf(stderr, "hexbench: %s completed %u of %u gait cycles\n", scenario, started ? started - 1 : 0, cycles);
+    record(scenario, "cycles_missing", (double)(cycles + 1 - started));
+    return;
+  }
+
+  SimI2C_GetStats(&last);
+  Control_GetStats(&control);
+  record(scenario, "latency_ms", toMs(SimHarness_Latency()));
+  record(scenario, "cycle_ms", toMs(Sim_Now() - firstAt) / cycles);
+  record(scenario, "i2c_bytes_per_cycle", (double)(last.bytes - first.bytes) / cycles);
+  record(scenario, "i2c_transactions_per_cycle", (double)(last.transactions - first.transactions) / cycles);
+  record(scenario, "max_loop_us", control.maxLoopUs);
+  record(scenario, "overruns", control.overruns);
+}
+#else
+static void benchOscillators( const char * scenario, uint8_t buttons, uint32_t cycles )
+{
+  simI2cStats_t first;
+  simI2cStats_t last;
+  controlStats_t control;
+  uint64_t length = (uint64_t)cycles * TRIPOD_CYCLE_TIME * (SIM_SYSCLK_HZ / 1000u);
+
+  SimHarness_Boot(0);
+  runFor((uint64_t)IDLE_SECONDS * SIM_SYSCLK_HZ);
+  Control_ResetStats();
+  SimHarness_Command(UART_PORT_BT, buttons, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE, PACKET_RATE);
+
+  //let the amplitudes ramp up before counting the bus
+  runFor((uint64_t)IDLE_SECONDS * SIM_SYSCLK_HZ);
+  SimI2C_GetStats(&first);
+  runFor(length);
+
+  SimI2C_GetStats(&last);
+  Control_GetStats(&control);
+  record(scenario, "latency_ms", toMs(SimHarness_Latency()));
+  record(scenario, "i2c_bytes_per_s", (double)(last.bytes - first.bytes) * 1000.0 / toMs(length));
+  record(scenario, "i2c_transactions_per_s", (double)(last.transactions - first.transactions) * 1000.0 / toMs(length));
+  record(scenario, "max_loop_us", control.maxLoopUs);
+  record(scenario, "overruns", control.overruns);
+}
+#endif
+
+static void benchDemo( void )
+{
+  simI2cStats_t before;
+  simI2cStats_t after;
+  uint64_t start;
+
+  SimHarness_Boot(0);
+  SimI2C_GetStats(&before);
+  start = Sim_Now();
+  demo();
+  SimI2C_GetStats(&after);
+  record("demo", "ms", toMs(Sim_Now() - start));
+  record("demo", "i2c_bytes", after.bytes - before.bytes);
+  record("demo", "i2c_transactions", after.transactions - before.transactions);
+}
+
+static void benchServo( void )
+{
+  uint64_t start;
+
+  SimHarness_Boot(0);
+
+  start = Sim_Now();
+  for (uint32_t i = 0; i < SERVO_REPEAT; i++) {
+    for (uint8_t ch = 0; ch < (2 * NUM_LEGS); ch++) PCA9685_setServo(ch, 80.0f + (i & 0x0F));
+  }
+  record("servo", "setservo_cycles", (double)(Sim_Now() - start) / (SERVO_REPEAT * 2 * NUM_LEGS));
+
+  start = Sim_Now();
+  for (uint32_t i = 0; i < SERVO_REPEAT; i++) {
+    for (uint8_t ch = 0; ch < (2 * NUM_LEGS); ch++) PCA9685_QueueServo(ch, 80.0f + (i & 0x0F));
+    PCA9685_CommitServos();
+  }
+  record("servo", "queued_cycles_per_servo", (double)(Sim_Now() - start) / (SERVO_REPEAT * 2 * NUM_LEGS));
+}
+
+static void benchCpg( uint32_t cycles )
+{
+  controlStats_t control;
+  uint64_t start, tickAt, period;
+  uint64_t worstUpdate = 0, worstTick = 0;
+  uint32_t ticks;
+
+  SimHarness_Boot(0);
+  Control_GetStats(&control);
+  period = (uint64_t)control.periodUs * SIM_CYCLES_PER_US;
+  ticks = (cycles * TRIPOD_CYCLE_TIME * 1000u) / control.periodUs;
+
+  CPG_SetGait(CPG_GAIT_TRIPOD);
+  CPG_Start(Timer_millis());
+  CPG_SetCommand(BOT_WALK_FWD);
+  start = Sim_Now();
+  for (uint32_t i = 0; i < ticks; i++) {
+    tickAt = Sim_Now();
+    transactServos();
+    CPG_Update(Timer_millis());
+    if ((Sim_Now() - tickAt) > worstUpdate) worstUpdate = Sim_Now() - tickAt;
+    commitServos();
+    if ((Sim_Now() - tickAt) > worstTick) worstTick = Sim_Now() - tickAt;
+    Sim_RunUntil(start + ((i + 1) * period));
+  }
+  record("cpg", "update_us", (double)worstUpdate / SIM_CYCLES_PER_US);
+  record("cpg", "max_tick_us", (double)worstTick / SIM_CYCLES_PER_US);
+}
+
+static void writeResults( const char * path )
+{
+  FILE * out = fopen(path, "w");
+
+  if (out == NULL) {
+    fprintf(stderr, "hexbench: cannot write %s\n", path);
+    exit(1);
+  }
+  fprintf(out, "{\n");
+  for (uint32_t i = 0; i < numResults; i++) {
+    fprintf(out, "  \"%s\": %.3f%s\n", results[i].name, results[i].value, (i + 1 < numResults) ? "," : "");
+  }
+  fprintf(out, "}\n");
+  fclose(out);
+}
+
+static uint32_t checkLimits( const char * path )
+{
+  FILE * in = fopen(path, "r");
+  char line[128];
+  char name[NAME_LEN];
+  double limit;
+  uint32_t failed = 0;
+
+  if (in == NULL) {
+    fprintf(stderr, "hexbench: cannot read %s\n", path);
+    exit(1);
+  }
+  printf("\n");
+  while (fgets(line, sizeof(line), in)) {
+    if ((line[0] == '#') || (sscanf(line, "%47s %lf", name, &limit) != 2)) continue;
+
+    const benchResult_t * r = findResult(name);
+    if (r == NULL) {
+      printf("FAIL %-36s missing\n", name);
+      failed++;
+    } else if (r->value > limit) {
+      printf("FAIL %-36s %12.2f > %.2f\n", name, r->value, limit);
+      failed++;
+    }
+  }
+  fclose(in);
+  if (findResult("walk.cycles_missing") || findResult("rotate.cycles_missing")) failed++;
+  printf("%s\n", failed ? "regression" : "all results within limits");
+  return failed;
+}
+
+static void usage( void )
+{
+  fprintf(stderr, "usage: hexbench [-n cycles] [-o results.json] [-l limits.txt]\n");
+  exit(2);
+}
+
+int main( int argc, char ** argv )
+{
+  uint32_t cycles = 4;
+  const char * resultsPath = NULL;
+  const char * limitsPath = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-n") && (i + 1 < argc)) cycles = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-o") && (i + 1 < argc)) resultsPath = argv[++i];
+    else if (!strcmp(argv[i], "-l") && (i + 1 < argc)) limitsPath = argv[++i];
+    else usage();
+  }
+  if (cycles == 0) usage();
+
+  benchStand();
+#if USE_CPG_GAIT
+  benchOscillators("walk", 0x02, cycles);
+  benchOscillators("rotate", 0x10, cycles);
+#else
+  benchGait("walk", 0x02, cycles);
+  benchGait("rotate", 0x10, cycles);
+#endif
+  benchDemo();
+  benchServo();
+  benchCpg(cycles);
+
+  if (resultsPath) writeResults(resultsPath);
+  return (limitsPath && checkLimits(limitsPath)) ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+/*! \file  hexble.c
+*
+* \brief
+* BLE_Configure against scripted Bluetooth modules, host build
+*
+* \details
+*  Runs the boot time module setup of BLEModule.c against the fake module
+*  in SimBLE.c, once per scenario:
+*    hm10-38400   HM-10 found at 38400, moved to 115200, interval set
+*    cc41-9600    CC-41-A found at the 9600 factory rate, moved to 115200
+*    hm10-115200  HM-10 already on the target rate, only reset
+*    none         nothing answers, the UART goes back to UART_DEFAULT_BAUD
+*    reset-silent HM-10 that never answers after AT+RESET, the UART goes
+*                 back to the rate it was found on
+*  and checks the status, the bleInfo_t and the rates the module and the
+*  UART end up on. The exit status is 1 if any scenario went wrong.
+*
+*  usage: hexble [-v] [scenario]
+*
+*  -v prints the AT conversation of each scenario run.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SimBLE.h"
+#include "BLEModule.h"
+#include "UART.h"
+
+typedef struct bleScenario
+{
+  const char *    name;
+  simBleScript_t  script;
+  bleStatus_t     status;       //expected results from here on
+  bleModuleType_t type;
+  uint32_t        foundBaud;
+  uint32_t        baud;
+  uint8_t         intervalSet;
+  uint32_t        moduleBaud;   //where the module is left
+  uint32_t        hostBaud;     //where the UART is left
+} bleScenario_t;
+
+static const bleScenario_t scenarios[] = {
+  { "hm10-38400",   { BLE_MODULE_HM10, 38400, 0 },
+    BLE_STATUS_OK, BLE_MODULE_HM10, 38400, 115200, 1, 115200, 115200 },
+  { "cc41-9600",    { BLE_MODULE_CC41, 9600, 0 },
+    BLE_STATUS_OK, BLE_MODULE_CC41, 9600, 115200, 0, 115200, 115200 },
+  { "hm10-115200",  { BLE_MODULE_HM10, 115200, 0 },
+    BLE_STATUS_OK, BLE_MODULE_HM10, 115200, 115200, 1, 115200, 115200 },
+  { "none",         { BLE_MODULE_NONE, 0, 0 },
+    BLE_STATUS_NO_MODULE, BLE_MODULE_NONE, 0, 0, 0, 0, UART_DEFAULT_BAUD },
+  { "reset-silent", { BLE_MODULE_HM10, 38400, 1 },
+    BLE_STATUS_BAUD_REFUSED, BLE_MODULE_HM10, 38400, 38400, 1, 115200, 38400 }
+};
+#define NUM_SCENARIOS (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static const char * const statusNames[] = { "ok", "no module", "baud refused" };
+static const char * const typeNames[] = { "none", "HM-10", "CC-41" };
+
+static uint8_t check( const char * what, uint32_t got, uint32_t expected )
+{
+  if (got == expected) return 1;
+  printf("    %s is %u, expected %u\n", what, (unsigned)got, (unsigned)expected);
+  return 0;
+}
+
+static uint8_t runScenario( const bleScenario_t * s, uint8_t verbose )
+{
+  bleInfo_t info;
+  bleStatus_t status;
+  uint8_t ok = 1;
+
+  if (verbose) printf("%s:\n", s->name);
+  SimBLE_Load(&s->script, verbose ? stdout : NULL);
+  status = BLE_Configure(&SimBLE_Transport, BLE_TARGET_BAUD, &info);
+
+  printf("%-13s %-12s %-5s found %6u, using %6u, interval %s, %5u ms\n", s->name, statusNames[status],
+         typeNames[info.type], (unsigned)info.foundBaud, (unsigned)info.baud, info.intervalSet ? "set" : "-",
+         (unsigned)SimBLE_Millis());
+  ok &= check("status", status, s->status);
+  ok &= check("module type", info.type, s->type);
+  ok &= check("found baud", info.foundBaud, s->foundBaud);
+  ok &= check("baud in use", info.baud, s->baud);
+  ok &= check("interval set", info.intervalSet, s->intervalSet);
+  ok &= check("module baud", SimBLE_ModuleBaud(), s->moduleBaud);
+  ok &= check("UART baud", SimBLE_HostBaud(), s->hostBaud);
+  return ok;
+}
+
+static void usage( void )
+{
+  fprintf(stderr, "usage: hexble [-v] [scenario]\n  scenarios:");
+  for (uint8_t i = 0; i < NUM_SCENARIOS; i++) fprintf(stderr, " %s", scenarios[i].name);
+  fprintf(stderr, "\n");
+  exit(2);
+}
+
+int main( int argc, char ** argv )
+{
+  const char * only = NULL;
+  uint8_t verbose = 0;
+  uint8_t failed = 0, ran = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-v")) verbose = 1;
+    else if ((argv[i][0] != '-') && !only) only = argv[i];
+    else usage();
+  }
+
+  for (uint8_t i = 0; i < NUM_SCENARIOS; i++) {
+    if (only && strcmp(only, scenarios[i].name)) continue;
+    ran++;
+    if (!runScenario(&scenarios[i], verbose)) failed++;
+  }
+  if (!ran) usage();
+
+  if (failed) printf("%u of %u scenarios failed\n", failed, ran);
+  else printf("all scenarios passed\n");
+  return failed ? 1 : 0;
+}
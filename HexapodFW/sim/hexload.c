@@ -0,0 +1,393 @@
+/*! \file  hexload.c
+*
+* \brief
+* GoBLE controller emulator and load generator for the packet parser
+*
+* \details
+*  Generates GoBLE packets (0x55 0xAA 0x11, buttons, joystick, checksum) at
+*  a given rate, optionally in bursts sent back to back, and damages a
+*  share of them:
+*    corrupt   one byte XORed with a random non zero value
+*    truncate  the frame is cut short, the next one follows straight on
+*    doubled   an extra 0x55, or a whole extra 0x55 0xAA, ahead of a
+*              frame that is otherwise valid
+*
+*  By default the stream goes to the simulated UART and only the link code
+*  runs: checkBlueTooth after every receive interrupt, so each call sees at
+*  most one new frame and the tag SimGoBLE_BuildTagged puts in the frame
+*  tells exactly which one the parser accepted. Reported:
+*    - packets/s accepted against offered, false accepts (damaged bytes that
+*      passed the checksum)
+*    - recovery: valid bytes lost after each damaged frame before the parser
+*      accepts again, 0 when the very next frame gets through
+*    - simulated CPU cycles per packet (receive ISR plus parser) and host
+*      time per packet spent in checkBlueTooth, simulator overhead included
+*  The exit status is 1 when damaged bytes got through as a packet, or when
+*  a clean frame was lost that the UART did not drop (make bench runs a
+*  truncation load for this).
+*
+*  With -p the same stream is written in real time to a pseudo-terminal
+*  instead, the slave name is printed for whatever should read it.
+*
+*  usage: hexload [-t seconds] [-r packets/s] [-b burst] [-w] [-s seed]
+*                 [-c corrupt%] [-k truncate%] [-d doubled%] [-p]
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "Sim.h"
+#include "SimGoBLE.h"
+#include "Timer.h"
+#include "UART.h"
+#include "Bluetooth.h"
+#include "ServoStream.h"
+#include "Script.h"
+
+#define LOAD_BUTTONS  0x02   //forward, the command does not matter to the parser
+#define MAX_BURST     64u
+#define MAX_BACKLOG   1024u  //bytes waiting on the wire before bursts are left out
+
+typedef enum frameKind
+{
+  FRAME_CLEAN,
+  FRAME_CORRUPT,
+  FRAME_TRUNCATED,
+  FRAME_DOUBLED,
+  NUM_FRAME_KINDS
+} frameKind_t;
+
+static const char * const kindNames[NUM_FRAME_KINDS] = { "clean", "corrupted", "truncated", "doubled header" };
+
+typedef struct loadFrame
+{
+  uint32_t offset;     //first byte in the stream
+  uint8_t  length;
+  uint8_t  kind;
+  uint8_t  accepted;
+} loadFrame_t;
+
+typedef struct loadConfig
+{
+  uint32_t seconds;
+  uint32_t rate;
+  uint32_t burst;
+  uint32_t corruptPct;
+  uint32_t truncatePct;
+  uint32_t doubledPct;
+  uint32_t seed;
+  uint8_t  port;
+} loadConfig_t;
+
+extern uint8_t packetData[];   //Bluetooth.c, the last accepted GoBLE frame
+
+static loadFrame_t * frames = NULL;
+static uint32_t numFrames = 0;
+static uint32_t maxFrames = 0;
+static uint32_t streamBytes = 0;
+static uint32_t rngState = 1;
+
+static uint32_t rng( void )
+{
+  //xorshift32, the run is reproducible for a given seed
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static uint8_t nextFrame( const loadConfig_t * cfg, uint8_t * out )
+/*!\brief   Build the next frame of the stream, damaged or not, and log it
+\return bytes written to out (at most GOBLE_MAX_FRAME + 2)
+*/
+{
+  uint8_t frame[GOBLE_MAX_FRAME];
+  uint8_t length = SimGoBLE_BuildTagged(frame, LOAD_BUTTONS, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE, (uint16_t)numFrames);
+  uint32_t pick = rng() % 100u;
+  uint8_t kind = FRAME_CLEAN;
+  uint8_t n = 0;
+
+  if (pick < cfg->corruptPct) {
+    kind = FRAME_CORRUPT;
+    frame[rng() % length] ^= (uint8_t)(1u + (rng() % 255u));
+  } else if (pick < (cfg->corruptPct + cfg->truncatePct)) {
+    kind = FRAME_TRUNCATED;
+    length = (uint8_t)(1u + (rng() % (length - 1u)));
+  } else if (pick < (cfg->corruptPct + cfg->truncatePct + cfg->doubledPct)) {
+    kind = FRAME_DOUBLED;
+    out[n++] = 0x55;
+    if (rng() & 0x01) out[n++] = 0xAA;
+  }
+  memcpy(&out[n], frame, length);
+  n += length;
+
+  if (numFrames == maxFrames) {
+    maxFrames += 4096u;
+    frames = realloc(frames, maxFrames * sizeof(loadFrame_t));
+    if (frames == NULL) {
+      fprintf(stderr, "hexload: out of memory\n");
+      exit(1);
+    }
+  }
+  frames[numFrames].offset = streamBytes;
+  frames[numFrames].length = n;
+  frames[numFrames].kind = kind;
+  frames[numFrames].accepted = 0;
+  numFrames++;
+  streamBytes += n;
+  return n;
+}
+
+static uint32_t nextBurst( const loadConfig_t * cfg, uint8_t * out )
+{
+  uint32_t n = 0;
+
+  for (uint32_t i = 0; i < cfg->burst; i++) n += nextFrame(cfg, &out[n]);
+  return n;
+}
+
+static uint32_t frameOfTag( uint16_t tag, uint32_t after, uint32_t delivered )
+/*!\brief   Map an accepted tag back to the frame it came from
+\details Accepted frames only move forward, and a frame cannot be accepted
+         before its last byte has left the wire. A tag that fits neither came
+         out of damaged bytes (a checksum that matched by accident).
+\param after[in]: frames up to this one were accepted or skipped already
+       delivered[in]: stream bytes that have reached the UART
+\return frame index, numFrames if there is none
+*/
+{
+  uint32_t f;
+
+  //tags wrap at 16 bits, take the newest frame carrying this one
+  f = (numFrames - 1u) - (((numFrames - 1u) - tag) & 0xFFFFu);
+  if ((f >= numFrames) || (f < after) || ((frames[f].offset + frames[f].length) > delivered)) return numFrames;
+  return f;
+}
+
+static double hostNs( void )
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+static void boot( uint8_t port )
+{
+  Sim_Reset();
+  Timer_setUp();
+  ServoStream_Init();
+  Script_Init();
+  BlueTooth_Init();
+  BlueTooth_SetLinkTimeout(0);
+  (void)port;
+}
+
+static int runSim( const loadConfig_t * cfg )
+{
+  uint8_t burst[MAX_BURST * (GOBLE_MAX_FRAME + 2)];
+  gaitCommand_t cmd = BOT_STAND;
+  linkStats_t link;
+  simCoreStats_t coreStart;
+  simCoreStats_t core;
+  simUartStats_t rx;
+  uint32_t lastPackets = 0;
+  uint32_t lastSuperseded = 0;
+  uint32_t coalesced = 0;
+  uint32_t unknown = 0;      //accepted frames that match nothing that was sent
+  uint32_t nextCandidate = 0;
+  uint32_t skipped = 0;      //bursts left out, the line was saturated
+  double parserNs = 0.0;
+
+  boot(cfg->port);
+
+  uint64_t start = Sim_Now();
+  uint64_t end = start + ((uint64_t)cfg->seconds * SIM_SYSCLK_HZ);
+  uint64_t period = ((uint64_t)SIM_SYSCLK_HZ * cfg->burst) / cfg->rate;
+  uint64_t nextAt = start;
+
+  Sim_GetStats(&coreStart);
+  BlueTooth_ResetLinkStats();
+
+  uint64_t stopAt = end;
+
+  while (Sim_Now() < stopAt) {
+    if ((Sim_Now() >= nextAt) && (Sim_Now() < end)) {
+      //above the line rate the wire backs up, leave the burst out instead
+      if (SimUART_Pending(cfg->port) < MAX_BACKLOG) SimUART_Inject(cfg->port, burst, nextBurst(cfg, burst));
+      else skipped++;
+      nextAt += period;
+    }
+
+    double t0 = hostNs();
+    checkBlueTooth(&cmd);
+    parserNs += hostNs() - t0;
+
+    BlueTooth_GetLinkStats(&link);
+    if (link.packets != lastPackets) {
+      uint32_t f = frameOfTag(SimGoBLE_Tag(packetData), nextCandidate, streamBytes - SimUART_Pending(cfg->port));
+
+      if (f == numFrames) {
+        unknown++;
+        f = nextCandidate;
+      } else {
+        frames[f].accepted = 1;
+        nextCandidate = f + 1;
+      }
+
+      //more than one frame in a call: the older ones are not visible, credit
+      //the nearest unaccepted clean frames before the newest
+      for (uint32_t extra = link.superseded - lastSuperseded; extra && (f > 0); ) {
+        f--;
+        if ((frames[f].kind != FRAME_CORRUPT) && (frames[f].kind != FRAME_TRUNCATED) && !frames[f].accepted) {
+          frames[f].accepted = 1;
+          extra--;
+          coalesced++;
+        }
+      }
+      lastPackets = link.packets;
+      lastSuperseded = link.superseded;
+    }
+    //run on past the end until the receive timeout has handed over the tail
+    if (SimUART_Pending(cfg->port) && ((Sim_Now() + (SIM_SYSCLK_HZ / 100u)) > stopAt)) {
+      stopAt = Sim_Now() + (SIM_SYSCLK_HZ / 100u);
+    }
+    SimReg_Idle();
+  }
+
+  Sim_GetStats(&core);
+  SimUART_GetStats(cfg->port, &rx);
+  BlueTooth_GetLinkStats(&link);
+
+  uint32_t sent[NUM_FRAME_KINDS] = {0};
+  uint32_t accepted = 0;
+  uint32_t falseAccepts = unknown;
+  uint32_t cleanLost = 0;
+  uint32_t damaged = 0;
+  uint32_t recovered = 0;
+  uint64_t recoverySum = 0;
+  uint32_t recoveryMax = 0;
+  uint64_t busy = (Sim_Now() - start) - (core.idleCycles - coreStart.idleCycles);
+
+  for (uint32_t i = 0; i < numFrames; i++) {
+    uint8_t bad = (frames[i].kind == FRAME_CORRUPT) || (frames[i].kind == FRAME_TRUNCATED);
+
+    sent[frames[i].kind]++;
+    if (frames[i].accepted) accepted++;
+    if (bad && frames[i].accepted) falseAccepts++;
+    if (!bad && !frames[i].accepted) cleanLost++;
+    if (!bad) continue;
+
+    //valid bytes lost between the end of the damage and the next accepted frame
+    damaged++;
+    uint32_t j = i + 1;
+    uint32_t lost = 0;
+    while ((j < numFrames) && !frames[j].accepted) {
+      if ((frames[j].kind != FRAME_CORRUPT) && (frames[j].kind != FRAME_TRUNCATED)) lost += frames[j].length;
+      j++;
+    }
+    if (j == numFrames) continue;   //stream ended first
+    recovered++;
+    recoverySum += lost;
+    if (lost > recoveryMax) recoveryMax = lost;
+  }
+
+  printf("stream              %s, %u packets/s in bursts of %u, seed %u\n",
+         (cfg->port == UART_PORT_WIRED) ? "UART0" : "UART1", cfg->rate, cfg->burst, cfg->seed);
+  printf("frames              %u sent, %u bytes:", numFrames, streamBytes);
+  for (uint8_t k = 0; k < NUM_FRAME_KINDS; k++) printf("%s %u %s", k ? "," : "", sent[k], kindNames[k]);
+  printf("\n");
+  printf("parser              %u accepted (%.1f/s), %u errors, %u false accepts, %u coalesced\n",
+         accepted, (double)accepted / cfg->seconds, link.errors, falseAccepts, coalesced);
+  printf("recovery            %u damaged frames, valid bytes lost after them: mean %.2f, max %u\n",
+         damaged, recovered ? (double)recoverySum / recovered : 0.0, recoveryMax);
+  printf("lost                %u valid frames not accepted, %u bytes dropped by the UART\n", cleanLost, rx.rxDropped);
+  if (skipped) printf("saturated           %u bursts left out, the offered rate is above the line rate\n", skipped);
+  printf("cost                %.0f sim cycles per packet (rx ISR + parser), %.0f host ns per packet\n",
+         numFrames ? (double)busy / numFrames : 0.0, accepted ? parserNs / accepted : 0.0);
+  return ((falseAccepts != 0) || ((cleanLost != 0) && (rx.rxDropped == 0))) ? 1 : 0;
+}
+
+static int runPty( const loadConfig_t * cfg )
+{
+  uint8_t burst[MAX_BURST * (GOBLE_MAX_FRAME + 2)];
+  struct termios raw;
+  struct timespec next;
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  int slave;
+
+  if ((master < 0) || grantpt(master) || unlockpt(master)) {
+    perror("hexload: pty");
+    return 1;
+  }
+  //hold the slave open so writes do not fail before a reader attaches
+  slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if ((slave < 0) || tcgetattr(slave, &raw)) {
+    perror("hexload: pty");
+    return 1;
+  }
+  cfmakeraw(&raw);
+  tcsetattr(slave, TCSANOW, &raw);
+  printf("writing to %s for %u s\n", ptsname(master), cfg->seconds);
+  fflush(stdout);
+
+  uint64_t periodNs = (1000000000ull * cfg->burst) / cfg->rate;
+  uint32_t bursts = (uint32_t)(((uint64_t)cfg->seconds * 1000000000ull) / periodNs);
+
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for (uint32_t b = 0; b < bursts; b++) {
+    uint32_t n = nextBurst(cfg, burst);
+    if (write(master, burst, n) != (ssize_t)n) {
+      perror("hexload: write");
+      return 1;
+    }
+    next.tv_nsec += (long)periodNs;
+    while (next.tv_nsec >= 1000000000L) {
+      next.tv_nsec -= 1000000000L;
+      next.tv_sec++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  printf("%u frames, %u bytes\n", numFrames, streamBytes);
+  close(slave);
+  close(master);
+  return 0;
+}
+
+static void usage( void )
+{
+  fprintf(stderr, "usage: hexload [-t seconds] [-r packets/s] [-b burst] [-w] [-s seed]\n"
+                  "               [-c corrupt%%] [-k truncate%%] [-d doubled%%] [-p]\n");
+  exit(2);
+}
+
+int main( int argc, char ** argv )
+{
+  loadConfig_t cfg = { 10, 20, 1, 0, 0, 0, 1, UART_PORT_BT };
+  uint8_t pty = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t") && (i + 1 < argc)) cfg.seconds = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && (i + 1 < argc)) cfg.rate = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) cfg.burst = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-c") && (i + 1 < argc)) cfg.corruptPct = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-k") && (i + 1 < argc)) cfg.truncatePct = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-d") && (i + 1 < argc)) cfg.doubledPct = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-s") && (i + 1 < argc)) cfg.seed = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-w")) cfg.port = UART_PORT_WIRED;
+    else if (!strcmp(argv[i], "-p")) pty = 1;
+    else usage();
+  }
+  if ((cfg.rate == 0) || (cfg.seconds == 0) || (cfg.burst == 0) || (cfg.burst > MAX_BURST) ||
+      ((cfg.corruptPct + cfg.truncatePct + cfg.doubledPct) > 100)) usage();
+  rngState = cfg.seed ? cfg.seed : 1;
+
+  return pty ? runPty(&cfg) : runSim(&cfg);
+}
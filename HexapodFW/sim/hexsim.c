@@ -0,0 +1,322 @@
+/*! \file  hexsim.c
+*
+* \brief
+* Host harness: boots the firmware on the virtual register map, drives it
+* with controller packets and reports timing
+*
+* \details
+*  Boot follows main.c (without the demo unless -d), then the main loop runs
+*  exactly as on the bot with SimReg_Idle standing in for the spare CPU time.
+*  After one second of standing, GoBLE packets for the chosen command are
+*  injected at the given rate on the Bluetooth UART (or the wired one).
+*
+*  usage: hexsim [-t seconds] [-c stand|fwd|back|left|right|fight]
+*                [-r packets/s] [-w] [-d] [-a cycles/access]
+*                [-o trace.csv] [-j trace.json]
+*                [-f dump.bin [-b runs back]] [-F dump.bin]
+*                [-v pack mV[:end mV]] [-g knee deg[,...]]
+*                [-p deg/s[:blocked servo[@deg]]]
+*
+*  -o and -j record every gait phase and servo output change after boot
+*  (SimTrace.c) and write them as CSV or Chrome trace JSON.
+*
+*  -f replays the commands of a flight recorder dump captured on the bot
+*  (SimReplay.c) instead of -c, then prints the field log and the log of the
+*  simulated run. -F writes the simulated run's log in the same dump format.
+*
+*  -v sets the pack voltage the battery monitor (Battery.c) measures, moving
+*  in a straight line to the end value over the run when one is given.
+*
+*  -g sets the knee angle at which the feet meet the ground, one value for
+*  every leg or six comma separated (SimContact.c). Built with CONTACT=1 the
+*  tripod set phases end when the knee current shows the feet landed.
+*
+*  -p feeds the servo feedback pots (SimFeedback.c) with the servos moving at
+*  the given speed, one of them optionally stuck at an angle (90 unless
+*  given). Built with FEEDBACK=1 the tripod phases advance on the measured
+*  joint positions, and on FEEDBACK_TIMEOUT past a stuck joint.
+*
+*  Reported figures are bus and peripheral bound: the simulator charges
+*  cycles for register accesses and waits but not for the arithmetic in
+*  between, so real loop times are this plus the compute part.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Sim.h"
+#include "SimGoBLE.h"
+#include "SimTrace.h"
+#include "SimHarness.h"
+#include "UART.h"
+#include "Bluetooth.h"
+#include "Control.h"
+#include "Profile.h"
+#include "Timer.h"
+#include "SimReplay.h"
+#include "Battery.h"
+#include "Contact.h"
+#include "SimContact.h"
+#include "SimFeedback.h"
+#include "Feedback.h"
+
+#define STAND_SECONDS  1u
+
+typedef struct simCommand
+{
+  const char * name;
+  uint8_t buttons;
+  uint8_t joyX;
+  uint8_t joyY;
+} simCommand_t;
+
+static const simCommand_t commands[] = {
+  { "stand", 0x20, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE },
+  { "fwd",   0x02, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE },
+  { "back",  0x08, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE },
+  { "left",  0x10, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE },
+  { "right", 0x04, GOBLE_JOY_CENTRE, GOBLE_JOY_CENTRE },
+  { "fight", 0x60, 200, 160 }
+};
+#define NUM_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+#if PROFILE_ENABLE
+static void printProfile( void )
+{
+  static const char * const names[PROF_NUM_REGIONS] = {
+    "loop", "GaitHandler", "packet", "setServo", "CommitServos",
+    "I2C_WriteByte", "I2C_WriteBytes", "I2C_Read", "I2C_WriteBurst"
+  };
+
+  printf("\n%-16s %8s %8s %8s %10s   (cycles)\n", "region", "count", "min", "max", "mean");
+  for (uint8_t r = 0; r < PROF_NUM_REGIONS; r++) {
+    profStats_t stats;
+    Profile_Get((profRegion_t)r, &stats);
+    if (stats.count == 0) continue;
+    printf("%-16s %8u %8u %8u %10.1f\n", names[r], stats.count, stats.min, stats.max,
+           (double)stats.total / stats.count);
+  }
+}
+#endif
+
+static void usage( void )
+{
+  fprintf(stderr, "usage: hexsim [-t seconds] [-c stand|fwd|back|left|right|fight]\n"
+                  "              [-r packets/s] [-w] [-d] [-a cycles/access]\n"
+                  "              [-o trace.csv] [-j trace.json]\n"
+                  "              [-f dump.bin [-b runs back]] [-F dump.bin]\n"
+                  "              [-v pack mV[:end mV]] [-g knee deg[,...]]\n"
+                  "              [-p deg/s[:blocked servo[@deg]]]\n");
+  exit(2);
+}
+
+static uint32_t packStartMv = 0;   //0: leave the harness default
+static uint32_t packEndMv = 0;
+static uint64_t packFrom, packTo;
+static int groundDeg[NUM_LEGS];
+static uint8_t groundCount = 0;   //0: flat, SIM_GROUND_DEG
+static uint32_t potDps = 0;       //0: no pots
+static uint32_t potBlocked = SIM_FB_NONE;
+static uint32_t potStuckDeg = SIM_FB_STUCK_DEG;
+
+static void step( void )
+{
+  if (packStartMv) {
+    uint64_t now = Sim_Now();
+    int64_t mv = packStartMv;
+    if (now >= packTo) mv = packEndMv;
+    else if (now > packFrom) mv += ((int64_t)packEndMv - packStartMv) * (int64_t)(now - packFrom) / (int64_t)(packTo - packFrom);
+    SimADC_SetInput(BATTERY_AIN, (uint16_t)(mv / BATTERY_DIVIDER));
+  }
+  SimHarness_Step();
+}
+
+static void writeTrace( const char * path, void (*writer)( FILE * out ) )
+{
+  FILE * out = fopen(path, "w");
+
+  if (out == NULL) {
+    fprintf(stderr, "hexsim: cannot write %s\n", path);
+    exit(1);
+  }
+  writer(out);
+  fclose(out);
+}
+
+int main( int argc, char ** argv )
+{
+  uint32_t seconds = 5;
+  uint32_t rate = 10;
+  uint8_t port = UART_PORT_BT;
+  uint8_t runDemo = 0;
+  const simCommand_t * cmd = &commands[1];
+  const char * csvPath = NULL;
+  const char * jsonPath = NULL;
+  const char * replayPath = NULL;
+  const char * dumpPath = NULL;
+  uint32_t runsBack = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t") && (i + 1 < argc)) seconds = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-r") && (i + 1 < argc)) rate = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-a") && (i + 1 < argc)) Sim_SetAccessCycles((uint32_t)atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-o") && (i + 1 < argc)) csvPath = argv[++i];
+    else if (!strcmp(argv[i], "-j") && (i + 1 < argc)) jsonPath = argv[++i];
+    else if (!strcmp(argv[i], "-f") && (i + 1 < argc)) replayPath = argv[++i];
+    else if (!strcmp(argv[i], "-F") && (i + 1 < argc)) dumpPath = argv[++i];
+    else if (!strcmp(argv[i], "-b") && (i + 1 < argc)) runsBack = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-v") && (i + 1 < argc)) {
+      const char * colon = strchr(argv[++i], ':');
+      packStartMv = (uint32_t)atoi(argv[i]);
+      packEndMv = colon ? (uint32_t)atoi(colon + 1) : packStartMv;
+      if ((packStartMv == 0) || (packEndMv == 0)) usage();
+    }
+    else if (!strcmp(argv[i], "-g") && (i + 1 < argc)) {
+      char * next = argv[++i];
+      for (groundCount = 0; groundCount < NUM_LEGS; ) {
+        groundDeg[groundCount++] = (int)strtol(next, &next, 10);
+        if (*next != ',') break;
+        next++;
+      }
+      if ((*next != '\0') || ((groundCount != 1) && (groundCount != NUM_LEGS))) usage();
+    }
+    else if (!strcmp(argv[i], "-p") && (i + 1 < argc)) {
+      const char * colon = strchr(argv[++i], ':');
+      const char * at = strchr(argv[i], '@');
+      potDps = (uint32_t)atoi(argv[i]);
+      potBlocked = colon ? (uint32_t)atoi(colon + 1) : SIM_FB_NONE;
+      if (at) potStuckDeg = (uint32_t)atoi(at + 1);
+      if ((potDps == 0) || (potDps > 0xFFFF) || (colon && (potBlocked >= SERVO_COUNT)) ||
+          (at && (!colon || (at < colon) || (potStuckDeg > 180)))) usage();
+    }
+    else if (!strcmp(argv[i], "-w")) port = UART_PORT_WIRED;
+    else if (!strcmp(argv[i], "-d")) runDemo = 1;
+    else if (!strcmp(argv[i], "-c") && (i + 1 < argc)) {
+      const char * name = argv[++i];
+      cmd = NULL;
+      for (uint32_t c = 0; c < NUM_COMMANDS; c++) {
+        if (!strcmp(name, commands[c].name)) cmd = &commands[c];
+      }
+      if (cmd == NULL) usage();
+    }
+    else usage();
+  }
+  if ((rate == 0) || (seconds <= STAND_SECONDS)) usage();
+  if (replayPath && (SimReplay_Load(replayPath, runsBack) == 0)) {
+    fprintf(stderr, "hexsim: no recorder run in %s\n", replayPath);
+    return 1;
+  }
+
+  SimHarness_Boot(runDemo);
+  for (uint8_t leg = 0; groundCount && (leg < NUM_LEGS); leg++) {
+    SimContact_SetGround(leg, (uint8_t)groundDeg[(groundCount == 1) ? 0 : leg]);
+  }
+  if (potDps) SimFeedback_Start((uint16_t)potDps, (uint8_t)potBlocked, (uint8_t)potStuckDeg);
+
+  uint64_t bootDone = Sim_Now();
+  uint64_t commandAt = bootDone + ((uint64_t)STAND_SECONDS * SIM_SYSCLK_HZ);
+  uint64_t end = bootDone + ((uint64_t)seconds * SIM_SYSCLK_HZ);
+  simI2cStats_t busStart;
+  simI2cStats_t bus;
+
+  packFrom = bootDone;
+  packTo = end;
+  if (csvPath || jsonPath) SimTrace_Start();
+  SimI2C_GetStats(&busStart);
+  Control_ResetStats();
+
+  if (replayPath) {
+    //log times are milliseconds after boot, run on for a second after the last one
+    commandAt = bootDone;
+    end = ((uint64_t)SimReplay_EndMs() + 1000u) * (SIM_SYSCLK_HZ / 1000u);
+    if (end <= bootDone) end = bootDone + SIM_SYSCLK_HZ;
+    packTo = end;
+    while (Sim_Now() < end) {
+      SimReplay_Service(port, rate, Timer_millis());
+      step();
+    }
+  }
+  else {
+    while (Sim_Now() < commandAt) step();
+    SimHarness_Command(port, cmd->buttons, cmd->joyX, cmd->joyY, rate);
+    while (Sim_Now() < end) step();
+  }
+
+  SimTrace_Stop();
+
+  controlStats_t control;
+  linkStats_t link;
+  simCoreStats_t core;
+  simUartStats_t rx;
+  batteryStatus_t battery;
+  double runSeconds = (double)(end - bootDone) / SIM_SYSCLK_HZ;
+  double walkSeconds = (double)(end - commandAt) / SIM_SYSCLK_HZ;
+
+  Control_GetStats(&control);
+  BlueTooth_GetLinkStats(&link);
+  Sim_GetStats(&core);
+  SimUART_GetStats(port, &rx);
+  Battery_GetStatus(&battery);
+  SimI2C_GetStats(&bus);
+  bus.transactions -= busStart.transactions;
+  bus.bytes -= busStart.bytes;
+  bus.frames -= busStart.frames;
+  bus.channelWrites -= busStart.channelWrites;
+  bus.busyCycles -= busStart.busyCycles;
+
+  printf("command             %s on %s, %u packets at %u/s\n", replayPath ? "replay" : cmd->name,
+         (port == UART_PORT_WIRED) ? "UART0" : "UART1", SimHarness_PacketsSent(), rate);
+  printf("boot                %.1f ms\n", (double)bootDone / (SIM_SYSCLK_HZ / 1000u));
+  printf("control ticks       %u (%u overruns), period %u us\n", control.ticks, control.overruns, control.periodUs);
+  printf("loop time           last %u us, max %u us\n", control.lastLoopUs, control.maxLoopUs);
+  printf("input to commit     last %u us, max %u us, %u late\n", control.lastInputUs, control.maxInputUs, control.lateInputs);
+  printf("command latency     %.2f ms (first byte on the wire to first output change)\n",
+         SimHarness_Latency() ? (double)SimHarness_Latency() / (SIM_SYSCLK_HZ / 1000u) : -1.0);
+  printf("packets             %u accepted, %u errors, %u rx bytes, %u dropped\n",
+         link.packets, link.errors, rx.rxBytes, rx.rxDropped);
+  printf("i2c                 %u transactions, %u bytes, %.1f%% bus busy\n", bus.transactions, bus.bytes,
+         100.0 * (double)bus.busyCycles / ((double)runSeconds * SIM_SYSCLK_HZ));
+  printf("servo frames        %u (%.1f/s), %u output changes\n", bus.frames, bus.frames / runSeconds, bus.channelWrites);
+  printf("gait cycles         %u (%.2f/s while commanded)\n", SimHarness_GaitCycles(), SimHarness_GaitCycles() / walkSeconds);
+  printf("battery             %u mV, %u%% gait, %s, %u cutoffs, %u samples\n", battery.packMv, battery.scale,
+         (battery.level == BATTERY_CUTOFF) ? "cutoff" : (battery.level == BATTERY_LOW) ? "low" :
+         (battery.level == BATTERY_OK) ? "ok" : "no sample", battery.cutoffs, battery.samples);
+#if FOOT_CONTACT_ENABLED
+  contactStats_t contact;
+  Contact_GetStats(&contact);
+  printf("foot contact        %u of %u set phases ended on landing\n", contact.touches, contact.arms);
+#endif
+  if (potDps) {
+    printf("position feedback   %u blocks, servos at %u deg/s", SimFeedback_Blocks(), potDps);
+    if (potBlocked != SIM_FB_NONE) {
+      printf(", servo %u stuck at %d (target %d)", potBlocked, SimFeedback_Angle((uint8_t)potBlocked),
+             ServoModel_Target((uint8_t)potBlocked));
+    }
+    printf(", %s\n", Feedback_Arrived(ALL_SERVOS, Timer_millis()) ? "all arrived" : "moving");
+  }
+  printf("register accesses   %llu, %llu irqs\n", (unsigned long long)core.accesses, (unsigned long long)core.irqs);
+#if PROFILE_ENABLE
+  printProfile();
+#endif
+
+  if (csvPath || jsonPath) {
+    printf("trace               %u events\n\n", SimTrace_Count());
+    SimTrace_Summary(stdout);
+    if (csvPath) writeTrace(csvPath, SimTrace_WriteCsv);
+    if (jsonPath) writeTrace(jsonPath, SimTrace_WriteChrome);
+  }
+  if (replayPath) {
+    printf("\nfield log\n");
+    SimReplay_PrintLoaded(stdout);
+    printf("\nsimulated log\n");
+    SimReplay_PrintSim(stdout, 0);
+  }
+  if (dumpPath && (SimReplay_WriteDump(dumpPath) != 0)) {
+    fprintf(stderr, "hexsim: cannot write %s\n", dumpPath);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+/*! \file  tm4c123gh6pm.h
+*
+* \brief
+* Host build stand-in for the TI device header
+*
+* \details
+*  Only the registers the simulated drivers use, at their real addresses,
+*  routed through HWREG so they land in the virtual register map. A driver
+*  that needs another register fails to compile here instead of silently
+*  touching host memory.
+*
+******************************************************************************/
+
+#ifndef __TM4C123GH6PM_H__
+#define __TM4C123GH6PM_H__
+
+#include "HWReg.h"
+
+#define GPIO_PORTA_AFSEL_R      HWREG(0x40004420)
+#define GPIO_PORTA_ODR_R        HWREG(0x4000450C)
+#define GPIO_PORTA_PUR_R        HWREG(0x40004510)
+#define GPIO_PORTA_DEN_R        HWREG(0x4000451C)
+#define GPIO_PORTA_PCTL_R       HWREG(0x4000452C)
+
+#define GPIO_PORTB_AFSEL_R      HWREG(0x40005420)
+#define GPIO_PORTB_DEN_R        HWREG(0x4000551C)
+#define GPIO_PORTB_AMSEL_R      HWREG(0x40005528)
+
+#define I2C1_MSA_R              HWREG(0x40021000)
+#define I2C1_MCS_R              HWREG(0x40021004)
+#define I2C1_MDR_R              HWREG(0x40021008)
+#define I2C1_MTPR_R             HWREG(0x4002100C)
+#define I2C1_MCR_R              HWREG(0x40021020)
+
+#define GPIO_PORTE_AFSEL_R      HWREG(0x40024420)
+#define GPIO_PORTE_DEN_R        HWREG(0x4002451C)
+#define GPIO_PORTE_AMSEL_R      HWREG(0x40024528)
+
+#define TIMER1_CFG_R            HWREG(0x40031000)
+#define TIMER1_TAMR_R           HWREG(0x40031004)
+#define TIMER1_CTL_R            HWREG(0x4003100C)
+#define TIMER1_IMR_R            HWREG(0x40031018)
+#define TIMER1_ICR_R            HWREG(0x40031024)
+#define TIMER1_TAILR_R          HWREG(0x40031028)
+
+#define ADC1_ACTSS_R            HWREG(0x40039000)
+#define ADC1_RIS_R              HWREG(0x40039004)
+#define ADC1_IM_R               HWREG(0x40039008)
+#define ADC1_ISC_R              HWREG(0x4003900C)
+#define ADC1_EMUX_R             HWREG(0x40039014)
+#define ADC1_SAC_R              HWREG(0x40039030)
+#define ADC1_SSMUX2_R           HWREG(0x40039080)
+#define ADC1_SSCTL2_R           HWREG(0x40039084)
+#define ADC1_SSFIFO2_R          HWREG(0x40039088)
+#define ADC1_SSMUX3_R           HWREG(0x400390A0)
+#define ADC1_SSCTL3_R           HWREG(0x400390A4)
+#define ADC1_SSFIFO3_R          HWREG(0x400390A8)
+
+#define FLASH_FMA_R             HWREG(0x400FD000)
+#define FLASH_FMD_R             HWREG(0x400FD004)
+#define FLASH_FMC_R             HWREG(0x400FD008)
+#define FLASH_FCRIS_R           HWREG(0x400FD00C)
+#define FLASH_FCMISC_R          HWREG(0x400FD014)
+
+#define EEPROM_EESIZE_R         HWREG(0x400AF000)
+#define EEPROM_EEBLOCK_R        HWREG(0x400AF004)
+#define EEPROM_EEOFFSET_R       HWREG(0x400AF008)
+#define EEPROM_EERDWR_R         HWREG(0x400AF010)
+#define EEPROM_EERDWRINC_R      HWREG(0x400AF014)
+#define EEPROM_EEDONE_R         HWREG(0x400AF018)
+#define EEPROM_EESUPP_R         HWREG(0x400AF01C)
+
+#define SYSCTL_RESC_R           HWREG(0x400FE05C)
+#define SYSCTL_RCGC2_R          HWREG(0x400FE108)
+#define FLASH_BOOTCFG_R         HWREG(0x400FE1D0)
+#define SYSCTL_SREEPROM_R       HWREG(0x400FE558)
+#define SYSCTL_RCGCTIMER_R      HWREG(0x400FE604)
+#define SYSCTL_RCGCGPIO_R       HWREG(0x400FE608)
+#define SYSCTL_RCGCI2C_R        HWREG(0x400FE620)
+#define SYSCTL_RCGCADC_R        HWREG(0x400FE638)
+#define SYSCTL_RCGCEEPROM_R     HWREG(0x400FE658)
+#define SYSCTL_PRTIMER_R        HWREG(0x400FEA04)
+#define SYSCTL_PRADC_R          HWREG(0x400FEA38)
+#define SYSCTL_PREEPROM_R       HWREG(0x400FEA58)
+
+#endif
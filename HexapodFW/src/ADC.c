@@ -1,61 +1,124 @@
-/*
-Module to Control ADC.
-*/
+/*! \file  ADC.c
+*
+* \brief
+* ADC0 driver for the servo position feedback pots
+*
+* \details
+*  Sample sequencer 0 converts all FB_NUM_STEPS feedback inputs back to back,
+*  continuously, with 64x hardware averaging per step. uDMA channel 14 moves
+*  each frame out of the sequencer FIFO into a ring of FB_RING_FRAMES frames
+*  using ping-pong mode, so the CPU never touches individual samples. When a
+*  half of the ring fills up the sequencer interrupt hands it to
+*  Feedback_ProcessBlock and re-arms that half while the other one fills.
+*
+* \author vsimontov
+*
+* \info
+* Based on TIVA User Reference manual, starting on pg.799
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
 
 #include <stdint.h>
 #include <stdio.h>
 #include "ADC.h"
 #include "Timer.h"
-#include "GPIO.h"
+#include "uDMA.h"
 #include <tm4c123gh6pm.h>
-#include <stdint.h>
-#include <stdio.h>
 
-#if 0 // Stub out ADC codes
-void ADC0_Handler( void ){
-  volatile int result = SSFIFO3;
-  float vref= (((float)result) *3.3)/4095.0;
-  float temp = ((2.7-vref)*75.0) - 55.0;
-  
-  if (temp > 0 && temp < 17)    
-    GPIO_LED_ON(RED_LED);
-  else if (temp > 17 && temp < 19)  
-    GPIO_LED_ON(BLUE_LED);
-  else if (temp > 19 && temp < 21)   
-    GPIO_LED_ON(VIOLET_LED);
-  else if (temp > 21 && temp < 23)   
-    GPIO_LED_ON(GREEN_LED);
-  else if (temp > 23 && temp < 25)   
-    GPIO_LED_ON(YELLOW_LED);
-  else if (temp > 25 && temp < 27)   
-    GPIO_LED_ON(LBLUE_LED);
-  else if (temp > 27)               
-    GPIO_LED_ON(WHITE_LED);
-  else GPIO_LED_OFF();
-  
-  ADCISC |= IN3; //Clear the interrupt
+#define HALF_SAMPLES (FB_FRAMES_PER_HALF * FB_NUM_STEPS)
+#define RING_DMA_CTL (UDMA_DST_INC_16 | UDMA_DST_SIZE_16 | UDMA_SRC_INC_NONE | \
+                      UDMA_SRC_SIZE_16 | UDMA_ARB_8 | UDMA_MODE_PINGPONG)
 
-}
+void ADC0Seq0_Handler( void ); /* Protoype def*/
+
+// AIN input sampled by each sequencer step, see Feedback_Init for the servo map
+static const uint8_t stepInput[FB_NUM_STEPS] = {0, 1, 2, 3, 4, 5, 6, 7};
 
-void ADC0_ModuleInit(void){
-  RCGC0ADC|=EN_ADC0;
-  GPIO_configPortE();
-  ADCSSPRI = (ADCSSPRI & ~PRI_SS3); //Set priority of Sequencer 3 to 0 (highest)
-  
-  ADCSSPRI |=(0x3); //Set Sequencer 0 priority from 0 to 3
+static uint16_t adcRing[FB_RING_FRAMES * FB_NUM_STEPS];
+static volatile uint32_t frameCount = 0;
+
+void ADC0Seq0_Handler( void )
+/*!\brief   ISR for sample sequencer 0
+\details Runs at the end of every sequence; only does work when the uDMA has
+         completed one half of the ring. That half is processed and re-armed
+         while the controller fills the other one.
+\return none
+*/
+{
+  ADC0_ISC_R = ADC_ISC_IN0;   //Clear the interrupt
+
+  if (uDMA_TransferDone(ADC0SS0_DMA_CH, UDMA_PRIMARY)) {
+    Feedback_ProcessBlock(&adcRing[0], FB_FRAMES_PER_HALF, Timer_millis());
+    uDMA_SetTransfer(ADC0SS0_DMA_CH, UDMA_PRIMARY, &ADC0_SSFIFO0_R, &adcRing[0],
+                     RING_DMA_CTL, HALF_SAMPLES);
+    frameCount += FB_FRAMES_PER_HALF;
+  }
+  if (uDMA_TransferDone(ADC0SS0_DMA_CH, UDMA_ALTERNATE)) {
+    Feedback_ProcessBlock(&adcRing[HALF_SAMPLES], FB_FRAMES_PER_HALF, Timer_millis());
+    uDMA_SetTransfer(ADC0SS0_DMA_CH, UDMA_ALTERNATE, &ADC0_SSFIFO0_R, &adcRing[HALF_SAMPLES],
+                     RING_DMA_CTL, HALF_SAMPLES);
+    frameCount += FB_FRAMES_PER_HALF;
+  }
 }
 
-void ADC0_SequencerInit(void){
-  ADCACTSS = (ADCACTSS & ~0xF); //Disable all sequencers
-  ADCEMUX |= TIMER_EVNT;
-   ADCSSCTL3 |= (TS0|IE0|END0);
-   ADCIM   |= MASK3;
-   ADCACTSS |= ASEN3;
-   //ADC0PSSI |= (0x01 << 3); 
+void ADC_Init(void)
+/*!\brief   Start continuous feedback sampling on ADC0 sequencer 0
+\details Configures the analog pins, the sequencer (always trigger, hardware
+         averaging, END/IE on the last step) and the ping-pong uDMA ring.
+\return none
+*/
+{
+  uint32_t mux = 0;
+
+  Feedback_Init();
+
+  //1. Clock the ADC and the GPIO ports carrying the analog inputs
+  SYSCTL_RCGCADC_R |= 0x01;
+  SYSCTL_RCGCGPIO_R |= (GPIO_PORTD_CLK | GPIO_PORTE_CLK);
+  while ((SYSCTL_PRADC_R & 0x01) == 0);
+
+  //2. Analog function on the feedback pins, digital buffers off
+  GPIO_PORTD_AFSEL_R |= FB_AIN_PORTD_PINS;
+  GPIO_PORTD_DEN_R   &= ~FB_AIN_PORTD_PINS;
+  GPIO_PORTD_AMSEL_R |= FB_AIN_PORTD_PINS;
+  GPIO_PORTE_AFSEL_R |= FB_AIN_PORTE_PINS;
+  GPIO_PORTE_DEN_R   &= ~FB_AIN_PORTE_PINS;
+  GPIO_PORTE_AMSEL_R |= FB_AIN_PORTE_PINS;
+
+  //3. Sequencer 0: disabled while configuring, always triggered, 64x averaging
+  ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN0;
+  ADC0_SAC_R = ADC_HW_AVG_64;
+  ADC0_EMUX_R = (ADC0_EMUX_R & ~ADC_EMUX_EM0_M) | ADC_EMUX_ALWAYS;
+
+  for (uint8_t step = 0; step < FB_NUM_STEPS; step++) {
+    mux |= ((uint32_t)stepInput[step] << (4 * step));
+  }
+  ADC0_SSMUX0_R = mux;
+  ADC0_SSCTL0_R = ((uint32_t)(ADC_SSCTL_END | ADC_SSCTL_IE)) << (4 * (FB_NUM_STEPS - 1));
+
+  //4. Ping-pong ring on uDMA channel 14
+  uDMA_Init();
+  uDMA_AssignChannel(ADC0SS0_DMA_CH, 0);
+  uDMA_SetTransfer(ADC0SS0_DMA_CH, UDMA_PRIMARY, &ADC0_SSFIFO0_R, &adcRing[0],
+                   RING_DMA_CTL, HALF_SAMPLES);
+  uDMA_SetTransfer(ADC0SS0_DMA_CH, UDMA_ALTERNATE, &ADC0_SSFIFO0_R, &adcRing[HALF_SAMPLES],
+                   RING_DMA_CTL, HALF_SAMPLES);
+  uDMA_EnableChannel(ADC0SS0_DMA_CH);
+
+  //5. Interrupt to collect completed halves, then start sampling
+  ADC0_ISC_R = ADC_ISC_IN0;
+  ADC0_IM_R |= ADC_IM_MASK0;
+  ENABLEINT = ADC0SS0_INT;
+  ADC0_ACTSS_R |= ADC_ACTSS_ASEN0;
 }
-void ADC_Init(void){
-  ADC0_ModuleInit();
-  ADC0_SequencerInit();
-  ENABLEINT |= ADC0_INT;
+
+uint32_t ADC_FrameCount(void)
+/*!\brief   Number of feedback frames processed since ADC_Init
+\return frame count
+*/
+{
+  return frameCount;
 }
-#endif
\ No newline at end of file
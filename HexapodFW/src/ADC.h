@@ -1,55 +1,43 @@
-#if !defined(ADC_H) 
-#define ADC_H
-
-#define ADC0_BASE       (0x40038000)
-
-
-#define RCGCADC      (*((volatile uint32_t *)  0x400FE638)) 
-  #define ENABLE_ADC0     (0x01)
-
-#define RCGC0ADC      (*((volatile uint32_t *)  0x400FE100)) 
-  #define EN_ADC0     (0x01 << 16)
-
-#define ADCIM        (*((volatile uint32_t *) (ADC0_BASE + 0x008)))
-  #define MASK3           (0x01 << 3)        //pg827 The raw interrupt signal from Sample Sequencer 3 (ADCRIS register INR0 bit
-
-
-
-#define ADCEMUX       (*((volatile uint32_t *) (ADC0_BASE + 0x014)))
-  #define TIMER_EVNT      (0x5 << 12)   //EM3 bit of ADCEMUX pg.837
-
-
-#define ADCACTSS      (*((volatile uint32_t *) (ADC0_BASE + 0x000))) //pg 821 ADC Active Sample Sequencer (ADCACTSS), offset 0x000 This register controls the activation of the sample sequencers. Each sample sequencer can be enabled or disabled independently.
-  #define BUSY            (0x01 << 16)  //for ADCACTSS, pg 821
-  #define ASEN3           (0x01 << 3)   //Enable Sequencer 3 for ADCACTSS, pg 821
-  #define DISABLE         (0x00)
-
-
-#define ADCSSCTL3     (*((volatile uint32_t *) (ADC0_BASE + 0x0A4)))
-  #define TS0             (0x01 << 3)   //1st Sample Temp Sensor Select pg 876
-  #define IE0             (0x01 << 2)   //Sample Interrupt enable for ADCSSCTL3 pg. 876
-  #define END0            (0x01 <<1)    //End of Sequence
-  #define D0              (0x01)        //Sample Differential Input Select
-
-#define ADCRIS         (*((volatile uint32_t *) (ADC0_BASE + 0x004))) //pg 823
-  #define INR3            (0x01 << 3)
-
-#define ADCDCCTL0      (*((volatile uint32_t *) (ADC0_BASE + 0xE00))) //pg 823
-  #define CIE     (0x01<<4)
-
-#define ADCSSPRI        (*((volatile uint32_t *) (ADC0_BASE + 0x020)))
-#define PRI_SS3 (0x03 << 12) //Default priority is
-#define ADC0SSMUX (*((volatile uint32_t *) (ADC0_BASE + 0x040)))
-
-#define ADC0PSSI (*((volatile uint32_t *) (ADC0_BASE + 0x028)))
-#define ADCRIS  (*((volatile uint32_t *) (ADC0_BASE + 0x004)))
-#define ADCISC  (*((volatile uint32_t *) (ADC0_BASE + 0x00C)))
-  #define IN3 (0x01 << 3)
-#define SSFIFO3  (*((volatile uint32_t *) (ADC0_BASE + 0x0A8)))
-
-void ADC_Init(void);
-void ADC0_SequencerInit(void);
-void ADC0_ModuleInit(void);
-
-#define ADC0_INT      (0x01 << 17) 
-#endif
+#if !defined(ADC_H) 
+#define ADC_H
+
+#include <stdint.h>
+#include "Feedback.h"
+
+ // Servo feedback pots: knees 6-11 on AIN0-5 (PE3-PE0, PD3-PD2),
+ // hips 0 and 5 on AIN6-7 (PD1-PD0). One sequencer step per input.
+#define FB_AIN_PORTD_PINS  (0x0F)          //PD0-PD3
+#define FB_AIN_PORTE_PINS  (0x0F)          //PE0-PE3
+#define GPIO_PORTD_CLK     (0x01 << 3)
+#define GPIO_PORTE_CLK     (0x01 << 4)
+#define GPIO_PORTB_CLK     (0x01 << 1)
+#define ADC1_CLK           (0x01 << 1)     //ADC1: pack voltage (Battery.c) and knee current (Contact.c)
+
+#define ADC_HW_AVG_64      (0x06)          //ADCSAC: 64x hardware oversampling pg.847
+#define ADC_EMUX_EM0_M     (0x0F)
+#define ADC_EMUX_ALWAYS    (0x0F)          //EM0: sample continuously pg.833
+#define ADC_ACTSS_ASEN0    (0x01)          //Enable Sequencer 0 pg.821
+#define ADC_SSCTL_END      (0x02)          //End of sequence bit of a step nibble pg.851
+#define ADC_SSCTL_IE       (0x04)          //Interrupt (and DMA request) after this step
+#define ADC_IM_MASK0       (0x01)
+#define ADC_ISC_IN0        (0x01)
+#define ADC_EMUX_EM2_M     (0x0F << 8)
+#define ADC_EMUX_TIMER2    (0x05 << 8)     //EM2: started by a timer with TnOTE set
+#define ADC_ACTSS_ASEN2    (0x04)
+#define ADC_RIS_INR2       (0x04)
+#define ADC_ISC_IN2        (0x04)
+#define ADC_EMUX_EM3_M     (0x0F << 12)
+#define ADC_EMUX_TIMER3    (0x05 << 12)    //EM3: started by a timer with TnOTE set pg.833
+#define ADC_ACTSS_ASEN3    (0x08)
+#define ADC_RIS_INR3       (0x08)
+#define ADC_ISC_IN3        (0x08)
+#define ADC0SS0_INT        (0x01 << 14)    //14th Interupt Location
+#define ADC0SS0_DMA_CH     (14)            //uDMA channel 14, encoding 0
+
+#define FB_FRAMES_PER_HALF (4)             //sequencer frames per ping-pong half
+#define FB_RING_FRAMES     (2 * FB_FRAMES_PER_HALF)
+
+void ADC_Init(void);
+uint32_t ADC_FrameCount(void);
+
+#endif
@@ -0,0 +1,195 @@
+/*! \file  BLEModule.c
+*
+* \brief
+* Boot time setup of the HM-10 / CC-41-A Bluetooth module
+*
+* \details
+*  The module keeps its own baud rate in flash, so the TIVA cannot assume it
+*  matches UART_InitPort1. BLE_Configure finds the module by sending "AT" at
+*  each candidate rate until it answers OK, asks it to switch to the target
+*  rate and, on an HM-10, to use the shortest connection interval. After an
+*  AT+RESET the UART follows and the module is probed again; if it no
+*  longer answers, the UART goes back to the rate it was found on.
+*
+*  The two modules speak different AT dialects:
+*    HM-10:  "AT+BAUD4" = 115200, no line ending, replies "OK+Set:4"
+*    CC-41:  "AT+BAUD8" = 115200, CR LF terminated, replies "+BAUD=8" / "OK"
+*
+*  All I/O goes through a bleTransport_t, so the whole negotiation can run
+*  against a scripted fake module on the host. Commands are only accepted
+*  while no phone is connected, so this must run before the link is used.
+*
+* \author livey
+*
+* \info
+* Bluetooth compatability: CC-41-A and HM-10
+*
+******************************************************************************/
+
+#include <string.h>
+#include "BLEModule.h"
+#include "UART.h"
+#include "Timer.h"
+
+typedef struct baudCode
+{
+  uint32_t baud;
+  char     hm10;     // AT+BAUD digit on the HM-10, 0 if unsupported
+  char     cc41;     // AT+BAUD digit on the CC-41-A, 0 if unsupported
+} baudCode_t;
+
+// probe order: our own default first, then factory default, then the rest
+static const baudCode_t baudTable[] = {
+  {  38400, '2', '6' },
+  {   9600, '0', '4' },
+  { 115200, '4', '8' },
+  {  57600, '3', '7' },
+  {  19200, '1', '5' },
+  { 230400, '8',  0  }
+};
+#define NUM_BAUDS (sizeof(baudTable) / sizeof(baudTable[0]))
+
+static uint8_t UART1_ReadOne( uint8_t * data )
+{
+  return (UART_ReadByte(data) == UART_STATUS_OK) ? 1 : 0;
+}
+
+const bleTransport_t BLE_UART1Transport = {
+  UART_SetBaudPort1,
+  UART_WriteBytes,
+  UART1_ReadOne,
+  UART_FlushRx,
+  Timer_millis
+};
+
+static uint8_t expectReply( const bleTransport_t * t, const char * token, uint32_t timeoutMs )
+/*!\brief   Wait for a token anywhere in the module's reply
+\return 1 if the token was seen before the timeout, 0 otherwise
+*/
+{
+  uint32_t start = t->millis();
+  uint8_t matched = 0;
+  uint8_t c;
+
+  while ((t->millis() - start) < timeoutMs) {
+    if (!t->read(&c)) continue;
+    if (c == (uint8_t)token[matched]) {
+      matched++;
+      if (token[matched] == '\0') return 1;
+    } else {
+      matched = (c == (uint8_t)token[0]) ? 1 : 0;
+    }
+  }
+  return 0;
+}
+
+static uint8_t sendCommand( const bleTransport_t * t, bleModuleType_t type,
+                            const char * command, const char * reply )
+/*!\brief   Send one AT command in the module's dialect and check the reply
+\return 1 if the expected reply arrived
+*/
+{
+  t->flush();
+  t->write((const uint8_t *)command, (uint16_t)strlen(command));
+  if (type == BLE_MODULE_CC41) t->write((const uint8_t *)"\r\n", 2);
+  return expectReply(t, reply, BLE_REPLY_TIMEOUT_MS);
+}
+
+static bleModuleType_t probe( const bleTransport_t * t, uint32_t baud )
+/*!\brief   Look for a module on one baud rate
+\return which dialect answered, BLE_MODULE_NONE if neither did
+*/
+{
+  t->setBaud(baud);
+  if (sendCommand(t, BLE_MODULE_HM10, "AT", "OK")) return BLE_MODULE_HM10;
+  //a CC-41 is still holding the bare "AT", end that line first (it answers ERROR)
+  t->write((const uint8_t *)"\r\n", 2);
+  if (sendCommand(t, BLE_MODULE_CC41, "AT", "OK")) return BLE_MODULE_CC41;
+  return BLE_MODULE_NONE;
+}
+
+static void waitMs( const bleTransport_t * t, uint32_t ms )
+{
+  uint32_t start = t->millis();
+  while ((t->millis() - start) < ms);
+}
+
+bleStatus_t BLE_Configure( const bleTransport_t * transport, uint32_t targetBaud, bleInfo_t * info )
+/*!\brief   Find the module, raise its baud rate and shorten the connection interval
+\details Leaves the UART on the fastest rate the module verifiably answers on.
+\param transport[in]: byte access to the module (BLE_UART1Transport on the bot)
+       targetBaud[in]: requested baud rate, must be in the module's AT+BAUD table
+       info[out]: module type and the rates found / in use
+\return bleStatus_t
+*/
+{
+  const baudCode_t * target = 0;
+  char command[12];
+  char reply[12];
+  char code;
+
+  info->type = BLE_MODULE_NONE;
+  info->foundBaud = 0;
+  info->baud = 0;
+  info->intervalSet = 0;
+
+  for (uint8_t i = 0; (i < NUM_BAUDS) && (info->type == BLE_MODULE_NONE); i++) {
+    info->type = probe(transport, baudTable[i].baud);
+    info->foundBaud = baudTable[i].baud;
+  }
+  if (info->type == BLE_MODULE_NONE) {
+    info->foundBaud = 0;
+    transport->setBaud(UART_DEFAULT_BAUD);
+    return BLE_STATUS_NO_MODULE;
+  }
+  info->baud = info->foundBaud;
+
+  //connection interval only exists on the HM-10, it takes effect after the reset below
+  if (info->type == BLE_MODULE_HM10) {
+    strcpy(command, "AT+COMI0");
+    command[7] = '0' + BLE_CONN_MIN_CODE;
+    strcpy(reply, "OK+Set:0");
+    reply[7] = command[7];
+    info->intervalSet = sendCommand(transport, info->type, command, reply);
+
+    command[6] = 'A';   //AT+COMA
+    command[7] = '0' + BLE_CONN_MAX_CODE;
+    reply[7] = command[7];
+    info->intervalSet &= sendCommand(transport, info->type, command, reply);
+
+    info->intervalSet &= sendCommand(transport, info->type, "AT+COUP1", "OK+Set:1");
+  }
+
+  for (uint8_t i = 0; i < NUM_BAUDS; i++) {
+    if (baudTable[i].baud == targetBaud) target = &baudTable[i];
+  }
+  code = (target == 0) ? 0 : ((info->type == BLE_MODULE_HM10) ? target->hm10 : target->cc41);
+  if ((code == 0) || (targetBaud == info->foundBaud)) {
+    sendCommand(transport, info->type, "AT+RESET", "OK");
+    waitMs(transport, BLE_RESET_DELAY_MS);
+    return (targetBaud == info->foundBaud) ? BLE_STATUS_OK : BLE_STATUS_BAUD_REFUSED;
+  }
+
+  strcpy(command, "AT+BAUD0");
+  command[7] = code;
+  if (info->type == BLE_MODULE_HM10) {
+    strcpy(reply, "OK+Set:0");
+    reply[7] = code;
+  } else {
+    strcpy(reply, "OK");
+  }
+  if (!sendCommand(transport, info->type, command, reply)) {
+    return BLE_STATUS_BAUD_REFUSED;
+  }
+
+  sendCommand(transport, info->type, "AT+RESET", "OK");
+  waitMs(transport, BLE_RESET_DELAY_MS);
+
+  //follow the module, and make sure it really moved
+  if (probe(transport, targetBaud) == info->type) {
+    info->baud = targetBaud;
+    return BLE_STATUS_OK;
+  }
+  transport->setBaud(info->foundBaud);
+  return BLE_STATUS_BAUD_REFUSED;
+}
@@ -0,0 +1,48 @@
+#if !defined(BLEMODULE_H)
+#define BLEMODULE_H
+
+#include <stdint.h>
+
+#define BLE_TARGET_BAUD      (115200u)   //fastest rate both module types accept
+#define BLE_REPLY_TIMEOUT_MS (300u)      //HM-10 answers after ~100ms of line idle
+#define BLE_RESET_DELAY_MS   (800u)      //module reboot after AT+RESET
+#define BLE_CONN_MIN_CODE    (0)         //HM-10 AT+COMI: 0 = 7.5ms, shortest allowed
+#define BLE_CONN_MAX_CODE    (3)         //HM-10 AT+COMA: 3 = 20ms, leaves iOS/Android room to accept
+
+typedef struct bleTransport
+/*! Byte level access to the module, swapped for a scripted fake on a host build */
+{
+  void     (*setBaud)( uint32_t baud );
+  void     (*write)( const uint8_t * data, uint16_t length );
+  uint8_t  (*read)( uint8_t * data );     //!<1 if a byte was returned, 0 if none waiting
+  void     (*flush)( void );
+  uint32_t (*millis)( void );
+} bleTransport_t;
+
+typedef enum bleModuleType
+{
+  BLE_MODULE_NONE,     //!<Nothing answered on any baud rate
+  BLE_MODULE_HM10,     //!<HM-10 (HMSoft firmware), commands without line endings
+  BLE_MODULE_CC41      //!<CC-41-A clone, commands terminated by CR LF
+} bleModuleType_t;
+
+typedef enum bleStatus
+{
+  BLE_STATUS_OK,           //!<Module found and running at the requested baud
+  BLE_STATUS_NO_MODULE,    //!<No answer at any candidate baud
+  BLE_STATUS_BAUD_REFUSED  //!<Module found but left at the baud it was found at
+} bleStatus_t;
+
+typedef struct bleInfo
+{
+  bleModuleType_t type;     //!<Which AT dialect answered
+  uint32_t foundBaud;       //!<Baud rate the module was answering on
+  uint32_t baud;            //!<Baud rate in use when BLE_Configure returned
+  uint8_t  intervalSet;     //!<1 if the connection interval request was accepted
+} bleInfo_t;
+
+extern const bleTransport_t BLE_UART1Transport;
+
+bleStatus_t BLE_Configure( const bleTransport_t * transport, uint32_t targetBaud, bleInfo_t * info );
+
+#endif
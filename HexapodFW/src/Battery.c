@@ -0,0 +1,160 @@
+/*! \file  Battery.c
+*
+* \brief
+* Pack voltage monitor with gait derating and a low voltage cutoff
+*
+* \details
+*  ADC1 sequencer 3 converts the pack voltage divider on AIN8 once per
+*  control tick: Timer 1A starts the conversion in hardware (TAOTE, EMUX
+*  timer trigger) and the sequencer averages 64 samples, so the CPU only
+*  picks the result up when Battery_Service sees the raw status bit. No
+*  interrupt, no busy wait.
+*
+*  A slow IIR filter rides out the sag of the servos starting moves. Below
+*  BATTERY_DERATE_MV the gait speed and stride are scaled down in step with
+*  the voltage, to BATTERY_MIN_SCALE at the cutoff; the scale only comes
+*  back up once the pack is BATTERY_HYSTERESIS_MV above where it was set,
+*  so a walk that loads the pack does not keep switching it. Below
+*  BATTERY_CUTOFF_MV the bot is made to sit down and stays down until the
+*  pack is back above BATTERY_RESUME_MV and the host commands a stand.
+*
+*  Until the first conversion arrives nothing is limited.
+*
+* \author vsimontov
+*
+* \info
+* Based on TIVA User Reference manual, ADC Initialization and Configuration
+* (pg.817)
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include "Battery.h"
+#include "ADC.h"
+#include "Timer.h"
+#include "Recorder.h"
+#include <tm4c123gh6pm.h>
+
+#define ADC_FULL_SCALE  (4095u)
+
+static batteryStatus_t status;
+static uint32_t filtered;     //pack mV << BATTERY_FILTER_SHIFT
+
+void Battery_Init( void )
+/*!\brief   Start sampling the pack voltage on every control tick
+\details Call after Control_Init, which sets Timer 1A up.
+\return none
+*/
+{
+  status.packMv = 0;
+  status.lastMv = 0;
+  status.scale = 100;
+  status.level = BATTERY_UNKNOWN;
+  status.cutoffs = 0;
+  status.samples = 0;
+  filtered = 0;
+  setGaitDerate(100);
+
+  //1. Clock ADC1 and port E, PE5 as an analog input
+  SYSCTL_RCGCADC_R |= ADC1_CLK;
+  SYSCTL_RCGCGPIO_R |= GPIO_PORTE_CLK;
+  while ((SYSCTL_PRADC_R & ADC1_CLK) == 0);
+
+  GPIO_PORTE_AFSEL_R |= BATTERY_PORTE_PIN;
+  GPIO_PORTE_DEN_R   &= ~BATTERY_PORTE_PIN;
+  GPIO_PORTE_AMSEL_R |= BATTERY_PORTE_PIN;
+
+  //2. Sequencer 3: disabled while configuring, timer triggered, 64x averaging
+  ADC1_ACTSS_R &= ~ADC_ACTSS_ASEN3;
+  ADC1_SAC_R = ADC_HW_AVG_64;
+  ADC1_EMUX_R = (ADC1_EMUX_R & ~ADC_EMUX_EM3_M) | ADC_EMUX_TIMER3;
+  ADC1_SSMUX3_R = BATTERY_AIN;
+  ADC1_SSCTL3_R = ADC_SSCTL_END | ADC_SSCTL_IE;   //raw status only, IM stays clear
+  ADC1_ISC_R = ADC_ISC_IN3;
+  ADC1_ACTSS_R |= ADC_ACTSS_ASEN3;
+
+  //3. Let the control tick time-out start the conversions
+  TIMER1_CTL_R |= TAOTE;
+}
+
+static uint8_t scaleFor( uint32_t mv )
+{
+  if (mv >= BATTERY_DERATE_MV) return 100;
+  if (mv <= BATTERY_CUTOFF_MV) return BATTERY_MIN_SCALE;
+  return (uint8_t)(BATTERY_MIN_SCALE + (((100 - BATTERY_MIN_SCALE) * (mv - BATTERY_CUTOFF_MV)) /
+                                        (BATTERY_DERATE_MV - BATTERY_CUTOFF_MV)));
+}
+
+static void evaluate( uint32_t mv )
+{
+  batteryLevel_t level = (batteryLevel_t)status.level;
+  uint8_t scale = scaleFor(mv);
+
+  //derate at once, ease off only when clear of the hysteresis band
+  if (scale > status.scale) {
+    uint8_t eased = (mv > BATTERY_HYSTERESIS_MV) ? scaleFor(mv - BATTERY_HYSTERESIS_MV) : BATTERY_MIN_SCALE;
+    scale = (eased > status.scale) ? eased : status.scale;
+  }
+
+  if ((level != BATTERY_CUTOFF) && (mv < BATTERY_CUTOFF_MV)) {
+    level = BATTERY_CUTOFF;
+    status.cutoffs++;
+  }
+  else if ((level != BATTERY_CUTOFF) || (mv > BATTERY_RESUME_MV)) {
+    level = (scale < 100) ? BATTERY_LOW : BATTERY_OK;
+  }
+
+  if (scale != status.scale) {
+    status.scale = scale;
+    setGaitDerate(scale);
+  }
+  if (level != status.level) {
+    RECORD(REC_BATTERY, level, mv);
+    status.level = level;
+  }
+}
+
+void Battery_Service( void )
+/*!\brief   Pick up a finished conversion, if any, and update the limits
+\details Cheap when nothing is ready; call once per main loop pass.
+\return none
+*/
+{
+  if ((ADC1_RIS_R & ADC_RIS_INR3) == 0) return;
+
+  uint32_t code = ADC1_SSFIFO3_R & ADC_FULL_SCALE;
+  ADC1_ISC_R = ADC_ISC_IN3;
+
+  uint32_t mv = (code * BATTERY_ADC_REF_MV * BATTERY_DIVIDER) / ADC_FULL_SCALE;
+  if (status.samples == 0) {
+    filtered = mv << BATTERY_FILTER_SHIFT;
+  }
+  else {
+    filtered += mv - (filtered >> BATTERY_FILTER_SHIFT);
+  }
+  status.samples++;
+  status.lastMv = (uint16_t)mv;
+  status.packMv = (uint16_t)(filtered >> BATTERY_FILTER_SHIFT);
+  evaluate(status.packMv);
+}
+
+gaitCommand_t Battery_LimitCommand( gaitCommand_t lastCmd )
+/*!\brief   The command the gait may act on
+\param lastCmd[in]: command from the host
+\return BOT_SIT while the pack is below the cutoff, lastCmd otherwise
+*/
+{
+  return (status.level == BATTERY_CUTOFF) ? BOT_SIT : lastCmd;
+}
+
+void Battery_GetStatus( batteryStatus_t * out )
+/*!\brief   Copy of the monitor state
+\param out[out]: filled in
+\return none
+*/
+{
+  *out = status;
+}
@@ -0,0 +1,45 @@
+#if !defined(BATTERY_H)
+#define BATTERY_H
+
+#include <stdint.h>
+#include "Gaits.h"
+
+ // Pack voltage on AIN8 (PE5) through a 20k/10k divider, 2S LiPo thresholds
+#define BATTERY_DIVIDER        (3)        //pack mV per pin mV
+#define BATTERY_ADC_REF_MV     (3300u)
+#define BATTERY_DERATE_MV      (7200u)    //full speed and stride above this
+#define BATTERY_CUTOFF_MV      (6600u)    //sit down below this
+#define BATTERY_RESUME_MV      (7000u)    //may stand again above this
+#define BATTERY_HYSTERESIS_MV  (100u)     //derating eases off only this far above where it was set
+#define BATTERY_MIN_SCALE      (50)       //percent of speed and stride just above the cutoff
+#define BATTERY_FILTER_SHIFT   (4)        //IIR over 16 control ticks, rides out servo load sag
+
+ // ADC1 sequencer 3, one step, started by the control tick timer (Timer 1A
+ // TAOTE); the register bits are in ADC.h
+#define BATTERY_AIN            (8)
+#define BATTERY_PORTE_PIN      (0x01 << 5)    //PE5
+
+typedef enum batteryLevel
+{
+  BATTERY_UNKNOWN,       //!<No sample yet, nothing is limited
+  BATTERY_OK,
+  BATTERY_LOW,           //!<Speed and stride derated
+  BATTERY_CUTOFF         //!<Sat down until the pack recovers
+} batteryLevel_t;
+
+typedef struct batteryStatus
+{
+  uint16_t packMv;       //!<Filtered pack voltage
+  uint16_t lastMv;       //!<Latest sample
+  uint8_t  scale;        //!<Percent of speed and stride the gait is allowed
+  uint8_t  level;        //!<batteryLevel_t
+  uint16_t cutoffs;      //!<Times the cutoff forced a sit-down
+  uint32_t samples;
+} batteryStatus_t;
+
+void Battery_Init( void );
+void Battery_Service( void );
+gaitCommand_t Battery_LimitCommand( gaitCommand_t lastCmd );
+void Battery_GetStatus( batteryStatus_t * out );
+
+#endif
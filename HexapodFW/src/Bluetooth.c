@@ -1,217 +1,552 @@
-/*! \file  Bluetooth.c
-*
-* \brief
-* Module for interfacing with the Bluetooth module 
-*
-* \details
-*  This modules uses the UART.c module to interface with the TIVA and be able
-*  to establish communications with the bluetooth 4.0 module
-*
-* \author livey
-*
-* \info
-* Bluetooth compatability: CC-41-A and HM-10
-*
-* This code was tested using an osciliscope to verify proper packet transfers
-*
-* For details on programming, refer to TM4C123G datasheet :
-* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
-*
-******************************************************************************/
-
-#include "Bluetooth.h"
-#include "UART.h"
-#include "Gaits.h"
-
-uint8_t GOBLE_ADDRESS = 0x11;
-uint8_t headerCHKSUM = 0x10;
-
-#define MAXPACKETDATA 48
-uint8_t packetData[MAXPACKETDATA];
-uint8_t packetLength = 0;
-uint8_t packetLengthReceived = 0;
-uint32_t flushcount = 0;
-uint32_t packetErrorCount = 0; 
-
-void BlueTooth_Init( void )
-/*!\brief   Initialize bluetooth, by initializing UART 
-\details none
-\return none
-*/
-{
-   UART_InitPort1();
-}
-
-void checkBlueTooth(gaitCommand_t * lastCmd)
-/*!\brief   Query bluetooth module, set new command
-\details: Check to see if anything is in the buffer of the uart, read and pass
-          back data via pointer
-\param lastCmd [out]: sets which movement hexapod will perform next
-\return none
-*/
-{
-  if (BlueTooth_PacketHandler() == P_NEW_DATA_AVAILABLE){
-    //do some logic to set the new command;
-      *lastCmd = parsePacket();
-#if USE_GOBLE_AS_MOVEMENT_CLOCK
-      if (*lastCmd != BOT_DEMO) updateMillis(); //joystick will throw off the timing if we're using this
-#endif
-  }
-  
-}
-
-packetState_t BlueTooth_PacketHandler( void )
-/*!\brief   Matches new data packet to what action should be
-\details: 
-\param none
-\return packetState_t
-*/
-{
-
-  static packetState_t packetState = P_WAITING_FOR_HEADER_55;
-  static uint8_t checksum = 0;
-  uint8_t c;
-  
-  while (UART_Rx_available() > 0) {
-    UART_ReadByte(&c);
-    
-    switch (packetState) {
-      
-      case P_WAITING_FOR_HEADER_55:
-        flushcount = 0;
-        while ((UART_Rx_available() > 0) && (c != 0x55)) {
-          //Discard everything up to the start of a new header, right here
-          UART_ReadByte(&c);
-          flushcount++;
-        }
-        if (c == 0x55){
-        //Got first byte of header, go to next state
-        packetState = P_WAITING_FOR_HEADER_AA;
-        }
-        break;
-        
-      case P_WAITING_FOR_HEADER_AA:
-        if (c == 0xAA){
-          //Got second byte of header, go to address
-          packetState = P_WAITING_FOR_ADDRESS;
-        }
-        else if (c == 0x55) break; //Unlikely event that we have a doubleshot, stay in this state
-        else{
-          packetState = P_WAITING_FOR_HEADER_55; //something when wrong, start over
-        }
-        break;
-        
-      case P_WAITING_FOR_ADDRESS:
-        if (c == GOBLE_ADDRESS) {
-          packetState = P_WAITING_FOR_LENGTH;
-        } else if (c == 0x55) {
-          packetState = P_WAITING_FOR_HEADER_AA; //check for the first byte again to avoid skipping a whole packet
-        } else {
-          packetErrorCount++;
-          packetState = P_WAITING_FOR_HEADER_55; // go back to looking for a 0x55 again
-          return P_PACKET_ERROR;
-        }
-        break;
-        
-      case P_WAITING_FOR_LENGTH:
-        if (c < 7) {  
-          checksum = headerCHKSUM + c;       //start generating checksum from known header and variable length
-          packetLength = c + 6;              //data length is the number of pressed buttons plus 4 analog, 2 digital (not incl. CHKSUM)
-          packetLengthReceived = 0;
-          packetData[packetLengthReceived++] = c;
-          packetState = P_READING_DATA;
-        } else {
-          packetErrorCount++;
-          packetState = P_WAITING_FOR_HEADER_55; // go back to looking for a 0x55 again
-          return P_PACKET_ERROR;
-        }
-        break;
-        
-      case P_READING_DATA:
-        if (packetLengthReceived >= MAXPACKETDATA) {
-          // if we're getting garbage in, abandon the packet and go back to waiting for headers
-          packetState = P_WAITING_FOR_HEADER_55;
-          packetLengthReceived = 0;
-          return P_PACKET_ERROR;
-        }
-        packetData[packetLengthReceived++] = c;
-        checksum += c;
-        if (packetLengthReceived == packetLength) {
-          //last byte is the checksum, not included in the packet length calculation
-          packetState = P_WAITING_FOR_CHECKSUM;
-        }
-        break;
-
-      case P_WAITING_FOR_CHECKSUM:        
-        if (checksum != c) {
-          //if the packet checksum fails, give up on it
-          packetErrorCount++;
-          packetState = P_WAITING_FOR_HEADER_55;
-          return P_PACKET_ERROR;
-        } else {          
-//          LastValidReceiveTime = millis();  // set the time we received a valid packet.  We can bring this back! --LI
-          packetState = P_WAITING_FOR_HEADER_55;
-          return P_NEW_DATA_AVAILABLE; // new data arrived!
-        }
-        break;
-    }
-  }
-
-  return packetState; // no new data arrived
-}
-
-gaitCommand_t parsePacket( void ) 
-/*!\brief  Sets new state based off of which button was pressed 
-\details: By analyzing the global variable (packetData), this function will
-          figure out which button has been pressed and decide its new action
-          accordingly
-\param none
-\return gaitCommand_t
-*/
-{
-
-  gaitCommand_t newCmd = BOT_PARSE_ERROR;  //if all goes well, this will change by the end of the function
-
-  //clear the button press bitmask
-  uint8_t buttonsPressed = 0;
-
-   //if joystick is activated, set bit 0
-  if (packetData[1]) buttonsPressed |= 1;
-  
-  //set mask for buttons 1-6
-    for (uint8_t b = packetData[0]; b > 0; b--){
-      buttonsPressed |= (1 << packetData[1+b]);
-   }
- 
-  //decide which command to send
- switch(buttonsPressed) {
-   case 0x40:  //1 << 6
-     newCmd = BOT_DEMO;
-     break;
-   case 0x20:  //1 << 5
-     newCmd = BOT_STAND;
-     break;
-   case 0x10:  //1 << 4
-     newCmd = BOT_ROTATE_LEFT;
-     break;
-   case 0x04:  //1 << 2
-     newCmd = BOT_ROTATE_RIGHT;
-     break;
-   case 0x0C:  //1 << 3 | 1 << 2
-   case 0x18:  //1 << 3 | 1 << 4
-   case 0x08:  //1 << 3
-     newCmd = BOT_WALK_BACK;
-     break;
-   case 0x06:  //1 << 1 | 1 << 2  
-   case 0x12:  //1 << 1 | 1 << 4
-   case 0x02:  //1 << 1
-     newCmd = BOT_WALK_FWD;
-     break;
-   default:
-     newCmd = BOT_STAND;
-     break;
- }
-  
-  return newCmd;
-}
-
+/*! \file  Bluetooth.c
+*
+* \brief
+* Module for interfacing with the Bluetooth module 
+*
+* \details
+*  This modules uses the UART.c module to interface with the TIVA and be able
+*  to establish communications with the bluetooth 4.0 module
+*
+*  With USE_WIRED_LINK the same GoBLE and joint stream frames are also
+*  accepted on UART0 (USB virtual COM port). Each link has its own parser
+*  state. While wired packets keep arriving (WIRED_HOLD_MS) the Bluetooth
+*  link is still parsed but its packets are dropped, so a tethered bench
+*  session cannot be fought over by a phone that is still connected.
+*
+* \author livey
+*
+* \info
+* Bluetooth compatability: CC-41-A and HM-10
+*
+* This code was tested using an osciliscope to verify proper packet transfers
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <string.h>
+#include "Bluetooth.h"
+#include "UART.h"
+#include "Gaits.h"
+#include "Timer.h"
+#include "BLEModule.h"
+#include "ServoStream.h"
+#include "Script.h"
+#include "Fight.h"
+#include "Telemetry.h"
+#include "Profile.h"
+#include "Recorder.h"
+#include "Config.h"
+
+uint8_t GOBLE_ADDRESS = 0x11;
+uint8_t headerCHKSUM = 0x10;
+uint8_t streamHeaderCHKSUM = 0x11;   //0x55 + 0xAA + STREAM_ADDRESS
+uint8_t scriptHeaderCHKSUM = 0x12;   //0x55 + 0xAA + SCRIPT_ADDRESS
+uint8_t dumpHeaderCHKSUM = 0x13;     //0x55 + 0xAA + DUMP_ADDRESS
+uint8_t configHeaderCHKSUM = 0x14;   //0x55 + 0xAA + CONFIG_ADDRESS
+
+#define MAXPACKETDATA 48
+#define MAXFRAMEBYTES (MAXPACKETDATA + 4)   //header, address, length and payload, checksum
+uint8_t packetData[MAXPACKETDATA];
+uint32_t flushcount = 0;
+uint32_t packetErrorCount = 0; 
+uint32_t packetSupersededCount = 0;
+uint32_t packetOverriddenCount = 0;
+uint32_t packetStampUs = 0;          //Timer_micros() when packetData last passed its checksum
+static uint32_t frameStampUs = 0;    //same for the last GoBLE or joint frame, for the jitter
+static uint8_t fightLatched = 0;
+
+typedef struct packetParser
+{
+  packetState_t state;
+  uint8_t port;                  //UART port the bytes come from
+  uint8_t checksum;
+  uint8_t address;
+  uint8_t length;                //bytes to receive before the checksum
+  uint8_t received;
+  uint8_t frame[MAXPACKETDATA];  //frame under assembly, copied out once the checksum matches
+  uint8_t raw[MAXFRAMEBYTES];    //every byte of it from the 0x55 on, scanned again if it is rejected
+  uint8_t rawLength;
+} packetParser_t;
+
+static packetParser_t bleParser = {P_WAITING_FOR_HEADER_55, UART_PORT_BT};
+#if USE_WIRED_LINK
+static packetParser_t wiredParser = {P_WAITING_FOR_HEADER_55, UART_PORT_WIRED};
+static uint8_t wiredActive = 0;
+static uint32_t lastWiredMs = 0;
+#endif
+
+bleInfo_t bleInfo;
+uint32_t LastValidReceiveTime = 0;
+static uint32_t linkTimeoutMs = LINK_TIMEOUT_MS;
+static uint8_t linkUp = 0;
+static linkStats_t linkStats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFFFFFFFF, 0, 0};
+static uint32_t lastStampUs = 0;
+static uint32_t lastGapUs = 0;
+static uint32_t jitterQ4 = 0;       //jitter in us << JITTER_SHIFT
+
+static packetState_t parseLink( packetParser_t * p, uint8_t deliver );
+
+static uint8_t isAddress( uint8_t c )
+{
+  return ((c == GOBLE_ADDRESS) || (c == STREAM_ADDRESS) || (c == SCRIPT_ADDRESS) || (c == DUMP_ADDRESS) ||
+          (c == CONFIG_ADDRESS)) ? 1 : 0;
+}
+
+/*
+  The last three bytes of a GoBLE frame under assembly, all past its length
+  byte, are a header. Buttons and joystick never line up like this in a
+  real frame, it means the frame was cut short and the next one started.
+  Joint, script and config payloads are binary and rely on the checksum.
+*/
+static uint8_t headerInGoBLE( const packetParser_t * p )
+{
+  uint8_t n = p->rawLength;
+
+  return ((p->address == GOBLE_ADDRESS) && (n >= 7) && (p->raw[n - 3] == 0x55) && (p->raw[n - 2] == 0xAA) &&
+          isAddress(p->raw[n - 1])) ? 1 : 0;
+}
+
+static void recordPacket( uint32_t now, uint32_t stampUs )
+/*!\brief   Update the arrival statistics for a valid packet
+\details The jitter is the RFC 3550 estimator on the gaps in microseconds,
+         J += (|D| - J) / 16, with J kept scaled by 16 so that changes
+         smaller than 16us still move it.
+\param now[in]: receive time in milliseconds
+       stampUs[in]: Timer_micros() when the frame passed its checksum
+\return none
+*/
+{
+  if (linkUp) {
+    uint32_t gap = now - LastValidReceiveTime;
+    uint32_t gapUs = stampUs - lastStampUs;
+    int32_t change = (int32_t)gapUs - (int32_t)lastGapUs;
+    if (change < 0) change = -change;
+
+    if (linkStats.packets > 1) {
+      //only meaningful once there are two gaps to compare
+      jitterQ4 += (uint32_t)change - ((jitterQ4 + (1u << (JITTER_SHIFT - 1))) >> JITTER_SHIFT);
+      linkStats.jitterUs = jitterQ4 >> JITTER_SHIFT;
+    }
+    if (gap < linkStats.minGapMs) linkStats.minGapMs = gap;
+    if (gap > linkStats.maxGapMs) linkStats.maxGapMs = gap;
+    linkStats.lastGapMs = gap;
+    lastGapUs = gapUs;
+  }
+  lastStampUs = stampUs;
+  LastValidReceiveTime = now;
+  linkStats.lastRxMs = now;
+  linkStats.packets++;
+  linkUp = 1;
+}
+
+void BlueTooth_Init( void )
+/*!\brief   Initialize bluetooth, by initializing UART 
+\details With BLE_AUTO_CONFIG the module is then found and moved to
+         the configured baud rate (BLE_TARGET_BAUD unless changed, see
+         Config.h); the result is kept in bleInfo. Takes a few seconds
+         when the module is not on the expected rate.
+\return none
+*/
+{
+   UART_InitPort1();
+#if BLE_AUTO_CONFIG
+   BLE_Configure(&BLE_UART1Transport, Config_Get()->bleBaud, &bleInfo);
+#endif
+#if USE_WIRED_LINK
+   UART_InitPort0(WIRED_BAUD);
+#endif
+}
+
+void checkBlueTooth(gaitCommand_t * lastCmd)
+/*!\brief   Query bluetooth module, set new command
+\details: Check to see if anything is in the buffer of the uart, read and pass
+          back data via pointer. If the link goes quiet for longer than the
+          link timeout the command is replaced with BOT_STAND, so the gait
+          finishes its step and stands instead of walking on forever.
+          The wired link is parsed first and wins while it is active.
+\param lastCmd [out]: sets which movement hexapod will perform next
+\return none
+*/
+{
+  uint32_t now = Timer_millis();
+  packetState_t state;
+
+  PROFILE_BEGIN(PROF_PACKET);
+#if USE_WIRED_LINK
+  packetState_t wired = parseLink(&wiredParser, 1);
+
+  if ((wired == P_NEW_DATA_AVAILABLE) || (wired == P_STREAM_DATA)) {
+    wiredActive = 1;
+    lastWiredMs = now;
+    linkStats.wiredPackets++;
+  } else if (wiredActive && ((now - lastWiredMs) > WIRED_HOLD_MS)) {
+    wiredActive = 0;   //cable quiet, hand control back to Bluetooth
+  }
+
+  if (wiredActive) {
+    parseLink(&bleParser, 0);   //keep the Bluetooth ring drained, its packets lose
+    state = wired;
+  } else {
+    state = parseLink(&bleParser, 1);
+  }
+#else
+  state = BlueTooth_PacketHandler();
+#endif
+  PROFILE_END(PROF_PACKET);
+
+  if (state == P_STREAM_DATA){
+    //joint frames went straight to ServoStream, just switch the gait over
+    recordPacket(now, frameStampUs);
+    if (*lastCmd != BOT_STREAM) RECORD(REC_COMMAND, BOT_STREAM, 0);
+    *lastCmd = BOT_STREAM;
+  }
+  else if (state == P_NEW_DATA_AVAILABLE){
+    recordPacket(now, frameStampUs);
+    //do some logic to set the new command;
+      gaitCommand_t newCmd = parsePacket();
+      uint8_t c = packetData[0];   //joystick bytes follow the buttons, centred on 128
+      if (newCmd != *lastCmd) RECORD(REC_COMMAND, newCmd, packetData[2 + c] | (packetData[3 + c] << 8));
+      *lastCmd = newCmd;
+      if (*lastCmd == BOT_FIGHT) {
+        Fight_SetInput((int8_t)(packetData[2 + c] - 128), (int8_t)(packetData[3 + c] - 128), packetStampUs);
+      }
+#if USE_GOBLE_AS_MOVEMENT_CLOCK
+      if (*lastCmd != BOT_DEMO) updateMillis(); //joystick will throw off the timing if we're using this
+#endif
+  }
+  else if (linkUp && (linkTimeoutMs != 0) && ((now - LastValidReceiveTime) > linkTimeoutMs)){
+    //phone disconnected or out of range, fail safe
+    linkUp = 0;
+    linkStats.timeouts++;
+    RECORD(REC_LINK_TIMEOUT, 0, now - LastValidReceiveTime);
+    fightLatched = 0;
+    *lastCmd = BOT_STAND;
+  }
+  
+}
+
+void BlueTooth_SetLinkTimeout( uint32_t timeoutMs )
+/*!\brief   Set how long the link may stay silent before the bot stops
+\param timeoutMs[in]: timeout in milliseconds, 0 disables the fail-safe
+\return none
+*/
+{
+  linkTimeoutMs = timeoutMs;
+}
+
+void BlueTooth_GetLinkStats( linkStats_t * stats )
+/*!\brief   Copy out the link statistics
+\param stats[out]: arrival, gap and error counters
+\return none
+*/
+{
+  *stats = linkStats;
+  stats->superseded = packetSupersededCount;
+  stats->overridden = packetOverriddenCount;
+  stats->errors = packetErrorCount;
+  stats->flushed = flushcount;
+}
+
+void BlueTooth_ResetLinkStats( void )
+/*!\brief   Clear the gap and jitter statistics and the counters
+\return none
+*/
+{
+  linkStats.packets = 0;
+  linkStats.timeouts = 0;
+  linkStats.lastGapMs = 0;
+  linkStats.minGapMs = 0xFFFFFFFF;
+  linkStats.maxGapMs = 0;
+  linkStats.jitterUs = 0;
+  lastGapUs = 0;
+  jitterQ4 = 0;
+  linkStats.wiredPackets = 0;
+  packetSupersededCount = 0;
+  packetOverriddenCount = 0;
+  packetErrorCount = 0;
+  linkUp = 0;
+}
+
+static packetState_t parseLink( packetParser_t * p, uint8_t deliver )
+/*!\brief   Pull every buffered byte of one link through the GoBLE frame parser
+\details: Header, address, length and checksum are checked as each byte goes
+          by. A frame is assembled in a private buffer and only copied to
+          packetData once its checksum matches. A frame that fails its
+          checksum, or a GoBLE frame with a 55 AA <address> inside it, was
+          cut short and swallowed the start of the next one: it is dropped
+          and its bytes after the first 0x55 are scanned again, so the frame
+          that follows is still found. All buffered bytes are consumed on every call: if several
+          valid packets were waiting, packetData ends up holding the newest
+          and the older ones are counted in packetSupersededCount, so a stale
+          joystick state is never acted on. Joint frames on STREAM_ADDRESS are
+          not coalesced, each one is handed to ServoStream_Push, script
+          upload packets on SCRIPT_ADDRESS go to Script_Push, dump
+          requests on DUMP_ADDRESS to Telemetry_Request and configuration
+          updates on CONFIG_ADDRESS to Config_Push.
+          When deliver is 0 frames are still checked, but then dropped and
+          counted in packetOverriddenCount.
+\param p[in,out]: parser state of the link
+       deliver[in]: 1 to act on valid frames, 0 to discard them
+\return packetState_t: P_NEW_DATA_AVAILABLE if at least one valid GoBLE packet
+          was completed, P_STREAM_DATA if only joint frames were, P_PACKET_ERROR
+          if only bad frames were seen, otherwise the state the parser is
+          waiting in
+*/
+{
+  uint8_t newPackets = 0;
+  uint8_t streamFrames = 0;
+  uint8_t badFrames = 0;
+  uint8_t replay[MAXFRAMEBYTES];   //bytes of rejected frames still to be scanned again
+  uint8_t replayLength = 0;
+  uint8_t replayPos = 0;
+  uint8_t rescan;
+  uint8_t c;
+  
+  for (;;) {
+    if (replayPos < replayLength) c = replay[replayPos++];
+    else if (UART_ReadPort(p->port, &c) != UART_STATUS_OK) break;
+
+    rescan = 0;
+    if (p->state != P_WAITING_FOR_HEADER_55) {
+      if (p->rawLength < MAXFRAMEBYTES) p->raw[p->rawLength++] = c;
+    }
+    
+    switch (p->state) {
+      
+      case P_WAITING_FOR_HEADER_55:
+        if (c == 0x55){
+          //Got first byte of header, go to next state
+          p->state = P_WAITING_FOR_HEADER_AA;
+          p->raw[0] = c;
+          p->rawLength = 1;
+          flushcount = 0;
+        } else {
+          flushcount++;  //Discard everything up to the start of a new header
+        }
+        break;
+        
+      case P_WAITING_FOR_HEADER_AA:
+        if (c == 0xAA){
+          //Got second byte of header, go to address
+          p->state = P_WAITING_FOR_ADDRESS;
+        }
+        else if (c == 0x55) break; //Unlikely event that we have a doubleshot, stay in this state
+        else{
+          p->state = P_WAITING_FOR_HEADER_55; //something when wrong, start over
+        }
+        break;
+        
+      case P_WAITING_FOR_ADDRESS:
+        if (isAddress(c)) {
+          p->address = c;
+          p->state = P_WAITING_FOR_LENGTH;
+        } else if (c == 0x55) {
+          p->state = P_WAITING_FOR_HEADER_AA; //check for the first byte again to avoid skipping a whole packet
+        } else {
+          packetErrorCount++;
+          badFrames++;
+          RECORD(REC_PACKET_ERROR, P_WAITING_FOR_ADDRESS, c | (p->port << 8));
+          p->state = P_WAITING_FOR_HEADER_55; // go back to looking for a 0x55 again
+        }
+        break;
+        
+      case P_WAITING_FOR_LENGTH:
+        if ((p->address == STREAM_ADDRESS) && (c >= STREAM_MIN_PAYLOAD) && (c <= STREAM_MAX_PAYLOAD)) {
+          p->checksum = streamHeaderCHKSUM + c;
+          p->length = c + 1;              //length byte plus the joint frame payload (not incl. CHKSUM)
+          p->received = 0;
+          p->frame[p->received++] = c;
+          p->state = P_READING_DATA;
+        } else if ((p->address == SCRIPT_ADDRESS) && (c >= SCRIPT_MIN_PAYLOAD) && (c < MAXPACKETDATA)) {
+          p->checksum = scriptHeaderCHKSUM + c;
+          p->length = c + 1;              //length byte plus the upload payload (not incl. CHKSUM)
+          p->received = 0;
+          p->frame[p->received++] = c;
+          p->state = P_READING_DATA;
+        } else if ((p->address == DUMP_ADDRESS) && (c == 1)) {
+          p->checksum = dumpHeaderCHKSUM + c;
+          p->length = c + 1;              //length byte plus what to dump (not incl. CHKSUM)
+          p->received = 0;
+          p->frame[p->received++] = c;
+          p->state = P_READING_DATA;
+        } else if ((p->address == CONFIG_ADDRESS) && (c >= 1) && (c < MAXPACKETDATA)) {
+          p->checksum = configHeaderCHKSUM + c;
+          p->length = c + 1;              //length byte plus the update payload (not incl. CHKSUM)
+          p->received = 0;
+          p->frame[p->received++] = c;
+          p->state = P_READING_DATA;
+        } else if ((p->address == GOBLE_ADDRESS) && (c < 7)) {  
+          p->checksum = headerCHKSUM + c;       //start generating checksum from known header and variable length
+          p->length = c + 6;              //data length is the number of pressed buttons plus 4 analog, 2 digital (not incl. CHKSUM)
+          p->received = 0;
+          p->frame[p->received++] = c;
+          p->state = P_READING_DATA;
+        } else {
+          packetErrorCount++;
+          badFrames++;
+          RECORD(REC_PACKET_ERROR, P_WAITING_FOR_LENGTH, c | (p->port << 8));
+          p->state = (c == 0x55) ? P_WAITING_FOR_HEADER_AA : P_WAITING_FOR_HEADER_55;
+        }
+        break;
+        
+      case P_READING_DATA:
+        if (headerInGoBLE(p)) {
+          //a GoBLE frame never holds a header, this one was cut short
+          packetErrorCount++;
+          badFrames++;
+          RECORD(REC_PACKET_ERROR, P_READING_DATA, c | (p->port << 8));
+          rescan = 1;
+          break;
+        }
+        p->frame[p->received++] = c;
+        p->checksum += c;
+        if (p->received == p->length) {
+          //last byte is the checksum, not included in the packet length calculation
+          p->state = P_WAITING_FOR_CHECKSUM;
+        }
+        break;
+
+      case P_WAITING_FOR_CHECKSUM:        
+        p->state = P_WAITING_FOR_HEADER_55;
+        if ((p->checksum != c) || headerInGoBLE(p)) {
+          //if the packet checksum fails, give up on it and look for the next header inside it
+          packetErrorCount++;
+          badFrames++;
+          RECORD(REC_PACKET_ERROR, P_WAITING_FOR_CHECKSUM, c | (p->port << 8));
+          rescan = 1;
+        } else if (!deliver) {
+          packetOverriddenCount++;   //valid, but the other link has control
+        } else if (p->address == STREAM_ADDRESS) {
+          //joint frames are interpolated, every one of them is needed
+          ServoStream_Push(&p->frame[1], p->frame[0], Timer_millis());
+          frameStampUs = Timer_micros();
+          streamFrames++;
+        } else if (p->address == SCRIPT_ADDRESS) {
+          //script uploads do not change the command
+          Script_Push(&p->frame[1], p->frame[0]);
+        } else if (p->address == DUMP_ADDRESS) {
+          //answered from Telemetry_Service, the command is unchanged
+          Telemetry_Request(p->frame[1]);
+        } else if (p->address == CONFIG_ADDRESS) {
+          //applied on COMMIT, the command is unchanged
+          Config_Push(&p->frame[1], p->frame[0]);
+        } else {          
+          //newest valid packet wins, keep reading in case there is a newer one
+          for (uint8_t i = 0; i < p->length; i++) {
+            packetData[i] = p->frame[i];
+          }
+          packetStampUs = Timer_micros();
+          frameStampUs = packetStampUs;
+          newPackets++;
+        }
+        break;
+
+      default:
+        p->state = P_WAITING_FOR_HEADER_55;
+        break;
+    }
+
+    if (rescan) {
+      //scan the rejected bytes after its 0x55 again, ahead of any still waiting
+      uint8_t kept = p->rawLength - 1;
+      uint8_t waiting = replayLength - replayPos;
+      memmove(&replay[kept], &replay[replayPos], waiting);
+      memcpy(replay, &p->raw[1], kept);
+      replayPos = 0;
+      replayLength = kept + waiting;
+      p->rawLength = 0;
+      p->state = P_WAITING_FOR_HEADER_55;
+    }
+  }
+
+  if (newPackets > 0) {
+    packetSupersededCount += newPackets - 1;
+    return P_NEW_DATA_AVAILABLE; // new data arrived!
+  }
+  if (streamFrames > 0) return P_STREAM_DATA;
+  if (badFrames > 0) return P_PACKET_ERROR;
+  return p->state; // no new data arrived
+}
+
+packetState_t BlueTooth_PacketHandler( void )
+/*!\brief   Parse everything buffered on the Bluetooth link
+\return packetState_t, see parseLink
+*/
+{
+  return parseLink(&bleParser, 1);
+}
+
+uint32_t BlueTooth_SupersededCount( void )
+/*!\brief   Number of valid packets dropped because a newer one was buffered
+\return superseded packet count
+*/
+{
+  return packetSupersededCount;
+}
+
+gaitCommand_t parsePacket( void ) 
+/*!\brief  Sets new state based off of which button was pressed 
+\details: By analyzing the global variable (packetData), this function will
+          figure out which button has been pressed and decide its new action
+          accordingly
+\param none
+\return gaitCommand_t
+*/
+{
+
+  gaitCommand_t newCmd = BOT_PARSE_ERROR;  //if all goes well, this will change by the end of the function
+
+  //clear the button press bitmask
+  uint8_t buttonsPressed = 0;
+
+   //if joystick is activated, set bit 0
+  if (packetData[1]) buttonsPressed |= 1;
+  
+  //set mask for buttons 1-6
+    for (uint8_t b = packetData[0]; b > 0; b--){
+      buttonsPressed |= (1 << packetData[1+b]);
+   }
+ 
+  //a stored script bound to this combination wins over the built-in commands
+  if (Script_Select(buttonsPressed)) return BOT_SCRIPT;
+ 
+  //buttons 5 and 6 together latch fight mode; it stays on while only the
+  //joystick is used and any other button releases it
+  if ((buttonsPressed & ~0x01) == 0x60) fightLatched = 1;
+  else if ((buttonsPressed & ~0x01) != 0) fightLatched = 0;
+  if (fightLatched) return BOT_FIGHT;
+ 
+  //decide which command to send
+ switch(buttonsPressed) {
+   case 0x40:  //1 << 6
+     newCmd = BOT_DEMO;
+     break;
+   case 0x20:  //1 << 5
+     newCmd = BOT_STAND;
+     break;
+   case 0x10:  //1 << 4
+     newCmd = BOT_ROTATE_LEFT;
+     break;
+   case 0x04:  //1 << 2
+     newCmd = BOT_ROTATE_RIGHT;
+     break;
+   case 0x0C:  //1 << 3 | 1 << 2
+   case 0x18:  //1 << 3 | 1 << 4
+   case 0x08:  //1 << 3
+     newCmd = BOT_WALK_BACK;
+     break;
+   case 0x06:  //1 << 1 | 1 << 2  
+   case 0x12:  //1 << 1 | 1 << 4
+   case 0x02:  //1 << 1
+     newCmd = BOT_WALK_FWD;
+     break;
+   default:
+     newCmd = BOT_STAND;
+     break;
+ }
+  
+  return newCmd;
+}
+
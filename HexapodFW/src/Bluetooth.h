@@ -4,6 +4,15 @@
 #include "UART.h"
 #include "Gaits.h"
 
+#if !defined(BLE_AUTO_CONFIG)
+#define BLE_AUTO_CONFIG 1     //negotiate baud rate and connection interval with the module at boot
+#endif
+#define LINK_TIMEOUT_MS 500   //stop and stand when no valid packet arrives for this long, 0 disables
+#define JITTER_SHIFT    4     //jitter is averaged over ~16 packets (RFC 3550 6.4.1)
+#define USE_WIRED_LINK  1     //also accept packets on UART0 (USB virtual COM), wired wins
+#define WIRED_BAUD      1000000u  //exact at 16MHz (IBRD 1, FBRD 0)
+#define WIRED_HOLD_MS   200   //wired keeps control this long after its last packet
+
 typedef enum packetStateType {
   P_WAITING_FOR_HEADER_55,
   P_WAITING_FOR_HEADER_AA,
@@ -12,13 +21,34 @@ typedef enum packetStateType {
   P_READING_DATA,
   P_WAITING_FOR_CHECKSUM,
   P_NEW_DATA_AVAILABLE,
-  P_PACKET_ERROR 
+  P_PACKET_ERROR,
+  P_STREAM_DATA
 } packetState_t;
 
+typedef struct linkStats
+{
+  uint32_t packets;      //!<Valid packets acted on
+  uint32_t superseded;   //!<Valid packets dropped for a newer one
+  uint32_t overridden;   //!<Valid Bluetooth packets dropped while the wired link had control
+  uint32_t wiredPackets; //!<Updates received over the wired link
+  uint32_t errors;       //!<Frames rejected by the parser (packetErrorCount)
+  uint32_t flushed;      //!<Bytes discarded looking for a header (flushcount)
+  uint32_t timeouts;     //!<Link timeouts that forced a stop
+  uint32_t lastRxMs;     //!<Timestamp of the last valid packet
+  uint32_t lastGapMs;    //!<Time between the last two valid packets
+  uint32_t minGapMs;     //!<Shortest gap seen
+  uint32_t maxGapMs;     //!<Longest gap seen
+  uint32_t jitterUs;     //!<Smoothed variation between consecutive gaps, microseconds
+} linkStats_t;
+
 void BlueTooth_Init( void );
 packetState_t BlueTooth_PacketHandler( void );
+uint32_t BlueTooth_SupersededCount( void );
 gaitCommand_t parsePacket( void );
 void checkBlueTooth(gaitCommand_t * cmd);
+void BlueTooth_SetLinkTimeout( uint32_t timeoutMs );
+void BlueTooth_GetLinkStats( linkStats_t * stats );
+void BlueTooth_ResetLinkStats( void );
 
 
 #endif
\ No newline at end of file
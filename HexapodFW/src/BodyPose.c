@@ -0,0 +1,139 @@
+/*! \file  BodyPose.c
+*
+* \brief
+* Body pose layer: height, pitch, roll and yaw on top of any gait
+*
+* \details
+*  The knee is modelled as a lever of KNEE_LENGTH_MM hanging below the hip, so
+*  a knee angle k (0 = straight down, 90 = horizontal) puts the foot
+*  L*cos(k) below the knee pivot. Tilting the body moves every mount point up
+*  or down; the new foot depth is converted back to a knee angle.
+*
+*  Both directions of that conversion are tables built once at boot:
+*    kneeDepth[k]  foot depth in 1/16 mm for knee angles 0..90
+*    depthKnee[d]  knee angle for a foot depth in 1/2 mm steps
+*  BodyPose_Set() works out a per-leg depth offset, so the per-servo cost in
+*  the control loop is one add, one clamp and two table reads.
+*
+*  Knees above horizontal (legs in the air) are passed through unchanged.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "BodyPose.h"
+#include "FixedMath.h"
+
+#define DEPTH_SHIFT   4                                   // depths are Q4 mm
+#define DEPTH_MAX     (KNEE_LENGTH_MM << DEPTH_SHIFT)
+#define KNEE_TABLE    91                                  // knee angles 0..90
+#define DEPTH_TABLE   ((KNEE_LENGTH_MM * 2) + 1)           // 1/2 mm steps 0..L
+
+static uint16_t kneeDepth[KNEE_TABLE];
+static uint8_t  depthKnee[DEPTH_TABLE];
+
+// hip mount points, same leg numbering as Gaits.h (0-2 right, 3-5 left)
+static const int16_t mountX[NUM_LEGS] = {
+  MOUNT_FRONT_X_MM, 0, -MOUNT_FRONT_X_MM, -MOUNT_FRONT_X_MM, 0, MOUNT_FRONT_X_MM
+};
+static const int16_t mountY[NUM_LEGS] = {
+  -MOUNT_CORNER_Y_MM, -MOUNT_MID_Y_MM, -MOUNT_CORNER_Y_MM,
+   MOUNT_CORNER_Y_MM,  MOUNT_MID_Y_MM,  MOUNT_CORNER_Y_MM
+};
+
+static bodyPose_t currentPose = {0, 0, 0, 0};
+static int16_t legDepth[NUM_LEGS];   // Q4 mm added to the foot depth of each leg
+static uint8_t poseActive = 0;
+
+void BodyPose_Init( void )
+/*!\brief   Build the knee/depth lookup tables
+\details Runs once at boot, uses the FixedMath sine table so no FPU or libm is
+         involved. depthKnee is filled with the knee angle whose depth is the
+         closest match for each half millimetre.
+\return none
+*/
+{
+  for (uint8_t k = 0; k < KNEE_TABLE; k++) {
+    int32_t c = FM_cos(FM_DEG_TO_ANGLE(k));
+    kneeDepth[k] = (uint16_t)((c * DEPTH_MAX + (FM_ONE_Q15 / 2)) / FM_ONE_Q15);
+  }
+
+  //depth grows as the knee angle shrinks, walk both tables once
+  uint8_t k = KNEE_TABLE - 1;
+  for (uint8_t d = 0; d < DEPTH_TABLE; d++) {
+    uint16_t depth = (uint16_t)d << (DEPTH_SHIFT - 1);
+    while ((k > 0) && (kneeDepth[k - 1] <= depth)) {
+      k--;
+    }
+    if ((k > 0) && ((kneeDepth[k - 1] - depth) < (depth - kneeDepth[k]))) {
+      depthKnee[d] = k - 1;
+    } else {
+      depthKnee[d] = k;
+    }
+  }
+
+  BodyPose_Set(&currentPose);
+}
+
+void BodyPose_Set( const bodyPose_t * pose )
+/*!\brief   Select a new body pose
+\details Converts height/pitch/roll into a foot depth offset per leg. The new
+         pose takes effect on the next servo write of each joint.
+\param pose[in]: requested pose, pitch and roll are clamped to POSE_MAX_TILT_DEG
+\return none
+*/
+{
+  currentPose = *pose;
+  if (currentPose.pitchDeg >  POSE_MAX_TILT_DEG) currentPose.pitchDeg =  POSE_MAX_TILT_DEG;
+  if (currentPose.pitchDeg < -POSE_MAX_TILT_DEG) currentPose.pitchDeg = -POSE_MAX_TILT_DEG;
+  if (currentPose.rollDeg  >  POSE_MAX_TILT_DEG) currentPose.rollDeg  =  POSE_MAX_TILT_DEG;
+  if (currentPose.rollDeg  < -POSE_MAX_TILT_DEG) currentPose.rollDeg  = -POSE_MAX_TILT_DEG;
+
+  int32_t sinPitch = FM_sin(FM_DEG_TO_ANGLE(currentPose.pitchDeg));
+  int32_t sinRoll  = FM_sin(FM_DEG_TO_ANGLE(currentPose.rollDeg));
+
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    int32_t dz = ((int32_t)currentPose.heightMm) << DEPTH_SHIFT;
+    dz += ((mountX[i] * sinPitch) - (mountY[i] * sinRoll)) >> (15 - DEPTH_SHIFT);
+    legDepth[i] = (int16_t)dz;
+  }
+
+  poseActive = (currentPose.heightMm != 0) || (currentPose.pitchDeg != 0) ||
+               (currentPose.rollDeg != 0) || (currentPose.yawDeg != 0);
+}
+
+void BodyPose_Get( bodyPose_t * pose )
+/*!\brief   Read back the active pose (after clamping)
+\param pose[out]: active pose
+\return none
+*/
+{
+  *pose = currentPose;
+}
+
+int16_t BodyPose_Hip( uint8_t leg, int16_t pos )
+/*!\brief   Apply the pose to a raw hip angle
+\param leg[in]: leg number 0-5
+       pos[in]: raw hip angle in degrees (left side already mirrored)
+\return posed hip angle in degrees
+*/
+{
+  if (leg >= NUM_LEGS) return pos;
+  return pos + currentPose.yawDeg;
+}
+
+int16_t BodyPose_Knee( uint8_t leg, int16_t pos )
+/*!\brief   Apply the pose to a knee angle
+\param leg[in]: leg number 0-5
+       pos[in]: knee angle in degrees as commanded by the gait
+\return posed knee angle in degrees
+*/
+{
+  if (!poseActive || (leg >= NUM_LEGS) || (pos < 0) || (pos >= KNEE_TABLE)) return pos;
+
+  int32_t depth = (int32_t)kneeDepth[pos] + legDepth[leg];
+  if (depth < 0) depth = 0;
+  if (depth > DEPTH_MAX) depth = DEPTH_MAX;
+
+  return depthKnee[(depth + (1 << (DEPTH_SHIFT - 2))) >> (DEPTH_SHIFT - 1)];
+}
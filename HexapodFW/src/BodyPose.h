@@ -0,0 +1,31 @@
+#if !defined(BODYPOSE_H)
+#define BODYPOSE_H
+
+#include <stdint.h>
+#include "Gaits.h"
+
+ // Leg geometry used by the pose tables, in mm. Knee length is measured from
+ // the knee pivot to the foot tip; mount points are the hip pivots relative
+ // to the body centre (x forward, y to the left).
+ #define KNEE_LENGTH_MM   50
+ #define MOUNT_FRONT_X_MM 60
+ #define MOUNT_CORNER_Y_MM 45
+ #define MOUNT_MID_Y_MM   55
+
+ #define POSE_MAX_TILT_DEG 30   // pitch and roll are clamped to this
+
+typedef struct bodyPose
+{
+  int16_t heightMm;   //!<Body height offset from the gait's pose, + raises the body
+  int16_t pitchDeg;   //!<+ lifts the front of the body
+  int16_t rollDeg;    //!<+ lifts the right side of the body
+  int16_t yawDeg;     //!<Added to every raw hip angle, twists the body over the feet
+} bodyPose_t;
+
+void BodyPose_Init( void );
+void BodyPose_Set( const bodyPose_t * pose );
+void BodyPose_Get( bodyPose_t * pose );
+int16_t BodyPose_Hip( uint8_t leg, int16_t pos );
+int16_t BodyPose_Knee( uint8_t leg, int16_t pos );
+
+#endif
@@ -0,0 +1,294 @@
+/*! \file  CPG.c
+*
+* \brief
+* Central pattern generator gait engine for the Vorpal Hexapod
+*
+* \details
+*  Alternative to the six phase tripod state machine in GaitHandler. Every leg
+*  owns a phase oscillator; neighbouring legs (around the body ring 0..5) are
+*  coupled so that they settle at the phase offsets of the selected gait.
+*  Hip and knee angles are read off the oscillator phase every update:
+*    - the swing part of the cycle maps to -90..+90 degrees of a sine, hip
+*      travels back to front while the knee is lifted by the cosine
+*    - the stance part maps to +90..270 degrees, hip travels front to back
+*      with the foot on the ground
+*  Gait, speed and direction only change oscillator parameters. Amplitudes
+*  and the swing fraction are slewed, so switching commands never produces a
+*  step in joint position.
+*
+*  Everything is integer arithmetic (FixedMath.c lookups, one divide per
+*  leg) so one update costs a few hundred cycles before the servo writes.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "CPG.h"
+#include "FixedMath.h"
+
+#define PHASE_SHIFT   8              // phase accumulators are binary angles in Q8
+#define PHASE_MASK    (0x00FFFFFFu)  // ... so they wrap at 2^24
+#define AMP_SLEW_Q8   24             // stride/lift ramp in Q8 degrees per ms (~94 deg/s)
+#define SWING_SLEW    64             // swing fraction ramp in 1/65536 cycle per ms
+#define MAX_AMPLITUDE 90             // keeps Q8 amplitudes inside int16_t
+
+typedef struct cpgGaitParams
+{
+  uint16_t periodMs;              // one full cycle of every leg
+  uint16_t swing;                 // fraction of the cycle spent in the air, 0x10000 = 1
+  int16_t  offsetDeg[NUM_LEGS];   // phase of each leg, only the differences matter
+} cpgGaitParams_t;
+
+static const cpgGaitParams_t gaitTable[CPG_NUM_GAITS] = {
+  { TRIPOD_CYCLE_TIME, 0x8000, {   0, 180,   0, 180,   0, 180 } },
+  { RIPPLE_CYCLE_TIME, 0x5555, { 240, 120,   0, 180, 300,  60 } },
+  { WAVE_CYCLE_TIME,   0x2AAB, { 120,  60,   0, 180, 240, 300 } }
+};
+
+static uint32_t phase[NUM_LEGS];     // Q8 binary angle
+static uint16_t offset[NUM_LEGS];    // binary angle
+static int16_t  lastHip[NUM_LEGS];
+static int16_t  lastKnee[NUM_LEGS];
+static uint8_t  lastAdj = 0;
+
+static uint32_t periodRate = 0;      // Q8 binary angle per ms at full speed
+static uint32_t phaseRate = 0;       // ... and derated by scale
+static uint8_t  scale = 100;         // percent of speed and stride, see CPG_SetScale
+static int32_t  swing = 0x8000, swingTarget = 0x8000;
+static int32_t  fwd = 0, fwdTarget = 0;        // Q8 degrees of hip swing
+static int32_t  turn = 0, turnTarget = 0;      // Q8 degrees, applied with opposite sign per side
+static int32_t  lift = 0, liftTarget = 0;      // Q8 degrees of knee lift
+static uint8_t  strideDeg = CPG_DEFAULT_STRIDE;
+static uint8_t  liftDeg = CPG_DEFAULT_LIFT;
+static uint16_t coupling = CPG_DEFAULT_COUPLING;
+static uint32_t lastUpdateMs = 0;
+
+static int32_t slew(int32_t value, int32_t target, int32_t step)
+{
+  if (value < target) return ((target - value) > step) ? (value + step) : target;
+  if (value > target) return ((value - target) > step) ? (value - step) : target;
+  return value;
+}
+
+static int32_t couplingError(uint8_t leg, uint8_t neighbour)
+{
+  //positive when the neighbour is ahead of where the gait wants it relative to leg
+  uint16_t err = (uint16_t)((phase[neighbour] >> PHASE_SHIFT) - (phase[leg] >> PHASE_SHIFT)
+                            - (uint16_t)(offset[neighbour] - offset[leg]));
+  return FM_sin(err);
+}
+
+void CPG_Init( void )
+/*!\brief   Load the tripod parameters and park the oscillators
+\return none
+*/
+{
+  CPG_SetGait(CPG_GAIT_TRIPOD);
+  swing = swingTarget;
+  CPG_Start(0);
+}
+
+void CPG_Start( uint32_t nowMs )
+/*!\brief   Restart the oscillators from the stand pose
+\details Phases are placed exactly at their gait offsets and all amplitudes
+         start at zero, so the first updates ramp out of the stand pose.
+\param nowMs[in]: current time in milliseconds
+\return none
+*/
+{
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    phase[i] = ((uint32_t)offset[i]) << PHASE_SHIFT;
+    lastHip[i] = NOMOVE;
+    lastKnee[i] = NOMOVE;
+  }
+  fwd = 0;
+  turn = 0;
+  lift = 0;
+  lastUpdateMs = nowMs;
+}
+
+void CPG_SetGait( cpgGait_t gait )
+/*!\brief   Switch the oscillator network to another gait
+\details Only targets change here. The coupling walks the phases to their new
+         offsets and the swing fraction is slewed in CPG_Update.
+\param gait[in]: gait to run
+\return none
+*/
+{
+  if (gait >= CPG_NUM_GAITS) return;
+
+  CPG_SetPeriod(gaitTable[gait].periodMs);
+  swingTarget = gaitTable[gait].swing;
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    offset[i] = FM_DEG_TO_ANGLE(gaitTable[gait].offsetDeg[i]);
+  }
+}
+
+void CPG_SetCommand( gaitCommand_t lastCmd )
+/*!\brief   Map a controller command onto oscillator amplitudes
+\details Walk commands set a forward component, rotations a turn component
+         (opposite sign on each side) and the diagonals a mix of both.
+         Anything else ramps the amplitudes to zero, which CPG_Update reports
+         as CPG_STOPPED once the legs are back in the stand pose.
+\param lastCmd[in]: command received from the controller
+\return none
+*/
+{
+  int32_t stride = (((int32_t)strideDeg * scale) << PHASE_SHIFT) / 100;
+
+  liftTarget = ((int32_t)liftDeg) << PHASE_SHIFT;
+  switch (lastCmd) {
+    case BOT_WALK_FWD:     fwdTarget =  stride; turnTarget = 0;           break;
+    case BOT_WALK_BACK:    fwdTarget = -stride; turnTarget = 0;           break;
+    case BOT_ROTATE_RIGHT: fwdTarget = 0;       turnTarget =  stride;     break;
+    case BOT_ROTATE_LEFT:  fwdTarget = 0;       turnTarget = -stride;     break;
+    case BOT_WALK_NW:      fwdTarget =  stride; turnTarget = -stride / 2; break;
+    case BOT_WALK_NE:      fwdTarget =  stride; turnTarget =  stride / 2; break;
+    case BOT_WALK_SW:      fwdTarget = -stride; turnTarget =  stride / 2; break;
+    case BOT_WALK_SE:      fwdTarget = -stride; turnTarget = -stride / 2; break;
+    default:
+      fwdTarget = 0;
+      turnTarget = 0;
+      liftTarget = 0;
+      break;
+  }
+}
+
+void CPG_SetPeriod( uint16_t periodMs )
+/*!\brief   Set the cycle time (speed) of every oscillator
+\param periodMs[in]: duration of one full step cycle in milliseconds
+\return none
+*/
+{
+  if (periodMs == 0) return;
+  periodRate = (PHASE_MASK + 1u) / periodMs;
+  phaseRate = (periodRate * scale) / 100u;
+}
+
+void CPG_SetScale( uint8_t percent )
+/*!\brief   Derate the oscillators for a sagging pack (setGaitDerate)
+\details Scales the oscillator frequency and the hip stride of the next
+         CPG_SetCommand; the knee lift is kept for ground clearance, as the
+         tripod gait keeps its knee travel.
+\param percent[in]: 1-100, 100 is the full gait
+\return none
+*/
+{
+  if (percent < 1) percent = 1;
+  if (percent > 100) percent = 100;
+  scale = percent;
+  phaseRate = (periodRate * scale) / 100u;
+}
+
+void CPG_SetAmplitude( uint8_t newStrideDeg, uint8_t newLiftDeg )
+/*!\brief   Set hip stride and knee lift used by subsequent commands
+\param newStrideDeg[in]: hip swing either side of neutral, degrees
+       newLiftDeg[in]: knee lift above KNEE_DOWN at mid swing, degrees
+\return none
+*/
+{
+  if (newStrideDeg > MAX_AMPLITUDE) newStrideDeg = MAX_AMPLITUDE;
+  if (newLiftDeg > MAX_AMPLITUDE) newLiftDeg = MAX_AMPLITUDE;
+  strideDeg = newStrideDeg;
+  liftDeg = newLiftDeg;
+}
+
+void CPG_SetCoupling( uint16_t gain )
+/*!\brief   Set how hard neighbouring oscillators pull on each other
+\param gain[in]: binary angle per ms applied at a full (90 degree) phase error
+\return none
+*/
+{
+  coupling = gain;
+}
+
+void CPG_SetPhaseOffset( uint8_t leg, uint16_t newOffset )
+/*!\brief   Override the phase offset of one leg of the current gait
+\param leg[in]: leg number 0-5
+       newOffset[in]: binary angle of the leg within the cycle
+\return none
+*/
+{
+  if (leg < NUM_LEGS) offset[leg] = newOffset;
+}
+
+cpgState_t CPG_Update( uint32_t nowMs )
+/*!\brief   Advance the oscillators and drive every hip and knee
+\details Integrates the elapsed time (clamped to CPG_MAX_STEP_MS so a stall
+         never turns into a jump), slews amplitudes, then converts each phase
+         to joint angles. Servos are only written when their angle changes.
+\param nowMs[in]: current time in milliseconds
+\return CPG_STOPPED once every amplitude has reached a zero target,
+        CPG_RUNNING otherwise
+*/
+{
+  uint32_t dt = nowMs - lastUpdateMs;
+  uint32_t next[NUM_LEGS];
+  uint8_t adj = 0;
+
+  if (dt > CPG_MAX_STEP_MS) dt = CPG_MAX_STEP_MS;
+  lastUpdateMs = nowMs;
+
+  fwd   = slew(fwd,   fwdTarget,   AMP_SLEW_Q8 * (int32_t)dt);
+  turn  = slew(turn,  turnTarget,  AMP_SLEW_Q8 * (int32_t)dt);
+  lift  = slew(lift,  liftTarget,  AMP_SLEW_Q8 * (int32_t)dt);
+  swing = slew(swing, swingTarget, SWING_SLEW * (int32_t)dt);
+
+  //phase update uses the phases from the start of the tick for every leg
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    uint8_t prev = (i == 0) ? (NUM_LEGS - 1) : (i - 1);
+    uint8_t nxt  = (i == (NUM_LEGS - 1)) ? 0 : (i + 1);
+    int32_t pull = couplingError(i, prev) + couplingError(i, nxt);
+    int32_t correction = (((int32_t)coupling * pull) >> 7) * (int32_t)dt;
+
+    next[i] = (phase[i] + (phaseRate * dt) + (uint32_t)correction) & PHASE_MASK;
+  }
+
+  if (liftDeg != 0) {
+    adj = (uint8_t)((CPG_FBSHIFT * lift) / (((int32_t)liftDeg) << PHASE_SHIFT));
+  }
+
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    uint16_t phi;
+    uint16_t psi;
+    int32_t amp;
+    int16_t hip;
+    int16_t knee;
+    int16_t c;
+
+    phase[i] = next[i];
+    phi = (uint16_t)(phase[i] >> PHASE_SHIFT);
+
+    //warp the phase so swing and stance each cover half a sine period
+    if (phi < (uint32_t)swing) {
+      psi = FM_ANGLE_270 + (uint16_t)(((uint32_t)phi * FM_ANGLE_180) / (uint32_t)swing);
+    } else {
+      psi = FM_ANGLE_90 + (uint16_t)(((uint32_t)(phi - swing) * FM_ANGLE_180) / (0x10000u - (uint32_t)swing));
+    }
+
+    amp = (i >= LEFT_START) ? (fwd - turn) : (fwd + turn);
+    hip = HIP_NEUTRAL + (int16_t)((amp * FM_sin(psi) + (1 << 22)) >> 23);
+
+    c = FM_cos(psi);
+    knee = KNEE_DOWN;
+    if (c > 0) {
+      knee += (int16_t)((lift * c + (1 << 22)) >> 23);
+    }
+
+    if ((hip != lastHip[i]) || (adj != lastAdj)) {
+      setHip(i, hip, adj);
+      lastHip[i] = hip;
+    }
+    if (knee != lastKnee[i]) {
+      setKnee(i, knee);
+      lastKnee[i] = knee;
+    }
+  }
+  lastAdj = adj;
+
+  if ((fwdTarget == 0) && (turnTarget == 0) && (liftTarget == 0) &&
+      (fwd == 0) && (turn == 0) && (lift == 0)) {
+    return CPG_STOPPED;
+  }
+  return CPG_RUNNING;
+}
@@ -0,0 +1,41 @@
+#if !defined(CPG_H)
+#define CPG_H
+
+#include <stdint.h>
+#include "Gaits.h"
+
+ // Cycle time of the gaits only the CPG engine knows about
+ #define WAVE_CYCLE_TIME 2400
+
+ #define CPG_DEFAULT_STRIDE   HIPSWING                      // degrees of hip swing either side of neutral
+ #define CPG_DEFAULT_LIFT     (KNEE_NEUTRAL - KNEE_DOWN)    // degrees of knee lift at mid swing
+ #define CPG_DEFAULT_COUPLING 40                            // binary angle per ms at full phase error
+ #define CPG_FBSHIFT          15                            // shift front legs back, back legs forward while moving
+ #define CPG_MAX_STEP_MS      50                            // longest interval integrated in one update
+
+typedef enum cpgGait
+{
+  CPG_GAIT_TRIPOD,   //!<Two sets of three legs, 50% swing
+  CPG_GAIT_RIPPLE,   //!<Back-to-front wave on each side, sides half a cycle apart
+  CPG_GAIT_WAVE,     //!<One leg in the air at a time
+  CPG_NUM_GAITS
+} cpgGait_t;
+
+typedef enum cpgState
+{
+  CPG_RUNNING,       //!<Legs are moving or ramping towards a new command
+  CPG_STOPPED        //!<All amplitudes have ramped down, bot is in the stand pose
+} cpgState_t;
+
+void CPG_Init( void );
+void CPG_Start( uint32_t nowMs );
+void CPG_SetGait( cpgGait_t gait );
+void CPG_SetCommand( gaitCommand_t lastCmd );
+void CPG_SetPeriod( uint16_t periodMs );
+void CPG_SetScale( uint8_t percent );
+void CPG_SetAmplitude( uint8_t strideDeg, uint8_t liftDeg );
+void CPG_SetCoupling( uint16_t gain );
+void CPG_SetPhaseOffset( uint8_t leg, uint16_t offset );
+cpgState_t CPG_Update( uint32_t nowMs );
+
+#endif
@@ -0,0 +1,304 @@
+/*! \file  Config.c
+*
+* \brief
+* Calibration and tuning kept in the on-chip EEPROM
+*
+* \details
+*  Servo trims, the servo pulse range, the tripod phase times, the link
+*  timeout, the I2C clock, the servo inrush budget, the PWM frame rate and
+*  the BLE baud rate live in one CONFIG_IMAGE_SIZE byte image (Config.h)
+*  with a version and a CRC. Config_Init loads it at boot, falling back to
+*  the compiled-in defaults when nothing valid is stored; Config_Apply then
+*  fills the runtime tables the hot path reads (servoOffset, the PCA9685
+*  count table, the phase times, the inrush budget), so nothing in the
+*  control loop ever touches the EEPROM.
+*
+*  The image in use is kept in a HW_NO_INIT copy with a stamp of its CRC.
+*  After a warm reset only the stored CRC word is read: if it matches the
+*  stamp, and the copy still has its magic, version and in range fields,
+*  the copy is used without reading the body from the EEPROM. A copy that
+*  fails those checks is reloaded from the EEPROM as on a cold boot.
+*
+*  Updates come over the command link (Config.h): patches go to a staged
+*  copy, COMMIT checks it against the host's CRC and the field ranges,
+*  writes it (only if it differs from the image in use) and applies it.
+*  The PWM frame rate and the BLE baud rate take effect at the next boot.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Config.h"
+#include "HWReg.h"
+#include "EEPROM.h"
+#include "Gaits.h"
+#include "PCA9685.h"
+#include "I2C.h"
+#include "Bluetooth.h"
+#include "BLEModule.h"
+
+#define CONFIG_WORDS        (CONFIG_IMAGE_SIZE / 4)
+#define CONFIG_STAMP(crc)   ((((uint32_t)(crc)) << 16) | (uint16_t)~(crc))
+
+//the image layout in Config.h must match the structure
+typedef char configSizeCheck[(sizeof(configImage_t) == CONFIG_IMAGE_SIZE) ? 1 : -1];
+
+static HW_NO_INIT configImage_t active;
+static HW_NO_INIT uint32_t activeStamp;
+static configImage_t staged;
+static configResult_t lastResult = CONFIG_OK;
+
+static uint16_t crc16( const uint8_t * data, uint16_t length )
+{
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static void seal( configImage_t * image )
+{
+  image->magic = CONFIG_MAGIC;
+  image->version = CONFIG_VERSION;
+  image->length = CONFIG_IMAGE_SIZE;
+  image->crc = crc16((const uint8_t *)image, CF_CRC);
+}
+
+static void loadDefaults( configImage_t * image )
+{
+  for (uint8_t i = 0; i < 12; i++) {
+    image->servoTrim[i] = 0;
+  }
+  image->pwmHz = SERVO_PWM_HZ;
+  image->pulseMinUs = 1000;
+  image->pulseMaxUs = 2000;
+  image->liftMs = 50;
+  image->swivelMs = 50;
+  image->setMs = 50;
+  image->linkTimeoutMs = LINK_TIMEOUT_MS;
+  image->i2cTimerPeriod = I2C1_TPR_100KBPS;
+  image->staggerMs = INRUSH_STAGGER_MS;
+  image->bleBaud = BLE_TARGET_BAUD;
+  image->inrushBudgetMa = INRUSH_BUDGET_MA;
+  image->servoStartMa = SERVO_START_MA;
+  image->sequence = 0;
+  seal(image);
+}
+
+static uint8_t inRange( uint32_t value, uint32_t low, uint32_t high )
+{
+  return (value >= low) && (value <= high);
+}
+
+static uint8_t validate( const configImage_t * image )
+{
+  for (uint8_t i = 0; i < 12; i++) {
+    if ((image->servoTrim[i] < -45) || (image->servoTrim[i] > 45)) return 0;
+  }
+  if (!inRange(image->pwmHz, 40, 400)) return 0;
+  if (!inRange(image->pulseMinUs, 400, 1500)) return 0;
+  if (!inRange(image->pulseMaxUs, image->pulseMinUs + 200, 2600)) return 0;
+  if (image->pulseMaxUs >= (1000000u / image->pwmHz)) return 0;
+  if (!inRange(image->liftMs, 10, 5000)) return 0;
+  if (!inRange(image->swivelMs, 10, 5000)) return 0;
+  if (!inRange(image->setMs, 10, 5000)) return 0;
+  if ((image->linkTimeoutMs != 0) && !inRange(image->linkTimeoutMs, 100, 60000)) return 0;
+  if (!inRange(image->i2cTimerPeriod, 1, 0x7F)) return 0;
+  if (!inRange(image->bleBaud, 9600, 1000000)) return 0;
+  if (image->staggerMs > 10) return 0;
+  if (!inRange(image->servoStartMa, 100, 5000)) return 0;
+  if (image->inrushBudgetMa < image->servoStartMa) return 0;   //at least one servo has to be able to start
+  return 1;
+}
+
+static uint8_t headerOk( const configImage_t * image )
+{
+  return (image->magic == CONFIG_MAGIC) && (image->version == CONFIG_VERSION) &&
+         (image->length == CONFIG_IMAGE_SIZE);
+}
+
+static uint8_t imageOk( const configImage_t * image )
+{
+  if (!headerOk(image)) return 0;
+  if (crc16((const uint8_t *)image, CF_CRC) != image->crc) return 0;
+  return validate(image);
+}
+
+static uint32_t tailWord( const configImage_t * image )
+{
+  return ((uint32_t)image->crc << 16) | image->sequence;
+}
+
+configSource_t Config_Init( void )
+/*!\brief   Load the stored configuration, or the defaults
+\details Call once at boot before the drivers that read it. Leaves the
+         staged image equal to the one in use.
+\return configSource_t: where the image in use came from
+*/
+{
+  configSource_t source = CONFIG_FROM_DEFAULTS;
+  configImage_t stored;
+  uint32_t tail;
+
+  if ((EEPROM_Init() == EEPROM_STATUS_OK) &&
+      (EEPROM_Read(CONFIG_EEPROM_WORD + CONFIG_WORDS - 1, &tail, 1) == EEPROM_STATUS_OK)) {
+    if ((activeStamp == CONFIG_STAMP(active.crc)) && (tail == tailWord(&active)) &&
+        headerOk(&active) && validate(&active)) {
+      source = CONFIG_FROM_RAM;   //unchanged since it was checked, skip the body
+    }
+    else if ((EEPROM_Read(CONFIG_EEPROM_WORD, (uint32_t *)&stored, CONFIG_WORDS) == EEPROM_STATUS_OK) &&
+             imageOk(&stored)) {
+      active = stored;
+      source = CONFIG_FROM_EEPROM;
+    }
+  }
+  if (source == CONFIG_FROM_DEFAULTS) loadDefaults(&active);
+  activeStamp = CONFIG_STAMP(active.crc);
+
+  staged = active;
+  lastResult = CONFIG_OK;
+  return source;
+}
+
+const configImage_t * Config_Get( void )
+/*!\brief   The image in use
+\return pointer to it, valid after Config_Init
+*/
+{
+  return &active;
+}
+
+void Config_Apply( void )
+/*!\brief   Copy the image in use into the runtime tables
+\details Call after I2C_InitPort1 and PCA9685_UpdatePWMFrequency (the count
+         table is built against the PWM period the PCA9685 is running at),
+         and again after every commit.
+\return none
+*/
+{
+  for (uint8_t i = 0; i < 12; i++) {
+    setServoTrim(i, active.servoTrim[i]);
+  }
+  PCA9685_SetPulseRange(active.pulseMinUs, active.pulseMaxUs);
+  setPhaseTimes(active.liftMs, active.swivelMs, active.setMs);
+  BlueTooth_SetLinkTimeout(active.linkTimeoutMs);
+  I2C_SetClock(active.i2cTimerPeriod);
+  setInrushBudget(active.inrushBudgetMa, active.servoStartMa, active.staggerMs);
+}
+
+static configResult_t commit( uint16_t crc )
+{
+  const uint8_t * fields = (const uint8_t *)&staged;
+  const uint8_t * current = (const uint8_t *)&active;
+  uint8_t changed = 0;
+
+  if (crc16(&fields[CF_TRIM], CF_SEQUENCE - CF_TRIM) != crc) return CONFIG_BAD_CRC;
+  if (!validate(&staged)) return CONFIG_BAD_VALUE;
+
+  for (uint8_t i = CF_TRIM; i < CF_SEQUENCE; i++) {
+    if (fields[i] != current[i]) changed = 1;
+  }
+  if (!changed) return CONFIG_OK;   //nothing to store, spare the EEPROM a write
+
+  staged.sequence = active.sequence + 1;
+  seal(&staged);
+  if (EEPROM_Write(CONFIG_EEPROM_WORD, (const uint32_t *)&staged, CONFIG_WORDS) != EEPROM_STATUS_OK) {
+    staged = active;
+    return CONFIG_EEPROM_ERROR;
+  }
+  active = staged;
+  activeStamp = CONFIG_STAMP(active.crc);
+  Config_Apply();
+  return CONFIG_OK;
+}
+
+void Config_Push( const uint8_t * payload, uint8_t length )
+/*!\brief   Handle one configuration packet from the command link
+\details Only COMMIT touches the EEPROM; it stalls for about a millisecond,
+         the control loop may count an overrun.
+\param payload[in]: packet payload, see Config.h
+       length[in]: payload length
+\return none, the outcome is kept for Config_LastResult
+*/
+{
+  uint8_t * bytes = (uint8_t *)&staged;
+
+  if (length < 1) {
+    lastResult = CONFIG_BAD_COMMAND;
+    return;
+  }
+
+  switch (payload[0]) {
+    case CONFIG_CMD_WRITE:
+      //only the settable fields, the header and the seal are filled in on commit
+      if ((length < 3) || (payload[1] < CF_TRIM) || ((payload[1] + (length - 2)) > CF_SEQUENCE)) {
+        lastResult = CONFIG_BAD_COMMAND;
+        break;
+      }
+      for (uint8_t i = 2; i < length; i++) {
+        bytes[payload[1] + (i - 2)] = payload[i];
+      }
+      lastResult = CONFIG_OK;
+      break;
+
+    case CONFIG_CMD_COMMIT:
+      if (length < 3) {
+        lastResult = CONFIG_BAD_COMMAND;
+        break;
+      }
+      lastResult = commit((uint16_t)(payload[1] | (payload[2] << 8)));
+      if (lastResult != CONFIG_OK) staged = active;
+      break;
+
+    case CONFIG_CMD_DEFAULTS:
+      loadDefaults(&staged);
+      lastResult = CONFIG_OK;
+      break;
+
+    case CONFIG_CMD_REVERT:
+      staged = active;
+      lastResult = CONFIG_OK;
+      break;
+
+    default:
+      lastResult = CONFIG_BAD_COMMAND;
+      break;
+  }
+}
+
+configResult_t Config_LastResult( void )
+/*!\brief   Outcome of the most recent configuration packet
+\return configResult_t
+*/
+{
+  return lastResult;
+}
+
+uint8_t Config_BuildFrame( uint8_t * frame )
+/*!\brief   Fill one DUMP_CONFIG answer frame
+\param frame[out]: at least CONFIG_FRAME bytes
+\return frame length in bytes
+*/
+{
+  const uint8_t * image = (const uint8_t *)&active;
+  uint8_t checksum = 0;
+
+  frame[0] = 0x55;
+  frame[1] = 0xAA;
+  frame[2] = CONFIG_OUT_ADDRESS;
+  frame[3] = CONFIG_PAYLOAD;
+  for (uint8_t i = 0; i < CONFIG_IMAGE_SIZE; i++) {
+    frame[4 + i] = image[i];
+  }
+  frame[4 + CONFIG_IMAGE_SIZE] = (uint8_t)lastResult;
+
+  for (uint8_t i = 0; i < (CONFIG_FRAME - 1); i++) {
+    checksum += frame[i];
+  }
+  frame[CONFIG_FRAME - 1] = checksum;
+  return CONFIG_FRAME;
+}
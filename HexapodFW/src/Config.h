@@ -0,0 +1,99 @@
+#if !defined(CONFIG_H)
+#define CONFIG_H
+
+#include <stdint.h>
+
+ // The configuration image, CONFIG_IMAGE_SIZE bytes at EEPROM word
+ // CONFIG_EEPROM_WORD, multi-byte fields little endian. crc is the
+ // CRC-16/CCITT of every byte before it.
+#define CONFIG_MAGIC        (0x4643)   //"CF"
+#define CONFIG_VERSION      (2)
+#define CONFIG_IMAGE_SIZE   (44)
+#define CONFIG_EEPROM_WORD  (0)
+#define CF_MAGIC       0    //u16 CONFIG_MAGIC
+#define CF_VERSION     2    //u8  CONFIG_VERSION
+#define CF_LENGTH      3    //u8  CONFIG_IMAGE_SIZE
+#define CF_TRIM        4    //s8 x12 degrees added to every command, per servo channel
+#define CF_PWM_HZ      16   //u16 servo frame rate (next boot)
+#define CF_PULSE_MIN   18   //u16 pulse width at 0 degrees, us
+#define CF_PULSE_MAX   20   //u16 pulse width at 180 degrees, us
+#define CF_LIFT_MS     22   //u16 tripod lift phase, without the servo model
+#define CF_SWIVEL_MS   24   //u16 tripod swivel phase
+#define CF_SET_MS      26   //u16 tripod set phase
+#define CF_LINK_MS     28   //u16 link timeout, 0 disables the fail-safe
+#define CF_I2C_TPR     30   //u8  I2C1 MTPR, see I2C_SetClock
+#define CF_STAGGER_MS  31   //u8  servo pulse start offset between channels
+#define CF_BLE_BAUD    32   //u32 baud rate the BLE module is moved to (next boot)
+#define CF_INRUSH_MA   36   //u16 current budget for servos starting large moves together
+#define CF_START_MA    38   //u16 current one servo draws starting a large move
+#define CF_SEQUENCE    40   //u16 bumped by every commit
+#define CF_CRC         42   //u16
+
+typedef struct configImage
+{
+  uint16_t magic;
+  uint8_t  version;
+  uint8_t  length;
+  int8_t   servoTrim[12];
+  uint16_t pwmHz;
+  uint16_t pulseMinUs;
+  uint16_t pulseMaxUs;
+  uint16_t liftMs;
+  uint16_t swivelMs;
+  uint16_t setMs;
+  uint16_t linkTimeoutMs;
+  uint8_t  i2cTimerPeriod;
+  uint8_t  staggerMs;
+  uint32_t bleBaud;
+  uint16_t inrushBudgetMa;
+  uint16_t servoStartMa;
+  uint16_t sequence;
+  uint16_t crc;
+} configImage_t;
+
+ // Updates use the GoBLE framing (0x55 0xAA address length payload checksum)
+ // on their own address. Payload:
+ //   [0] CONFIG_CMD_*
+ //   WRITE:    [1] image offset  [2..] bytes, patch the staged image
+ //   COMMIT:   [1..2] CRC-16/CCITT the host computed over bytes CF_TRIM up
+ //             to CF_SEQUENCE of the staged image, then it is checked,
+ //             stored and applied
+ //   DEFAULTS: nothing, stage the compiled-in defaults
+ //   REVERT:   nothing, stage the image in use again
+ // The staged image starts as the one in use. The magic, version, length,
+ // sequence and crc fields are filled in on commit.
+#define CONFIG_ADDRESS      (0x15)
+#define CONFIG_CMD_WRITE    (1)
+#define CONFIG_CMD_COMMIT   (2)
+#define CONFIG_CMD_DEFAULTS (3)
+#define CONFIG_CMD_REVERT   (4)
+
+ // DUMP_CONFIG answer: the image in use and the last update result
+#define CONFIG_OUT_ADDRESS  (0x23)
+#define CONFIG_PAYLOAD      (CONFIG_IMAGE_SIZE + 1)
+#define CONFIG_FRAME        (CONFIG_PAYLOAD + 5)
+
+typedef enum configResult
+{
+  CONFIG_OK,
+  CONFIG_BAD_COMMAND,    //!<Unknown command or a write outside the image
+  CONFIG_BAD_CRC,        //!<The staged image does not match the host's CRC
+  CONFIG_BAD_VALUE,      //!<A field is out of range
+  CONFIG_EEPROM_ERROR
+} configResult_t;
+
+typedef enum configSource
+{
+  CONFIG_FROM_DEFAULTS,  //!<Nothing valid stored
+  CONFIG_FROM_EEPROM,    //!<Read and checked
+  CONFIG_FROM_RAM        //!<Warm reset, the copy in RAM matched the stored CRC
+} configSource_t;
+
+configSource_t Config_Init( void );
+const configImage_t * Config_Get( void );
+void Config_Apply( void );
+void Config_Push( const uint8_t * payload, uint8_t length );
+configResult_t Config_LastResult( void );
+uint8_t Config_BuildFrame( uint8_t * frame );
+
+#endif
@@ -0,0 +1,174 @@
+/*! \file  Contact.c
+*
+* \brief
+* Foot contact detection from the knee servo supply current
+*
+* \details
+*  Each tripod's three knee servos are fed through one shunt, its amplifier
+*  output goes to an analog input (Contact.h). ADC1 sequencer 2 converts
+*  both inputs on every control tick: Timer 1A starts it in hardware, the
+*  same trigger the pack voltage sequencer uses (Battery.c), and
+*  Contact_Service picks the results up when the raw status bit is set.
+*
+*  A leg swinging down draws little; once the foot lands the servo pushes
+*  the body's weight and its current jumps. GaitHandler arms the tripod it
+*  is setting down. Past CONTACT_BLANK_MS (the start current of the move
+*  itself) a rise of CONTACT_LEG_SPIKE_MA per leg of the group above the
+*  lowest current seen, the legs held up in the air or swinging, means
+*  every foot of the group is down. The set phase then ends without waiting for the full
+*  knee travel. A landing that is never seen changes nothing, the phase
+*  ends at its usual time.
+*
+* \author vsimontov
+*
+* \info
+* Based on TIVA User Reference manual, ADC Initialization and Configuration
+* (pg.817)
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include "Contact.h"
+#include "ADC.h"
+#include "Gaits.h"
+#include "Timer.h"
+#include <tm4c123gh6pm.h>
+
+#define ADC_FULL_SCALE  (4095u)
+#define ADC_REF_MV      (3300u)
+
+static const uint8_t groupLegs[CONTACT_GROUPS] = { TRIPOD1_LEGS, TRIPOD2_LEGS };
+
+typedef struct contactGroup
+{
+  uint32_t armedAt;
+  uint16_t floorMa;      //lowest current since the legs were held up
+  uint16_t spikeMa;      //rise that means every armed foot is down
+  uint8_t  armed;
+  uint8_t  touched;
+} contactGroup_t;
+
+static contactGroup_t group[CONTACT_GROUPS];
+static contactStats_t stats;
+
+void Contact_Init( void )
+/*!\brief   Start sampling the knee currents on every control tick
+\details Call after Control_Init, which sets Timer 1A up.
+\return none
+*/
+{
+  for (uint8_t g = 0; g < CONTACT_GROUPS; g++) {
+    group[g].armed = 0;
+    group[g].touched = 0;
+    stats.currentMa[g] = 0;
+  }
+  stats.arms = 0;
+  stats.touches = 0;
+
+  //1. Clock ADC1 and ports B and E, PE4 and PB4 as analog inputs
+  SYSCTL_RCGCADC_R |= ADC1_CLK;
+  SYSCTL_RCGCGPIO_R |= (GPIO_PORTB_CLK | GPIO_PORTE_CLK);
+  while ((SYSCTL_PRADC_R & ADC1_CLK) == 0);
+
+  GPIO_PORTE_AFSEL_R |= CONTACT_PORTE_PIN;
+  GPIO_PORTE_DEN_R   &= ~CONTACT_PORTE_PIN;
+  GPIO_PORTE_AMSEL_R |= CONTACT_PORTE_PIN;
+  GPIO_PORTB_AFSEL_R |= CONTACT_PORTB_PIN;
+  GPIO_PORTB_DEN_R   &= ~CONTACT_PORTB_PIN;
+  GPIO_PORTB_AMSEL_R |= CONTACT_PORTB_PIN;
+
+  //2. Sequencer 2: disabled while configuring, timer triggered, 64x averaging
+  ADC1_ACTSS_R &= ~ADC_ACTSS_ASEN2;
+  ADC1_SAC_R = ADC_HW_AVG_64;
+  ADC1_EMUX_R = (ADC1_EMUX_R & ~ADC_EMUX_EM2_M) | ADC_EMUX_TIMER2;
+  ADC1_SSMUX2_R = CONTACT_AIN_TRIPOD1 | (CONTACT_AIN_TRIPOD2 << 4);
+  ADC1_SSCTL2_R = ((uint32_t)(ADC_SSCTL_END | ADC_SSCTL_IE)) << 4;   //raw status only, IM stays clear
+  ADC1_ISC_R = ADC_ISC_IN2;
+  ADC1_ACTSS_R |= ADC_ACTSS_ASEN2;
+
+  //3. Let the control tick time-out start the conversions
+  TIMER1_CTL_R |= TAOTE;
+}
+
+static uint8_t legCount( uint8_t legMask )
+{
+  uint8_t count = 0;
+  for (; legMask; legMask &= (legMask - 1)) count++;
+  return count;
+}
+
+void Contact_Service( uint32_t nowMs )
+/*!\brief   Pick up a finished conversion, if any, and look for landings
+\details Cheap when nothing is ready; call once per main loop pass.
+\param nowMs[in]: Timer_millis
+\return none
+*/
+{
+  if ((ADC1_RIS_R & ADC_RIS_INR2) == 0) return;
+
+  for (uint8_t g = 0; g < CONTACT_GROUPS; g++) {
+    uint32_t code = ADC1_SSFIFO2_R & ADC_FULL_SCALE;
+    uint32_t mv = (code * ADC_REF_MV) / ADC_FULL_SCALE;
+    uint16_t ma = (uint16_t)((mv * 1000u) / CONTACT_MV_PER_A);
+    contactGroup_t * c = &group[g];
+
+    stats.currentMa[g] = ma;
+    if (!c->armed || c->touched || ((nowMs - c->armedAt) < CONTACT_BLANK_MS)) continue;
+    if (ma < c->floorMa) {
+      c->floorMa = ma;
+    }
+    else if ((ma - c->floorMa) >= c->spikeMa) {
+      c->touched = 1;
+      stats.touches++;
+    }
+  }
+  ADC1_ISC_R = ADC_ISC_IN2;
+}
+
+void Contact_Arm( uint8_t legMask, uint32_t nowMs )
+/*!\brief   Watch for the landing of legs that have just been sent down
+\param legMask[in]: legs being set down, groups without any are disarmed
+       nowMs[in]: Timer_millis when the move was commanded
+\return none
+*/
+{
+  for (uint8_t g = 0; g < CONTACT_GROUPS; g++) {
+    contactGroup_t * c = &group[g];
+    uint8_t legs = legCount(legMask & groupLegs[g]);
+
+    c->armed = (legs != 0);
+    c->touched = 0;
+    c->armedAt = nowMs;
+    c->floorMa = stats.currentMa[g];   //held up in the air
+    c->spikeMa = legs * CONTACT_LEG_SPIKE_MA;
+    if (c->armed) stats.arms++;
+  }
+}
+
+uint8_t Contact_Touched( uint8_t legMask )
+/*!\brief   Whether the legs armed last have all landed
+\param legMask[in]: legs asked about
+\return 1 if every group holding one of them saw its landing, 0 otherwise
+*/
+{
+  uint8_t asked = 0;
+
+  for (uint8_t g = 0; g < CONTACT_GROUPS; g++) {
+    if (!(legMask & groupLegs[g])) continue;
+    if (!group[g].armed || !group[g].touched) return 0;
+    asked = 1;
+  }
+  return asked;
+}
+
+void Contact_GetStats( contactStats_t * out )
+/*!\brief   Copy of the detection counters and the latest currents
+\param out[out]: filled in
+\return none
+*/
+{
+  *out = stats;
+}
@@ -0,0 +1,31 @@
+#if !defined(CONTACT_H)
+#define CONTACT_H
+
+#include <stdint.h>
+
+ // Knee servo supply current, one shunt amplifier per tripod: TRIPOD1 knees
+ // on AIN9 (PE4), TRIPOD2 knees on AIN10 (PB4). ADC1 sequencer 2 converts
+ // both on every control tick (Timer 1A TAOTE), 64x averaged.
+#define CONTACT_GROUPS        (2)
+#define CONTACT_AIN_TRIPOD1   (9)
+#define CONTACT_AIN_TRIPOD2   (10)
+#define CONTACT_PORTE_PIN     (0x01 << 4)   //PE4
+#define CONTACT_PORTB_PIN     (0x01 << 4)   //PB4
+#define CONTACT_MV_PER_A      (1000)        //50 mOhm shunt, gain 20 amplifier
+#define CONTACT_LEG_SPIKE_MA  (300)         //rise per landed leg over the lowest current since the leg started down
+#define CONTACT_BLANK_MS      (40)          //start current of the knee move itself, not a landing
+
+typedef struct contactStats
+{
+  uint32_t arms;         //!<Set phases watched
+  uint32_t touches;      //!<... that saw the landing
+  uint16_t currentMa[CONTACT_GROUPS];   //!<Latest knee current per tripod
+} contactStats_t;
+
+void Contact_Init( void );
+void Contact_Service( uint32_t nowMs );
+void Contact_Arm( uint8_t legMask, uint32_t nowMs );
+uint8_t Contact_Touched( uint8_t legMask );
+void Contact_GetStats( contactStats_t * stats );
+
+#endif
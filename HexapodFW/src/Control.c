@@ -0,0 +1,114 @@
+/*! \file  Control.c
+*
+* \brief
+* Fixed-rate control loop for the Vorpal Hexapod
+*
+* \details
+*  Timer 1A ticks once per PCA9685 PWM period. Each tick the gait state
+*  machine runs exactly once inside a servo transaction, and the resulting
+*  12-servo frame goes out as a single I2C burst. Everything else (Bluetooth
+*  command parsing) runs in whatever time is left before the next tick.
+*
+*  If the main loop comes back after more than one tick has elapsed, the
+*  missing frames are counted as overruns; they are never made up, the next
+*  frame is simply computed against the current time.
+*
+*  A mode that follows the controller directly (fight mode) marks the frame
+*  that consumes a new packet with the packet's receive time; the latency to
+*  the end of that frame's commit is kept in the stats.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Control.h"
+#include "Timer.h"
+#include "PCA9685.h"
+#include "Recorder.h"
+
+static controlStats_t stats;
+static uint32_t lastTick = 0;
+static uint8_t  inputPending = 0;
+static uint32_t inputStampUs = 0;
+
+void Control_Init( void )
+/*!\brief   Start the control tick at the PCA9685 PWM period
+\details Call after PCA9685_UpdatePWMFrequency so the period matches the
+         prescale the servo driver is really running at
+\return none
+*/
+{
+  Control_ResetStats();
+  stats.periodUs = PCA9685_GetPeriodUs();
+  Timer_ControlTickInit(stats.periodUs);
+  lastTick = Timer_controlTicks();
+}
+
+uint8_t Control_Service( gaitCommand_t lastCmd )
+/*!\brief   Run one control frame if a tick is due
+\details Call from the main loop as often as possible. Returns straight away
+         when no tick is pending, so the caller can spend the slack on
+         command processing.
+\param lastCmd[in]: most recent command from the controller
+\return 1 if a frame was computed and committed, 0 otherwise
+*/
+{
+  uint32_t now = Timer_controlTicks();
+
+  if (now == lastTick) return 0;
+
+  if ((now - lastTick) > 1) {
+    stats.overruns += (now - lastTick) - 1;
+    RECORD(REC_OVERRUN, 0, (now - lastTick) - 1);
+  }
+  lastTick = now;
+
+  uint32_t start = Timer_micros();
+  transactServos();
+  runGaitFSM(lastCmd);
+  commitServos();
+  uint32_t end = Timer_micros();
+  stats.lastLoopUs = end - start;
+
+  if (inputPending) {
+    stats.lastInputUs = end - inputStampUs;
+    if (stats.lastInputUs > stats.maxInputUs) stats.maxInputUs = stats.lastInputUs;
+    if (stats.lastInputUs > stats.periodUs) stats.lateInputs++;
+    stats.inputs++;
+    inputPending = 0;
+  }
+
+  if (stats.lastLoopUs > stats.maxLoopUs) stats.maxLoopUs = stats.lastLoopUs;
+  stats.ticks++;
+  return 1;
+}
+
+void Control_MarkInput( uint32_t stampUs )
+/*!\brief   Note that the frame being computed acts on a new packet
+\details Call from inside the gait state machine
+\param stampUs[in]: Timer_micros() when the packet passed its checksum
+\return none
+*/
+{
+  inputStampUs = stampUs;
+  inputPending = 1;
+}
+
+void Control_GetStats( controlStats_t * out )
+/*!\brief   Copy out the loop timing counters
+\param out[out]: current statistics
+\return none
+*/
+{
+  *out = stats;
+}
+
+void Control_ResetStats( void )
+/*!\brief   Clear tick, overrun and loop time counters
+\return none
+*/
+{
+  uint32_t periodUs = stats.periodUs;
+  stats = (controlStats_t){0};
+  stats.periodUs = periodUs;
+}
@@ -0,0 +1,26 @@
+#if !defined(CONTROL_H)
+#define CONTROL_H
+
+#include <stdint.h>
+#include "Gaits.h"
+
+typedef struct controlStats
+{
+  uint32_t periodUs;     //!<Control period, matched to the PCA9685 PWM period
+  uint32_t ticks;        //!<Frames computed and committed
+  uint32_t overruns;     //!<Control periods that passed without a frame
+  uint32_t lastLoopUs;   //!<Compute + commit time of the last frame
+  uint32_t maxLoopUs;    //!<Worst compute + commit time seen
+  uint32_t inputs;       //!<Frames that carried a freshly received input
+  uint32_t lastInputUs;  //!<Packet checksum to servo commit for the last one
+  uint32_t maxInputUs;   //!<Worst packet to commit latency seen
+  uint32_t lateInputs;   //!<Inputs that took longer than one period to reach the servos
+} controlStats_t;
+
+void Control_Init( void );
+uint8_t Control_Service( gaitCommand_t lastCmd );
+void Control_GetStats( controlStats_t * stats );
+void Control_ResetStats( void );
+void Control_MarkInput( uint32_t stampUs );
+
+#endif
@@ -0,0 +1,102 @@
+/*! \file  EEPROM.c
+*
+* \brief
+* On-chip EEPROM read and write for the TIVA TM4C123G
+*
+* \details
+*  2KB of EEPROM in 32 blocks of 16 words, addressed here by word number.
+*  Words go through EERDWRINC, which steps the offset after every access;
+*  the block register is reloaded when a transfer crosses into the next
+*  block. Unlike flash, a word is rewritten without an erase, but every
+*  write stalls for the controller (a few hundred us, longer when it has
+*  to compact), so writes do not belong in the control loop.
+*
+* \author vsimontov
+*
+* \info
+* Based on TIVA User Reference manual, EEPROM Initialization and
+* Configuration (pg.537)
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include "EEPROM.h"
+#include <tm4c123gh6pm.h>
+
+#define EEPROM_WORDS  (EEPROM_WORDS_PER_BLOCK * EEPROM_BLOCKS)
+
+static void waitIdle( void )
+{
+  while (EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING);
+}
+
+static void seek( uint16_t word )
+{
+  EEPROM_EEBLOCK_R = word / EEPROM_WORDS_PER_BLOCK;
+  EEPROM_EEOFFSET_R = word % EEPROM_WORDS_PER_BLOCK;
+}
+
+eepromStatus_t EEPROM_Init( void )
+/*!\brief   Clock the EEPROM module and let it finish any interrupted write
+\details The module recovers a write that a reset cut short while it powers
+         up; PRETRY/ERETRY in EESUPP mean that recovery failed.
+\return eepromStatus_t: EEPROM_STATUS_OK, or EEPROM_STATUS_ERROR when the
+          contents cannot be trusted
+*/
+{
+  SYSCTL_RCGCEEPROM_R |= 0x01;
+  while ((SYSCTL_PREEPROM_R & 0x01) == 0);
+  waitIdle();
+  if (EEPROM_EESUPP_R & EEPROM_EESUPP_ERRMASK) return EEPROM_STATUS_ERROR;
+
+  //reset the module so it starts from the recovered state
+  SYSCTL_SREEPROM_R |= 0x01;
+  SYSCTL_SREEPROM_R &= ~0x01;
+  while ((SYSCTL_PREEPROM_R & 0x01) == 0);
+  waitIdle();
+  if (EEPROM_EESUPP_R & EEPROM_EESUPP_ERRMASK) return EEPROM_STATUS_ERROR;
+  return EEPROM_STATUS_OK;
+}
+
+eepromStatus_t EEPROM_Read( uint16_t word, uint32_t * data, uint16_t count )
+/*!\brief   Read consecutive words
+\param word[in]: first word, 0 to 511
+       data[out]: words read
+       count[in]: number of words
+\return eepromStatus_t: EEPROM_STATUS_OK or EEPROM_STATUS_BAD_ADDRESS
+*/
+{
+  if (((uint32_t)word + count) > EEPROM_WORDS) return EEPROM_STATUS_BAD_ADDRESS;
+
+  seek(word);
+  for (uint16_t i = 0; i < count; i++) {
+    if ((i != 0) && (((word + i) % EEPROM_WORDS_PER_BLOCK) == 0)) seek(word + i);
+    data[i] = EEPROM_EERDWRINC_R;
+  }
+  return EEPROM_STATUS_OK;
+}
+
+eepromStatus_t EEPROM_Write( uint16_t word, const uint32_t * data, uint16_t count )
+/*!\brief   Write consecutive words
+\param word[in]: first word, 0 to 511
+       data[in]: words to write
+       count[in]: number of words
+\return eepromStatus_t: EEPROM_STATUS_OK, EEPROM_STATUS_BAD_ADDRESS, or
+          EEPROM_STATUS_ERROR on the first word that failed
+*/
+{
+  if (((uint32_t)word + count) > EEPROM_WORDS) return EEPROM_STATUS_BAD_ADDRESS;
+
+  waitIdle();
+  seek(word);
+  for (uint16_t i = 0; i < count; i++) {
+    if ((i != 0) && (((word + i) % EEPROM_WORDS_PER_BLOCK) == 0)) seek(word + i);
+    EEPROM_EERDWRINC_R = data[i];
+    waitIdle();
+    if (EEPROM_EEDONE_R & EEPROM_EEDONE_ERRMASK) return EEPROM_STATUS_ERROR;
+  }
+  return EEPROM_STATUS_OK;
+}
@@ -0,0 +1,25 @@
+#if !defined(EEPROM_H)
+#define EEPROM_H
+
+#include <stdint.h>
+
+#define EEPROM_WORDS_PER_BLOCK  (16)      //64 byte blocks
+#define EEPROM_BLOCKS           (32)      //2KB on the TM4C123GH6PM
+
+ // EEDONE and EESUPP bits
+ #define EEPROM_EEDONE_WORKING  (0x01)
+ #define EEPROM_EEDONE_ERRMASK  (0x3C)    //WKERASE | WKCOPY | NOPERM | WRBUSY
+ #define EEPROM_EESUPP_ERRMASK  (0x0C)    //ERETRY | PRETRY
+
+typedef enum eepromStatus
+{
+  EEPROM_STATUS_OK,
+  EEPROM_STATUS_BAD_ADDRESS,
+  EEPROM_STATUS_ERROR      //!<Controller reported a failed write or a failed recovery at power up
+} eepromStatus_t;
+
+eepromStatus_t EEPROM_Init( void );
+eepromStatus_t EEPROM_Read( uint16_t word, uint32_t * data, uint16_t count );
+eepromStatus_t EEPROM_Write( uint16_t word, const uint32_t * data, uint16_t count );
+
+#endif
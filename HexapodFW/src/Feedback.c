@@ -0,0 +1,164 @@
+/*! \file  Feedback.c
+*
+* \brief
+* Servo position feedback: ADC samples to joint angles, arrival checks
+*
+* \details
+*  Hardware independent half of the position feedback. ADC.c hands over
+*  blocks of raw sequencer frames (FB_NUM_STEPS samples each), this module
+*  averages them, converts each step to degrees with a two point calibration
+*  and compares against the targets the servo model holds.
+*
+*  Servos without a pot (or whose last measurement is stale) fall back to the
+*  model's predicted arrival, so a partly instrumented robot still walks.
+*
+*  Nothing in here touches registers: a host build can feed synthesized
+*  sample blocks straight into Feedback_ProcessBlock.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Feedback.h"
+
+#define NUM_KNEES (6)
+
+typedef struct feedbackChannel
+{
+  uint8_t  step;        // sequencer step sampling this servo, FB_NONE if none
+  uint16_t rawAt0;
+  uint16_t rawAt180;
+  int16_t  angle;       // last measured angle in degrees
+} feedbackChannel_t;
+
+static feedbackChannel_t channels[SERVO_COUNT];
+static uint8_t tolerance = FB_DEFAULT_TOLERANCE_DEG;
+static uint32_t lastBlockMs = 0;
+static uint8_t haveBlock = 0;
+
+void Feedback_Init( void )
+/*!\brief   Default wiring: knee pots on steps 0-5, front hips on 6-7
+\details The middle and back hips have no pot, they use the servo model
+\return none
+*/
+{
+  for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+    channels[i].step = FB_NONE;
+    channels[i].rawAt0 = FB_RAW_AT_0;
+    channels[i].rawAt180 = FB_RAW_AT_180;
+    channels[i].angle = 0;
+  }
+  for (uint8_t knee = 0; knee < NUM_KNEES; knee++) {
+    channels[6 + knee].step = knee;
+  }
+  channels[0].step = NUM_KNEES;       //front right hip
+  channels[5].step = NUM_KNEES + 1;   //front left hip
+  haveBlock = 0;
+}
+
+void Feedback_MapChannel( uint8_t channel, uint8_t step )
+/*!\brief   Attach a servo to a sequencer step
+\param channel[in]: servo channel 0-11
+       step[in]: sequencer step 0..FB_NUM_STEPS-1, FB_NONE to detach
+\return none
+*/
+{
+  if (channel >= SERVO_COUNT) return;
+  channels[channel].step = (step < FB_NUM_STEPS) ? step : FB_NONE;
+}
+
+void Feedback_SetCalibration( uint8_t channel, uint16_t rawAt0, uint16_t rawAt180 )
+/*!\brief   Two point calibration of one pot
+\details rawAt180 may be lower than rawAt0 for pots wired the other way round
+\return none
+*/
+{
+  if ((channel >= SERVO_COUNT) || (rawAt0 == rawAt180)) return;
+  channels[channel].rawAt0 = rawAt0;
+  channels[channel].rawAt180 = rawAt180;
+}
+
+void Feedback_SetTolerance( uint8_t toleranceDeg )
+/*!\brief   Set how close a joint must be to its target to count as arrived
+\return none
+*/
+{
+  tolerance = toleranceDeg;
+}
+
+void Feedback_ProcessBlock( const uint16_t * samples, uint8_t frames, uint32_t nowMs )
+/*!\brief   Consume a block of sequencer frames
+\details Averages every step over the block (on top of the ADC's hardware
+         averaging) and updates the measured angle of each mapped servo.
+         Called from the ADC ISR on target, directly from test code on a host.
+\param samples[in]: frames * FB_NUM_STEPS raw 12-bit samples, frame major
+       frames[in]: number of frames in the block
+       nowMs[in]: time the block completed
+\return none
+*/
+{
+  uint32_t sum[FB_NUM_STEPS] = {0};
+
+  if (frames == 0) return;
+
+  for (uint8_t f = 0; f < frames; f++) {
+    for (uint8_t s = 0; s < FB_NUM_STEPS; s++) {
+      sum[s] += samples[(f * FB_NUM_STEPS) + s] & 0x0FFF;
+    }
+  }
+
+  for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+    feedbackChannel_t * ch = &channels[i];
+    if (ch->step == FB_NONE) continue;
+
+    int32_t raw = (int32_t)((sum[ch->step] + (frames / 2)) / frames);
+    int32_t span = (int32_t)ch->rawAt180 - (int32_t)ch->rawAt0;
+    ch->angle = (int16_t)(((raw - (int32_t)ch->rawAt0) * 180) / span);
+  }
+
+  lastBlockMs = nowMs;
+  haveBlock = 1;
+}
+
+uint8_t Feedback_IsMeasured( uint8_t channel, uint32_t nowMs )
+/*!\brief   Check whether a servo has a fresh measurement
+\return 1 if the servo has a pot and the last block is recent, 0 otherwise
+*/
+{
+  if ((channel >= SERVO_COUNT) || (channels[channel].step == FB_NONE) || !haveBlock) return 0;
+  return ((nowMs - lastBlockMs) <= FB_STALE_MS) ? 1 : 0;
+}
+
+int16_t Feedback_Angle( uint8_t channel )
+/*!\brief   Last measured angle of a servo
+\return angle in degrees, 0 for unmeasured channels
+*/
+{
+  if (channel >= SERVO_COUNT) return 0;
+  return channels[channel].angle;
+}
+
+uint8_t Feedback_Arrived( uint16_t channelMask, uint32_t nowMs )
+/*!\brief   Check whether every selected joint has reached its target
+\details Measured joints must be within the tolerance of the angle last
+         commanded through the servo model; the others use the model's
+         predicted arrival.
+\param channelMask[in]: bit per servo channel, ALL_SERVOS for the whole bot
+       nowMs[in]: current time in milliseconds
+\return 1 if all selected joints have arrived, 0 otherwise
+*/
+{
+  for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+    if ((channelMask & (1u << i)) == 0) continue;
+
+    if (Feedback_IsMeasured(i, nowMs)) {
+      int16_t err = channels[i].angle - ServoModel_Target(i);
+      if (err < 0) err = -err;
+      if (err > tolerance) return 0;
+    }
+    else if (!ServoModel_Arrived((uint16_t)(1u << i), nowMs)) {
+      return 0;
+    }
+  }
+  return 1;
+}
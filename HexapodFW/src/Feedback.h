@@ -0,0 +1,23 @@
+#if !defined(FEEDBACK_H)
+#define FEEDBACK_H
+
+#include <stdint.h>
+#include "ServoModel.h"
+
+#define FB_NONE                  (0xFF)   // servo has no feedback pot
+#define FB_NUM_STEPS             (8)      // sequencer steps per frame, one per measured servo
+#define FB_DEFAULT_TOLERANCE_DEG (4)      // joint counts as arrived within this many degrees
+#define FB_STALE_MS              (20)     // measurements older than this are not trusted
+#define FB_RAW_AT_0              (620)    // ADC counts at 0 degrees (~0.5V)
+#define FB_RAW_AT_180            (3600)   // ADC counts at 180 degrees (~2.9V)
+
+void Feedback_Init( void );
+void Feedback_MapChannel( uint8_t channel, uint8_t step );
+void Feedback_SetCalibration( uint8_t channel, uint16_t rawAt0, uint16_t rawAt180 );
+void Feedback_SetTolerance( uint8_t toleranceDeg );
+void Feedback_ProcessBlock( const uint16_t * samples, uint8_t frames, uint32_t nowMs );
+uint8_t Feedback_IsMeasured( uint8_t channel, uint32_t nowMs );
+int16_t Feedback_Angle( uint8_t channel );
+uint8_t Feedback_Arrived( uint16_t channelMask, uint32_t nowMs );
+
+#endif
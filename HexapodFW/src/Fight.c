@@ -0,0 +1,95 @@
+/*! \file  Fight.c
+*
+* \brief
+* Fight mode: the front legs follow the joystick, the others brace
+*
+* \details
+*  Runs once per control tick from the gait state machine. The newest
+*  joystick sample is low pass filtered and then rate limited, so a noisy
+*  stick or a burst of packets can neither jerk the servos nor ask for more
+*  than they can travel in one frame. Angles are kept in Q4 degrees so the
+*  filter does not stall short of the target.
+*
+*  When a tick consumes a new sample its receive time is handed to the
+*  control loop, which measures the packet-to-commit latency.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Fight.h"
+#include "Control.h"
+
+#define Q 4    // filter state is Q4 degrees
+
+static int16_t targetHip = 0, targetKnee = 0;     // degrees from centre, set by the link
+static int16_t filtHip = 0, filtKnee = 0;         // Q4
+static int16_t outHip = 0, outKnee = 0;           // degrees from centre, last written
+static uint32_t inputStampUs = 0;
+static uint8_t  newInput = 0;
+
+static int16_t limit( int16_t value, int16_t target, int16_t step )
+{
+  if (target > value + step) return value + step;
+  if (target < value - step) return value - step;
+  return target;
+}
+
+void Fight_Start( void )
+/*!\brief   Brace the middle and back legs and centre the front legs
+\details Back legs move their feet rearwards and all four supporting knees go
+         down, which moves the body's weight off the front legs
+\return none
+*/
+{
+  setLegs(MIDDLE_LEGS, HIP_NEUTRAL, FIGHT_BRACE_KNEE, 0, 0, 0);
+  setLegs(BACK_LEGS, HIP_BACKWARD, FIGHT_BRACE_KNEE, 0, 0, 0);
+  setLegs(FRONT_LEGS, HIP_NEUTRAL, FIGHT_KNEE_CENTRE, 0, 0, 0);
+  targetHip = targetKnee = 0;
+  filtHip = filtKnee = 0;
+  outHip = outKnee = 0;
+  newInput = 0;
+}
+
+void Fight_SetInput( int8_t x, int8_t y, uint32_t stampUs )
+/*!\brief   Latest joystick position from the controller
+\param x[in]: stick X, -128..127, + is right
+       y[in]: stick Y, -128..127, + is up
+       stampUs[in]: Timer_micros() when the packet passed its checksum
+\return none
+*/
+{
+  targetHip = (int16_t)(((int32_t)x * FIGHT_HIP_RANGE) / 128);
+  targetKnee = (int16_t)(((int32_t)y * FIGHT_KNEE_RANGE) / 128);
+  inputStampUs = stampUs;
+  newInput = 1;
+}
+
+void Fight_Update( void )
+/*!\brief   One control tick of fight mode
+\return none
+*/
+{
+  if (newInput) {
+    Control_MarkInput(inputStampUs);
+    newInput = 0;
+  }
+
+  filtHip += ((targetHip << Q) - filtHip) >> FIGHT_FILTER_SHIFT;
+  filtKnee += ((targetKnee << Q) - filtKnee) >> FIGHT_FILTER_SHIFT;
+
+  int16_t hip = limit(outHip, (filtHip + (1 << (Q - 1))) >> Q, FIGHT_MAX_STEP);
+  int16_t knee = limit(outKnee, (filtKnee + (1 << (Q - 1))) >> Q, FIGHT_MAX_STEP);
+
+  if (hip != outHip) {
+    //same raw direction on both sides: the pair sweeps sideways together
+    setHip(0, HIP_NEUTRAL + hip, 0);
+    setHip(5, HIP_NEUTRAL - hip, 0);
+    outHip = hip;
+  }
+  if (knee != outKnee) {
+    setKnee(0, FIGHT_KNEE_CENTRE + knee);
+    setKnee(5, FIGHT_KNEE_CENTRE + knee);
+    outKnee = knee;
+  }
+}
@@ -0,0 +1,20 @@
+#if !defined(FIGHT_H)
+#define FIGHT_H
+
+#include <stdint.h>
+#include "Gaits.h"
+
+ // Front legs follow the joystick: X swings both hips to the same side,
+ // Y raises (+) or lowers (-) both knees. Ranges are degrees at full stick.
+ #define FIGHT_HIP_RANGE    45
+ #define FIGHT_KNEE_RANGE   60
+ #define FIGHT_KNEE_CENTRE  KNEE_NEUTRAL
+ #define FIGHT_FILTER_SHIFT 1      // one pole low pass per tick, 1 = half way each tick
+ #define FIGHT_MAX_STEP     8      // degrees per control tick, ~480 deg/s at 60Hz
+ #define FIGHT_BRACE_KNEE   KNEE_STAND
+
+void Fight_Start( void );
+void Fight_SetInput( int8_t x, int8_t y, uint32_t stampUs );
+void Fight_Update( void );
+
+#endif
@@ -0,0 +1,74 @@
+/*! \file  FixedMath.c
+*
+* \brief
+* Integer trigonometry for the control loop
+*
+* \details
+*  The gait and pose code runs every control tick, so nothing on that path
+*  touches the FPU or libm. Sine is looked up in a 256 entry table and
+*  linearly interpolated on the low byte of the binary angle.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "FixedMath.h"
+
+static const int16_t sineTable[256] = {
+       0,    804,   1608,   2410,   3212,   4011,   4808,   5602,
+    6393,   7179,   7962,   8739,   9512,  10278,  11039,  11793,
+   12539,  13279,  14010,  14732,  15446,  16151,  16846,  17530,
+   18204,  18868,  19519,  20159,  20787,  21403,  22005,  22594,
+   23170,  23731,  24279,  24811,  25329,  25832,  26319,  26790,
+   27245,  27683,  28105,  28510,  28898,  29268,  29621,  29956,
+   30273,  30571,  30852,  31113,  31356,  31580,  31785,  31971,
+   32137,  32285,  32412,  32521,  32609,  32678,  32728,  32757,
+   32767,  32757,  32728,  32678,  32609,  32521,  32412,  32285,
+   32137,  31971,  31785,  31580,  31356,  31113,  30852,  30571,
+   30273,  29956,  29621,  29268,  28898,  28510,  28105,  27683,
+   27245,  26790,  26319,  25832,  25329,  24811,  24279,  23731,
+   23170,  22594,  22005,  21403,  20787,  20159,  19519,  18868,
+   18204,  17530,  16846,  16151,  15446,  14732,  14010,  13279,
+   12539,  11793,  11039,  10278,   9512,   8739,   7962,   7179,
+    6393,   5602,   4808,   4011,   3212,   2410,   1608,    804,
+       0,   -804,  -1608,  -2410,  -3212,  -4011,  -4808,  -5602,
+   -6393,  -7179,  -7962,  -8739,  -9512, -10278, -11039, -11793,
+  -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530,
+  -18204, -18868, -19519, -20159, -20787, -21403, -22005, -22594,
+  -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+  -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956,
+  -30273, -30571, -30852, -31113, -31356, -31580, -31785, -31971,
+  -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+  -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285,
+  -32137, -31971, -31785, -31580, -31356, -31113, -30852, -30571,
+  -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+  -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731,
+  -23170, -22594, -22005, -21403, -20787, -20159, -19519, -18868,
+  -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+  -12539, -11793, -11039, -10278,  -9512,  -8739,  -7962,  -7179,
+   -6393,  -5602,  -4808,  -4011,  -3212,  -2410,  -1608,   -804
+};
+
+int16_t FM_sin(uint16_t angle)
+/*!\brief   Q15 sine of a binary angle
+\details Table value at the upper byte, interpolated towards the next entry
+         using the lower byte. Worst case error is well under 0.1%
+\param angle[in]: binary angle, 0x10000 per turn
+\return sine in Q15
+*/
+{
+  uint8_t idx = (uint8_t)(angle >> 8);
+  int32_t frac = angle & 0xFF;
+  int32_t a = sineTable[idx];
+  int32_t b = sineTable[(uint8_t)(idx + 1)];
+
+  return (int16_t)(a + (((b - a) * frac) >> 8));
+}
+
+int16_t FM_cos(uint16_t angle)
+/*!\brief   Q15 cosine of a binary angle
+\return cosine in Q15
+*/
+{
+  return FM_sin((uint16_t)(angle + FM_ANGLE_90));
+}
@@ -0,0 +1,20 @@
+#if !defined(FIXEDMATH_H)
+#define FIXEDMATH_H
+
+#include <stdint.h>
+
+/*
+ Angles are 16-bit binary angles: 0x10000 is one full turn, so phase
+ accumulators wrap for free. Sine/cosine results are Q15 (32767 = 1.0).
+*/
+#define FM_ONE_Q15          (32767)
+#define FM_ANGLE_90         (0x4000u)
+#define FM_ANGLE_180        (0x8000u)
+#define FM_ANGLE_270        (0xC000u)
+#define FM_DEG_TO_ANGLE(D)  ((uint16_t)(((int32_t)(D) * 65536L) / 360L))
+#define FM_MUL_Q15(A, B)    ((int16_t)(((int32_t)(A) * (int32_t)(B)) >> 15))
+
+int16_t FM_sin(uint16_t angle);
+int16_t FM_cos(uint16_t angle);
+
+#endif
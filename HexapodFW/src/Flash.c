@@ -0,0 +1,76 @@
+/*! \file  Flash.c
+*
+* \brief
+* On-chip flash erase and program for the TIVA TM4C123G
+*
+* \details
+*  Blocks are erased 1KB at a time and programmed one 32-bit word at a time
+*  through FMA/FMD/FMC. The CPU keeps fetching from flash while an operation
+*  runs, so every call stalls until the controller is done (an erase takes a
+*  few ms). Only use it where the control loop can afford to miss ticks.
+*
+* \author vsimontov
+*
+* \info
+* Based on TIVA User Reference manual, Internal Memory chapter
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include "Flash.h"
+#include <tm4c123gh6pm.h>
+
+static uint32_t writeKey( void )
+{
+  return (FLASH_BOOTCFG_R & FLASH_BOOTCFG_KEYBIT) ? FLASH_KEY_DEFAULT : FLASH_KEY_ALT;
+}
+
+static flashStatus_t waitDone( uint32_t bit )
+{
+  while (FLASH_FMC_R & bit);
+  if (FLASH_FCRIS_R & FLASH_FCRIS_ERRMASK) {
+    FLASH_FCMISC_R = FLASH_FCRIS_ERRMASK;
+    return FLASH_STATUS_ERROR;
+  }
+  return FLASH_STATUS_OK;
+}
+
+flashStatus_t Flash_Erase( uint32_t address )
+/*!\brief   Erase one 1KB block to 0xFF
+\param address[in]: start of the block, must be block aligned
+\return flashStatus_t: FLASH_STATUS_OK, FLASH_STATUS_BAD_ADDRESS, or
+          FLASH_STATUS_ERROR if the controller reported a fault
+*/
+{
+  if ((address & (FLASH_BLOCK_SIZE - 1)) || (address >= FLASH_SIZE)) return FLASH_STATUS_BAD_ADDRESS;
+
+  FLASH_FCMISC_R = FLASH_FCRIS_ERRMASK;
+  FLASH_FMA_R = address;
+  FLASH_FMC_R = writeKey() | FLASH_FMC_ERASEBIT;
+  return waitDone(FLASH_FMC_ERASEBIT);
+}
+
+flashStatus_t Flash_Write( uint32_t address, const uint32_t * data, uint16_t count )
+/*!\brief   Program words into erased flash
+\details Bits can only be cleared, the target must have been erased first
+\param address[in]: destination, word aligned
+       data[in]: words to program
+       count[in]: number of words
+\return flashStatus_t: FLASH_STATUS_OK, FLASH_STATUS_BAD_ADDRESS, or
+          FLASH_STATUS_ERROR on the first word that failed
+*/
+{
+  if ((address & 0x03) || ((address + ((uint32_t)count * 4u)) > FLASH_SIZE)) return FLASH_STATUS_BAD_ADDRESS;
+
+  FLASH_FCMISC_R = FLASH_FCRIS_ERRMASK;
+  for (uint16_t i = 0; i < count; i++) {
+    FLASH_FMA_R = address + ((uint32_t)i * 4u);
+    FLASH_FMD_R = data[i];
+    FLASH_FMC_R = writeKey() | FLASH_FMC_WRITEBIT;
+    if (waitDone(FLASH_FMC_WRITEBIT) != FLASH_STATUS_OK) return FLASH_STATUS_ERROR;
+  }
+  return FLASH_STATUS_OK;
+}
@@ -0,0 +1,28 @@
+#if !defined(FLASH_H)
+#define FLASH_H
+
+#include <stdint.h>
+#include "HWReg.h"
+
+#define FLASH_BLOCK_SIZE   (1024)           //erase granularity
+#define FLASH_SIZE         (0x40000)        //256KB on the TM4C123GH6PM
+
+ // FMC write keys, which one applies depends on BOOTCFG.KEY
+ #define FLASH_KEY_DEFAULT (0xA4420000u)
+ #define FLASH_KEY_ALT     (0x71D50000u)
+ #define FLASH_BOOTCFG_KEYBIT (0x01 << 4)
+ #define FLASH_FMC_WRITEBIT (0x01)
+ #define FLASH_FMC_ERASEBIT (0x02)
+ #define FLASH_FCRIS_ERRMASK (0x0E00)       //ERRIS | INVDRIS | VOLTRIS
+
+typedef enum flashStatus
+{
+  FLASH_STATUS_OK,
+  FLASH_STATUS_BAD_ADDRESS,
+  FLASH_STATUS_ERROR
+} flashStatus_t;
+
+flashStatus_t Flash_Erase( uint32_t address );
+flashStatus_t Flash_Write( uint32_t address, const uint32_t * data, uint16_t count );
+
+#endif
@@ -1,541 +1,943 @@
-/*! \file  Gaits.c
-*
-* \brief
-* Module for controlling the gait of the Vorpal Hexapod
-*
-*  Most functions are ported directly from the Vorpal Hexapod Control Program
-*
-*  Copyright (C) 2017, 2018 Vorpal Robotics, LLC.
-*  https://github.com/vorpalrobotics/VorpalHexapod
-
-*  \license (copied directly from Vorpal Source Code)
-*  This work is licensed under the Creative Commons 
-*  Attribution-NonCommercial-ShareAlike 4.0 International License.
-*  To view a copy of this license, visit http:* creativecommons.org/licenses/by-nc-sa/4.0/.
-*  Attribution for derivations of this work should be made to: Vorpal Robotics, LLC
-*  
-*  You may use this work for noncommercial purposes without cost as long as you give us
-*  credit for our work (attribution) and any improvements you make are licensed in a way
-*  no more restrictive than our license.
-* 
-*  For example, you may build a Hexapod yourself and use this code for your own experiments,
-*  or you can build one and give the hexapod running this code to a friend, as long as you
-*  don't charge for it.
-* 
-*  If you have a question about whether a contemplated use is in compliance with the license,
-*  just ask us. We're friendly. Email us at support@vorpalrobotics.com
-* 
-*  For information on licensing this work for commercial purposes, 
-*  please send email to support@vorpalrobotics.com and we'll work with you to come up with
-*  something fair.
-* 
-*  This is the program that goes on the Robot, not the gamepad!
-* 
-*  For more technical informatio, see http://www.vorpalrobotics.com
-*
-* 
-* \author Vorpal Robotics
-          livey
-*
-******************************************************************************/
-#include "Gaits.h"
-#include "PCA9685.h"
-#include "Timer.h"
-#include "GPIO.h"
-
-uint8_t deferServoSet = 0;
-uint32_t timeToMove = 0;
-uint32_t timeToMoveDemo = 0;
-volatile uint32_t ms_sinceStart = 0;
-
-#define POSITION_FEEDBACK_ENABLED 0
-
-void updateMillis( void ){
-  ms_sinceStart++;
-  return;
-}
-#if USE_GOBLE_AS_MOVEMENT_CLOCK
-uint32_t Timer_millis( void ){
-   return ms_sinceStart;
-}
-#endif
-
-int16_t ServoPos[2*NUM_LEGS]; //store last servo position instruction
-uint8_t servoOffset[2*NUM_LEGS] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};  /*knee offsets (6-11)*/
-
-/*
-Wrapper functions to be used for clarity in state machines and outside the source file
-* SetWalkLegs
-* SetRotateLegs
-
-*/
-//version for just the knees
-void setKneesOnly( uint8_t legmask, int16_t knee_pos ) {
-  setLegs(legmask, NOMOVE, knee_pos, 0, 0, 0);
-}
-
-//return to default stand position
-void stand( void ) {
-  setLegs(ALL_LEGS, HIP_NEUTRAL, NOMOVE, 0, 0, 0);
-  delay(200);
-  setLegs(ALL_LEGS, HIP_NEUTRAL, KNEE_STAND, 0, 0, 0);
-}
-
-//return to default sit position
-void laydown( void ) {
-  setLegs(ALL_LEGS, HIP_NEUTRAL, KNEE_UP_MAX, 0, 0, 0);
-}
-
- 
-/*
-setLegs function for all your hip and knee directing needs
-not sure we're going to use the leanangle but it's here
-*/
-void setLegs(uint8_t legmask, int16_t hip_pos, int16_t knee_pos, uint8_t adj, uint8_t raw, int16_t leanangle) {
-  for(uint8_t i = 0; i < NUM_LEGS; i++) {
-    if(legmask & 0x01) {  // if the lowest bit is ON
-      if(hip_pos != NOMOVE) {
-        if(!raw) {
-          setHip(i, hip_pos, adj);
-        } else {
-          setHipRaw(i, hip_pos);
-        }
-      }
-      if(knee_pos != NOMOVE) {
-        uint8_t pos = knee_pos;
-        if(leanangle != 0) {
-          switch(i) {
-            case 0: case 6: case 5: case 11:
-              if(leanangle < 0) pos -= leanangle;
-              break;
-            case 1: case 7: case 4: case 10:
-              pos += (leanangle/2); //abs()
-              break;
-            case 2: case 8: case 3: case 9:
-              if(leanangle > 0) pos += leanangle;
-              break;
-          }
-        }       
-        setKnee(i, pos);
-      }
-    }
-    legmask = (legmask>>1);  // shift down one bit position
-  }
-}
-
-// this version of setHip adjusts not only for left and right,
-// but also shifts the front legs a little back and the back legs
-// forward to make a better balance for certain gaits like tripod or quadruped
-//
-
-void setHip(uint8_t leg, int16_t pos, uint8_t adj) {
-  if (ISFRONTLEG(leg)) {
-    pos -= adj;
-  } else if (ISBACKLEG(leg)) {
-    pos += adj;
-  }
-  // reverse the left side for consistent forward motion
-  if (leg >= LEFT_START) {
-    pos = 180 - pos;
-  }
-
-  setHipRaw(leg, pos);
-}
-
-/*
-// this version of setHip does no processing at all (for example
-// to distinguish left from right sides)
-*/
-void setHipRaw(uint8_t leg, int16_t pos) {
-  pos += servoOffset[leg];  //needs tuning! --LI
-  ServoPos[leg] = pos;
-  PCA9685_setServo(leg, (float)pos);
-}
-
-/*
-
-*/
-void setKnee(uint8_t leg, int16_t pos) {
-  // find the knee associated with leg if this is not already a knee
-  if (leg < KNEE_OFFSET) {
-    leg += KNEE_OFFSET;
-  }
-  pos += servoOffset[leg];
-  PCA9685_setServo(leg, (float)pos);
-}
-
-
-void runGaitFSM( gaitCommand_t lastCmd ){
-  static phase_t position = SITTING;
-  
-  switch(position){
-  case DEMOING: //sit
-    if (lastCmd == BOT_STAND) {
-      stand(); 
-      position = STANDING;
-    }
-    break;
-  case STANDING: //stand
-    if (lastCmd == BOT_DEMO) {
-      demo();
-    } 
-    else if (lastCmd != BOT_STAND){
-      setKneesOnly(TRIPOD1_LEGS, KNEE_UP);
-      position = WALKING;
-    }
-    break;
-  case WALKING: //handles walking, turning, and veering
-    if (timeToMove < Timer_millis() || POSITION_FEEDBACK_ENABLED){
-      if (GaitHandler(lastCmd) == DONE_WALKING){
-        stand();
-        position = STANDING;
-      }
-      else if (lastCmd == BOT_STOP){
-        //bot is frozen
-        position = FROZEN;
-      }
-    }
-    break;
-  case FROZEN:
-    if (lastCmd == BOT_STAND) {
-      stand();
-      position = STANDING;
-    } 
-    break;
-  default:
-    break;
-  }
-}    
-
-#define WALK_MODE 0x00
-#define TURN_MODE 0x01
-#define FBSHIFT    15   // shift front legs back, back legs forward, this much
-#define FBSHIFT_TURN    40
-
-#if USE_GOBLE_AS_MOVEMENT_CLOCK
- //these "times" are multipliers for the incoming packet rate (~5 per second)
- #define TRIPOD_LIFT_TIME 1
- #define TRIPOD_SWIVEL_TIME 1
- #define TRIPOD_SET_TIME 1
-#else
- //else use a (yet to be created) Timer_millis function which returns milliseconds
- #define TRIPOD_LIFT_TIME 50
- #define TRIPOD_SWIVEL_TIME 50
- #define TRIPOD_SET_TIME 50
-#endif
-
-/*
-Each gait consists of 6 phases (walking, veering, turning)
-The gait parameters may be changed at any time (based on the incoming command)
-which allows for smooth transitions between different motions
-
-*/
-
-uint8_t hipdir1 = HIP_FORWARD;
-uint8_t hipdir2 = HIP_BACKWARD;
-uint8_t servoShift = FBSHIFT;
-uint8_t moveType = WALK_MODE;
-uint8_t leanangle = 0;
-  
-phase_t GaitHandler( gaitCommand_t lastCmd ){
-
-  static phase_t gaitPhase = TRIPOD1_LIFT;
-  
-  if (lastCmd == BOT_STOP){
-    //freeze and wait for a new command
-    return FROZEN;
-  }
-  
-  switch (gaitPhase) {
-    case TRIPOD1_LIFT:     
-      // in this phase, center-left and noncenter-right legs raise up at
-      // the knee
-      setLegs(TRIPOD1_LEGS, NOMOVE, KNEE_NEUTRAL, 0, 0, leanangle);
-      timeToMove = Timer_millis() + TRIPOD_LIFT_TIME;
-      gaitPhase = TRIPOD1_SWIVEL;
-      break;
-      
-    case TRIPOD1_SWIVEL:
-      // in this phase, the center-left and noncenter-right legs move forward
-      // at the hips, while the rest of the legs move backward at the hip      
-      setGaitVariables(lastCmd, gaitPhase); 
-      setLegs(TRIPOD1_LEGS, hipdir1, NOMOVE, servoShift, moveType, leanangle);  
-      setLegs(TRIPOD2_LEGS, hipdir2, NOMOVE, servoShift, moveType, leanangle);
-      timeToMove = Timer_millis() + TRIPOD_SWIVEL_TIME;
-      if (lastCmd == BOT_STAND || lastCmd == BOT_SIT){
-        gaitPhase = WALK_STOPPING;
-      }else {
-        gaitPhase = TRIPOD1_SET;
-      }
-      break;
-      
-    case TRIPOD1_SET: 
-      // now put the first set of legs back down on the ground
-      setLegs(TRIPOD1_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
-      timeToMove = Timer_millis() + TRIPOD_SET_TIME;
-      gaitPhase = TRIPOD2_LIFT;
-      break;
-      
-    case TRIPOD2_LIFT:
-      // lift up the other set of legs at the knee
-      setLegs(TRIPOD2_LEGS, NOMOVE, KNEE_NEUTRAL, 0, 0, leanangle);
-      timeToMove = Timer_millis() + TRIPOD_LIFT_TIME;
-      gaitPhase = TRIPOD2_SWIVEL;
-      break;
-      
-    case TRIPOD2_SWIVEL:
-      // similar to phase 1, move raised legs forward and lowered legs backward     
-      setGaitVariables(lastCmd, gaitPhase); 
-      setLegs(TRIPOD1_LEGS, hipdir2, NOMOVE, servoShift, moveType, leanangle);
-      setLegs(TRIPOD2_LEGS, hipdir1, NOMOVE, servoShift, moveType, leanangle);
-      timeToMove = Timer_millis() + TRIPOD_SWIVEL_TIME;
-      if (lastCmd == BOT_STAND || lastCmd == BOT_SIT){
-        gaitPhase = WALK_STOPPING;
-      }else {
-        gaitPhase = TRIPOD2_SET;
-      }
-      break;
-
-    case TRIPOD2_SET:
-      // put the second set of legs down, and the cycle repeats
-      setLegs(TRIPOD2_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
-      timeToMove = Timer_millis() + TRIPOD_SET_TIME;
-      gaitPhase = TRIPOD1_LIFT;
-      break;
-      
-    case WALK_STOPPING:
-      setLegs(TRIPOD1_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
-      setLegs(TRIPOD2_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
-      gaitPhase = TRIPOD1_LIFT;
-      return DONE_WALKING;
-      break;
-      
-  }
-  return gaitPhase;
-}
-
-
-void setGaitVariables(gaitCommand_t lastCmd, phase_t gaitPhase){
-  if (gaitPhase == TRIPOD1_SWIVEL){
-    switch(lastCmd){    
-       case BOT_WALK_NW:
-       case BOT_WALK_NE:
-         lastCmd = BOT_WALK_FWD;
-         break;
-       case BOT_WALK_SW:
-       case BOT_WALK_SE:        
-         lastCmd = BOT_WALK_BACK;
-         break;
-    }
-  }
-  else if (gaitPhase == TRIPOD1_SWIVEL){
-    switch(lastCmd){    
-       case BOT_WALK_NW:
-       case BOT_WALK_SE:
-         lastCmd = BOT_ROTATE_LEFT;
-         break;
-       case BOT_WALK_SW:
-       case BOT_WALK_NE:        
-         lastCmd = BOT_ROTATE_RIGHT;
-         break;
-    }
-  }
-     switch(lastCmd){
-        case BOT_WALK_FWD:
-           hipdir1 = HIP_FORWARD;
-           hipdir2 = HIP_BACKWARD;
-           servoShift = FBSHIFT;
-           moveType = WALK_MODE;
-           break;
-        case BOT_WALK_BACK:
-           hipdir1 = HIP_BACKWARD;
-           hipdir2 = HIP_FORWARD;
-           servoShift = FBSHIFT;
-           moveType = WALK_MODE;
-           break;
-        case BOT_ROTATE_RIGHT:
-           hipdir1 = HIP_FORWARD;
-           hipdir2 = HIP_BACKWARD;
-           servoShift = FBSHIFT_TURN;
-           moveType = TURN_MODE;
-           break;
-        case BOT_ROTATE_LEFT:
-           hipdir1 = HIP_BACKWARD;
-           hipdir2 = HIP_FORWARD;
-           servoShift = FBSHIFT_TURN;
-           moveType = TURN_MODE;
-           break;
-        case BOT_STAND:
-        case BOT_SIT:
-           hipdir1 = HIP_NEUTRAL;
-           hipdir2 = HIP_NEUTRAL;
-           servoShift = 0;
-           moveType = WALK_MODE;
-           break;
-       
-     }        
-  return;
-}
-
-void demo() {
-  
-  //Start by standing:
-  stand();
-  delay(500);//small delay before the next move 1/2 sec
-  
-  /*Call function to rotate each leg*/
-  rotateLegs();
-  
-    /*Swim*/
-    delay(500);//small delay before the next move 1 sec
-    //Set legs to not interfere with movement of middle legs and middle legs to a neutral position
-    setLegs(BACK_LEGS, HIP_BACKWARD_MAX, KNEE_RELAX, 0, 0, leanangle);
-    setLegs(FRONT_LEGS, HIP_FORWARD_MAX, KNEE_RELAX, 0, 0, leanangle);
-    setLegs(MIDDLE_LEGS, HIP_NEUTRAL, KNEE_UP, 0, 0, leanangle);
-    
-    delay(500);//small delay before the next move 1 sec
-      
-    //Swim forward
-    for(int i = 0; i < 6; i++) {
-      
-      //move middle legs forward and knees up
-      delay(100);//small delay before the next move 1/10th sec
-      setLegs(MIDDLE_LEGS, HIP_FORWARD_MAX, KNEE_UP_MAX, 0, 0, leanangle);
-      
-      //dont move legs and have knees push off surface
-      delay(100);//small delay before the next move 1/10th sec
-      setLegs(MIDDLE_LEGS, NOMOVE, 50, 0, 0, leanangle);
-      
-      //move legs back to neutral position with knee pushing off surface
-      delay(200);//small delay before the next move 1/5th sec
-      setLegs(MIDDLE_LEGS, HIP_NEUTRAL, NOMOVE, 0, 0, leanangle);
-      
-      //move legs back to back position with knee pushing off surface
-      delay(200);//small delay before the next move 1/5th sec
-      setLegs(MIDDLE_LEGS, HIP_BACKWARD_MAX, NOMOVE, 0, 0, leanangle);
-      
-      delay(100);//small delay before the next move 1/10th sec
-      setLegs(MIDDLE_LEGS, NOMOVE, KNEE_UP_MAX, 0, 0, leanangle);
-    }
-    
-    //Swim backward
-    for(int i = 0; i < 6; i++) {
-      
-      //move middle legs forward and knees up
-      delay(100);//small delay before the next move 
-      setLegs(MIDDLE_LEGS, HIP_BACKWARD_MAX, KNEE_UP_MAX, 0, 0, leanangle);
-      
-      //dont move legs and have knees push off surface
-      delay(100);//small delay before the next move 
-      setLegs(MIDDLE_LEGS, NOMOVE, 50, 0, 0, leanangle);
-      
-      //move legs back to neutral position with knee pushing off surface
-      delay(200);//small delay before the next move 
-      setLegs(MIDDLE_LEGS, HIP_NEUTRAL, NOMOVE, 0, 0, leanangle);
-      
-      //move legs back to back position with knee pushing off surface
-      delay(200);//small delay before the next move 
-      setLegs(MIDDLE_LEGS, HIP_FORWARD_MAX, NOMOVE, 0, 0, leanangle);
-      
-      delay(100);//small delay before the next move 
-      setLegs(MIDDLE_LEGS, NOMOVE, KNEE_UP_MAX, 0, 0, leanangle);
-    }
-    
-    /*Bow*/
-    delay(500);//small delay before the next move .5 sec
-    stand();
-    delay(500);//small delay before the next move .5 sec
-      setLegs(BACK_LEGS, HIP_NEUTRAL, KNEE_STAND, 0, 0, leanangle);
-      setLegs(MIDDLE_LEGS, HIP_NEUTRAL, KNEE_HALF_CROUCH, 0, 0, leanangle);
-      setLegs(FRONT_LEGS, HIP_NEUTRAL, KNEE_CROUCH, 0, 0, leanangle);
-      
-      delay(1500);//small delay before the next move 1.5 sec
-      stand();
-      delay(1000);//small delay before the next move 1 sec
-}
-
-/*
-  This is a delay function used to give the servos time to complete their tasks.
-*/
-void delay(int milliSec){
-  timeToMoveDemo = Timer_millis() + milliSec;
-  while(Timer_millis() < timeToMoveDemo){}
-}
-
-/*
-  This function creates circular motions with each of the 6 legs individually.
-*/
-void rotateLegs(){
-  
-  //Loop to go through each of the legs
-  uint8_t currentLeg = 0;
-    for(int i = 0; i < NUM_LEGS; i++) {
-    
-      //Check what leg will be moved
-    switch(i) {
-      case 0:
-        currentLeg = LEG0;
-        break;
-      case 1:
-        currentLeg = LEG1;
-        break;
-      case 2:
-        currentLeg = LEG2;
-        break;
-      case 3:
-        currentLeg = LEG3;
-        break;
-      case 4:
-        currentLeg = LEG4;
-        break;
-      case 5:
-        currentLeg = LEG5;
-        break;
-    default:
-      currentLeg = -1;
-        break;
-    }
-    
-    //Move hip from neutral to front and knee from high to mid
-    int KNEE_LOCATION = 175; 
-    int HIP_LOCATION = 90;  
-    while(HIP_LOCATION < 130){
-      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
-      delay(5);
-      HIP_LOCATION++;
-      KNEE_LOCATION--;
-    }
-    
-    //Move hip from front to neutral and knee from mid to low
-    KNEE_LOCATION = 110;
-    HIP_LOCATION = 130;
-    while(HIP_LOCATION > 90){
-      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
-      delay(5);
-      HIP_LOCATION--;
-      KNEE_LOCATION--;
-    }
-    
-    //Move hip from neutral to back and knee from low to mid
-    KNEE_LOCATION = 45;
-    HIP_LOCATION = 90;
-    while(HIP_LOCATION > 50){
-      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
-      delay(5);
-      HIP_LOCATION--;
-      KNEE_LOCATION++;
-    }
-    
-    //Move hip from back to neutral and knee from mid to high
-    KNEE_LOCATION = 110;
-    HIP_LOCATION = 50;
-    while(HIP_LOCATION < 90){
-      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
-      delay(5);
-      HIP_LOCATION++;
-      KNEE_LOCATION++;
-    }
-    //Set leg back to standing position
-    setLegs(currentLeg, HIP_LOCATION, KNEE_STAND, 0, 0, 0);
-  }
-}
+/*! \file  Gaits.c
+*
+* \brief
+* Module for controlling the gait of the Vorpal Hexapod
+*
+*  Most functions are ported directly from the Vorpal Hexapod Control Program
+*
+*  Copyright (C) 2017, 2018 Vorpal Robotics, LLC.
+*  https://github.com/vorpalrobotics/VorpalHexapod
+
+*  \license (copied directly from Vorpal Source Code)
+*  This work is licensed under the Creative Commons 
+*  Attribution-NonCommercial-ShareAlike 4.0 International License.
+*  To view a copy of this license, visit http:* creativecommons.org/licenses/by-nc-sa/4.0/.
+*  Attribution for derivations of this work should be made to: Vorpal Robotics, LLC
+*  
+*  You may use this work for noncommercial purposes without cost as long as you give us
+*  credit for our work (attribution) and any improvements you make are licensed in a way
+*  no more restrictive than our license.
+* 
+*  For example, you may build a Hexapod yourself and use this code for your own experiments,
+*  or you can build one and give the hexapod running this code to a friend, as long as you
+*  don't charge for it.
+* 
+*  If you have a question about whether a contemplated use is in compliance with the license,
+*  just ask us. We're friendly. Email us at support@vorpalrobotics.com
+* 
+*  For information on licensing this work for commercial purposes, 
+*  please send email to support@vorpalrobotics.com and we'll work with you to come up with
+*  something fair.
+* 
+*  This is the program that goes on the Robot, not the gamepad!
+* 
+*  For more technical informatio, see http://www.vorpalrobotics.com
+*
+* 
+* \author Vorpal Robotics
+          livey
+*
+******************************************************************************/
+#include "Gaits.h"
+#include "PCA9685.h"
+#include "Timer.h"
+#include "GPIO.h"
+#include "CPG.h"
+#include "BodyPose.h"
+#include "ServoModel.h"
+#include "Feedback.h"
+#include "ServoStream.h"
+#include "Script.h"
+#include "Fight.h"
+#include "Profile.h"
+#include "Recorder.h"
+#include "Contact.h"
+
+uint8_t deferServoSet = 0;
+uint32_t timeToMove = 0;
+uint32_t timeToMoveDemo = 0;
+volatile uint32_t ms_sinceStart = 0;
+
+#define USE_SERVO_MODEL 1 //end tripod phases at the predicted arrival of the joints (ServoModel.c)
+
+void updateMillis( void ){
+  ms_sinceStart++;
+  return;
+}
+#if USE_GOBLE_AS_MOVEMENT_CLOCK
+uint32_t Timer_millis( void ){
+   return ms_sinceStart;
+}
+#endif
+
+static void writeServo(uint8_t channel, int16_t pos);
+static void releaseHeldServos(uint32_t now);
+
+ //inrush budget, see setInrushBudget
+static uint8_t  inrushMaxStarts = INRUSH_BUDGET_MA / SERVO_START_MA;
+static uint16_t inrushWindowMs = 15;       //one servo frame, less a little timer jitter
+static uint8_t  inrushStarts = 0;          //large moves started in the current window
+static uint32_t inrushWindowStart = 0;
+static uint16_t inrushHeld = 0;            //bit per servo whose large move waits for room
+static int16_t  inrushTarget[2*NUM_LEGS];  //where the held servos go
+
+int16_t ServoPos[2*NUM_LEGS] = {NOMOVE, NOMOVE, NOMOVE, NOMOVE, NOMOVE, NOMOVE,
+                                NOMOVE, NOMOVE, NOMOVE, NOMOVE, NOMOVE, NOMOVE}; //store last servo position instruction (before pose and trim)
+int8_t servoOffset[2*NUM_LEGS] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};  /*knee offsets (6-11), see setServoTrim*/
+
+/*
+Wrapper functions to be used for clarity in state machines and outside the source file
+* SetWalkLegs
+* SetRotateLegs
+
+*/
+//version for just the knees
+void setKneesOnly( uint8_t legmask, int16_t knee_pos ) {
+  setLegs(legmask, NOMOVE, knee_pos, 0, 0, 0);
+}
+
+//return to default stand position
+void stand( void ) {
+  setLegs(ALL_LEGS, HIP_NEUTRAL, NOMOVE, 0, 0, 0);
+  delay(200);
+  setLegs(ALL_LEGS, HIP_NEUTRAL, KNEE_STAND, 0, 0, 0);
+}
+
+//return to default sit position
+void laydown( void ) {
+  setLegs(ALL_LEGS, HIP_NEUTRAL, KNEE_UP_MAX, 0, 0, 0);
+}
+
+/*
+  Power-up: the servo positions are unknown, so every servo is about to make
+  a large move. Go to the sit pose first (resting on the body, the inrush
+  budget staggers the servos), then raise the body to the stand height in
+  small knee steps, each too small to draw stall current.
+*/
+void softStart( void ) {
+  laydown();
+  while (!ServoModel_Arrived(ALL_SERVOS, Timer_millis())) { HW_IDLE(); }
+
+  for (int16_t knee = KNEE_UP_MAX - SOFT_START_STEP_DEG; knee > KNEE_STAND; knee -= SOFT_START_STEP_DEG) {
+    transactServos();
+    setKneesOnly(ALL_LEGS, knee);
+    commitServos();
+    delay(SOFT_START_STEP_MS);
+  }
+  setKneesOnly(ALL_LEGS, KNEE_STAND);
+}
+
+ 
+/*
+setLegs function for all your hip and knee directing needs
+leanangle tilts the knees of this one call (front legs for lean < 0, back legs
+for lean > 0); for a persistent tilt use setBodyPose
+*/
+void setLegs(uint8_t legmask, int16_t hip_pos, int16_t knee_pos, uint8_t adj, uint8_t raw, int16_t leanangle) {
+  for(uint8_t i = 0; i < NUM_LEGS; i++) {
+    if(legmask & 0x01) {  // if the lowest bit is ON
+      if(hip_pos != NOMOVE) {
+        if(!raw) {
+          setHip(i, hip_pos, adj);
+        } else {
+          setHipRaw(i, hip_pos);
+        }
+      }
+      if(knee_pos != NOMOVE) {
+        int16_t pos = knee_pos;
+        if(leanangle != 0) {
+          switch(i) {
+            case 0: case 5:
+              if(leanangle < 0) pos -= leanangle;
+              break;
+            case 1: case 4:
+              pos += (leanangle < 0 ? -leanangle : leanangle)/2;
+              break;
+            case 2: case 3:
+              if(leanangle > 0) pos += leanangle;
+              break;
+          }
+        }
+        setKnee(i, pos);
+      }
+    }
+    legmask = (legmask>>1);  // shift down one bit position
+  }
+}
+
+// this version of setHip adjusts not only for left and right,
+// but also shifts the front legs a little back and the back legs
+// forward to make a better balance for certain gaits like tripod or quadruped
+//
+
+void setHip(uint8_t leg, int16_t pos, uint8_t adj) {
+  if (ISFRONTLEG(leg)) {
+    pos -= adj;
+  } else if (ISBACKLEG(leg)) {
+    pos += adj;
+  }
+  // reverse the left side for consistent forward motion
+  if (leg >= LEFT_START) {
+    pos = 180 - pos;
+  }
+
+  setHipRaw(leg, pos);
+}
+
+/*
+// this version of setHip does no processing at all (for example
+// to distinguish left from right sides)
+*/
+void setHipRaw(uint8_t leg, int16_t pos) {
+  ServoPos[leg] = pos;
+  pos = BodyPose_Hip(leg, pos);
+  pos += servoOffset[leg];  //needs tuning! --LI
+  writeServo(leg, pos);
+}
+
+/*
+  Trim (degrees) added to every command for one servo channel, loaded from
+  the configuration (Config.c)
+*/
+void setServoTrim(uint8_t channel, int8_t trim) {
+  if (channel < 2*NUM_LEGS) {
+    servoOffset[channel] = trim;
+  }
+}
+
+/*
+
+*/
+void setKnee(uint8_t leg, int16_t pos) {
+  // find the knee associated with leg if this is not already a knee
+  if (leg < KNEE_OFFSET) {
+    leg += KNEE_OFFSET;
+  }
+  ServoPos[leg] = pos;
+  pos = BodyPose_Knee(leg - KNEE_OFFSET, pos);
+  pos += servoOffset[leg];
+  writeServo(leg, pos);
+}
+
+/*
+  Either write the servo right away or, inside a transaction, stage it for
+  the single burst in commitServos
+*/
+static void outputServo(uint8_t channel, int16_t pos, uint32_t now) {
+  ServoModel_Command(channel, pos, now);
+  if (deferServoSet) {
+    PCA9685_QueueServo(channel, (float)pos);
+  } else {
+    PCA9685_setServo(channel, (float)pos);
+  }
+}
+
+/*
+  Room for one more large move in the current inrush window
+*/
+static uint8_t inrushRoom(uint32_t now) {
+  if ((now - inrushWindowStart) >= inrushWindowMs) {
+    inrushWindowStart = now;
+    inrushStarts = 0;
+  }
+  return (inrushStarts < inrushMaxStarts) ? 1 : 0;
+}
+
+/*
+  Hold a large move back for a later frame of the transaction
+*/
+static void holdServo(uint8_t channel, int16_t pos, uint32_t now) {
+  uint16_t bit = (uint16_t)(1u << channel);
+  uint8_t waiting = 0;
+
+  for (uint16_t held = inrushHeld & ~bit; held; held &= (held - 1)) waiting++;
+  inrushTarget[channel] = pos;
+  inrushHeld |= bit;
+  ServoModel_Command(channel, pos, now + ((uint32_t)inrushWindowMs * (1u + (waiting / inrushMaxStarts))));
+}
+
+/*
+  Small moves go out straight away. A large move that does not fit the
+  inrush budget waits: inside a transaction it is held for a later frame
+  (the servo model is told it starts then, so the gait phase waits for it),
+  outside one the caller blocks until the next window. A servo already
+  held has not moved yet, whatever the model expects of it: inside a
+  transaction it stays held with the new target, outside one it waits for
+  the budget like any large move.
+*/
+static void writeServo(uint8_t channel, int16_t pos) {
+  uint32_t now = Timer_millis();
+  uint16_t bit = (uint16_t)(1u << channel);
+
+  if (deferServoSet && (inrushHeld & bit)) {
+    holdServo(channel, pos, now);
+    return;
+  }
+
+  if (!(inrushHeld & bit) && (ServoModel_Travel(channel, pos, now) < INRUSH_LARGE_DEG)) {
+    outputServo(channel, pos, now);
+    return;
+  }
+
+  if (!inrushRoom(now)) {
+    if (deferServoSet) {
+      holdServo(channel, pos, now);
+      return;
+    }
+    while (!inrushRoom(Timer_millis())) { HW_IDLE(); }
+    now = Timer_millis();
+  }
+  inrushStarts++;
+  inrushHeld &= ~bit;
+  outputServo(channel, pos, now);
+}
+
+/*
+  Start the held servos the budget has room for, lowest channel first
+*/
+static void releaseHeldServos(uint32_t now) {
+  for (uint8_t ch = 0; (ch < 2*NUM_LEGS) && inrushHeld; ch++) {
+    if (!(inrushHeld & (1u << ch))) continue;
+    if (!inrushRoom(now)) return;
+    inrushStarts++;
+    inrushHeld &= ~(1u << ch);
+    outputServo(ch, inrushTarget[ch], now);
+  }
+}
+
+/*
+  Inrush budget from the configuration (Config.c): how many large moves may
+  start per servo frame, and the pulse stagger between channels. Call after
+  the PWM frequency is set, the window follows its period.
+*/
+void setInrushBudget(uint16_t budgetMa, uint16_t startMa, uint8_t staggerMs) {
+  uint32_t starts = (startMa == 0) ? (2*NUM_LEGS) : (budgetMa / startMa);
+
+  if (starts < 1) starts = 1;
+  if (starts > 2*NUM_LEGS) starts = 2*NUM_LEGS;
+  inrushMaxStarts = (uint8_t)starts;
+
+  uint32_t periodMs = PCA9685_GetPeriodUs() / 1000u;
+  inrushWindowMs = (uint16_t)((periodMs > 1u) ? (periodMs - 1u) : 1u);
+  PCA9685_SetPhaseStagger((uint16_t)staggerMs * 1000u);
+}
+
+/*
+  Start collecting a servo frame: every set* call until commitServos is
+  staged instead of written. Servos held back by the inrush budget get the
+  first starts of the frame.
+*/
+void transactServos( void ) {
+  deferServoSet = 1;
+  releaseHeldServos(Timer_millis());
+}
+
+/*
+  Send the staged frame to the PCA9685 in one transaction and go back to
+  writing servos immediately
+*/
+void commitServos( void ) {
+  PCA9685_CommitServos();
+  deferServoSet = 0;
+}
+
+/*
+  Change the body pose and re-issue the last gait position of every joint,
+  so the new pose shows up even when the gait is not moving
+*/
+void setBodyPose(const bodyPose_t * pose) {
+  BodyPose_Set(pose);
+  for(uint8_t i = 0; i < NUM_LEGS; i++) {
+    if(ServoPos[i] != NOMOVE) setHipRaw(i, ServoPos[i]);
+    if(ServoPos[i + KNEE_OFFSET] != NOMOVE) setKnee(i, ServoPos[i + KNEE_OFFSET]);
+  }
+}
+
+
+/*
+  Decide whether the current tripod phase is over. With position feedback
+  the measured joints decide (servos without a pot use the model); the
+  predicted end time plus FEEDBACK_TIMEOUT still moves on if a joint is
+  blocked and never gets within tolerance.
+*/
+#define FEEDBACK_TIMEOUT 100
+static uint8_t contactLegs = NO_LEGS;   //legs the current set phase is putting down
+
+#if !USE_CPG_GAIT
+static uint8_t phaseComplete( void ){
+#if FOOT_CONTACT_ENABLED
+  if (contactLegs && Contact_Touched(contactLegs)) return 1;
+#endif
+#if POSITION_FEEDBACK_ENABLED
+  uint32_t now = Timer_millis();
+  return Feedback_Arrived(ALL_SERVOS, now) || ((int32_t)(now - (timeToMove + FEEDBACK_TIMEOUT)) > 0);
+#else
+  return (timeToMove < Timer_millis());
+#endif
+}
+#endif
+
+static phase_t fsmPosition = STANDING;   //copies of the FSM and tripod phase, for reporting
+static phase_t walkPhase = TRIPOD1_LIFT;
+
+phase_t getGaitPhase( void ){
+  return (fsmPosition == WALKING) ? walkPhase : fsmPosition;
+}
+
+void runGaitFSM( gaitCommand_t lastCmd ){
+  static phase_t position = STANDING;   //main stands the bot before the loop starts
+  
+  switch(position){
+  case DEMOING: //sit
+    if (lastCmd == BOT_STAND) {
+      stand(); 
+      position = STANDING;
+    }
+    break;
+  case STANDING: //stand
+    if (lastCmd == BOT_DEMO) {
+      demo();
+    } 
+    else if (lastCmd == BOT_STREAM) {
+      ServoStream_Resume();
+      position = STREAMING;
+    }
+    else if (lastCmd == BOT_SCRIPT) {
+      if (Script_Start(Script_Selected(), Timer_millis())) position = SCRIPTING;
+    }
+    else if (lastCmd == BOT_FIGHT) {
+      Fight_Start();
+      position = FIGHTING;
+    }
+    else if (lastCmd == BOT_SIT) {
+      laydown();
+      position = SITTING;
+    }
+    else if (lastCmd != BOT_STAND){
+#if USE_CPG_GAIT
+      CPG_Start(Timer_millis());
+#else
+      setKneesOnly(TRIPOD1_LEGS, KNEE_UP);
+#endif
+      position = WALKING;
+    }
+    break;
+  case WALKING: //handles walking, turning, and veering
+#if USE_CPG_GAIT
+    if (lastCmd == BOT_STOP){
+      //bot is frozen
+      position = FROZEN;
+    }
+    else {
+      //the oscillators ramp down to the stand pose on their own
+      CPG_SetCommand(lastCmd);
+      if (CPG_Update(Timer_millis()) == CPG_STOPPED){
+        position = STANDING;
+      }
+    }
+#else
+    if (phaseComplete()){
+      //streams, scripts and fight mode wait for the step to finish and the bot to stand
+      gaitCommand_t walkCmd = lastCmd;
+      if ((lastCmd == BOT_STREAM) || (lastCmd == BOT_SCRIPT) || (lastCmd == BOT_FIGHT)) walkCmd = BOT_STAND;
+      if (GaitHandler(walkCmd) == DONE_WALKING){
+        stand();
+        position = STANDING;
+      }
+      else if (lastCmd == BOT_STOP){
+        //bot is frozen
+        position = FROZEN;
+      }
+    }
+#endif
+    break;
+  case SITTING: //resting on the body (low battery), stays down until told to stand
+    if (lastCmd == BOT_STAND) {
+      stand();
+      position = STANDING;
+    }
+    break;
+  case FROZEN:
+    if (lastCmd == BOT_STAND) {
+      stand();
+      position = STANDING;
+    } 
+    else if (lastCmd == BOT_SIT) {
+      laydown();
+      position = SITTING;
+    }
+    else if (lastCmd == BOT_STREAM) {
+      ServoStream_Resume();
+      position = STREAMING;
+    }
+    break;
+  case STREAMING: //joints follow the frames streamed by the host
+    if (lastCmd == BOT_STREAM) {
+      ServoStream_Update(Timer_millis());
+    }
+    else {
+      stand();
+      position = STANDING;
+    }
+    break;
+  case FIGHTING: //front legs follow the joystick every tick
+    if (lastCmd == BOT_FIGHT) {
+      Fight_Update();
+    }
+    else if (lastCmd == BOT_STOP) {
+      position = FROZEN;
+    }
+    else {
+      stand();
+      position = STANDING;
+    }
+    break;
+  case SCRIPTING: //a stored script plays to the end unless the bot is stopped
+    if (lastCmd == BOT_STOP) {
+      Script_Stop();
+      position = FROZEN;
+    }
+    else if (lastCmd == BOT_SIT) {
+      Script_Stop();
+      stand();
+      position = STANDING;
+    }
+    else if (!Script_Update(Timer_millis())) {
+      stand();
+      position = STANDING;
+    }
+    break;
+  default:
+    break;
+  }
+  if (position != fsmPosition) {
+    GAIT_TRACE_PHASE(position);
+    RECORD(REC_FSM, position, lastCmd);
+  }
+  fsmPosition = position;
+}    
+
+#define WALK_MODE 0x00
+#define TURN_MODE 0x01
+#define FBSHIFT    15   // shift front legs back, back legs forward, this much
+#define FBSHIFT_TURN    40
+
+#if USE_GOBLE_AS_MOVEMENT_CLOCK
+ //these "times" are multipliers for the incoming packet rate (~5 per second)
+ #define TRIPOD_LIFT_TIME 1
+ #define TRIPOD_SWIVEL_TIME 1
+ #define TRIPOD_SET_TIME 1
+#else
+ //else use a (yet to be created) Timer_millis function which returns milliseconds
+ static uint16_t tripodLiftTime = 50;
+ static uint16_t tripodSwivelTime = 50;
+ static uint16_t tripodSetTime = 50;
+ #define TRIPOD_LIFT_TIME tripodLiftTime
+ #define TRIPOD_SWIVEL_TIME tripodSwivelTime
+ #define TRIPOD_SET_TIME tripodSetTime
+#endif
+
+/*
+  Fixed tripod phase times in milliseconds, loaded from the configuration
+  (Config.c). Ignored with the GoBLE clock, which counts packets instead.
+*/
+void setPhaseTimes(uint16_t liftMs, uint16_t swivelMs, uint16_t setMs){
+#if USE_GOBLE_AS_MOVEMENT_CLOCK
+  (void)liftMs; (void)swivelMs; (void)setMs;
+#else
+  tripodLiftTime = liftMs;
+  tripodSwivelTime = swivelMs;
+  tripodSetTime = setMs;
+#endif
+}
+
+static uint8_t gaitScale = 100;   //percent of speed and stride, see setGaitDerate
+
+/*
+  Slow the walk down and shorten its stride, for a sagging pack
+  (Battery.c). 100 is the full gait; the hip swing and the time each phase
+  is given both scale by percent, and so do the CPG oscillator frequency
+  and stride.
+*/
+void setGaitDerate(uint8_t percent){
+  if (percent < 1) percent = 1;
+  if (percent > 100) percent = 100;
+  gaitScale = percent;
+  CPG_SetScale(percent);
+}
+
+/*
+  When the next gait phase may start. With the servo model the phase ends
+  as soon as every joint commanded so far is predicted to have settled, so a
+  small knee tweak finishes long before a full hip swing. The fixed phase
+  times are only used without the model (or with the GoBLE clock). A
+  derated gait stretches the phase to 100/gaitScale of its length.
+*/
+static uint32_t phaseEndTime(uint32_t fixedTime){
+  uint32_t now = Timer_millis();
+#if USE_SERVO_MODEL && !USE_GOBLE_AS_MOVEMENT_CLOCK
+  (void)fixedTime;
+  uint32_t end = ServoModel_ArrivalTime(ALL_SERVOS);
+#else
+  uint32_t end = now + fixedTime;
+#endif
+  if ((gaitScale < 100) && ((int32_t)(end - now) > 0)) {
+    end += ((end - now) * (100 - gaitScale)) / gaitScale;
+  }
+  return end;
+}
+
+/*
+Each gait consists of 6 phases (walking, veering, turning)
+The gait parameters may be changed at any time (based on the incoming command)
+which allows for smooth transitions between different motions
+
+*/
+
+uint8_t hipdir1 = HIP_FORWARD;
+uint8_t hipdir2 = HIP_BACKWARD;
+uint8_t servoShift = FBSHIFT;
+uint8_t moveType = WALK_MODE;
+int16_t leanangle = 0;
+  
+/*
+  A set phase may end as soon as the knee current shows its feet landed
+  (Contact.c), rather than after the full knee travel: lowering a leg is
+  only as slow as the ground under it requires.
+*/
+static void armContact(uint8_t legMask){
+#if FOOT_CONTACT_ENABLED
+  contactLegs = legMask;
+  Contact_Arm(legMask, Timer_millis());
+#else
+  (void)legMask;
+#endif
+}
+
+phase_t GaitHandler( gaitCommand_t lastCmd ){
+
+  static phase_t gaitPhase = TRIPOD1_LIFT;
+  
+  if (lastCmd == BOT_STOP){
+    //freeze and wait for a new command
+    return FROZEN;
+  }
+  
+  PROFILE_BEGIN(PROF_GAIT_HANDLER);
+  walkPhase = gaitPhase;
+  GAIT_TRACE_PHASE(gaitPhase);
+  contactLegs = NO_LEGS;
+  switch (gaitPhase) {
+    case TRIPOD1_LIFT:     
+      // in this phase, center-left and noncenter-right legs raise up at
+      // the knee
+      setLegs(TRIPOD1_LEGS, NOMOVE, KNEE_NEUTRAL, 0, 0, leanangle);
+      timeToMove = phaseEndTime(TRIPOD_LIFT_TIME);
+      gaitPhase = TRIPOD1_SWIVEL;
+      break;
+      
+    case TRIPOD1_SWIVEL:
+      // in this phase, the center-left and noncenter-right legs move forward
+      // at the hips, while the rest of the legs move backward at the hip      
+      setGaitVariables(lastCmd, gaitPhase); 
+      setLegs(TRIPOD1_LEGS, hipdir1, NOMOVE, servoShift, moveType, leanangle);  
+      setLegs(TRIPOD2_LEGS, hipdir2, NOMOVE, servoShift, moveType, leanangle);
+      timeToMove = phaseEndTime(TRIPOD_SWIVEL_TIME);
+      if (lastCmd == BOT_STAND || lastCmd == BOT_SIT){
+        gaitPhase = WALK_STOPPING;
+      }else {
+        gaitPhase = TRIPOD1_SET;
+      }
+      break;
+      
+    case TRIPOD1_SET: 
+      // now put the first set of legs back down on the ground
+      setLegs(TRIPOD1_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
+      timeToMove = phaseEndTime(TRIPOD_SET_TIME);
+      armContact(TRIPOD1_LEGS);
+      gaitPhase = TRIPOD2_LIFT;
+      break;
+      
+    case TRIPOD2_LIFT:
+      // lift up the other set of legs at the knee
+      setLegs(TRIPOD2_LEGS, NOMOVE, KNEE_NEUTRAL, 0, 0, leanangle);
+      timeToMove = phaseEndTime(TRIPOD_LIFT_TIME);
+      gaitPhase = TRIPOD2_SWIVEL;
+      break;
+      
+    case TRIPOD2_SWIVEL:
+      // similar to phase 1, move raised legs forward and lowered legs backward     
+      setGaitVariables(lastCmd, gaitPhase); 
+      setLegs(TRIPOD1_LEGS, hipdir2, NOMOVE, servoShift, moveType, leanangle);
+      setLegs(TRIPOD2_LEGS, hipdir1, NOMOVE, servoShift, moveType, leanangle);
+      timeToMove = phaseEndTime(TRIPOD_SWIVEL_TIME);
+      if (lastCmd == BOT_STAND || lastCmd == BOT_SIT){
+        gaitPhase = WALK_STOPPING;
+      }else {
+        gaitPhase = TRIPOD2_SET;
+      }
+      break;
+
+    case TRIPOD2_SET:
+      // put the second set of legs down, and the cycle repeats
+      setLegs(TRIPOD2_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
+      timeToMove = phaseEndTime(TRIPOD_SET_TIME);
+      armContact(TRIPOD2_LEGS);
+      gaitPhase = TRIPOD1_LIFT;
+      break;
+      
+    case WALK_STOPPING:
+      setLegs(TRIPOD1_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
+      setLegs(TRIPOD2_LEGS, NOMOVE, KNEE_DOWN, 0, 0, leanangle);
+      gaitPhase = TRIPOD1_LIFT;
+      PROFILE_END(PROF_GAIT_HANDLER);
+      return DONE_WALKING;
+      break;
+      
+  }
+  PROFILE_END(PROF_GAIT_HANDLER);
+  return gaitPhase;
+}
+
+
+void setGaitVariables(gaitCommand_t lastCmd, phase_t gaitPhase){
+  if (gaitPhase == TRIPOD1_SWIVEL){
+    switch(lastCmd){    
+       case BOT_WALK_NW:
+       case BOT_WALK_NE:
+         lastCmd = BOT_WALK_FWD;
+         break;
+       case BOT_WALK_SW:
+       case BOT_WALK_SE:        
+         lastCmd = BOT_WALK_BACK;
+         break;
+    }
+  }
+  else if (gaitPhase == TRIPOD1_SWIVEL){
+    switch(lastCmd){    
+       case BOT_WALK_NW:
+       case BOT_WALK_SE:
+         lastCmd = BOT_ROTATE_LEFT;
+         break;
+       case BOT_WALK_SW:
+       case BOT_WALK_NE:        
+         lastCmd = BOT_ROTATE_RIGHT;
+         break;
+    }
+  }
+     switch(lastCmd){
+        case BOT_WALK_FWD:
+           hipdir1 = HIP_FORWARD;
+           hipdir2 = HIP_BACKWARD;
+           servoShift = FBSHIFT;
+           moveType = WALK_MODE;
+           break;
+        case BOT_WALK_BACK:
+           hipdir1 = HIP_BACKWARD;
+           hipdir2 = HIP_FORWARD;
+           servoShift = FBSHIFT;
+           moveType = WALK_MODE;
+           break;
+        case BOT_ROTATE_RIGHT:
+           hipdir1 = HIP_FORWARD;
+           hipdir2 = HIP_BACKWARD;
+           servoShift = FBSHIFT_TURN;
+           moveType = TURN_MODE;
+           break;
+        case BOT_ROTATE_LEFT:
+           hipdir1 = HIP_BACKWARD;
+           hipdir2 = HIP_FORWARD;
+           servoShift = FBSHIFT_TURN;
+           moveType = TURN_MODE;
+           break;
+        case BOT_STAND:
+        case BOT_SIT:
+           hipdir1 = HIP_NEUTRAL;
+           hipdir2 = HIP_NEUTRAL;
+           servoShift = 0;
+           moveType = WALK_MODE;
+           break;
+       
+     }        
+  if (gaitScale < 100){
+    //shorter stride, same centre
+    hipdir1 = HIP_NEUTRAL + (((int16_t)hipdir1 - HIP_NEUTRAL) * gaitScale) / 100;
+    hipdir2 = HIP_NEUTRAL + (((int16_t)hipdir2 - HIP_NEUTRAL) * gaitScale) / 100;
+  }
+  return;
+}
+
+void demo() {
+  
+  //a demo uploaded to flash replaces the one below
+  if (Script_Play(SCRIPT_DEMO_SLOT)) return;
+  
+  //Start by standing:
+  stand();
+  delay(500);//small delay before the next move 1/2 sec
+  
+  /*Call function to rotate each leg*/
+  rotateLegs();
+  
+    /*Swim*/
+    delay(500);//small delay before the next move 1 sec
+    //Set legs to not interfere with movement of middle legs and middle legs to a neutral position
+    setLegs(BACK_LEGS, HIP_BACKWARD_MAX, KNEE_RELAX, 0, 0, leanangle);
+    setLegs(FRONT_LEGS, HIP_FORWARD_MAX, KNEE_RELAX, 0, 0, leanangle);
+    setLegs(MIDDLE_LEGS, HIP_NEUTRAL, KNEE_UP, 0, 0, leanangle);
+    
+    delay(500);//small delay before the next move 1 sec
+      
+    //Swim forward
+    for(int i = 0; i < 6; i++) {
+      
+      //move middle legs forward and knees up
+      delay(100);//small delay before the next move 1/10th sec
+      setLegs(MIDDLE_LEGS, HIP_FORWARD_MAX, KNEE_UP_MAX, 0, 0, leanangle);
+      
+      //dont move legs and have knees push off surface
+      delay(100);//small delay before the next move 1/10th sec
+      setLegs(MIDDLE_LEGS, NOMOVE, 50, 0, 0, leanangle);
+      
+      //move legs back to neutral position with knee pushing off surface
+      delay(200);//small delay before the next move 1/5th sec
+      setLegs(MIDDLE_LEGS, HIP_NEUTRAL, NOMOVE, 0, 0, leanangle);
+      
+      //move legs back to back position with knee pushing off surface
+      delay(200);//small delay before the next move 1/5th sec
+      setLegs(MIDDLE_LEGS, HIP_BACKWARD_MAX, NOMOVE, 0, 0, leanangle);
+      
+      delay(100);//small delay before the next move 1/10th sec
+      setLegs(MIDDLE_LEGS, NOMOVE, KNEE_UP_MAX, 0, 0, leanangle);
+    }
+    
+    //Swim backward
+    for(int i = 0; i < 6; i++) {
+      
+      //move middle legs forward and knees up
+      delay(100);//small delay before the next move 
+      setLegs(MIDDLE_LEGS, HIP_BACKWARD_MAX, KNEE_UP_MAX, 0, 0, leanangle);
+      
+      //dont move legs and have knees push off surface
+      delay(100);//small delay before the next move 
+      setLegs(MIDDLE_LEGS, NOMOVE, 50, 0, 0, leanangle);
+      
+      //move legs back to neutral position with knee pushing off surface
+      delay(200);//small delay before the next move 
+      setLegs(MIDDLE_LEGS, HIP_NEUTRAL, NOMOVE, 0, 0, leanangle);
+      
+      //move legs back to back position with knee pushing off surface
+      delay(200);//small delay before the next move 
+      setLegs(MIDDLE_LEGS, HIP_FORWARD_MAX, NOMOVE, 0, 0, leanangle);
+      
+      delay(100);//small delay before the next move 
+      setLegs(MIDDLE_LEGS, NOMOVE, KNEE_UP_MAX, 0, 0, leanangle);
+    }
+    
+    /*Bow*/
+    delay(500);//small delay before the next move .5 sec
+    stand();
+    delay(500);//small delay before the next move .5 sec
+      setLegs(BACK_LEGS, HIP_NEUTRAL, KNEE_STAND, 0, 0, leanangle);
+      setLegs(MIDDLE_LEGS, HIP_NEUTRAL, KNEE_HALF_CROUCH, 0, 0, leanangle);
+      setLegs(FRONT_LEGS, HIP_NEUTRAL, KNEE_CROUCH, 0, 0, leanangle);
+      
+      delay(1500);//small delay before the next move 1.5 sec
+      stand();
+      delay(1000);//small delay before the next move 1 sec
+}
+
+/*
+  This is a delay function used to give the servos time to complete their tasks.
+*/
+void delay(int milliSec){
+  //whatever was staged before the pause has to reach the servos first
+  if (deferServoSet) PCA9685_CommitServos();
+  timeToMoveDemo = Timer_millis() + milliSec;
+  while(Timer_millis() < timeToMoveDemo){
+    //servos held by the inrush budget start as the pause makes room
+    if (deferServoSet && inrushHeld) {
+      releaseHeldServos(Timer_millis());
+      PCA9685_CommitServos();
+    }
+    HW_IDLE();
+  }
+}
+
+/*
+  This function creates circular motions with each of the 6 legs individually.
+*/
+void rotateLegs(){
+  
+  //Loop to go through each of the legs
+  uint8_t currentLeg = 0;
+    for(int i = 0; i < NUM_LEGS; i++) {
+    
+      //Check what leg will be moved
+    switch(i) {
+      case 0:
+        currentLeg = LEG0;
+        break;
+      case 1:
+        currentLeg = LEG1;
+        break;
+      case 2:
+        currentLeg = LEG2;
+        break;
+      case 3:
+        currentLeg = LEG3;
+        break;
+      case 4:
+        currentLeg = LEG4;
+        break;
+      case 5:
+        currentLeg = LEG5;
+        break;
+    default:
+      currentLeg = -1;
+        break;
+    }
+    
+    //Move hip from neutral to front and knee from high to mid
+    int KNEE_LOCATION = 175; 
+    int HIP_LOCATION = 90;  
+    while(HIP_LOCATION < 130){
+      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
+      delay(5);
+      HIP_LOCATION++;
+      KNEE_LOCATION--;
+    }
+    
+    //Move hip from front to neutral and knee from mid to low
+    KNEE_LOCATION = 110;
+    HIP_LOCATION = 130;
+    while(HIP_LOCATION > 90){
+      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
+      delay(5);
+      HIP_LOCATION--;
+      KNEE_LOCATION--;
+    }
+    
+    //Move hip from neutral to back and knee from low to mid
+    KNEE_LOCATION = 45;
+    HIP_LOCATION = 90;
+    while(HIP_LOCATION > 50){
+      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
+      delay(5);
+      HIP_LOCATION--;
+      KNEE_LOCATION++;
+    }
+    
+    //Move hip from back to neutral and knee from mid to high
+    KNEE_LOCATION = 110;
+    HIP_LOCATION = 50;
+    while(HIP_LOCATION < 90){
+      setLegs(currentLeg, HIP_LOCATION, KNEE_LOCATION, 0, 0, 0);
+      delay(5);
+      HIP_LOCATION++;
+      KNEE_LOCATION++;
+    }
+    //Set leg back to standing position
+    setLegs(currentLeg, HIP_LOCATION, KNEE_STAND, 0, 0, 0);
+  }
+}
@@ -0,0 +1,29 @@
+#if !defined(HWREG_H)
+#define HWREG_H
+
+#include <stdint.h>
+
+ // Every peripheral register is reached through HWREG, and memory mapped
+ // flash contents through HWMEM, so the drivers can be built on a host with
+ // HOST_SIM defined and run against the virtual register map in ../sim.
+ // HW_IDLE marks busy waits on time that touch no register.
+#if defined(HOST_SIM)
+ #include "SimRegs.h"
+ #define HWREG(addr)   (*SimReg_Access((uint32_t)(addr)))
+ #define HWMEM(addr)   (SimMem_Ptr((uint32_t)(addr)))
+ #define HW_IDLE()     SimReg_Idle()
+#else
+ #define HWREG(addr)   (*((volatile uint32_t *)(addr)))
+ #define HWMEM(addr)   ((const void *)(addr))
+ #define HW_IDLE()
+#endif
+
+ // HW_NO_INIT keeps a variable out of the startup zeroing, so it survives a
+ // warm reset (IAR places it in .noinit)
+#if defined(__ICCARM__)
+ #define HW_NO_INIT    __no_init
+#else
+ #define HW_NO_INIT
+#endif
+
+#endif
@@ -1,209 +1,355 @@
-/*! \file  PCA9685.c
-*
-* \brief  Driver module for interfacing with PCA9685. 
-*
-* \details This device is 16 channel, 12-bit used for driving LEDs or Servos 
-*          with PWMs. In this module, we allow the frequency and duty cycle to 
-*          be changed.
-*       All functions:
-*           - use the return value to communicate driver status.
-*           - return information through pointer arguments.
-*
-*
-* \author vsimontov
-*
-*
-* This code was tested using an osciliscope to verify frequency and duty cycle
-*
-* For details on programming, refer to PCA9685 datasheet :
-* https://cdn-shop.adafruit.com/datasheets/PCA9685.pdf
-*
-******************************************************************************/
-
-#include <stdint.h>
-#include <stdio.h>
-#include "PCA9685.h"
-#include <tm4c123gh6pm.h>
-#include "GPIO.h"
-#include "I2C.h"
-#include <math.h>
-
-pca9685_status_t PCA9685_Init(void)
-/*! \brief   Initialize the PCA9685 for use. 
-    \details: Set MODE1 enable restarts and all calls to all channels
-          set MODE2 to output all changes on ACKs
-    \return pca9685_status_t : status of i2c bus
-                PCA_9685_OK : I2C transfer completed successfully
-                PCA_9685_NOT_SET : Clock timeout error has occurred.
-*/
-{
-  i2c_status_t writePrescaleMode1 = I2C_WriteBytes(PCA_9685_ADDR, MODE1,(EN_RST | EN_ALLCALL));  
-  i2c_status_t writePrescaleMode2 = I2C_WriteBytes(PCA_9685_ADDR, MODE2, OCH_ACK);
-  if((writePrescaleMode1 == i2c_OK) && (writePrescaleMode2 == i2c_OK))
-    return PCA_9685_OK;
-  else
-    return PCA_9685_NOT_SET;
-  
-}
-
-pca9685_status_t PCA9685_Restart(void)
-/*! \brief   Software restart the PCA9685
-    \details: Checks MODE1 to see if Restart bit is high, indicates that a restart
-          is needed. 
-    \return pca9685_status_t : status of i2c bus
-                PCA_9685_OK : Unit is restarted and ready to accept new commands
-                PCA_9685_NOT_SET : Unit has not accepted the restart sequence
-                PCA_9685_UNKNOWN : Unknown error condition
-*/
-{
-  uint8_t modeStatus=0x00;
-  uint32_t delayCounter = 0;
-  uint8_t verifyRestart = 0x0;
-  
-  //All leds off (write 1 to 4th bit of ALL_LED_OFF_H register pg.15 of datasheet)
-  //fastest way to shutdown
-  i2c_status_t writeOff = I2C_WriteBytes(PCA_9685_ADDR, ALL_LED_OFF_H, (0x01 << 4));
-  i2c_status_t writeOff1 = I2C_WriteBytes(PCA_9685_ADDR, ALL_LED_OFF_L, (0x01 << 4));
-
-
-  if(I2C_Read(PCA_9685_ADDR, MODE1, &modeStatus) == i2c_OK){   
-    
-    //trigger a restart if the bit is high
-    if((modeStatus & RESTART) == RESTART){  
-      
-      I2C_WriteBytes(PCA_9685_ADDR, MODE1, (modeStatus | RESTART));
-      //arbitrary delay here. Need to scope out this delay
-      while(delayCounter < 100000u){
-        delayCounter++;
-      }
-    }
-    
-    I2C_Read(PCA_9685_ADDR, MODE1, &verifyRestart);
-    if ((verifyRestart & RESTART) == 0)
-      return PCA_9685_OK;
-    else
-      return PCA_9685_NOT_SET;
-  }
-  return PCA_9685_UNKNOWN;
-}
-
-
-pca9685_status_t PCA9685_UpdatePWMFrequency(uint16_t newFrequency)
-/*! \brief   Sets the desired frequency of the PCA9685 output pins
-    \notes: frequency should be between 24hz and 1526hz
-    \param[in]: newFrequency, desired frequency value
-    \return pca9685_status_t : status of i2c bus
-                PCA_9685_OK : Frequency has been set and old mode has been restored
-                PCA_9685_NOT_SET : The old mode has not been restored, problems happened
-*/
-{
-  if (newFrequency < MIN_HZ)  newFrequency = MIN_HZ;
-  if (newFrequency > MAX_HZ)  newFrequency = MAX_HZ;
-  
-  uint32_t delayCounter = 0;
-  uint8_t oldMode=0x00;
-  float prescaleVal = CLKRATE;
-  
-  prescaleVal /= 4096;
-  prescaleVal /= newFrequency;
-  prescaleVal -= 1;
-  uint8_t prescale = (uint8_t)floor(prescaleVal);  
-  
-  
-  I2C_Read(PCA_9685_ADDR, MODE1, &oldMode);
-
-  uint8_t newMode = ((oldMode & ~RESTART) | SLEEP); // check if sleep is 1, otherwise prescale writes are blocked
-  I2C_WriteBytes(PCA_9685_ADDR, MODE1, (uint8_t)(newMode));  
- 
-  //write new value
-  I2C_WriteBytes(PCA_9685_ADDR, PRESCALE, (uint8_t) prescale);  
-
-  //reset the original mode register
-  I2C_WriteBytes(PCA_9685_ADDR, MODE1, (uint8_t)(oldMode));  
-  
-  //bit of a delay here to allow things to stabilize
-  while(delayCounter < 100000u){
-        delayCounter++;
-  }
-  uint8_t verifyOldMode = 0x00;
-  i2c_status_t verifyModeStatus = I2C_Read(PCA_9685_ADDR, MODE1, &verifyOldMode);
-
-  //check to make sure the old mode was reset
-  if((verifyOldMode == oldMode) && (verifyModeStatus == i2c_OK))
-    return PCA_9685_OK;
-  else
-    return PCA_9685_NOT_SET;
-
-}
-
-void PCA9685_convertDutyCycleToCounts(float dutyCycle, uint16_t * highCount, uint16_t * lowCount)
-/*!\brief   Converts duty cycle(%) to counts as understood by the PCA9685
-\notes: Operating frequency should be 60hz for Servo motoros
-        100% Duty Cycle is 0x0FFF (4095 counts)
-          0% Duty Cycle is 0x199 (409 counts)
-\param dutyCycle[in]: on-time percentage of square wave
-       highCount[out]: upper 8-bit value of the 16-bit register as needed by PCA
-       lowCount[out]:  lower 8-bit value of the 16-bit register as needed by PCA
-\return none 
-*/
-{
-  //check duty cycle bounds and clamp
-  if (dutyCycle < 0) dutyCycle = 0;
-  if (dutyCycle > 100) dutyCycle = 100;
-  
-  //convert duty cycle into counts
-  float counts = (float)(((float)dutyCycle/100) * 4095);
-    
-  
-  uint16_t onCounts = (uint16_t)(counts);
-  *highCount = ((onCounts >> 8) & 0xff); //isolate upper 8-bits
-  *lowCount = onCounts & 0xff;           //isolate lower 8-bits
-}
-  
-void PCA9685_setServo(uint8_t leg, float degree)
-/*!\brief   main function to drive each leg
-   \details each leg will take a degree position as target input, and this function
-            will translate the required degree to duty cycle/pulse width to enable
-            the movement
-   \notes: degree range should be clamped between 0 and 180
-   \param leg[in]: leg number to be moved
-          degree[in]: number of degrees to move leg
-   \return none 
-*/
-{
-  //check for proper degree range and leg number, clamp if outside range
-  if (degree < 0.0) degree = 0.0;
-  if (degree > 180.0) degree = 180.0;
-  if(leg > 11) leg = 11;
-   
-  uint16_t highCount = 0;
-  uint16_t lowCount = 0;  
-  
-  //Set address of new leg   
-  uint8_t addr_on_l = (6 + (4*leg));
-  uint8_t addr_on_h = (7 + (4*leg));
-  uint8_t addr_off_l= (8 + (4*leg));
-  uint8_t addr_off_h= (9 + (4*leg));
-  
-  
-  //find out on time
-
-  float onTime = ((ONE_MSEC/ MAX_ROTATION) * degree) + ONE_MSEC; //0 degrees = 1ms on time, 180 degrees = 2ms
-  
-  //Calibrate PCA9685 pulse width to be what we expect (small error)
-  //onTime = ((onTime* 1.0489) - 0.0039); //calibrating the cycle time.
-
-
-  float dutyCycle = (onTime/PERIOD) * 100.0;
-
-  //convert duty cycle to counts as understood by PCA
-  PCA9685_convertDutyCycleToCounts(dutyCycle, &highCount, &lowCount);
-  
-  //Write to the address, make the legs move!
-  //(we could optimize this to make one long write instead of four seperate calls)
-  i2c_status_t write1 = I2C_WriteBytes(PCA_9685_ADDR, addr_off_h, (uint8_t)highCount);
-  i2c_status_t write2 = I2C_WriteBytes(PCA_9685_ADDR, addr_off_l, lowCount);
-  i2c_status_t write3 = I2C_WriteBytes(PCA_9685_ADDR, addr_on_h,  0x0F);
-  i2c_status_t write4 = I2C_WriteBytes(PCA_9685_ADDR, addr_on_l,  0xFF);
-  
-}
+/*! \file  PCA9685.c
+*
+* \brief  Driver module for interfacing with PCA9685. 
+*
+* \details This device is 16 channel, 12-bit used for driving LEDs or Servos 
+*          with PWMs. In this module, we allow the frequency and duty cycle to 
+*          be changed.
+*       All functions:
+*           - use the return value to communicate driver status.
+*           - return information through pointer arguments.
+*
+*
+* \author vsimontov
+*
+*
+* This code was tested using an osciliscope to verify frequency and duty cycle
+*
+* For details on programming, refer to PCA9685 datasheet :
+* https://cdn-shop.adafruit.com/datasheets/PCA9685.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include "PCA9685.h"
+#include <tm4c123gh6pm.h>
+#include "GPIO.h"
+#include "I2C.h"
+#include "Profile.h"
+#include <math.h>
+
+static uint8_t activePrescale = 0;                  /*prescale last written, 0 = not set yet*/
+static uint8_t frameRegs[NUM_CHANNELS * LED_REG_STRIDE];  /*queued ON/OFF registers per channel*/
+static uint16_t frameDirty = 0;                     /*bit per channel queued since the last commit*/
+static uint16_t pulseMinUs = 1000;                  /*pulse width at 0 degrees*/
+static uint16_t pulseMaxUs = 2000;                  /*pulse width at MAX_ROTATION*/
+static uint16_t countTable[MAX_ROTATION + 1];       /*OFF count per whole degree, see buildCountTable*/
+static uint8_t countTableReady = 0;
+static uint16_t channelPhase[NUM_CHANNELS];         /*counts each channel's pulse is shifted by, see PCA9685_SetPhaseStagger*/
+
+/*
+  One OFF count per whole degree for the pulse range, against the period the
+  PCA9685 is running at. Rebuilt whenever either changes, so setServo only
+  interpolates.
+*/
+static void buildCountTable(void)
+{
+  float periodUs = (float)PCA9685_GetPeriodUs();
+
+  for (uint16_t deg = 0; deg <= MAX_ROTATION; deg++){
+    float onUs = pulseMinUs + (((float)(pulseMaxUs - pulseMinUs) * deg) / MAX_ROTATION);
+    float counts = (onUs / periodUs) * 4095;
+    if (counts > 4095) counts = 4095;
+    countTable[deg] = (uint16_t)counts;
+  }
+  countTableReady = 1;
+}
+
+static void PCA9685_StageChannel(uint8_t leg, uint16_t counts)
+{
+  uint8_t * regs = &frameRegs[leg * LED_REG_STRIDE];
+  uint16_t on = (0x0FFF + channelPhase[leg]) & 0x0FFF;   //pulse starts at count 4095 plus the phase
+  uint16_t off = (counts + channelPhase[leg]) & 0x0FFF;
+
+  regs[0] = (uint8_t)(on & 0xff);       //ON_L
+  regs[1] = (uint8_t)(on >> 8);         //ON_H
+  regs[2] = (uint8_t)(off & 0xff);      //OFF_L
+  regs[3] = (uint8_t)(off >> 8);        //OFF_H
+}
+
+pca9685_status_t PCA9685_Init(void)
+/*! \brief   Initialize the PCA9685 for use. 
+    \details: Set MODE1 enable restarts and all calls to all channels
+          set MODE2 to output all changes on ACKs
+    \return pca9685_status_t : status of i2c bus
+                PCA_9685_OK : I2C transfer completed successfully
+                PCA_9685_NOT_SET : Clock timeout error has occurred.
+*/
+{
+  //auto-increment lets PCA9685_CommitServos write a whole frame in one burst
+  i2c_status_t writePrescaleMode1 = I2C_WriteBytes(PCA_9685_ADDR, MODE1,(EN_RST | EN_ALLCALL | AUTO_INC));  
+  i2c_status_t writePrescaleMode2 = I2C_WriteBytes(PCA_9685_ADDR, MODE2, OCH_ACK);
+
+  //until a channel is driven its frame entry holds "full off" (bit 4 of OFF_H)
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    frameRegs[(ch * LED_REG_STRIDE) + 3] = (0x01 << 4);
+  }
+  frameDirty = 0;
+  if((writePrescaleMode1 == i2c_OK) && (writePrescaleMode2 == i2c_OK))
+    return PCA_9685_OK;
+  else
+    return PCA_9685_NOT_SET;
+  
+}
+
+pca9685_status_t PCA9685_Restart(void)
+/*! \brief   Software restart the PCA9685
+    \details: Checks MODE1 to see if Restart bit is high, indicates that a restart
+          is needed. 
+    \return pca9685_status_t : status of i2c bus
+                PCA_9685_OK : Unit is restarted and ready to accept new commands
+                PCA_9685_NOT_SET : Unit has not accepted the restart sequence
+                PCA_9685_UNKNOWN : Unknown error condition
+*/
+{
+  uint8_t modeStatus=0x00;
+  uint32_t delayCounter = 0;
+  uint8_t verifyRestart = 0x0;
+  
+  //All leds off (write 1 to 4th bit of ALL_LED_OFF_H register pg.15 of datasheet)
+  //fastest way to shutdown
+  i2c_status_t writeOff = I2C_WriteBytes(PCA_9685_ADDR, ALL_LED_OFF_H, (0x01 << 4));
+  i2c_status_t writeOff1 = I2C_WriteBytes(PCA_9685_ADDR, ALL_LED_OFF_L, (0x01 << 4));
+
+
+  if(I2C_Read(PCA_9685_ADDR, MODE1, &modeStatus) == i2c_OK){   
+    
+    //trigger a restart if the bit is high
+    if((modeStatus & RESTART) == RESTART){  
+      
+      I2C_WriteBytes(PCA_9685_ADDR, MODE1, (modeStatus | RESTART));
+      //arbitrary delay here. Need to scope out this delay
+      while(delayCounter < 100000u){
+        delayCounter++;
+      }
+    }
+    
+    I2C_Read(PCA_9685_ADDR, MODE1, &verifyRestart);
+    if ((verifyRestart & RESTART) == 0)
+      return PCA_9685_OK;
+    else
+      return PCA_9685_NOT_SET;
+  }
+  return PCA_9685_UNKNOWN;
+}
+
+
+pca9685_status_t PCA9685_UpdatePWMFrequency(uint16_t newFrequency)
+/*! \brief   Sets the desired frequency of the PCA9685 output pins
+    \notes: frequency should be between 24hz and 1526hz
+    \param[in]: newFrequency, desired frequency value
+    \return pca9685_status_t : status of i2c bus
+                PCA_9685_OK : Frequency has been set and old mode has been restored
+                PCA_9685_NOT_SET : The old mode has not been restored, problems happened
+*/
+{
+  if (newFrequency < MIN_HZ)  newFrequency = MIN_HZ;
+  if (newFrequency > MAX_HZ)  newFrequency = MAX_HZ;
+  
+  uint32_t delayCounter = 0;
+  uint8_t oldMode=0x00;
+  float prescaleVal = CLKRATE;
+  
+  prescaleVal /= 4096;
+  prescaleVal /= newFrequency;
+  prescaleVal -= 1;
+  uint8_t prescale = (uint8_t)floor(prescaleVal);  
+  
+  
+  I2C_Read(PCA_9685_ADDR, MODE1, &oldMode);
+
+  uint8_t newMode = ((oldMode & ~RESTART) | SLEEP); // check if sleep is 1, otherwise prescale writes are blocked
+  I2C_WriteBytes(PCA_9685_ADDR, MODE1, (uint8_t)(newMode));  
+ 
+  //write new value
+  I2C_WriteBytes(PCA_9685_ADDR, PRESCALE, (uint8_t) prescale);  
+  activePrescale = prescale;
+  buildCountTable();
+
+  //reset the original mode register
+  I2C_WriteBytes(PCA_9685_ADDR, MODE1, (uint8_t)(oldMode));  
+  
+  //bit of a delay here to allow things to stabilize
+  while(delayCounter < 100000u){
+        delayCounter++;
+  }
+  uint8_t verifyOldMode = 0x00;
+  i2c_status_t verifyModeStatus = I2C_Read(PCA_9685_ADDR, MODE1, &verifyOldMode);
+
+  //check to make sure the old mode was reset
+  if((verifyOldMode == oldMode) && (verifyModeStatus == i2c_OK))
+    return PCA_9685_OK;
+  else
+    return PCA_9685_NOT_SET;
+
+}
+
+void PCA9685_convertDutyCycleToCounts(float dutyCycle, uint16_t * highCount, uint16_t * lowCount)
+/*!\brief   Converts duty cycle(%) to counts as understood by the PCA9685
+\notes: Operating frequency should be 60hz for Servo motoros
+        100% Duty Cycle is 0x0FFF (4095 counts)
+          0% Duty Cycle is 0x199 (409 counts)
+\param dutyCycle[in]: on-time percentage of square wave
+       highCount[out]: upper 8-bit value of the 16-bit register as needed by PCA
+       lowCount[out]:  lower 8-bit value of the 16-bit register as needed by PCA
+\return none 
+*/
+{
+  //check duty cycle bounds and clamp
+  if (dutyCycle < 0) dutyCycle = 0;
+  if (dutyCycle > 100) dutyCycle = 100;
+  
+  //convert duty cycle into counts
+  float counts = (float)(((float)dutyCycle/100) * 4095);
+    
+  
+  uint16_t onCounts = (uint16_t)(counts);
+  *highCount = ((onCounts >> 8) & 0xff); //isolate upper 8-bits
+  *lowCount = onCounts & 0xff;           //isolate lower 8-bits
+}
+  
+uint16_t PCA9685_DegreeToCounts(float degree)
+/*!\brief   Converts a servo angle to the PCA9685 OFF count
+   \details 0 degrees = pulse minimum, 180 degrees = pulse maximum (1ms and 2ms
+            unless PCA9685_SetPulseRange says otherwise), at the period the
+            PCA9685 is running at. Interpolated from the per-degree table.
+   \notes: degree range is clamped between 0 and 180
+   \param degree[in]: servo angle
+   \return 12-bit OFF count
+*/
+{
+  if (degree < 0.0) degree = 0.0;
+  if (degree > 180.0) degree = 180.0;
+  if (!countTableReady) buildCountTable();
+
+  uint16_t whole = (uint16_t)degree;
+  if (whole >= MAX_ROTATION) return countTable[MAX_ROTATION];
+
+  float fraction = degree - whole;
+  return (uint16_t)(countTable[whole] + ((countTable[whole + 1] - countTable[whole]) * fraction));
+}
+
+void PCA9685_SetPulseRange(uint16_t minUs, uint16_t maxUs)
+/*!\brief   Servo pulse widths at 0 and 180 degrees
+   \details Calibration from the configuration (Config.c). Only affects
+            positions converted from now on.
+   \param minUs[in]: pulse width at 0 degrees, microseconds
+          maxUs[in]: pulse width at 180 degrees, must be above minUs
+   \return none
+*/
+{
+  if (maxUs <= minUs) return;
+  pulseMinUs = minUs;
+  pulseMaxUs = maxUs;
+  buildCountTable();
+}
+
+void PCA9685_setServo(uint8_t leg, float degree)
+/*!\brief   main function to drive each leg
+   \details each leg will take a degree position as target input, and this function
+            will translate the required degree to duty cycle/pulse width to enable
+            the movement
+   \notes: degree range should be clamped between 0 and 180
+   \param leg[in]: leg number to be moved
+          degree[in]: number of degrees to move leg
+   \return none 
+*/
+{
+  PROFILE_BEGIN(PROF_SET_SERVO);
+  //check for proper leg number, clamp if outside range
+  if(leg > 11) leg = 11;
+   
+  PCA9685_StageChannel(leg, PCA9685_DegreeToCounts(degree));  //keep the frame copy in sync for later bursts
+  const uint8_t * regs = &frameRegs[leg * LED_REG_STRIDE];
+  
+  //Set address of new leg   
+  uint8_t addr_on_l = (6 + (4*leg));
+  uint8_t addr_on_h = (7 + (4*leg));
+  uint8_t addr_off_l= (8 + (4*leg));
+  uint8_t addr_off_h= (9 + (4*leg));
+  
+  //Write to the address, make the legs move!
+  //(use PCA9685_QueueServo/PCA9685_CommitServos to write a whole frame in one transaction)
+  i2c_status_t write1 = I2C_WriteBytes(PCA_9685_ADDR, addr_off_h, regs[3]);
+  i2c_status_t write2 = I2C_WriteBytes(PCA_9685_ADDR, addr_off_l, regs[2]);
+  i2c_status_t write3 = I2C_WriteBytes(PCA_9685_ADDR, addr_on_h,  regs[1]);
+  i2c_status_t write4 = I2C_WriteBytes(PCA_9685_ADDR, addr_on_l,  regs[0]);
+  PROFILE_END(PROF_SET_SERVO);
+}
+
+void PCA9685_QueueServo(uint8_t leg, float degree)
+/*!\brief   Stage a servo position for the next PCA9685_CommitServos
+   \details Same conversion as PCA9685_setServo, but nothing goes on the bus.
+            Queuing the same servo twice keeps the last position.
+   \param leg[in]: servo channel to be moved
+          degree[in]: number of degrees to move leg
+   \return none 
+*/
+{
+  if(leg > 11) leg = 11;
+
+  PCA9685_StageChannel(leg, PCA9685_DegreeToCounts(degree));
+  frameDirty |= (1u << leg);
+}
+
+pca9685_status_t PCA9685_CommitServos(void)
+/*!\brief   Write every queued servo in a single I2C transaction
+   \details Covers the channel span from the lowest to the highest queued
+            servo (unchanged channels in between are rewritten with their last
+            value). All outputs update together on the STOP condition, so a
+            frame never shows up half old, half new. Relies on MODE1.AI.
+   \return pca9685_status_t :
+                PCA_9685_OK : frame written (or nothing was queued)
+                PCA_9685_UNRESPONSIVE : the transfer failed, frame stays queued
+*/
+{
+  uint8_t first = 0;
+  uint8_t last = NUM_CHANNELS - 1;
+
+  if (frameDirty == 0) return PCA_9685_OK;
+
+  while (((frameDirty >> first) & 0x01) == 0) first++;
+  while (((frameDirty >> last) & 0x01) == 0) last--;
+
+  PROFILE_BEGIN(PROF_COMMIT);
+  i2c_status_t status = I2C_WriteBurst(PCA_9685_ADDR, LED0_ON_L + (first * LED_REG_STRIDE),
+                                       &frameRegs[first * LED_REG_STRIDE],
+                                       (uint8_t)((last - first + 1) * LED_REG_STRIDE));
+  PROFILE_END(PROF_COMMIT);
+  if (status != i2c_OK) return PCA_9685_UNRESPONSIVE;
+
+  frameDirty = 0;
+  return PCA_9685_OK;
+}
+
+void PCA9685_SetPhaseStagger(uint16_t staggerUs)
+/*!\brief   Spread the start of the servo pulses over the PWM period
+   \details Channel n starts its pulse n * staggerUs after channel 0 (modulo
+            the period) instead of every servo starting on the same count, so
+            servos given a new position in the same frame start driving their
+            motors staggerUs apart. Pulse widths are unchanged. Takes effect
+            for each channel the next time it is written; set it before the
+            first servo command to avoid one odd pulse on the change.
+   \param staggerUs[in]: delay between neighbouring channels, 0 for none
+   \return none
+*/
+{
+  uint32_t periodUs = PCA9685_GetPeriodUs();
+
+  for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++){
+    uint32_t offsetUs = ((uint32_t)ch * staggerUs) % periodUs;
+    channelPhase[ch] = (uint16_t)((offsetUs * 4096u) / periodUs);
+  }
+}
+
+uint32_t PCA9685_GetPeriodUs(void)
+/*!\brief   PWM period the PCA9685 is actually running at
+   \details Derived from the prescale that was written, which is what the
+            outputs follow (the requested frequency is rounded down to it)
+   \return period in microseconds, nominal PERIOD if the frequency was never set
+*/
+{
+  if (activePrescale == 0) return (uint32_t)(PERIOD * 1000000.0);
+  return (4096u * ((uint32_t)activePrescale + 1u)) / (CLKRATE / 1000000u);
+}
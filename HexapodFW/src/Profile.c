@@ -0,0 +1,131 @@
+/*! \file  Profile.c
+*
+* \brief
+* Cycle counts of the hot paths from the DWT cycle counter
+*
+* \details
+*  PROFILE_BEGIN/PROFILE_END (Profile.h) read CYCCNT around a region and hand
+*  the difference to Profile_Record, which keeps count, min, max, total and
+*  a log2 histogram per region in RAM. Recording costs a few dozen cycles;
+*  regions only run from the main loop, so there is no locking.
+*
+*  A dump is requested with a DUMP_PROFILE packet (Telemetry.h) and goes out
+*  as one PROFILE_ADDRESS frame per region from Telemetry_Service.
+*
+*  Built with PROFILE_ENABLE 0 the macros expand to nothing and this file is
+*  empty.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Profile.h"
+
+#if PROFILE_ENABLE
+
+#if defined(__ICCARM__)
+ #include <intrinsics.h>
+ #define PROF_CLZ(x)  __CLZ(x)
+#else
+ #define PROF_CLZ(x)  __builtin_clz(x)
+#endif
+
+static profStats_t regions[PROF_NUM_REGIONS];
+
+static void put32( uint8_t * p, uint32_t value )
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  p[2] = (uint8_t)(value >> 16);
+  p[3] = (uint8_t)(value >> 24);
+}
+
+void Profile_Init( void )
+/*!\brief   Start the DWT cycle counter and clear the statistics
+\return none
+*/
+{
+  DEMCR |= DEMCR_TRCENA;      //DWT is off until trace is enabled
+  DWT_CYCCNT = 0;
+  DWT_CTRL |= DWT_CYCCNTENA;
+  Profile_Reset();
+}
+
+void Profile_Reset( void )
+/*!\brief   Clear the statistics of every region
+\return none
+*/
+{
+  for (uint8_t r = 0; r < PROF_NUM_REGIONS; r++) {
+    regions[r] = (profStats_t){0};
+    regions[r].min = 0xFFFFFFFF;
+  }
+}
+
+void Profile_Record( profRegion_t region, uint32_t cycles )
+/*!\brief   Add one run of a region, called by PROFILE_END
+\param region[in]: which region ran
+       cycles[in]: how long it took
+\return none
+*/
+{
+  profStats_t * s = &regions[region];
+  int32_t bucket = (31 - (int32_t)PROF_CLZ(cycles | 1u)) - PROFILE_MIN_SHIFT;
+
+  if (bucket < 0) bucket = 0;
+  if (bucket >= PROFILE_BUCKETS) bucket = PROFILE_BUCKETS - 1;
+
+  s->count++;
+  s->total += cycles;
+  if (cycles < s->min) s->min = cycles;
+  if (cycles > s->max) s->max = cycles;
+  s->hist[bucket]++;
+}
+
+void Profile_Get( profRegion_t region, profStats_t * stats )
+/*!\brief   Copy out the statistics of one region
+\param stats[out]: count, min, max, total and histogram, min is 0xFFFFFFFF
+                   while count is 0
+\return none
+*/
+{
+  *stats = regions[region];
+}
+
+uint8_t Profile_BuildFrame( uint8_t region, uint8_t * frame )
+/*!\brief   Fill one dump frame
+\param region[in]: profRegion_t to report
+       frame[out]: at least PROFILE_FRAME bytes
+\return frame length in bytes, 0 for an unknown region
+*/
+{
+  const profStats_t * s = &regions[region];
+  uint8_t * p = &frame[4];
+  uint8_t checksum = 0;
+
+  if (region >= PROF_NUM_REGIONS) return 0;
+
+  frame[0] = 0x55;
+  frame[1] = 0xAA;
+  frame[2] = PROFILE_ADDRESS;
+  frame[3] = PROFILE_PAYLOAD;
+
+  p[PF_REGION] = region;
+  put32(&p[PF_COUNT], s->count);
+  put32(&p[PF_MIN], s->count ? s->min : 0);
+  put32(&p[PF_MAX], s->max);
+  put32(&p[PF_MEAN], s->count ? (uint32_t)(s->total / s->count) : 0);
+  for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+    uint32_t n = (s->hist[b] > 0xFFFF) ? 0xFFFF : s->hist[b];
+    p[PF_HIST + (2 * b)] = (uint8_t)n;
+    p[PF_HIST + (2 * b) + 1] = (uint8_t)(n >> 8);
+  }
+
+  for (uint8_t i = 0; i < (PROFILE_FRAME - 1); i++) {
+    checksum += frame[i];
+  }
+  frame[PROFILE_FRAME - 1] = checksum;
+  return PROFILE_FRAME;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#if !defined(PROFILE_H)
+#define PROFILE_H
+
+#include <stdint.h>
+#include "HWReg.h"
+
+#if !defined(PROFILE_ENABLE)
+#define PROFILE_ENABLE 0      //1: time the hot paths with the DWT cycle counter
+#endif
+
+ // Cortex-M4 debug registers, ARMv7-M ARM C1.8
+#define DEMCR          HWREG(0xE000EDFC)
+#define DEMCR_TRCENA   (0x01 << 24)
+#define DWT_CTRL       HWREG(0xE0001000)
+#define DWT_CYCCNTENA  (0x01)
+#define DWT_CYCCNT     HWREG(0xE0001004)
+
+ // Histogram bucket b counts regions that took 2^(b+4) to 2^(b+5)-1 cycles,
+ // bucket 0 everything shorter, the last bucket everything longer
+ // (2^19 cycles = 33ms at 16MHz)
+#define PROFILE_BUCKETS     (16)
+#define PROFILE_MIN_SHIFT   (4)
+
+ // Dump frames use the GoBLE framing: 0x55 0xAA address length payload checksum.
+ // One frame per region, multi-byte fields little endian, the histogram
+ // counts saturate at 0xFFFF
+#define PROFILE_ADDRESS     (0x21)
+#define PF_REGION     0    //u8  profRegion_t
+#define PF_COUNT      1    //u32 times the region ran
+#define PF_MIN        5    //u32 cycles
+#define PF_MAX        9    //u32 cycles
+#define PF_MEAN       13   //u32 cycles
+#define PF_HIST       17   //u16 x PROFILE_BUCKETS
+#define PROFILE_PAYLOAD     (PF_HIST + (2 * PROFILE_BUCKETS))
+#define PROFILE_FRAME       (PROFILE_PAYLOAD + 5)
+
+typedef enum profRegion
+{
+  PROF_LOOP,            //!<Main loop body
+  PROF_GAIT_HANDLER,    //!<GaitHandler
+  PROF_PACKET,          //!<Link parsing in checkBlueTooth (BlueTooth_PacketHandler)
+  PROF_SET_SERVO,       //!<PCA9685_setServo
+  PROF_COMMIT,          //!<PCA9685_CommitServos
+  PROF_I2C_WRITE_BYTE,  //!<I2C_WriteByte
+  PROF_I2C_WRITE_BYTES, //!<I2C_WriteBytes
+  PROF_I2C_READ,        //!<I2C_Read
+  PROF_I2C_WRITE_BURST, //!<I2C_WriteBurst
+  PROF_NUM_REGIONS
+} profRegion_t;
+
+typedef struct profStats
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t hist[PROFILE_BUCKETS];
+} profStats_t;
+
+ // PROFILE_BEGIN and PROFILE_END bracket a region inside one function; an
+ // early return needs its own PROFILE_END. Nested regions include the few
+ // cycles the inner ones spend recording. Without PROFILE_ENABLE both expand
+ // to nothing.
+#if PROFILE_ENABLE
+ #define PROFILE_BEGIN(region)  uint32_t profStart_##region = DWT_CYCCNT
+ #define PROFILE_END(region)    Profile_Record((region), DWT_CYCCNT - profStart_##region)
+#else
+ #define PROFILE_BEGIN(region)
+ #define PROFILE_END(region)
+#endif
+
+void Profile_Init( void );
+void Profile_Reset( void );
+void Profile_Record( profRegion_t region, uint32_t cycles );
+void Profile_Get( profRegion_t region, profStats_t * stats );
+uint8_t Profile_BuildFrame( uint8_t region, uint8_t * frame );
+
+#endif
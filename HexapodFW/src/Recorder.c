@@ -0,0 +1,161 @@
+/*! \file  Recorder.c
+*
+* \brief
+* Flight recorder: circular event log in RAM for post-mortem of bad runs
+*
+* \details
+*  Commands, runGaitFSM transitions, I2C and packet errors, control loop
+*  overruns and link timeouts are logged with RECORD (Recorder.h) as 8 byte
+*  entries into a RECORDER_ENTRIES ring; the oldest entries are overwritten.
+*  Logging is an index mask and four stores. Everything logs from the main
+*  loop, so there is no locking; do not RECORD from an ISR.
+*
+*  The log lives in a __no_init section, so a warm reset (watchdog, fault,
+*  debugger reset) keeps it. Recorder_Init checks the magic word: after a
+*  power on it starts a new log, otherwise it appends a REC_BOOT entry with
+*  the reset cause and carries on.
+*
+*  A dump is requested with a DUMP_RECORDER packet (Telemetry.h) and goes out
+*  as RECORDER_ADDRESS frames from Telemetry_Service, oldest entry first.
+*  The command entries can be played back in the host simulator
+*  (hexsim -f dump.bin).
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Recorder.h"
+
+#if RECORDER_ENABLE
+
+#include <tm4c123gh6pm.h>
+#include "HWReg.h"
+#include "Timer.h"
+
+typedef struct recLog
+{
+  uint32_t magic;
+  uint32_t next;         //seq of the next entry to write
+  uint16_t boots;
+  recEntry_t entries[RECORDER_ENTRIES];
+} recLog_t;
+
+static HW_NO_INIT recLog_t recLog;
+
+static void put32( uint8_t * p, uint32_t value )
+{
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  p[2] = (uint8_t)(value >> 16);
+  p[3] = (uint8_t)(value >> 24);
+}
+
+void Recorder_Init( void )
+/*!\brief   Keep the log of the last run if RAM survived, log the reset
+\details Call once at boot, after Timer_setUp. Reads and clears SYSCTL_RESC.
+\return none
+*/
+{
+  uint32_t cause = SYSCTL_RESC_R;
+
+  SYSCTL_RESC_R = 0;          //the next reset reports only its own cause
+  if (recLog.magic != RECORDER_MAGIC) Recorder_Clear();
+  recLog.boots++;
+  RECORD(REC_BOOT, cause, recLog.boots);
+}
+
+void Recorder_Clear( void )
+/*!\brief   Start a new, empty log
+\return none
+*/
+{
+  recLog.magic = RECORDER_MAGIC;
+  recLog.next = 0;
+  recLog.boots = 0;
+}
+
+void Recorder_Log( recEvent_t event, uint8_t arg, uint16_t data )
+/*!\brief   Append one entry, overwriting the oldest when the ring is full
+\details Main loop only, called through RECORD
+\param event[in]: recEvent_t
+       arg, data[in]: meaning depends on the event, see recEvent_t
+\return none
+*/
+{
+  recEntry_t * e = &recLog.entries[recLog.next & (RECORDER_ENTRIES - 1)];
+
+  e->timeMs = Timer_millis();
+  e->event = (uint8_t)event;
+  e->arg = arg;
+  e->data = data;
+  recLog.next++;
+}
+
+uint32_t Recorder_Count( void )
+/*!\brief   Entries logged since the log was started
+\return seq of the next entry, the newest one in the log is this minus 1
+*/
+{
+  return recLog.next;
+}
+
+uint8_t Recorder_Get( uint32_t seq, recEntry_t * entry )
+/*!\brief   Copy out one entry
+\param seq[in]: entry number, see Recorder_Count
+       entry[out]: the entry
+\return 1 if the entry is still in the log, 0 if overwritten or not logged yet
+*/
+{
+  if ((seq >= recLog.next) || ((recLog.next - seq) > RECORDER_ENTRIES)) return 0;
+  *entry = recLog.entries[seq & (RECORDER_ENTRIES - 1)];
+  return 1;
+}
+
+uint8_t Recorder_BuildFrame( uint32_t * seq, uint32_t end, uint8_t * frame )
+/*!\brief   Fill one dump frame with the entries from seq on
+\details Entries overwritten since the dump started are skipped, the frame's
+         RF_SEQ shows the gap.
+\param seq[in,out]: first entry to send, advanced past the ones sent
+       end[in]: seq to stop at (Recorder_Count when the dump was requested)
+       frame[out]: at least RECORDER_FRAME bytes
+\return frame length in bytes, 0 when there is nothing left before end
+*/
+{
+  uint8_t * p = &frame[4];
+  uint8_t checksum = 0;
+  uint8_t count = 0;
+
+  if ((recLog.next - *seq) > RECORDER_ENTRIES) *seq = recLog.next - RECORDER_ENTRIES;
+  if (*seq >= end) return 0;
+
+  frame[0] = 0x55;
+  frame[1] = 0xAA;
+  frame[2] = RECORDER_ADDRESS;
+  frame[3] = RECORDER_PAYLOAD;
+
+  put32(&p[RF_SEQ], *seq);
+  for (uint8_t i = 0; i < RECORDER_PER_FRAME; i++) {
+    uint8_t * q = &p[RF_ENTRIES + (i * RECORDER_ENTRY_SIZE)];
+    recEntry_t e = {0};
+
+    //unused slots in the last frame go out as zeros
+    if ((*seq < end) && Recorder_Get(*seq, &e)) {
+      (*seq)++;
+      count++;
+    }
+    put32(q, e.timeMs);
+    q[4] = e.event;
+    q[5] = e.arg;
+    q[6] = (uint8_t)e.data;
+    q[7] = (uint8_t)(e.data >> 8);
+  }
+  p[RF_COUNT] = count;
+
+  for (uint8_t i = 0; i < (RECORDER_FRAME - 1); i++) {
+    checksum += frame[i];
+  }
+  frame[RECORDER_FRAME - 1] = checksum;
+  return RECORDER_FRAME;
+}
+
+#endif
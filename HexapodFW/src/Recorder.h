@@ -0,0 +1,58 @@
+#if !defined(RECORDER_H)
+#define RECORDER_H
+
+#include <stdint.h>
+
+#if !defined(RECORDER_ENABLE)
+#define RECORDER_ENABLE 1     //1: keep the flight recorder event log
+#endif
+
+#define RECORDER_ENTRIES    (256)     //power of two, 8 bytes each
+#define RECORDER_MAGIC      (0x48584652u)   //"HXFR", log in RAM is valid
+
+typedef enum recEvent {
+  REC_BOOT = 1,         //!<arg: SYSCTL_RESC reset cause (low byte), data: boots seen by this log
+  REC_COMMAND,          //!<arg: new gaitCommand_t, data: joystick x | y << 8
+  REC_FSM,              //!<arg: new runGaitFSM position (phase_t), data: command it acted on
+  REC_I2C_ERROR,        //!<arg: i2c_status_t, data: errors so far
+  REC_PACKET_ERROR,     //!<arg: packetState_t the frame failed in, data: byte | port << 8
+  REC_OVERRUN,          //!<arg: 0, data: control ticks missed
+  REC_LINK_TIMEOUT,     //!<arg: 0, data: ms since the last valid packet
+  REC_BATTERY           //!<arg: new batteryLevel_t, data: filtered pack mV
+} recEvent_t;
+
+typedef struct recEntry
+{
+  uint32_t timeMs;      //!<Timer_millis when logged
+  uint8_t  event;       //!<recEvent_t
+  uint8_t  arg;
+  uint16_t data;
+} recEntry_t;
+
+ // Dump frames use the GoBLE framing: 0x55 0xAA address length payload checksum.
+ // Up to RECORDER_PER_FRAME entries per frame, oldest first, multi-byte
+ // fields little endian. seq numbers every entry ever logged, a jump between
+ // frames means entries were overwritten while the dump was going out.
+#define RECORDER_ADDRESS    (0x22)
+#define RECORDER_PER_FRAME  (6)
+#define RF_SEQ        0    //u32 seq of the first entry in this frame
+#define RF_COUNT      4    //u8  entries in this frame
+#define RF_ENTRIES    5    //u32 timeMs, u8 event, u8 arg, u16 data per entry
+#define RECORDER_ENTRY_SIZE (8)
+#define RECORDER_PAYLOAD    (RF_ENTRIES + (RECORDER_PER_FRAME * RECORDER_ENTRY_SIZE))
+#define RECORDER_FRAME      (RECORDER_PAYLOAD + 5)
+
+#if RECORDER_ENABLE
+ #define RECORD(event, arg, data)   Recorder_Log((event), (uint8_t)(arg), (uint16_t)(data))
+#else
+ #define RECORD(event, arg, data)
+#endif
+
+void Recorder_Init( void );
+void Recorder_Clear( void );
+void Recorder_Log( recEvent_t event, uint8_t arg, uint16_t data );
+uint32_t Recorder_Count( void );
+uint8_t Recorder_Get( uint32_t seq, recEntry_t * entry );
+uint8_t Recorder_BuildFrame( uint32_t * seq, uint32_t end, uint8_t * frame );
+
+#endif
@@ -0,0 +1,485 @@
+/*! \file  Script.c
+*
+* \brief
+* Motion scripts stored in flash and played back by the control loop
+*
+* \details
+*  Choreographies are a small bytecode (see Script.h) uploaded over the
+*  command link instead of being compiled in. An upload is staged in RAM,
+*  checked against its CRC, walked once to make sure every opcode, operand
+*  and loop is well formed, and only then written to its 1KB flash slot.
+*  The slot header is programmed last, so a reset in the middle of a write
+*  leaves an erased (invalid) slot rather than a half written script.
+*
+*  Script_Init checks every slot again at boot and keeps the trigger button
+*  mask of each valid one. Playback is non-blocking: Script_Update runs at
+*  most SCRIPT_OPS_PER_TICK instructions per call and returns as soon as a
+*  wait or a ramp is in progress, so a control tick never costs more than a
+*  few setLegs calls.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "Script.h"
+#include "Gaits.h"
+#include "Timer.h"
+
+#define SCRIPT_MAGIC  (0x5343)   //"SC"
+
+typedef struct scriptHeader
+{
+  uint16_t magic;
+  uint16_t length;     //bytecode bytes following the header
+  uint16_t crc;        //CRC-16/CCITT of the bytecode
+  uint8_t  trigger;    //GoBLE button mask that starts the script
+  uint8_t  reserved;
+} scriptHeader_t;
+
+typedef struct scriptLoop
+{
+  uint16_t start;      //first instruction of the loop body
+  uint8_t  remaining;
+} scriptLoop_t;
+
+//slot index built at boot and after every upload
+static uint8_t slotValid[SCRIPT_SLOTS];
+static uint8_t slotTrigger[SCRIPT_SLOTS];
+
+//upload staging, word aligned for Flash_Write, header first
+static uint32_t staging[FLASH_BLOCK_SIZE / 4];
+static uint8_t  uploadSlot = 0;
+static uint8_t  uploadOpen = 0;
+static uint16_t uploadReceived = 0;
+static scriptResult_t lastResult = SCRIPT_OK;
+
+//interpreter
+static const uint8_t * code = 0;
+static uint16_t pc = 0;
+static uint8_t  selected = 0;
+static uint8_t  running = 0;
+static uint32_t waitUntil = 0;
+static scriptLoop_t loops[SCRIPT_LOOP_DEPTH];
+static uint8_t  loopDepth = 0;
+static int16_t  legHip[NUM_LEGS];     //pose of every leg as setLegs sees it
+static int16_t  legKnee[NUM_LEGS];
+static int16_t  moveFromHip[NUM_LEGS];
+static int16_t  moveFromKnee[NUM_LEGS];
+static uint8_t  moveMask = 0;
+static int16_t  moveHip = NOMOVE;
+static int16_t  moveKnee = NOMOVE;
+static uint32_t moveStart = 0;
+static uint16_t moveMs = 0;
+
+static uint32_t slotAddress( uint8_t slot )
+{
+  return SCRIPT_FLASH_BASE + ((uint32_t)slot * FLASH_BLOCK_SIZE);
+}
+
+static const scriptHeader_t * slotHeader( uint8_t slot )
+{
+  return (const scriptHeader_t *)HWMEM(slotAddress(slot));
+}
+
+static uint16_t read16( const uint8_t * p )
+{
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint16_t crc16( const uint8_t * data, uint16_t length )
+{
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint8_t angleOk( uint8_t angle )
+{
+  return (angle <= 180) || (angle == SCRIPT_KEEP);
+}
+
+static uint8_t validate( const uint8_t * p, uint16_t length )
+/*!\brief   Walk the bytecode once without running it
+\details Every opcode must be known, its operands in range and inside the
+         script, loops balanced and no deeper than SCRIPT_LOOP_DEPTH, and the
+         last byte must be the only OP_END.
+\return 1 if the script is safe to interpret
+*/
+{
+  uint16_t i = 0;
+  uint8_t depth = 0;
+
+  while (i < length) {
+    uint8_t op = p[i];
+    uint16_t remaining = length - i - 1;
+
+    switch (op) {
+      case SCRIPT_OP_END:
+        return (depth == 0) && (remaining == 0);
+      case SCRIPT_OP_LEGS:
+        if ((remaining < 3) || (p[i + 1] > ALL_LEGS) || !angleOk(p[i + 2]) || !angleOk(p[i + 3])) return 0;
+        i += 4;
+        break;
+      case SCRIPT_OP_JOINT:
+        if ((remaining < 2) || (p[i + 1] >= (2 * NUM_LEGS)) || (p[i + 2] > 180)) return 0;
+        i += 3;
+        break;
+      case SCRIPT_OP_WAIT:
+        if (remaining < 2) return 0;
+        i += 3;
+        break;
+      case SCRIPT_OP_MOVE:
+        if ((remaining < 5) || (p[i + 1] > ALL_LEGS) || !angleOk(p[i + 2]) || !angleOk(p[i + 3])) return 0;
+        i += 6;
+        break;
+      case SCRIPT_OP_LOOP:
+        if ((remaining < 1) || (p[i + 1] == 0) || (depth >= SCRIPT_LOOP_DEPTH)) return 0;
+        depth++;
+        i += 2;
+        break;
+      case SCRIPT_OP_NEXT:
+        if (depth == 0) return 0;
+        depth--;
+        i += 1;
+        break;
+      default:
+        return 0;
+    }
+  }
+  return 0;   //ran off the end without OP_END
+}
+
+static uint8_t slotOk( uint8_t slot )
+{
+  const scriptHeader_t * h = slotHeader(slot);
+  const uint8_t * p = (const uint8_t *)h + SCRIPT_HEADER_LEN;
+
+  if ((h->magic != SCRIPT_MAGIC) || (h->length == 0) || (h->length > SCRIPT_MAX_LEN)) return 0;
+  if (crc16(p, h->length) != h->crc) return 0;
+  return validate(p, h->length);
+}
+
+static void indexSlot( uint8_t slot )
+{
+  slotValid[slot] = slotOk(slot);
+  slotTrigger[slot] = slotValid[slot] ? slotHeader(slot)->trigger : 0;
+}
+
+void Script_Init( void )
+/*!\brief   Find the valid scripts in flash
+\return none
+*/
+{
+  for (uint8_t s = 0; s < SCRIPT_SLOTS; s++) {
+    indexSlot(s);
+  }
+  running = 0;
+  uploadOpen = 0;
+}
+
+static scriptResult_t commit( uint16_t crc )
+{
+  scriptHeader_t * h = (scriptHeader_t *)staging;
+  uint8_t * bytes = (uint8_t *)staging;
+  uint32_t base = slotAddress(uploadSlot);
+
+  if (uploadReceived != h->length) return SCRIPT_BAD_SEQUENCE;
+  if (crc16(&bytes[SCRIPT_HEADER_LEN], h->length) != crc) return SCRIPT_BAD_CRC;
+  if (!validate(&bytes[SCRIPT_HEADER_LEN], h->length)) return SCRIPT_BAD_CODE;
+
+  h->magic = SCRIPT_MAGIC;
+  h->crc = crc;
+  for (uint16_t i = SCRIPT_HEADER_LEN + h->length; i < FLASH_BLOCK_SIZE; i++) {
+    bytes[i] = 0xFF;
+  }
+
+  //body first, header last: an interrupted write never looks valid
+  if (Flash_Erase(base) != FLASH_STATUS_OK) return SCRIPT_FLASH_ERROR;
+  if (Flash_Write(base + SCRIPT_HEADER_LEN, &staging[SCRIPT_HEADER_LEN / 4],
+                  (h->length + 3) / 4) != FLASH_STATUS_OK) return SCRIPT_FLASH_ERROR;
+  if (Flash_Write(base, staging, SCRIPT_HEADER_LEN / 4) != FLASH_STATUS_OK) return SCRIPT_FLASH_ERROR;
+  return SCRIPT_OK;
+}
+
+void Script_Push( const uint8_t * payload, uint8_t length )
+/*!\brief   Handle one upload packet from the command link
+\details Flash is only touched by COMMIT and ERASE. Both stall the CPU for
+         the erase, so the control loop will count an overrun or two. A
+         script that is playing from the slot being written is stopped.
+\param payload[in]: packet payload, see Script.h
+       length[in]: payload length
+\return none, the outcome is kept for Script_LastResult
+*/
+{
+  uint8_t cmd = payload[0];
+  uint8_t slot = payload[1];
+  scriptHeader_t * h = (scriptHeader_t *)staging;
+  uint8_t * bytes = (uint8_t *)staging;
+
+  if ((length < SCRIPT_MIN_PAYLOAD) || (slot >= SCRIPT_SLOTS)) {
+    lastResult = SCRIPT_BAD_COMMAND;
+    return;
+  }
+
+  switch (cmd) {
+    case SCRIPT_CMD_BEGIN:
+      if ((length < 5) || (payload[2] == 0) || (read16(&payload[3]) == 0) ||
+          (read16(&payload[3]) > SCRIPT_MAX_LEN)) {
+        lastResult = SCRIPT_BAD_COMMAND;
+        break;
+      }
+      h->trigger = payload[2];
+      h->reserved = 0xFF;
+      h->length = read16(&payload[3]);
+      uploadSlot = slot;
+      uploadReceived = 0;
+      uploadOpen = 1;
+      lastResult = SCRIPT_OK;
+      break;
+
+    case SCRIPT_CMD_DATA:
+      if (!uploadOpen || (slot != uploadSlot) || (length < 4) ||
+          (read16(&payload[2]) != uploadReceived) ||
+          ((uploadReceived + (length - 4)) > h->length)) {
+        uploadOpen = 0;   //a lost chunk means starting over
+        lastResult = SCRIPT_BAD_SEQUENCE;
+        break;
+      }
+      for (uint8_t i = 4; i < length; i++) {
+        bytes[SCRIPT_HEADER_LEN + uploadReceived++] = payload[i];
+      }
+      lastResult = SCRIPT_OK;
+      break;
+
+    case SCRIPT_CMD_COMMIT:
+      if (!uploadOpen || (slot != uploadSlot) || (length < 4)) {
+        lastResult = SCRIPT_BAD_SEQUENCE;
+        break;
+      }
+      if (running && (selected == slot)) Script_Stop();
+      lastResult = commit(read16(&payload[2]));
+      uploadOpen = 0;
+      indexSlot(slot);
+      break;
+
+    case SCRIPT_CMD_ERASE:
+      if (running && (selected == slot)) Script_Stop();
+      lastResult = (Flash_Erase(slotAddress(slot)) == FLASH_STATUS_OK) ? SCRIPT_OK : SCRIPT_FLASH_ERROR;
+      indexSlot(slot);
+      break;
+
+    default:
+      lastResult = SCRIPT_BAD_COMMAND;
+      break;
+  }
+}
+
+scriptResult_t Script_LastResult( void )
+/*!\brief   Outcome of the most recent upload packet
+\return scriptResult_t
+*/
+{
+  return lastResult;
+}
+
+uint8_t Script_Select( uint8_t buttons )
+/*!\brief   Pick the script bound to a button combination
+\details The lowest valid slot with a matching trigger wins. Triggers take
+         priority over the built-in button commands.
+\param buttons[in]: button mask as built by parsePacket
+\return 1 if a script was selected
+*/
+{
+  if (buttons == 0) return 0;
+  for (uint8_t s = 0; s < SCRIPT_SLOTS; s++) {
+    if (slotValid[s] && (slotTrigger[s] == buttons)) {
+      if (!running) selected = s;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+uint8_t Script_Selected( void )
+/*!\brief   Slot chosen by the last successful Script_Select
+\return slot number
+*/
+{
+  return selected;
+}
+
+uint8_t Script_Start( uint8_t slot, uint32_t nowMs )
+/*!\brief   Start playing a stored script
+\details Assumes the bot is standing, the pose tracked for OP_MOVE starts
+         from the stand pose
+\param slot[in]: script slot
+       nowMs[in]: current time in milliseconds
+\return 1 if the slot holds a valid script
+*/
+{
+  if ((slot >= SCRIPT_SLOTS) || !slotValid[slot]) return 0;
+
+  code = (const uint8_t *)slotHeader(slot) + SCRIPT_HEADER_LEN;
+  pc = 0;
+  loopDepth = 0;
+  moveMask = 0;
+  waitUntil = nowMs;
+  selected = slot;
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    legHip[i] = HIP_NEUTRAL;
+    legKnee[i] = KNEE_STAND;
+  }
+  running = 1;
+  return 1;
+}
+
+static void poseLegs( uint8_t mask, int16_t hip, int16_t knee )
+{
+  setLegs(mask, hip, knee, 0, 0, 0);
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    if (mask & (1 << i)) {
+      if (hip != NOMOVE) legHip[i] = hip;
+      if (knee != NOMOVE) legKnee[i] = knee;
+    }
+  }
+}
+
+static int16_t toAngle( uint8_t operand )
+{
+  return (operand == SCRIPT_KEEP) ? NOMOVE : operand;
+}
+
+static uint8_t stepMove( uint32_t nowMs )
+/*!\brief   Write the next point of an OP_MOVE ramp
+\return 1 once the ramp has reached its end pose
+*/
+{
+  uint32_t t = nowMs - moveStart;
+
+  if (t >= moveMs) {
+    poseLegs(moveMask, moveHip, moveKnee);
+    moveMask = 0;
+    return 1;
+  }
+
+  for (uint8_t i = 0; i < NUM_LEGS; i++) {
+    if (moveMask & (1 << i)) {
+      int16_t hip = NOMOVE;
+      int16_t knee = NOMOVE;
+      if (moveHip != NOMOVE) hip = moveFromHip[i] + (int16_t)(((int32_t)(moveHip - moveFromHip[i]) * (int32_t)t) / moveMs);
+      if (moveKnee != NOMOVE) knee = moveFromKnee[i] + (int16_t)(((int32_t)(moveKnee - moveFromKnee[i]) * (int32_t)t) / moveMs);
+      setLegs(1 << i, hip, knee, 0, 0, 0);
+    }
+  }
+  return 0;
+}
+
+uint8_t Script_Update( uint32_t nowMs )
+/*!\brief   Advance the running script
+\details Call once per control tick. Runs instructions until one has to wait
+         (OP_WAIT, OP_MOVE) or SCRIPT_OPS_PER_TICK have been executed.
+\param nowMs[in]: current time in milliseconds
+\return 1 while the script is running, 0 once it has finished or was stopped
+*/
+{
+  if (!running) return 0;
+
+  if (moveMask) {
+    if (!stepMove(nowMs)) return 1;
+  }
+  if ((int32_t)(nowMs - waitUntil) < 0) return 1;
+
+  for (uint8_t ops = 0; ops < SCRIPT_OPS_PER_TICK; ops++) {
+    const uint8_t * p = &code[pc];
+
+    switch (p[0]) {
+      case SCRIPT_OP_LEGS:
+        poseLegs(p[1], toAngle(p[2]), toAngle(p[3]));
+        pc += 4;
+        break;
+
+      case SCRIPT_OP_JOINT:
+        if (p[1] < NUM_LEGS) {
+          setHipRaw(p[1], p[2]);
+          legHip[p[1]] = (p[1] >= LEFT_START) ? (180 - p[2]) : p[2];
+        } else {
+          setKnee(p[1] - NUM_LEGS, p[2]);
+          legKnee[p[1] - NUM_LEGS] = p[2];
+        }
+        pc += 3;
+        break;
+
+      case SCRIPT_OP_WAIT:
+        waitUntil = nowMs + read16(&p[1]);
+        pc += 3;
+        return 1;
+
+      case SCRIPT_OP_MOVE:
+        moveMask = p[1];
+        moveHip = toAngle(p[2]);
+        moveKnee = toAngle(p[3]);
+        moveMs = read16(&p[4]);
+        moveStart = nowMs;
+        for (uint8_t i = 0; i < NUM_LEGS; i++) {
+          moveFromHip[i] = legHip[i];
+          moveFromKnee[i] = legKnee[i];
+        }
+        pc += 6;
+        if (moveMs == 0) {
+          stepMove(nowMs);
+          break;
+        }
+        return 1;
+
+      case SCRIPT_OP_LOOP:
+        loops[loopDepth].start = pc + 2;
+        loops[loopDepth].remaining = p[1];
+        loopDepth++;
+        pc += 2;
+        break;
+
+      case SCRIPT_OP_NEXT:
+        if (--loops[loopDepth - 1].remaining > 0) {
+          pc = loops[loopDepth - 1].start;
+        } else {
+          loopDepth--;
+          pc += 1;
+        }
+        break;
+
+      default:   //OP_END, validate() guarantees nothing else gets here
+        running = 0;
+        return 0;
+    }
+  }
+  return 1;
+}
+
+void Script_Stop( void )
+/*!\brief   Abandon the running script, the joints stay where they are
+\return none
+*/
+{
+  running = 0;
+  moveMask = 0;
+}
+
+uint8_t Script_Play( uint8_t slot )
+/*!\brief   Play a script to the end before returning
+\details Blocking counterpart of Script_Start/Script_Update for the places
+         that already block, like demo()
+\param slot[in]: script slot
+\return 1 if the slot held a valid script and it was played
+*/
+{
+  if (!Script_Start(slot, Timer_millis())) return 0;
+  while (Script_Update(Timer_millis())) {
+    delay(SCRIPT_PLAY_STEP_MS);
+  }
+  return 1;
+}
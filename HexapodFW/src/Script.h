@@ -0,0 +1,69 @@
+#if !defined(SCRIPT_H)
+#define SCRIPT_H
+
+#include <stdint.h>
+#include "Flash.h"
+
+ // Scripts are uploaded with the GoBLE framing (0x55 0xAA address length
+ // payload checksum) on their own address. Payload:
+ //   [0] SCRIPT_CMD_*  [1] slot
+ //   BEGIN:   [2] trigger button mask  [3..4] bytecode length, little endian
+ //   DATA:    [2..3] offset  [4..] bytecode, chunks must arrive in order
+ //   COMMIT:  [2..3] CRC-16/CCITT of the whole bytecode, then it is checked
+ //            and written to flash
+ //   ERASE:   nothing, the slot is cleared
+#define SCRIPT_ADDRESS      (0x13)
+#define SCRIPT_CMD_BEGIN    (1)
+#define SCRIPT_CMD_DATA     (2)
+#define SCRIPT_CMD_COMMIT   (3)
+#define SCRIPT_CMD_ERASE    (4)
+#define SCRIPT_MIN_PAYLOAD  (2)
+
+ // Bytecode, an opcode byte followed by its operands. Angles are degrees,
+ // SCRIPT_KEEP leaves that joint where it is. Times are little endian ms.
+ //   OP_END                           end of script
+ //   OP_LEGS  mask hip knee           setLegs, left hips mirrored as usual
+ //   OP_JOINT channel angle           one servo, 0-5 raw hips, 6-11 knees
+ //   OP_WAIT  ms ms                   hold the pose
+ //   OP_MOVE  mask hip knee ms ms     ramp the legs from their pose to hip/knee
+ //   OP_LOOP  count                   run up to the matching OP_NEXT count times
+ //   OP_NEXT
+#define SCRIPT_OP_END       (0x00)
+#define SCRIPT_OP_LEGS      (0x01)
+#define SCRIPT_OP_JOINT     (0x02)
+#define SCRIPT_OP_WAIT      (0x03)
+#define SCRIPT_OP_MOVE      (0x04)
+#define SCRIPT_OP_LOOP      (0x05)
+#define SCRIPT_OP_NEXT      (0x06)
+#define SCRIPT_KEEP         (0xFF)
+
+#define SCRIPT_SLOTS        (4)
+#define SCRIPT_FLASH_BASE   (FLASH_SIZE - (SCRIPT_SLOTS * FLASH_BLOCK_SIZE))  //last 4KB, far above the image
+#define SCRIPT_HEADER_LEN   (8)
+#define SCRIPT_MAX_LEN      (FLASH_BLOCK_SIZE - SCRIPT_HEADER_LEN)
+#define SCRIPT_DEMO_SLOT    (0)    //replaces the compiled-in demo when stored
+#define SCRIPT_OPS_PER_TICK (8)    //bounds the interpreter's work per control tick
+#define SCRIPT_LOOP_DEPTH   (4)
+#define SCRIPT_PLAY_STEP_MS (20)   //update interval of the blocking Script_Play
+
+typedef enum scriptResult
+{
+  SCRIPT_OK,
+  SCRIPT_BAD_COMMAND,    //!<Unknown command, slot or trigger
+  SCRIPT_BAD_SEQUENCE,   //!<DATA or COMMIT without BEGIN, or a gap in the offsets
+  SCRIPT_BAD_CRC,
+  SCRIPT_BAD_CODE,       //!<Bytecode failed validation
+  SCRIPT_FLASH_ERROR
+} scriptResult_t;
+
+void Script_Init( void );
+void Script_Push( const uint8_t * payload, uint8_t length );
+scriptResult_t Script_LastResult( void );
+uint8_t Script_Select( uint8_t buttons );
+uint8_t Script_Selected( void );
+uint8_t Script_Start( uint8_t slot, uint32_t nowMs );
+uint8_t Script_Update( uint32_t nowMs );
+void Script_Stop( void );
+uint8_t Script_Play( uint8_t slot );
+
+#endif
@@ -0,0 +1,177 @@
+/*! \file  ServoModel.c
+*
+* \brief
+* Kinematic model of the hobby servos, predicts when joints reach their target
+*
+* \details
+*  Each servo is modelled as a constant speed slew (degrees per second)
+*  followed by a fixed settle time. Whenever a channel gets a new target the
+*  model works out where the servo probably is right now (it may still be on
+*  its way to the previous target), and from that the arrival time of the new
+*  move. The gait uses the latest arrival of the joints it just commanded to
+*  decide when the next phase may start, instead of a fixed wait per phase.
+*
+*  Speed and settle time are per channel so a weak or slow servo can be
+*  described without slowing the others down.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "ServoModel.h"
+
+typedef struct servoModel
+{
+  int16_t  start;       // estimated angle when the current move began
+  int16_t  target;      // last commanded angle
+  uint32_t moveStart;   // ms, when the current move began
+  uint32_t travelMs;    // slew time of the current move, settle not included
+  uint32_t arrival;     // ms, moveStart + travelMs + settle
+  uint16_t speedDps;
+  uint16_t settleMs;
+  uint8_t  known;       // 0 until the first command, position is a guess
+} servoModel_t;
+
+static servoModel_t servos[SERVO_COUNT];
+
+void ServoModel_Init( void )
+/*!\brief   Reset every channel to the default speed and an unknown position
+\return none
+*/
+{
+  for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+    servos[i] = (servoModel_t){0};
+    servos[i].speedDps = SERVO_DEFAULT_SPEED_DPS;
+    servos[i].settleMs = SERVO_DEFAULT_SETTLE_MS;
+  }
+}
+
+void ServoModel_SetSpeed( uint8_t channel, uint16_t speedDps )
+/*!\brief   Set the slew speed of one channel
+\param channel[in]: servo channel 0-11
+       speedDps[in]: degrees per second, 0 is ignored
+\return none
+*/
+{
+  if ((channel < SERVO_COUNT) && (speedDps != 0)) servos[channel].speedDps = speedDps;
+}
+
+void ServoModel_SetSettle( uint8_t channel, uint16_t settleMs )
+/*!\brief   Set the settle time of one channel
+\param channel[in]: servo channel 0-11
+       settleMs[in]: time added after the slew before the joint counts as arrived
+\return none
+*/
+{
+  if (channel < SERVO_COUNT) servos[channel].settleMs = settleMs;
+}
+
+int16_t ServoModel_Position( uint8_t channel, uint32_t nowMs )
+/*!\brief   Estimated angle of a servo
+\param channel[in]: servo channel 0-11
+       nowMs[in]: current time in milliseconds
+\return estimated angle in degrees, linear between start and target (the
+          start angle while a delayed move has not begun)
+*/
+{
+  if (channel >= SERVO_COUNT) return 0;
+
+  servoModel_t * s = &servos[channel];
+  int32_t elapsed = (int32_t)(nowMs - s->moveStart);
+
+  if (elapsed < 0) return s->start;
+  if ((s->travelMs == 0) || ((uint32_t)elapsed >= s->travelMs)) return s->target;
+  return s->start + (int16_t)(((int32_t)(s->target - s->start) * elapsed) / (int32_t)s->travelMs);
+}
+
+uint16_t ServoModel_Travel( uint8_t channel, int16_t target, uint32_t nowMs )
+/*!\brief   How far a servo would move if commanded now
+\param channel[in]: servo channel 0-11
+       target[in]: angle about to be commanded
+       nowMs[in]: current time in milliseconds
+\return degrees, 0 if that is already the target, SERVO_UNKNOWN_TRAVEL if
+          the position is unknown
+*/
+{
+  if (channel >= SERVO_COUNT) return 0;
+
+  servoModel_t * s = &servos[channel];
+  if (!s->known) return SERVO_UNKNOWN_TRAVEL;
+  if (target == s->target) return 0;
+
+  int16_t from = ServoModel_Position(channel, nowMs);
+  return (uint16_t)((target > from) ? (target - from) : (from - target));
+}
+
+int16_t ServoModel_Target( uint8_t channel )
+/*!\brief   Last angle commanded to a servo
+\param channel[in]: servo channel 0-11
+\return commanded angle in degrees
+*/
+{
+  if (channel >= SERVO_COUNT) return 0;
+  return servos[channel].target;
+}
+
+void ServoModel_Command( uint8_t channel, int16_t target, uint32_t nowMs )
+/*!\brief   Tell the model a servo has been given a new target
+\details Repeating the current target leaves the arrival time alone, so
+         rewriting an unchanged joint does not delay the gait. nowMs may lie
+         in the future for a move that is known to start late.
+\param channel[in]: servo channel 0-11
+       target[in]: commanded angle in degrees
+       nowMs[in]: time the command was issued
+\return none
+*/
+{
+  if (channel >= SERVO_COUNT) return;
+
+  servoModel_t * s = &servos[channel];
+  uint32_t travel;
+
+  if (s->known && (target == s->target)) return;
+
+  if (s->known) {
+    int16_t from = ServoModel_Position(channel, nowMs);
+    s->start = from;
+    travel = (uint32_t)((target > from) ? (target - from) : (from - target));
+  } else {
+    s->start = target;
+    travel = SERVO_UNKNOWN_TRAVEL;
+    s->known = 1;
+  }
+
+  s->target = target;
+  s->moveStart = nowMs;
+  s->travelMs = ((travel * 1000u) + s->speedDps - 1u) / s->speedDps;
+  s->arrival = nowMs + s->travelMs + s->settleMs;
+}
+
+uint32_t ServoModel_ArrivalTime( uint16_t channelMask )
+/*!\brief   Predicted time by which every selected servo has settled
+\param channelMask[in]: bit per servo channel, ALL_SERVOS for the whole bot
+\return latest arrival time in milliseconds
+*/
+{
+  uint32_t latest = 0;
+  uint8_t first = 1;
+
+  for (uint8_t i = 0; i < SERVO_COUNT; i++) {
+    if ((channelMask & (1u << i)) == 0) continue;
+    if (first || ((int32_t)(servos[i].arrival - latest) > 0)) {
+      latest = servos[i].arrival;
+      first = 0;
+    }
+  }
+  return latest;
+}
+
+uint8_t ServoModel_Arrived( uint16_t channelMask, uint32_t nowMs )
+/*!\brief   Check whether every selected servo should have settled by now
+\param channelMask[in]: bit per servo channel
+       nowMs[in]: current time in milliseconds
+\return 1 if all have arrived, 0 otherwise
+*/
+{
+  return ((int32_t)(nowMs - ServoModel_ArrivalTime(channelMask)) >= 0) ? 1 : 0;
+}
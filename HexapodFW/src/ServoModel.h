@@ -0,0 +1,22 @@
+#if !defined(SERVOMODEL_H)
+#define SERVOMODEL_H
+
+#include <stdint.h>
+
+#define SERVO_COUNT              (12)
+#define ALL_SERVOS               (0x0FFF)   // bit per servo channel, hips 0-5, knees 6-11
+#define SERVO_DEFAULT_SPEED_DPS  (400)      // no-load speed of the stock servos, derated for the load
+#define SERVO_DEFAULT_SETTLE_MS  (20)       // time to stop ringing once the target is reached
+#define SERVO_UNKNOWN_TRAVEL     (90)       // assumed travel when the start position is unknown
+
+void ServoModel_Init( void );
+void ServoModel_SetSpeed( uint8_t channel, uint16_t speedDps );
+void ServoModel_SetSettle( uint8_t channel, uint16_t settleMs );
+void ServoModel_Command( uint8_t channel, int16_t target, uint32_t nowMs );
+int16_t ServoModel_Position( uint8_t channel, uint32_t nowMs );
+int16_t ServoModel_Target( uint8_t channel );
+uint16_t ServoModel_Travel( uint8_t channel, int16_t target, uint32_t nowMs );
+uint32_t ServoModel_ArrivalTime( uint16_t channelMask );
+uint8_t ServoModel_Arrived( uint16_t channelMask, uint32_t nowMs );
+
+#endif
@@ -0,0 +1,266 @@
+/*! \file  ServoStream.c
+*
+* \brief
+* Joint frames streamed from a PC or phone side planner
+*
+* \details
+*  The host sends complete 12-joint frames (or deltas against the previous
+*  one) at its own rate, typically 50Hz. Each frame carries the host's
+*  timestamp. The offset between host and robot clocks is tracked as the
+*  smallest arrival delay seen, so a frame's play time is
+*    host timestamp + offset + STREAM_PLAYOUT_MS
+*  which absorbs link jitter up to the playout delay. On every control tick
+*  ServoStream_Update interpolates linearly between the two frames around
+*  the current time and writes only the joints that changed.
+*
+*  Late frames are still used, they just shorten the interpolation. When the
+*  queue runs dry the last frame is held and an underrun is counted.
+*
+* \author vsimontov
+*
+******************************************************************************/
+
+#include "ServoStream.h"
+#include "Gaits.h"
+
+#define OFFSET_LEAK 64   //frames between 1ms upward steps of the clock offset, follows host clock drift
+
+typedef struct streamFrame
+{
+  uint32_t playMs;
+  int16_t  joint[SERVO_COUNT];
+} streamFrame_t;
+
+static streamFrame_t queue[STREAM_QUEUE];
+static uint8_t  queueTail = 0;
+static uint8_t  queueCount = 0;
+
+static int16_t  lastJoint[SERVO_COUNT];   //last frame received, base for deltas
+static int16_t  output[SERVO_COUNT];      //last angle written per channel
+static uint8_t  lastSeq = 0;
+static uint8_t  synced = 0;               //lastJoint is valid for deltas
+static uint8_t  active = 0;               //a stream is in progress
+static uint8_t  starved = 0;
+static uint8_t  leak = 0;
+static uint8_t  haveOffset = 0;
+static uint32_t clockOffset = 0;
+static uint32_t lastArrivalMs = 0;
+static streamStats_t stats;
+
+static uint32_t read32( const uint8_t * p )
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void restart( void )
+{
+  queueTail = 0;
+  queueCount = 0;
+  synced = 0;
+  starved = 0;
+  leak = 0;
+  haveOffset = 0;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+    lastJoint[ch] = NOMOVE;
+    output[ch] = NOMOVE;
+  }
+}
+
+static void writeJoint( uint8_t channel, int16_t pos )
+{
+  if ((pos == NOMOVE) || (pos == output[channel])) return;
+  output[channel] = pos;
+  if (channel < NUM_LEGS) {
+    setHipRaw(channel, pos);
+  } else {
+    setKnee(channel - NUM_LEGS, pos);
+  }
+}
+
+void ServoStream_Init( void )
+/*!\brief   Forget any stream in progress and clear the statistics
+\return none
+*/
+{
+  restart();
+  active = 0;
+  stats.frames = 0;
+  stats.late = 0;
+  stats.dropped = 0;
+  stats.rejected = 0;
+  stats.underruns = 0;
+}
+
+void ServoStream_Push( const uint8_t * payload, uint8_t length, uint32_t nowMs )
+/*!\brief   Accept one frame from the packet parser
+\param payload[in]: frame payload, see ServoStream.h
+       length[in]: payload length in bytes
+       nowMs[in]: arrival time
+\return none
+*/
+{
+  uint8_t flags = payload[0];
+  uint8_t seq = payload[1];
+  uint32_t hostMs = read32(&payload[2]);
+  int16_t joint[SERVO_COUNT];
+  uint32_t delay;
+  int8_t gap;
+
+  if (!active || ((nowMs - lastArrivalMs) > STREAM_IDLE_MS)) {
+    restart();
+    active = 1;
+  }
+  lastArrivalMs = nowMs;
+
+  gap = (int8_t)(seq - lastSeq);
+  if (synced && (gap <= 0)) {
+    stats.rejected++;   //repeated or out of order
+    return;
+  }
+
+  if (flags & STREAM_FLAG_DELTA) {
+    uint16_t mask = (uint16_t)payload[6] | ((uint16_t)payload[7] << 8);
+    uint8_t n = STREAM_MIN_PAYLOAD;
+
+    if (!synced || (gap != 1)) {
+      //the base frame never arrived, wait for the next full frame
+      stats.rejected++;
+      synced = 0;
+      return;
+    }
+    for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+      joint[ch] = lastJoint[ch];
+      if (mask & (1u << ch)) {
+        if ((n >= length) || (joint[ch] == NOMOVE)) {
+          stats.rejected++;
+          synced = 0;
+          return;
+        }
+        joint[ch] += (int8_t)payload[n++];
+        if (joint[ch] < 0) joint[ch] = 0;
+        if (joint[ch] > 180) joint[ch] = 180;
+      }
+    }
+    if (n != length) {
+      stats.rejected++;
+      synced = 0;
+      return;
+    }
+  } else {
+    if (length != STREAM_MAX_PAYLOAD) {
+      stats.rejected++;
+      return;
+    }
+    for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+      uint8_t v = payload[STREAM_HEADER_LEN + ch];
+      if ((v != STREAM_KEEP) && (v > 180)) {
+        stats.rejected++;   //not an angle, keep every joint where it is
+        return;
+      }
+      joint[ch] = (v == STREAM_KEEP) ? lastJoint[ch] : v;
+    }
+  }
+
+  if (synced && (gap > 1)) stats.dropped += (uint8_t)(gap - 1);
+
+  //smallest transit time seen, leaking upwards so host clock drift is followed
+  delay = nowMs - hostMs;
+  if (!haveOffset || ((int32_t)(delay - clockOffset) < 0)) {
+    clockOffset = delay;
+    haveOffset = 1;
+  } else if (++leak >= OFFSET_LEAK) {
+    leak = 0;
+    clockOffset++;
+  }
+
+  if (queueCount == STREAM_QUEUE) {
+    queueTail = (queueTail + 1) % STREAM_QUEUE;
+    queueCount--;
+    stats.dropped++;
+  }
+
+  streamFrame_t * frame = &queue[(queueTail + queueCount) % STREAM_QUEUE];
+  frame->playMs = hostMs + clockOffset + STREAM_PLAYOUT_MS;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+    frame->joint[ch] = joint[ch];
+    lastJoint[ch] = joint[ch];
+  }
+  queueCount++;
+
+  if ((int32_t)(nowMs - frame->playMs) > 0) stats.late++;
+  lastSeq = seq;
+  synced = 1;
+  starved = 0;
+  stats.frames++;
+}
+
+void ServoStream_Resume( void )
+/*!\brief   The joints were moved by something else, write all of them again
+\details Call when the gait hands the joints (back) to the stream, the
+         frames already queued are kept.
+\return none
+*/
+{
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+    output[ch] = NOMOVE;
+  }
+}
+
+uint8_t ServoStream_Update( uint32_t nowMs )
+/*!\brief   Drive every joint from the stream, once per control tick
+\param nowMs[in]: current time in milliseconds
+\return 1 while a stream is playing, 0 if nothing has been received
+*/
+{
+  streamFrame_t * a;
+  streamFrame_t * b;
+
+  if (queueCount == 0) return 0;
+
+  //drop frames whose successor is already due
+  while ((queueCount > 1) &&
+         ((int32_t)(nowMs - queue[(queueTail + 1) % STREAM_QUEUE].playMs) >= 0)) {
+    queueTail = (queueTail + 1) % STREAM_QUEUE;
+    queueCount--;
+  }
+
+  a = &queue[queueTail];
+  if ((int32_t)(nowMs - a->playMs) < 0) return 1;   //first frame not due yet
+
+  if (queueCount == 1) {
+    if (!starved) {
+      starved = 1;
+      stats.underruns++;
+    }
+    for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+      writeJoint(ch, a->joint[ch]);
+    }
+    return 1;
+  }
+
+  b = &queue[(queueTail + 1) % STREAM_QUEUE];
+  int32_t span = (int32_t)(b->playMs - a->playMs);
+  int32_t t = (int32_t)(nowMs - a->playMs);
+
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+    int16_t from = a->joint[ch];
+    int16_t to = b->joint[ch];
+    if (from == NOMOVE) {
+      writeJoint(ch, to);
+    } else if ((to == NOMOVE) || (span <= 0)) {
+      writeJoint(ch, from);
+    } else {
+      writeJoint(ch, from + (int16_t)(((int32_t)(to - from) * t) / span));
+    }
+  }
+  return 1;
+}
+
+void ServoStream_GetStats( streamStats_t * stats_out )
+/*!\brief   Copy out the stream counters
+\param stats_out[out]: frame, late, dropped, rejected and underrun counts
+\return none
+*/
+{
+  *stats_out = stats;
+}
@@ -0,0 +1,43 @@
+#if !defined(SERVOSTREAM_H)
+#define SERVOSTREAM_H
+
+#include <stdint.h>
+#include "ServoModel.h"
+
+ // Streamed joint frames share the GoBLE framing (0x55 0xAA address length
+ // payload checksum) on their own address. Payload, little endian:
+ //   [0] flags     STREAM_FLAG_DELTA set for a delta frame
+ //   [1] sequence  increments by one per frame, gaps count as dropped
+ //   [2..5]        host timestamp in ms
+ //   full frame:   [6..17]  angle per servo channel (0-5 raw hips, 6-11 knees),
+ //                          STREAM_KEEP repeats the previous frame, a frame
+ //                          with any other value above 180 is rejected
+ //   delta frame:  [6..7]   mask of channels that change, then one int8_t
+ //                          step per set bit, lowest channel first
+#define STREAM_ADDRESS      (0x12)
+#define STREAM_FLAG_DELTA   (0x01)
+#define STREAM_KEEP         (0xFF)
+#define STREAM_HEADER_LEN   (6)
+#define STREAM_MAX_PAYLOAD  (STREAM_HEADER_LEN + SERVO_COUNT)
+#define STREAM_MIN_PAYLOAD  (STREAM_HEADER_LEN + 2)
+
+#define STREAM_PLAYOUT_MS   (40)    //frames play this long after their best case arrival, ~2 frames at 50Hz
+#define STREAM_IDLE_MS      (500)   //a gap this long starts a new stream
+#define STREAM_QUEUE        (4)
+
+typedef struct streamStats
+{
+  uint32_t frames;      //!<Frames accepted
+  uint32_t late;        //!<Frames that arrived after their play time
+  uint32_t dropped;     //!<Sequence numbers never seen, or pushed out of a full queue
+  uint32_t rejected;    //!<Malformed, out of order, or deltas without their base frame
+  uint32_t underruns;   //!<Times the queue ran dry while playing
+} streamStats_t;
+
+void ServoStream_Init( void );
+void ServoStream_Push( const uint8_t * payload, uint8_t length, uint32_t nowMs );
+void ServoStream_Resume( void );
+uint8_t ServoStream_Update( uint32_t nowMs );
+void ServoStream_GetStats( streamStats_t * stats );
+
+#endif
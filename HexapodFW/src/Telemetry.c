@@ -0,0 +1,176 @@
+/*! \file  Telemetry.c
+*
+* \brief
+* Binary status frames over the Bluetooth UART
+*
+* \details
+*  Telemetry_Service is called from the main loop. At the configured rate it
+*  snapshots the gait phase, the commanded servo frame, the control loop
+*  timing, the I2C counters and the Bluetooth link counters into one
+*  TELEMETRY_FRAME byte frame and hands it to UART_QueueFrame. Sending is
+*  interrupt driven and drops the oldest frame when the phone cannot keep
+*  up, so the control loop never waits on the link.
+*
+*  Dumps requested with Telemetry_Request go out one frame per call while
+*  the UART queue has a spare slot, so they never push out telemetry.
+*
+* \author livey
+*
+******************************************************************************/
+
+#include "Telemetry.h"
+#include "UART.h"
+#include "I2C.h"
+#include "Control.h"
+#include "Bluetooth.h"
+#include "ServoModel.h"
+#include "ServoStream.h"
+#include "Profile.h"
+#include "Recorder.h"
+#include "Config.h"
+
+static uint32_t intervalMs = 1000 / TELEMETRY_DEFAULT_HZ;
+static uint32_t lastSentMs = 0;
+static uint8_t sequence = 0;
+#if PROFILE_ENABLE
+static uint8_t profileNext = PROF_NUM_REGIONS;   //next region to dump, PROF_NUM_REGIONS when idle
+#endif
+#if RECORDER_ENABLE
+static uint32_t recorderNext = 0;    //next entry to dump
+static uint32_t recorderEnd = 0;     //dump stops here, equal to recorderNext when idle
+#endif
+static uint8_t configPending = 0;
+
+static void put16( uint8_t * p, uint32_t value )
+{
+  if (value > 0xFFFF) value = 0xFFFF;
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+}
+
+void Telemetry_SetRate( uint8_t hz )
+/*!\brief   Set how often a status frame is sent
+\param hz[in]: frames per second, 0 turns telemetry off
+\return none
+*/
+{
+  intervalMs = (hz == 0) ? 0 : (1000u / hz);
+}
+
+void Telemetry_Request( uint8_t what )
+/*!\brief   Act on a dump request from the link
+\param what[in]: one of the DUMP_ selectors, others are ignored
+\return none
+*/
+{
+#if PROFILE_ENABLE
+  if (what == DUMP_PROFILE) profileNext = 0;
+  else if (what == DUMP_PROFILE_RESET) Profile_Reset();
+#endif
+#if RECORDER_ENABLE
+  if (what == DUMP_RECORDER) {
+    recorderEnd = Recorder_Count();
+    recorderNext = (recorderEnd > RECORDER_ENTRIES) ? (recorderEnd - RECORDER_ENTRIES) : 0;
+  }
+  else if (what == DUMP_RECORDER_CLEAR) {
+    Recorder_Clear();
+    recorderNext = recorderEnd = 0;
+  }
+#endif
+  if (what == DUMP_CONFIG) configPending = 1;
+}
+
+uint8_t Telemetry_BuildFrame( uint8_t * frame, uint32_t nowMs, gaitCommand_t lastCmd )
+/*!\brief   Fill one complete telemetry frame
+\param frame[out]: at least TELEMETRY_FRAME bytes
+       nowMs[in]: timestamp for the frame
+       lastCmd[in]: command being executed
+\return frame length in bytes
+*/
+{
+  controlStats_t control;
+  i2cStats_t i2c;
+  linkStats_t link;
+  streamStats_t stream;
+  uint8_t * p = &frame[4];
+  uint8_t checksum = 0;
+
+  Control_GetStats(&control);
+  I2C_GetStats(&i2c);
+  BlueTooth_GetLinkStats(&link);
+  ServoStream_GetStats(&stream);
+
+  frame[0] = 0x55;
+  frame[1] = 0xAA;
+  frame[2] = TELEMETRY_ADDRESS;
+  frame[3] = TELEMETRY_PAYLOAD;
+
+  p[TM_SEQ] = sequence++;
+  p[TM_VERSION] = TELEMETRY_VERSION;
+  p[TM_TIME_MS]     = (uint8_t)nowMs;
+  p[TM_TIME_MS + 1] = (uint8_t)(nowMs >> 8);
+  p[TM_TIME_MS + 2] = (uint8_t)(nowMs >> 16);
+  p[TM_TIME_MS + 3] = (uint8_t)(nowMs >> 24);
+  p[TM_PHASE] = (uint8_t)getGaitPhase();
+  p[TM_COMMAND] = (uint8_t)lastCmd;
+  for (uint8_t ch = 0; ch < SERVO_COUNT; ch++) {
+    int16_t angle = ServoModel_Target(ch);
+    p[TM_SERVOS + ch] = ((angle < 0) || (angle > 180)) ? 0xFF : (uint8_t)angle;
+  }
+  put16(&p[TM_LOOP_US], control.lastLoopUs);
+  put16(&p[TM_MAXLOOP_US], control.maxLoopUs);
+  put16(&p[TM_OVERRUNS], control.overruns);
+  put16(&p[TM_I2C_XFERS], i2c.transfers & 0xFFFF);
+  put16(&p[TM_I2C_ERRORS], i2c.errors);
+  p[TM_I2C_LAST] = (uint8_t)i2c.lastError;
+  put16(&p[TM_PKT_ERRORS], link.errors);
+  put16(&p[TM_PKT_SUPERSEDED], link.superseded);
+  put16(&p[TM_RX_OVERRUNS], UART_RxOverruns());
+  put16(&p[TM_TX_DROPPED], UART_TxDropped());
+  put16(&p[TM_LINK_GAP], link.lastGapMs);
+  put16(&p[TM_STREAM_LATE], stream.late);
+  put16(&p[TM_STREAM_DROPPED], stream.dropped);
+
+  for (uint8_t i = 0; i < (TELEMETRY_FRAME - 1); i++) {
+    checksum += frame[i];
+  }
+  frame[TELEMETRY_FRAME - 1] = checksum;
+  return TELEMETRY_FRAME;
+}
+
+void Telemetry_Service( uint32_t nowMs, gaitCommand_t lastCmd )
+/*!\brief   Queue a status frame when one is due, and the next dump frame
+\details Call from the main loop. Costs one frame build per interval; the
+         frame is copied into the UART queue, never waited on.
+\param nowMs[in]: current time in milliseconds
+       lastCmd[in]: command being executed
+\return none
+*/
+{
+  uint8_t frame[TELEMETRY_FRAME];
+
+#if PROFILE_ENABLE
+  if ((profileNext < PROF_NUM_REGIONS) && (UART_TxQueueFree() > 1)) {
+    uint8_t dump[PROFILE_FRAME];
+    UART_QueueFrame(dump, Profile_BuildFrame(profileNext++, dump));
+  }
+#endif
+#if RECORDER_ENABLE
+  if ((recorderNext != recorderEnd) && (UART_TxQueueFree() > 1)) {
+    uint8_t dump[RECORDER_FRAME];
+    uint8_t length = Recorder_BuildFrame(&recorderNext, recorderEnd, dump);
+    if (length) UART_QueueFrame(dump, length);
+    else recorderEnd = recorderNext;
+  }
+#endif
+  if (configPending && (UART_TxQueueFree() > 1)) {
+    uint8_t dump[CONFIG_FRAME];
+    UART_QueueFrame(dump, Config_BuildFrame(dump));
+    configPending = 0;
+  }
+
+  if ((intervalMs == 0) || ((nowMs - lastSentMs) < intervalMs)) return;
+  lastSentMs = nowMs;
+
+  UART_QueueFrame(frame, Telemetry_BuildFrame(frame, nowMs, lastCmd));
+}
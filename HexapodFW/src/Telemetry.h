@@ -0,0 +1,50 @@
+#if !defined(TELEMETRY_H)
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "Gaits.h"
+
+ // Frames use the GoBLE framing in the other direction:
+ // 0x55 0xAA address length payload checksum, checksum = sum of all bytes before it
+#define TELEMETRY_ADDRESS    (0x20)
+#define TELEMETRY_VERSION    (2)
+#define TELEMETRY_DEFAULT_HZ (10)
+#define TELEMETRY_PAYLOAD    (45)
+#define TELEMETRY_FRAME      (TELEMETRY_PAYLOAD + 5)
+
+ // Payload layout, multi-byte fields little endian, counters truncated to 16 bits
+#define TM_SEQ        0    //u8  frame sequence number
+#define TM_VERSION    1    //u8  TELEMETRY_VERSION
+#define TM_TIME_MS    2    //u32 Timer_millis
+#define TM_PHASE      6    //u8  getGaitPhase
+#define TM_COMMAND    7    //u8  command being executed
+#define TM_SERVOS     8    //u8 x12 commanded angle per servo channel, 0xFF unknown
+#define TM_LOOP_US    20   //u16 last control frame compute + commit time
+#define TM_MAXLOOP_US 22   //u16 worst control frame time
+#define TM_OVERRUNS   24   //u16 control ticks without a frame
+#define TM_I2C_XFERS  26   //u16 I2C transactions
+#define TM_I2C_ERRORS 28   //u16 failed I2C transactions
+#define TM_I2C_LAST   30   //u8  last I2C error status
+#define TM_PKT_ERRORS 31   //u16 rejected GoBLE frames
+#define TM_PKT_SUPERSEDED 33 //u16 GoBLE packets replaced by a newer one
+#define TM_RX_OVERRUNS 35  //u16 received bytes lost
+#define TM_TX_DROPPED 37   //u16 telemetry frames dropped by backpressure
+#define TM_LINK_GAP   39   //u16 last gap between GoBLE packets, ms
+#define TM_STREAM_LATE 41  //u16 streamed joint frames that arrived after their play time
+#define TM_STREAM_DROPPED 43 //u16 streamed joint frames lost
+
+ // Dump requests arrive as GoBLE framed packets on DUMP_ADDRESS with a one
+ // byte payload; the answer goes out between telemetry frames
+#define DUMP_ADDRESS         (0x14)
+#define DUMP_PROFILE         (1)   //one PROFILE_ADDRESS frame per region, PROFILE_ENABLE builds only
+#define DUMP_PROFILE_RESET   (2)   //clear the profile statistics
+#define DUMP_RECORDER        (3)   //the flight recorder log as RECORDER_ADDRESS frames, oldest first
+#define DUMP_RECORDER_CLEAR  (4)   //start a new flight recorder log
+#define DUMP_CONFIG          (5)   //one CONFIG_OUT_ADDRESS frame, the configuration in use
+
+void Telemetry_SetRate( uint8_t hz );
+void Telemetry_Request( uint8_t what );
+void Telemetry_Service( uint32_t nowMs, gaitCommand_t lastCmd );
+uint8_t Telemetry_BuildFrame( uint8_t * frame, uint32_t nowMs, gaitCommand_t lastCmd );
+
+#endif
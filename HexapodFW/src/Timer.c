@@ -1,74 +1,139 @@
-/*! \file  Timer.c
-*
-* \brief
-* Timer control functions to be used with the TIVA TM4C123G Development Kit
-*
-* \details
-*  Sets up the TimerA for use with the Hexapod. Limited functionality as we
-*  only need to count milliseconds
-*
-* \author vsimontov
-          clopez
-*
-* \info
-* Based on TIVA User Reference manual, starting on pg.705
-*
-* This code was tested using an osciliscope to verify acturate clock setting
-*
-* For details on programming, refer to TM4C123G datasheet :
-* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
-*
-******************************************************************************/
-
-#include <stdint.h>
-#include <stdio.h>
-#include "Timer.h"
-#include <tm4c123gh6pm.h>
-#include "GPIO.h"
-
-void TimerA_Handler( void ); /* Protoype def*/
-
-uint32_t timerCounter = 0;
-static volatile int TIMEDOUT;
-
-
-void TimerA_Handler( void )
-/*!\brief   ISR for Timer A interupts. 
-\details    1ms has elapsed since we got here, increment the global
-            variable timerCounter by one
-\return none
-*/
-{
-  timerCounter++;     //increment counter by 1
-  GPTMICR |= 0x01; 	  //Clear the interrupt
-}
-
-void Timer_setUp( void ) 
-/*!\brief   Configure timer A for use as a count down timer
-\details Load the timer with 1ms worth of ticks based on system clock and
-         start counting down.
-\return none
-*/
-{
-  
-  ENABLEINT = TIMERA_INT;             //Enable TimerA interrupt
-  SYSCTL_RCGC2_R |= EN_RUN_GCR;               //Enable Run Mode Clock Gating Control Register 2
-  RCGCTIMER |= SEL_TIMER0_GCR;                    //select Timer 0 in gating control reg
-  GPTMCTL &= ~ENABLE;                     //disable timer in Timer 0 control reg 
-  GPTMCFG = SET_32K_MODE;                       //set timer to 32bit mode, and not a RTC
-  GPTMTAMR = PERIODIC_MODE;                      //configure Timer_0_A to periodic mode
-  GPTMTAMR &= ~COUNT_DIR;                    //Direction is set to down counter
-  GPTMTAILR = ONE_MS;                   //16MH / 1000 to return time in milliseconds
-  GPTMIMR = TIMEOUT_INT;                 //enable time-out interrupt
-  GPTMCTL |= ENABLE;                     //re-enable timer in Timer 0 control reg 
-}
-
-
-uint32_t Timer_millis( void )
-/*!\brief   Wrapper function to access global variable timerCounter
-\details Function returns current number of milliseconds since restart of system
-\return timerCounter in milliseconds
-*/
-{
-  return timerCounter;
-}
\ No newline at end of file
+/*! \file  Timer.c
+*
+* \brief
+* Timer control functions to be used with the TIVA TM4C123G Development Kit
+*
+* \details
+*  Sets up the TimerA for use with the Hexapod. Limited functionality as we
+*  only need to count milliseconds
+*
+* \author vsimontov
+          clopez
+*
+* \info
+* Based on TIVA User Reference manual, starting on pg.705
+*
+* This code was tested using an osciliscope to verify acturate clock setting
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include "Timer.h"
+#include <tm4c123gh6pm.h>
+#include "GPIO.h"
+
+void TimerA_Handler( void ); /* Protoype def*/
+void Timer1A_Handler( void );
+
+volatile uint32_t timerCounter = 0;
+static volatile uint32_t controlTickCounter = 0;
+static volatile int TIMEDOUT;
+
+
+void TimerA_Handler( void )
+/*!\brief   ISR for Timer A interupts. 
+\details    1ms has elapsed since we got here, increment the global
+            variable timerCounter by one
+\return none
+*/
+{
+  timerCounter++;     //increment counter by 1
+  GPTMICR |= 0x01; 	  //Clear the interrupt
+}
+
+void Timer_setUp( void ) 
+/*!\brief   Configure timer A for use as a count down timer
+\details Load the timer with 1ms worth of ticks based on system clock and
+         start counting down.
+\return none
+*/
+{
+  
+  ENABLEINT = TIMERA_INT;             //Enable TimerA interrupt
+  SYSCTL_RCGC2_R |= EN_RUN_GCR;               //Enable Run Mode Clock Gating Control Register 2
+  RCGCTIMER |= SEL_TIMER0_GCR;                    //select Timer 0 in gating control reg
+  GPTMCTL &= ~ENABLE;                     //disable timer in Timer 0 control reg 
+  GPTMCFG = SET_32K_MODE;                       //set timer to 32bit mode, and not a RTC
+  GPTMTAMR = PERIODIC_MODE;                      //configure Timer_0_A to periodic mode
+  GPTMTAMR &= ~COUNT_DIR;                    //Direction is set to down counter
+  GPTMTAILR = ONE_MS;                   //16MH / 1000 to return time in milliseconds
+  GPTMIMR = TIMEOUT_INT;                 //enable time-out interrupt
+  GPTMCTL |= ENABLE;                     //re-enable timer in Timer 0 control reg 
+}
+
+
+uint32_t Timer_millis( void )
+/*!\brief   Wrapper function to access global variable timerCounter
+\details Function returns current number of milliseconds since restart of system
+\return timerCounter in milliseconds
+*/
+{
+  return timerCounter;
+}
+
+uint32_t Timer_micros( void )
+/*!\brief   Microseconds since restart of system
+\details Milliseconds from timerCounter plus the elapsed part of the current
+         millisecond read back from the Timer A down counter. Re-reads if the
+         millisecond interrupt ran in between. If the counter has reloaded
+         but the interrupt is still pending (called with interrupts off, or
+         from a higher priority ISR) the raw time-out status is set and the
+         missing millisecond is added.
+\return time in microseconds (wraps after ~71 minutes)
+*/
+{
+  uint32_t ms;
+  uint32_t ticks;
+  uint32_t late;
+  do {
+    ms = timerCounter;
+    ticks = GPTMTAV;
+    late = GPTMRIS & TATORIS;
+    if (late) ticks = GPTMTAV;   //the reload may have come after the first read
+  } while (ms != timerCounter);
+  return ((ms + late) * 1000u) + ((ONE_MS - ticks) / TICKS_PER_US);
+}
+
+void Timer1A_Handler( void )
+/*!\brief   ISR for the control tick (Timer 1A)
+\details One control period has elapsed, count it. The main loop compares
+         against this count to run exactly one servo frame per period.
+\return none
+*/
+{
+  controlTickCounter++;
+  TIMER1_ICR_R = CLEARINT;    //Clear the interrupt
+}
+
+void Timer_ControlTickInit( uint32_t periodUs )
+/*!\brief   Start Timer 1A as the periodic control tick
+\details 32-bit periodic down counter reloaded with periodUs worth of system
+         clock ticks, time-out interrupt enabled.
+\param periodUs[in]: control period in microseconds
+\return none
+*/
+{
+  SYSCTL_RCGCTIMER_R |= (0x01 << 1);    //clock Timer 1
+  while ((SYSCTL_PRTIMER_R & (0x01 << 1)) == 0);
+
+  TIMER1_CTL_R &= ~ENABLE;              //disable while configuring
+  TIMER1_CFG_R = SET_32K_MODE;          //32-bit timer
+  TIMER1_TAMR_R = PERIODIC_MODE;        //periodic, counting down
+  TIMER1_TAILR_R = (periodUs * TICKS_PER_US) - 1;
+  TIMER1_ICR_R = CLEARINT;
+  TIMER1_IMR_R = TIMEOUT_INT;           //enable time-out interrupt
+  ENABLEINT = TIMER1A_INT;              //Enable Timer1A interrupt in the NVIC
+  TIMER1_CTL_R |= ENABLE;
+}
+
+uint32_t Timer_controlTicks( void )
+/*!\brief   Number of control ticks since Timer_ControlTickInit
+\return tick count
+*/
+{
+  return controlTickCounter;
+}
@@ -1,118 +1,481 @@
-/*! \file  UART.c
-*
-* \brief
-* UART control functions to be used with the TIVA TM4C123G Development Kit
-*
-* \details
-*  This modules sets up the uart serial driver for receiving communication from
-*  any serial device
-*
-* \author livey
-*
-* \info
-* Based on TIVA User Reference manual, starting on pg.893
-*
-* This code was tested using an osciliscope to verify proper packet transfers
-*
-* For details on programming, refer to TM4C123G datasheet :
-* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
-*
-******************************************************************************/
-
-#include "UART.h"
-uint8_t storedDataByte = 0;
-
-void UART_InitPort1( void )
-/*!\brief   Initialize UART for Port 1. 
-\details set the port to 38400 8N1
-\return none
-*/
-{
-    //1. Enable the I2C clock using the RCGCI2C register in the System Control module (see page 348).
-    RCGC_UART |= (0x01 << 1); //enable UART 1
-
-    //2. Enable the clock to the appropriate GPIO module via the RCGCGPIO register in the System
-    //Control module (see page 340). To find out which GPIO port to enable, refer to Table
-    //23-5 on page 1351.
-    RCGCGPIO |= (0x04);//Clock to port C (pin 4 and 5 for UART Rx and Tx respectively)
-
-    //3. In the GPIO module, enable the appropriate pins for their alternate function using the
-    //GPIOAFSEL register (see page 671). To determine which GPIOs to configure, see Table
-    ///23-4 on page 1344.
-    GPIO_C_AFSEL |= (0x30);//pin 4 and 5 are assigned alternative function
-    
-    //4. Set drive current and slew rate 
-    //(use default 2-mA)
-    GPIO_C_DEN |= (0x30);//pin 4 and 5 are assigned alternative function
-    GPIO_C_DIR |= (0x20); //pin 5 is an output
-    GPIO_C_DR8R |= (0x30);//pin 4 and 5 are assigned alternative function
-    GPIO_C_SLR |= (0x30);//pin 4 and 5 are assigned alternative function
-    
-    //5. Configure the PMCn fields in the GPIOPCTL register to assign the UART signals to the appropriate
-    //pins. See page 688 and Table 23-5 on page 1351.
-    GPIO_C_PCTL |= (0x22 << (16));
-
-    //6. Disable UART in UART_CTL register
-    UART_CTL(1) &= ~UART_ENABLE;
-    
-    //7. Calculate baudrate divisor for 16MHz system
-    //BRD = 16,000,000 / (16 * 38,400) = 26.04167
-    //FBRD = .04167 * 64 + .5 = 3.1667
-    UART_IBRD(1) = 26;
-    UART_FBRD(1) = 3;
-    
-    //8. Set configuration 
-    UART_LCRH(1) |= UART_8BIT_CFG;  //8 bits, (no parity, one stop bit by default)
-    UART_LCRH(1) |= UART_FIFO_EN;  //16-entry FIFOs enabled
-    
-    //9. Interrupts to come
-    
-    //10. UART_CC is set to the system clock by default
-    
-    //11. Re-enable UART module
-    UART_CTL(1) |= 0x0001;
-    
-}
-
-UART_status_t UART_ReadByte(uint8_t * dataByte)
-/*!\brief   Read one byte from the client
-\details: This function will read one data byte and pass back via pointer
-\return UART_status_t : status of i2c bus 
-              UART_STATUS_OK : UART packet succesfully read
-              UART_STATUS_UNKNOWN: default state. Assume the worst and hope for the best
-              UART_STATUS_RxEMPTY : The RX buffer is empy
-*/
-{
-
-     *dataByte = UART1_DATA;
-     storedDataByte = *dataByte;
-     UART_status_t FIFOStatus = UART_STATUS_UNKNOWN;
-      if ((UART_FR(1) & UART_RxFIFO_EMPTY_FLAG) != 0){
-         FIFOStatus = UART_STATUS_RxEMPTY;
-      }
-      else {
-        //could add in more error checking here but we don't need it presently
-        *dataByte = UART1_DATA;
-        FIFOStatus = UART_STATUS_OK;
-      }
-      return FIFOStatus;
-}
-
-uint8_t UART_lastRxByte( void )
-/*!\brief   Read back last byte received
-\return One byte of data representing last byte received
-*/
-{
-  return storedDataByte;
-}
-
-uint8_t UART_Rx_available( void )
-/*!\brief   Check if RX data is availble
-\details Poll the UART registers to see if data has arrived. 
-\return 0 if false
-        1 if true
-*/
-{
-  if ((UART_FR(1) & UART_RxFIFO_EMPTY_FLAG) != 0) return 0;
-  else return 1;
+/*! \file  UART.c
+*
+* \brief
+* UART control functions to be used with the TIVA TM4C123G Development Kit
+*
+* \details
+*  This modules sets up the uart serial driver for receiving communication from
+*  any serial device
+*
+*  Two ports receive: UART1 (Bluetooth module, PC4/PC5) and UART0 (the
+*  launchpad's USB virtual COM port, PA0/PA1) for a wired link. Each has its
+*  own uartRx_t context.
+*
+*  Reception is interrupt driven: the UART ISR drains the hardware FIFO on the
+*  FIFO-level and receive-timeout interrupts into a single producer / single
+*  consumer ring buffer. The ISR only moves the head, the reader only moves
+*  the tail, so no locking is needed. Bytes that arrive with the ring full (or
+*  that the hardware FIFO already lost) are counted as overruns.
+*
+*  With UART_RX_USE_DMA the same ring is filled by the port's uDMA channel in
+*  ping-pong mode, one structure per half, with no CPU work per byte. The
+*  ISR only runs when a half completes, to re-arm it. The write position is
+*  read from the live channel count, so a partial packet at the tail is
+*  available as soon as it is out of the FIFO.
+*
+*  Transmit (UART1 only) is interrupt driven too. Whole frames are queued with
+*  UART_QueueFrame and the TX FIFO level interrupt refills the FIFO, so the
+*  caller never waits. When the queue is full the oldest waiting frame is
+*  dropped (counted in txDropped); the frame already on the wire finishes.
+*
+* \author livey
+*
+* \info
+* Based on TIVA User Reference manual, starting on pg.893
+*
+* This code was tested using an osciliscope to verify proper packet transfers
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include "UART.h"
+#if UART_RX_USE_DMA
+#include "uDMA.h"
+#endif
+uint8_t storedDataByte = 0;
+
+#if UART_RX_USE_DMA
+#define RX_HALF      (UART_RX_RING_SIZE / 2)
+#define RX_DMA_CTL   (UDMA_DST_INC_8 | UDMA_DST_SIZE_8 | UDMA_SRC_INC_NONE | \
+                      UDMA_SRC_SIZE_8 | UDMA_ARB_4 | UDMA_MODE_PINGPONG)
+#endif
+
+typedef struct uartRx
+{
+  volatile uint8_t  ring[UART_RX_RING_SIZE];
+#if UART_RX_USE_DMA
+  volatile uint32_t halves;     //ring halves completed by the uDMA, written by the ISR only
+#else
+  volatile uint32_t head;       //free running, written by the ISR only
+#endif
+  volatile uint32_t tail;       //free running, written by the reader only
+  volatile uint32_t overruns;   //FIFO overruns and full ring drops, written by the ISR only
+  uint32_t lapped;              //bytes the uDMA overwrote before the reader got to them, reader only
+} uartRx_t;
+
+static uartRx_t rxPort[UART_NUM_PORTS];
+#if UART_RX_USE_DMA
+static const uint8_t rxDmaChannel[UART_NUM_PORTS] = {UART0_RX_DMA_CH, UART1_RX_DMA_CH};
+#endif
+static const uint32_t portInt[UART_NUM_PORTS] = {UART0_INT, UART1_INT};
+
+typedef struct txFrame
+{
+  uint8_t length;
+  uint8_t data[UART_TX_FRAME_MAX];
+} txFrame_t;
+
+static txFrame_t txActive;             //frame being shifted out by the ISR
+static volatile uint8_t txPos = 0;     //bytes of txActive already in the FIFO
+static txFrame_t txQueue[UART_TX_SLOTS];
+static volatile uint8_t txHead = 0, txTail = 0, txCount = 0;
+static volatile uint32_t txDropped = 0;
+
+static void UART_StartRx( uint8_t port )
+/*!\brief   Start interrupt or uDMA reception on a port
+\details The port must be disabled while this runs
+\return none
+*/
+{
+  uartRx_t * rx = &rxPort[port];
+
+  rx->tail = 0;
+  rx->overruns = 0;
+  rx->lapped = 0;
+  UART_IFLS(port) = UART_IFLS_RX4_8;
+#if UART_RX_USE_DMA
+  //Receive through the port's uDMA channel into both halves of the ring. The
+  //UART interrupt then only signals completed halves and overruns.
+  rx->halves = 0;
+  uDMA_Init();
+  uDMA_AssignChannel(rxDmaChannel[port], 0);
+  uDMA_SetTransfer(rxDmaChannel[port], UDMA_PRIMARY, &UART_DR(port), &rx->ring[0], RX_DMA_CTL, RX_HALF);
+  uDMA_SetTransfer(rxDmaChannel[port], UDMA_ALTERNATE, &UART_DR(port), &rx->ring[RX_HALF], RX_DMA_CTL, RX_HALF);
+  uDMA_EnableChannel(rxDmaChannel[port]);
+  UART_DMACTL(port) |= UART_RXDMAE;
+  UART_ICR(port) = UART_OEIM;
+  UART_IM(port) |= UART_OEIM;
+#else
+  //Interrupt at half full or after 32 idle bit times, plus overruns
+  rx->head = 0;
+  UART_ICR(port) = (UART_RXIM | UART_RTIM | UART_OEIM);
+  UART_IM(port) |= (UART_RXIM | UART_RTIM | UART_OEIM);
+#endif
+  NVIC_EN0 = portInt[port];
+}
+
+void UART_InitPort1( void )
+/*!\brief   Initialize UART for Port 1. 
+\details set the port to 38400 8N1
+\return none
+*/
+{
+    //1. Enable the I2C clock using the RCGCI2C register in the System Control module (see page 348).
+    RCGC_UART |= (0x01 << 1); //enable UART 1
+
+    //2. Enable the clock to the appropriate GPIO module via the RCGCGPIO register in the System
+    //Control module (see page 340). To find out which GPIO port to enable, refer to Table
+    //23-5 on page 1351.
+    RCGCGPIO |= (0x04);//Clock to port C (pin 4 and 5 for UART Rx and Tx respectively)
+
+    //3. In the GPIO module, enable the appropriate pins for their alternate function using the
+    //GPIOAFSEL register (see page 671). To determine which GPIOs to configure, see Table
+    ///23-4 on page 1344.
+    GPIO_C_AFSEL |= (0x30);//pin 4 and 5 are assigned alternative function
+    
+    //4. Set drive current and slew rate 
+    //(use default 2-mA)
+    GPIO_C_DEN |= (0x30);//pin 4 and 5 are assigned alternative function
+    GPIO_C_DIR |= (0x20); //pin 5 is an output
+    GPIO_C_DR8R |= (0x30);//pin 4 and 5 are assigned alternative function
+    GPIO_C_SLR |= (0x30);//pin 4 and 5 are assigned alternative function
+    
+    //5. Configure the PMCn fields in the GPIOPCTL register to assign the UART signals to the appropriate
+    //pins. See page 688 and Table 23-5 on page 1351.
+    GPIO_C_PCTL |= (0x22 << (16));
+
+    //6. Disable UART in UART_CTL register
+    UART_CTL(1) &= ~UART_ENABLE;
+    
+    //7. Calculate baudrate divisor for 16MHz system
+    //BRD = 16,000,000 / (16 * 38,400) = 26.04167
+    //FBRD = .04167 * 64 + .5 = 3.1667
+    UART_IBRD(1) = 26;
+    UART_FBRD(1) = 3;
+    
+    //8. Set configuration 
+    UART_LCRH(1) |= UART_8BIT_CFG;  //8 bits, (no parity, one stop bit by default)
+    UART_LCRH(1) |= UART_FIFO_EN;  //16-entry FIFOs enabled
+    
+    //9. Interrupt or uDMA driven reception into the ring
+    UART_StartRx(UART_PORT_BT);
+    
+    //10. TX interrupt is only unmasked while frames are waiting
+    UART_IFLS(1) |= UART_IFLS_TX1_8;
+    
+    //UART_CC is set to the system clock by default
+    
+    //11. Re-enable UART module
+    UART_CTL(1) |= 0x0001;
+    
+}
+
+void UART_InitPort0( uint32_t baud )
+/*!\brief   Initialize UART0, the launchpad's USB virtual COM port
+\details PA0 is Rx, PA1 is Tx, 8N1 with FIFOs, same reception path as UART1
+\param baud[in]: baud rate, up to 1 Mbaud
+\return none
+*/
+{
+    //1. Clock UART0 and GPIO port A
+    RCGC_UART |= 0x01;
+    RCGCGPIO |= 0x01;
+
+    //2. PA0 and PA1 to their UART function
+    GPIO_A_AFSEL |= (0x03);
+    GPIO_A_DEN |= (0x03);
+    GPIO_A_PCTL = (GPIO_A_PCTL & ~0xFF) | 0x11;
+
+    //3. Reception is set up while disabled, setting the divisors and
+    //   format enables the port
+    UART_CTL(UART_PORT_WIRED) &= ~UART_ENABLE;
+    UART_StartRx(UART_PORT_WIRED);
+    UART_SetBaud(UART_PORT_WIRED, baud);
+}
+
+static void UART_TxFill( void )
+/*!\brief   Move queued bytes into the TX FIFO
+\details Called from the ISR, or from UART_QueueFrame with TXIM masked. The
+         TX interrupt stays unmasked only while there is more to send.
+\return none
+*/
+{
+  while ((UART_FR(1) & UART_TxFIFO_FULL_FLAG) == 0) {
+    if (txPos >= txActive.length) {
+      if (txCount == 0) break;
+      txActive = txQueue[txTail];
+      txTail = (txTail + 1) % UART_TX_SLOTS;
+      txCount--;
+      txPos = 0;
+    }
+    UART1_DATA = txActive.data[txPos++];
+  }
+
+  if ((txPos < txActive.length) || (txCount != 0)) {
+    UART_IM(1) |= UART_TXIM;
+  } else {
+    UART_IM(1) &= ~UART_TXIM;
+  }
+}
+
+uint8_t UART_QueueFrame( const uint8_t * data, uint8_t length )
+/*!\brief   Queue one frame for transmission, never blocks
+\param data[in]: frame bytes, copied
+       length[in]: 1 to UART_TX_FRAME_MAX bytes
+\return 1 if queued, 0 if the length was invalid
+*/
+{
+  if ((length == 0) || (length > UART_TX_FRAME_MAX)) return 0;
+
+  UART_IM(1) &= ~UART_TXIM;   //keep the ISR off the queue while it changes
+
+  if (txCount == UART_TX_SLOTS) {
+    //backpressure: drop the oldest waiting frame, keep the newest state
+    txTail = (txTail + 1) % UART_TX_SLOTS;
+    txCount--;
+    txDropped++;
+  }
+  txQueue[txHead].length = length;
+  for (uint8_t i = 0; i < length; i++) {
+    txQueue[txHead].data[i] = data[i];
+  }
+  txHead = (txHead + 1) % UART_TX_SLOTS;
+  txCount++;
+
+  UART_TxFill();
+  return 1;
+}
+
+uint32_t UART_TxDropped( void )
+/*!\brief   Number of frames dropped because the TX queue was full
+\return dropped frame count
+*/
+{
+  return txDropped;
+}
+
+uint8_t UART_TxQueueFree( void )
+/*!\brief   Frames that can be queued before the oldest waiting one is dropped
+\return free TX queue slots
+*/
+{
+  return UART_TX_SLOTS - txCount;
+}
+
+#if UART_RX_USE_DMA
+static void UART_RxService( uint8_t port, uint32_t status )
+/*!\brief   Receive part of the UART ISRs
+\details Re-arms receive halves the uDMA has completed. Halves are re-armed in
+         the order they were filled, which also tells the reader which
+         structure is currently active.
+\return none
+*/
+{
+  uartRx_t * rx = &rxPort[port];
+  uint8_t half = rx->halves & 1;
+
+  if (status & UART_OEIM) rx->overruns++;
+
+  while (uDMA_TransferDone(rxDmaChannel[port], half)) {
+    uDMA_SetTransfer(rxDmaChannel[port], half, &UART_DR(port), &rx->ring[half ? RX_HALF : 0], RX_DMA_CTL, RX_HALF);
+    rx->halves++;
+    half ^= 1;
+  }
+}
+
+static uint32_t UART_RxHead( uint8_t port )
+/*!\brief   Free running count of bytes the uDMA has written
+\details Completed halves plus the progress of the active structure. Retries
+         if a half completes while the two parts are being read.
+\return write position
+*/
+{
+  uartRx_t * rx = &rxPort[port];
+  uint32_t halves;
+  uint16_t remaining;
+
+  do {
+    halves = rx->halves;
+    remaining = uDMA_Remaining(rxDmaChannel[port], halves & 1);
+  } while (halves != rx->halves);
+
+  return (halves * RX_HALF) + (RX_HALF - remaining);
+}
+#else
+static void UART_RxService( uint8_t port, uint32_t status )
+/*!\brief   Receive part of the UART ISRs
+\details Empties the RX FIFO into the ring buffer. Runs on the FIFO level
+         interrupt, on receive timeout (the tail of a packet) and on overrun.
+\return none
+*/
+{
+  uartRx_t * rx = &rxPort[port];
+  uint32_t data;
+
+  while ((UART_FR(port) & UART_RxFIFO_EMPTY_FLAG) == 0) {
+    data = UART_DR(port);
+    if (data & UART_DR_OE) rx->overruns++;   //the hardware FIFO dropped a byte before this one
+
+    if ((rx->head - rx->tail) >= UART_RX_RING_SIZE) {
+      rx->overruns++;   //ring full, drop the new byte
+    } else {
+      rx->ring[rx->head & UART_RX_RING_MASK] = (uint8_t)data;
+      rx->head++;
+    }
+  }
+}
+
+static uint32_t UART_RxHead( uint8_t port )
+{
+  return rxPort[port].head;
+}
+#endif
+
+void UART1_Handler( void )
+/*!\brief   ISR for UART1
+\details Refills the TX FIFO and services reception
+\return none
+*/
+{
+  uint32_t status = UART_MIS(1);
+
+  UART_ICR(1) = status;   //Clear whatever fired, the FIFO is drained below
+  if (status & UART_TXIM) UART_TxFill();
+  UART_RxService(UART_PORT_BT, status);
+}
+
+void UART0_Handler( void )
+/*!\brief   ISR for UART0, the wired link
+\return none
+*/
+{
+  uint32_t status = UART_MIS(0);
+
+  UART_ICR(0) = status;
+  UART_RxService(UART_PORT_WIRED, status);
+}
+
+UART_status_t UART_ReadPort( uint8_t port, uint8_t * dataByte )
+/*!\brief   Read one received byte from a port
+\details: Takes the oldest byte out of the port's receive ring and passes it
+          back via pointer. Nothing is consumed when the ring is empty. If the
+          uDMA has lapped the reader, the overwritten bytes are skipped and
+          counted.
+\return UART_status_t : status of the port
+              UART_STATUS_OK : UART packet succesfully read
+              UART_STATUS_RxEMPTY : The RX buffer is empy
+*/
+{
+  uartRx_t * rx = &rxPort[port];
+  uint32_t head = UART_RxHead(port);
+  uint32_t tail = rx->tail;
+
+  if (tail == head) return UART_STATUS_RxEMPTY;
+
+#if UART_RX_USE_DMA
+  if ((head - tail) > UART_RX_RING_SIZE) {
+    //keep only the newest half, the rest is being overwritten
+    rx->lapped += (head - tail) - RX_HALF;
+    tail = head - RX_HALF;
+  }
+#endif
+
+  *dataByte = rx->ring[tail & UART_RX_RING_MASK];
+  rx->tail = tail + 1;
+  return UART_STATUS_OK;
+}
+
+UART_status_t UART_ReadByte(uint8_t * dataByte)
+/*!\brief   Read one byte from the client
+\details: Oldest byte received from the Bluetooth module, see UART_ReadPort
+\return UART_status_t : status of i2c bus 
+              UART_STATUS_OK : UART packet succesfully read
+              UART_STATUS_RxEMPTY : The RX buffer is empy
+*/
+{
+  UART_status_t status = UART_ReadPort(UART_PORT_BT, dataByte);
+  if (status == UART_STATUS_OK) storedDataByte = *dataByte;
+  return status;
+}
+
+void UART_SetBaud( uint8_t port, uint32_t baud )
+/*!\brief   Change the baud rate of a port
+\details Waits for the transmitter to go idle, then reloads the divisors.
+         BRD*64 = SYSCLK*4 / baud, rounded: the top bits go to IBRD, the low
+         6 bits to FBRD. The LCRH write latches the new divisor (pg.914).
+\param port[in]: UART_PORT_WIRED or UART_PORT_BT
+       baud[in]: new baud rate, 1 Mbaud is the highest at 16MHz
+\return none
+*/
+{
+  uint32_t div = (((UART_SYSCLK_HZ * 8u) / baud) + 1u) / 2u;
+
+  while (UART_FR(port) & UART_BUSY_FLAG);
+  UART_CTL(port) &= ~UART_ENABLE;
+  UART_IBRD(port) = div >> 6;
+  UART_FBRD(port) = div & 0x3F;
+  UART_LCRH(port) = (UART_8BIT_CFG | UART_FIFO_EN);
+  UART_CTL(port) |= UART_ENABLE;
+}
+
+void UART_SetBaudPort1( uint32_t baud )
+/*!\brief   Change the UART1 (Bluetooth) baud rate
+\return none
+*/
+{
+  UART_SetBaud(UART_PORT_BT, baud);
+}
+
+void UART_WriteBytes( const uint8_t * data, uint16_t length )
+/*!\brief   Send bytes to the Bluetooth module, blocking
+\details Spins on a full TX FIFO, only meant for boot time AT commands
+\param data[in]: bytes to send
+       length[in]: number of bytes
+\return none
+*/
+{
+  for (uint16_t i = 0; i < length; i++) {
+    while (UART_FR(1) & UART_TxFIFO_FULL_FLAG);
+    UART1_DATA = data[i];
+  }
+}
+
+void UART_FlushRx( void )
+/*!\brief   Discard everything received so far
+\return none
+*/
+{
+  rxPort[UART_PORT_BT].tail = UART_RxHead(UART_PORT_BT);
+}
+
+uint8_t UART_lastRxByte( void )
+/*!\brief   Read back last byte received
+\return One byte of data representing last byte received
+*/
+{
+  return storedDataByte;
+}
+
+uint8_t UART_Rx_available( void )
+/*!\brief   Check if RX data is availble
+\details Check the Bluetooth receive ring for bytes the ISR has stored.
+\return 0 if false
+        1 if true
+*/
+{
+  if (rxPort[UART_PORT_BT].tail == UART_RxHead(UART_PORT_BT)) return 0;
+  else return 1;
+}
+
+uint32_t UART_RxOverruns( void )
+/*!\brief   Number of received bytes lost so far, both ports
+\details Counts hardware FIFO overruns, bytes dropped on a full ring and
+         bytes the uDMA lapped before they were read
+\return overrun count
+*/
+{
+  return rxPort[UART_PORT_WIRED].overruns + rxPort[UART_PORT_WIRED].lapped +
+         rxPort[UART_PORT_BT].overruns + rxPort[UART_PORT_BT].lapped;
 }
\ No newline at end of file
@@ -1,49 +1,102 @@
-#ifndef UART_H 
-#define UART_H
-
-#include <stdint.h>
-#include <stdio.h>
-
-#define SYSCTL_BASE  0x400FE000
-#define PORTC_BASE   0x40006000
-#define UART0_BASE   0x4000C000
-
-#define RCGC_UART       (*((volatile uint32_t *) (SYSCTL_BASE | 0x0618)))
-#define RCGCGPIO        (*((volatile uint32_t *) (SYSCTL_BASE | 0x0608)))
-#define GPIO_C_AFSEL    (*((volatile uint32_t *) (PORTC_BASE |  0x0420)))  
-#define GPIO_C_PCTL     (*((volatile uint32_t *) (PORTC_BASE |  0x052C))) 
-#define GPIO_C_DR8R     (*((volatile uint32_t *) (PORTC_BASE |  0x0508)))
-#define GPIO_C_SLR      (*((volatile uint32_t *) (PORTC_BASE |  0x0518)))
-#define GPIO_C_DEN      (*((volatile uint32_t *) (PORTC_BASE |  0x051C)))
-#define GPIO_C_DIR      (*((volatile uint32_t *) (PORTC_BASE |  0x0400)))
-
-#define UART1_DATA     (*((volatile uint32_t *) (0x4000D000))) 
-#define UART_CTL(N)    (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x0030)))
-#define UART_FR(N)     (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x0018)))
-#define UART_IBRD(N)   (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x0024)))
-#define UART_FBRD(N)   (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x0028)))
-#define UART_LCRH(N)   (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x002C)))
-#define UART_CC(N)     (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x0FC8)))
-#define UART_ICR(N)    (*((volatile uint32_t *) ((UART0_BASE + (0x1000 * N)) | 0x0044)))
-
-#define UART_ENABLE (0x01)
-#define UART_8BIT_CFG (0x60)
-#define UART_FIFO_EN (0x10)
-#define UART_RxFIFO_EMPTY_FLAG (0x10)
-
-typedef enum UART_status
-/*! -- */
-{
-/*@{*/
-  UART_STATUS_OK,       //!<All is well
-  UART_STATUS_ERROR,    //!<Generic error condition
-  UART_STATUS_TxFULL,   //!<Buffer full
-  UART_STATUS_RxEMPTY,  //!<Buffer empty
-  UART_STATUS_UNKNOWN   //!<Default Status
-/*@}*/
-} UART_status_t;
-
-void UART_InitPort1( void );
-UART_status_t UART_ReadByte(uint8_t * data);
-uint8_t UART_Rx_available( void );
+#ifndef UART_H 
+#define UART_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "HWReg.h"
+
+#define SYSCTL_BASE  0x400FE000
+#define PORTA_BASE   0x40004000
+#define PORTC_BASE   0x40006000
+#define UART0_BASE   0x4000C000
+
+#define RCGC_UART       HWREG(SYSCTL_BASE | 0x0618)
+#define RCGCGPIO        HWREG(SYSCTL_BASE | 0x0608)
+#define GPIO_A_AFSEL    HWREG(PORTA_BASE |  0x0420)
+#define GPIO_A_PCTL     HWREG(PORTA_BASE |  0x052C)
+#define GPIO_A_DEN      HWREG(PORTA_BASE |  0x051C)
+#define GPIO_C_AFSEL    HWREG(PORTC_BASE |  0x0420)  
+#define GPIO_C_PCTL     HWREG(PORTC_BASE |  0x052C) 
+#define GPIO_C_DR8R     HWREG(PORTC_BASE |  0x0508)
+#define GPIO_C_SLR      HWREG(PORTC_BASE |  0x0518)
+#define GPIO_C_DEN      HWREG(PORTC_BASE |  0x051C)
+#define GPIO_C_DIR      HWREG(PORTC_BASE |  0x0400)
+
+#define UART1_DATA     HWREG(0x4000D000) 
+#define UART_CTL(N)    HWREG((UART0_BASE + (0x1000 * N)) | 0x0030)
+#define UART_FR(N)     HWREG((UART0_BASE + (0x1000 * N)) | 0x0018)
+#define UART_IBRD(N)   HWREG((UART0_BASE + (0x1000 * N)) | 0x0024)
+#define UART_FBRD(N)   HWREG((UART0_BASE + (0x1000 * N)) | 0x0028)
+#define UART_LCRH(N)   HWREG((UART0_BASE + (0x1000 * N)) | 0x002C)
+#define UART_CC(N)     HWREG((UART0_BASE + (0x1000 * N)) | 0x0FC8)
+#define UART_ICR(N)    HWREG((UART0_BASE + (0x1000 * N)) | 0x0044)
+#define UART_DR(N)     HWREG((UART0_BASE + (0x1000 * N)) | 0x0000)
+#define UART_IFLS(N)   HWREG((UART0_BASE + (0x1000 * N)) | 0x0034)
+#define UART_IM(N)     HWREG((UART0_BASE + (0x1000 * N)) | 0x0038)
+#define UART_MIS(N)    HWREG((UART0_BASE + (0x1000 * N)) | 0x0040)
+#define UART_DMACTL(N) HWREG((UART0_BASE + (0x1000 * N)) | 0x0048)
+#define NVIC_EN0       HWREG(0xE000E100)
+
+#define UART_ENABLE (0x01)
+#define UART_8BIT_CFG (0x60)
+#define UART_FIFO_EN (0x10)
+#define UART_RxFIFO_EMPTY_FLAG (0x10)
+#define UART_TxFIFO_FULL_FLAG  (0x20)
+#define UART_BUSY_FLAG         (0x08)
+#define UART_SYSCLK_HZ         (16000000u)
+#define UART_DEFAULT_BAUD      (38400u)
+#define UART_DR_OE    (0x01 << 11)    //Data register overrun flag, pg.906
+#define UART_RXIM     (0x01 << 4)     //Receive FIFO level interrupt, pg.924
+#define UART_RTIM     (0x01 << 6)     //Receive timeout interrupt
+#define UART_TXIM     (0x01 << 5)     //Transmit FIFO level interrupt
+#define UART_OEIM     (0x01 << 10)    //Overrun interrupt
+#define UART_IFLS_RX4_8 (0x02 << 3)   //RX interrupt at half full (8 bytes), pg.922
+#define UART_IFLS_TX1_8 (0x00)        //TX interrupt when down to 2 bytes
+#define UART0_INT     (0x01 << 5)     //5th Interupt Location
+#define UART1_INT     (0x01 << 6)     //6th Interupt Location
+#define UART_RXDMAE   (0x01)          //Receive DMA enable, pg.930
+#define UART0_RX_DMA_CH (8)           //uDMA channel 8, encoding 0
+#define UART1_RX_DMA_CH (22)          //uDMA channel 22, encoding 0
+
+#define UART_PORT_WIRED 0             //UART0, USB virtual COM port
+#define UART_PORT_BT    1             //UART1, Bluetooth module
+#define UART_NUM_PORTS  2
+
+#if !defined(UART_RX_USE_DMA)
+#define UART_RX_USE_DMA 1             //1: uDMA ping-pong reception, 0: FIFO interrupts
+#endif
+
+#define UART_RX_RING_SIZE 256         //must be a power of two, split in two halves for the uDMA
+#define UART_RX_RING_MASK (UART_RX_RING_SIZE - 1)
+
+#define UART_TX_SLOTS     4           //frames waiting behind the one being sent
+#define UART_TX_FRAME_MAX 64
+
+typedef enum UART_status
+/*! -- */
+{
+/*@{*/
+  UART_STATUS_OK,       //!<All is well
+  UART_STATUS_ERROR,    //!<Generic error condition
+  UART_STATUS_TxFULL,   //!<Buffer full
+  UART_STATUS_RxEMPTY,  //!<Buffer empty
+  UART_STATUS_UNKNOWN   //!<Default Status
+/*@}*/
+} UART_status_t;
+
+void UART_InitPort1( void );
+void UART_InitPort0( uint32_t baud );
+UART_status_t UART_ReadByte(uint8_t * data);
+UART_status_t UART_ReadPort( uint8_t port, uint8_t * data );
+uint8_t UART_Rx_available( void );
+uint32_t UART_RxOverruns( void );
+void UART_SetBaud( uint8_t port, uint32_t baud );
+void UART_SetBaudPort1( uint32_t baud );
+void UART_WriteBytes( const uint8_t * data, uint16_t length );
+void UART_FlushRx( void );
+uint8_t UART_QueueFrame( const uint8_t * data, uint8_t length );
+uint32_t UART_TxDropped( void );
+uint8_t UART_TxQueueFree( void );
+void UART1_Handler( void );
+void UART0_Handler( void );
 #endif
\ No newline at end of file
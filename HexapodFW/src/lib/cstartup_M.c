@@ -1,136 +1,148 @@
-/**************************************************
- *
- * This file contains an interrupt vector for Cortex-M written in C.
- * The actual interrupt functions must be provided by the application developer.
- *
- * Copyright 2007-2017 IAR Systems AB.
- *
- * $Revision: 112610 $
- *
- **************************************************/
-
-#pragma language=extended
-#pragma segment="CSTACK"
-
-extern void __iar_program_start( void );
-
-extern void NMI_Handler( void );
-extern void HardFault_Handler( void );
-extern void MemManage_Handler( void );
-extern void BusFault_Handler( void );
-extern void UsageFault_Handler( void );
-extern void SVC_Handler( void );
-extern void DebugMon_Handler( void );
-extern void PendSV_Handler( void );
-extern void SysTick_Handler( void );
-extern void ADC0_Handler( void );
-extern void TimerA_Handler( void );
-extern void PortF_Handler( void );
-
-typedef void( *intfunc )( void );
-typedef union { intfunc __fun; void * __ptr; } intvec_elem;
-
-// The vector table is normally located at address 0.
-// When debugging in RAM, it can be located in RAM, aligned to at least 2^6.
-// If you need to define interrupt service routines,
-// make a copy of this file and include it in your project.
-// The name "__vector_table" has special meaning for C-SPY, which
-// is where to find the SP start value.
-// If vector table is not located at address 0, the user has to initialize
-// the  NVIC vector table register (VTOR) before using interrupts.
-
-
-#pragma location = ".intvec"
-const intvec_elem __vector_table[] =
-{
-  { .__ptr = __sfe( "CSTACK" ) },
-  __iar_program_start,
-
-  NMI_Handler,
-  HardFault_Handler,
-  MemManage_Handler,
-  BusFault_Handler,
-  UsageFault_Handler,
-  0,
-  0,
-  0,
-  0,
-  SVC_Handler,
-  DebugMon_Handler,
-  0,
-  PendSV_Handler,
-  SysTick_Handler, //15th Vector Number, End Processor exceptions
-  
-  /* Add User Defined Handlers below */
-  0, //16
-  0, //17
-  0, //18
-  0, //19
-  0, //20
-  0, //21
-  0, //22
-  0, //23
-  0, //24
-  0, //25
-  0, //26
-  0, //27
-  0, //28
-  0, //29
-  0, //30
-  0, //31
-  0, //32
-  ADC0_Handler, //33
-  0, //34
-  TimerA_Handler, //35
-  0, //36
-  0, //37
-  0, //38
-  0, //39
-  0, //40
-  0, //41
-  0, //42
-  0, //43  
-  0, //44
-  0, //45
-  PortF_Handler, //46
-  0 //47  
-
-};
-
-#pragma call_graph_root = "interrupt"
-__weak void NMI_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void HardFault_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void MemManage_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void BusFault_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void UsageFault_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void SVC_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void DebugMon_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void PendSV_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void SysTick_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void TimerA_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void PortF_Handler( void ) { while (1) {} }
-#pragma call_graph_root = "interrupt"
-__weak void ADC0_Handler( void ) { while (1) {} }
-
-
-void __cmain( void );
-__weak void __iar_init_core( void );
-__weak void __iar_init_vfp( void );
-
-#pragma required=__vector_table
-void __iar_program_start( void )
-{
-  __iar_init_core();
-  __iar_init_vfp();
-  __cmain();
-}
+/**************************************************
+ *
+ * This file contains an interrupt vector for Cortex-M written in C.
+ * The actual interrupt functions must be provided by the application developer.
+ *
+ * Copyright 2007-2017 IAR Systems AB.
+ *
+ * $Revision: 112610 $
+ *
+ **************************************************/
+
+#pragma language=extended
+#pragma segment="CSTACK"
+
+extern void __iar_program_start( void );
+
+extern void NMI_Handler( void );
+extern void HardFault_Handler( void );
+extern void MemManage_Handler( void );
+extern void BusFault_Handler( void );
+extern void UsageFault_Handler( void );
+extern void SVC_Handler( void );
+extern void DebugMon_Handler( void );
+extern void PendSV_Handler( void );
+extern void SysTick_Handler( void );
+extern void ADC0_Handler( void );
+extern void UART0_Handler( void );
+extern void UART1_Handler( void );
+extern void ADC0Seq0_Handler( void );
+extern void TimerA_Handler( void );
+extern void Timer1A_Handler( void );
+extern void PortF_Handler( void );
+
+typedef void( *intfunc )( void );
+typedef union { intfunc __fun; void * __ptr; } intvec_elem;
+
+// The vector table is normally located at address 0.
+// When debugging in RAM, it can be located in RAM, aligned to at least 2^6.
+// If you need to define interrupt service routines,
+// make a copy of this file and include it in your project.
+// The name "__vector_table" has special meaning for C-SPY, which
+// is where to find the SP start value.
+// If vector table is not located at address 0, the user has to initialize
+// the  NVIC vector table register (VTOR) before using interrupts.
+
+
+#pragma location = ".intvec"
+const intvec_elem __vector_table[] =
+{
+  { .__ptr = __sfe( "CSTACK" ) },
+  __iar_program_start,
+
+  NMI_Handler,
+  HardFault_Handler,
+  MemManage_Handler,
+  BusFault_Handler,
+  UsageFault_Handler,
+  0,
+  0,
+  0,
+  0,
+  SVC_Handler,
+  DebugMon_Handler,
+  0,
+  PendSV_Handler,
+  SysTick_Handler, //15th Vector Number, End Processor exceptions
+  
+  /* Add User Defined Handlers below */
+  0, //16
+  0, //17
+  0, //18
+  0, //19
+  0, //20
+  UART0_Handler, //21
+  UART1_Handler, //22
+  0, //23
+  0, //24
+  0, //25
+  0, //26
+  0, //27
+  0, //28
+  0, //29
+  ADC0Seq0_Handler, //30
+  0, //31
+  0, //32
+  ADC0_Handler, //33
+  0, //34
+  TimerA_Handler, //35
+  0, //36
+  Timer1A_Handler, //37
+  0, //38
+  0, //39
+  0, //40
+  0, //41
+  0, //42
+  0, //43  
+  0, //44
+  0, //45
+  PortF_Handler, //46
+  0 //47  
+
+};
+
+#pragma call_graph_root = "interrupt"
+__weak void NMI_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void HardFault_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void MemManage_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void BusFault_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void UsageFault_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void SVC_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void DebugMon_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void PendSV_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void SysTick_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void TimerA_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void Timer1A_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void PortF_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void ADC0_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void UART0_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void UART1_Handler( void ) { while (1) {} }
+#pragma call_graph_root = "interrupt"
+__weak void ADC0Seq0_Handler( void ) { while (1) {} }
+
+
+void __cmain( void );
+__weak void __iar_init_core( void );
+__weak void __iar_init_vfp( void );
+
+#pragma required=__vector_table
+void __iar_program_start( void )
+{
+  __iar_init_core();
+  __iar_init_vfp();
+  __cmain();
+}
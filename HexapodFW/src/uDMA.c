@@ -0,0 +1,143 @@
+/*! \file  uDMA.c
+*
+* \brief
+* Minimal micro DMA controller driver for the TIVA TM4C123G
+*
+* \details
+*  Owns the channel control table and sets up basic and ping-pong peripheral
+*  transfers. Completion interrupts arrive on the interrupt vector of the
+*  peripheral that owns the channel, so the peripheral drivers re-arm their
+*  own halves from their ISRs.
+*
+* \author vsimontov
+*
+* \info
+* Based on TIVA User Reference manual, starting on pg.585
+*
+* For details on programming, refer to TM4C123G datasheet :
+* http://www.ti.com/lit/ds/spms376e/spms376e.pdf
+*
+******************************************************************************/
+
+#include <stdint.h>
+#include "uDMA.h"
+#include <tm4c123gh6pm.h>
+
+//primary structures for all channels followed by the alternate ones, must be 1KB aligned
+#if defined(__ICCARM__)
+#pragma data_alignment=1024
+static uDMAEntry_t controlTable[2 * UDMA_NUM_CHANNELS];
+#else
+static uDMAEntry_t controlTable[2 * UDMA_NUM_CHANNELS] __attribute__((aligned(1024)));
+#endif
+
+void uDMA_Init( void )
+/*!\brief   Clock and enable the uDMA controller
+\details Safe to call from every driver that uses DMA, only the first call
+         does any work
+\return none
+*/
+{
+  static uint8_t initialized = 0;
+  if (initialized) return;
+
+  SYSCTL_RCGCDMA_R |= 0x01;
+  while ((SYSCTL_PRDMA_R & 0x01) == 0);
+
+  UDMA_CFG_R = 0x01;                           //MASTEN
+  UDMA_CTLBASE_R = (uint32_t)controlTable;
+  initialized = 1;
+}
+
+void uDMA_AssignChannel( uint8_t channel, uint8_t encoding )
+/*!\brief   Select which peripheral drives a channel (table 9-1, pg.587)
+\param channel[in]: uDMA channel 0-31
+       encoding[in]: channel encoding 0-4
+\return none
+*/
+{
+  volatile uint32_t * map;
+  uint8_t shift = (channel & 0x07) * 4;
+
+  switch (channel >> 3) {
+    case 0:  map = &UDMA_CHMAP0_R; break;
+    case 1:  map = &UDMA_CHMAP1_R; break;
+    case 2:  map = &UDMA_CHMAP2_R; break;
+    default: map = &UDMA_CHMAP3_R; break;
+  }
+  *map = (*map & ~(0x0Fu << shift)) | ((uint32_t)(encoding & 0x0F) << shift);
+
+  UDMA_ALTCLR_R = (1u << channel);             //start on the primary structure
+  UDMA_USEBURSTCLR_R = (1u << channel);        //single and burst requests
+  UDMA_REQMASKCLR_R = (1u << channel);         //let the peripheral request
+  UDMA_PRIOCLR_R = (1u << channel);
+}
+
+static uint32_t uDMA_EndAddress( volatile void * start, uint32_t incBits, uint16_t count )
+{
+  uint32_t address = (uint32_t)start;
+  switch (incBits) {
+    case 0: return address + (count - 1);          //8-bit
+    case 1: return address + ((count - 1) << 1);   //16-bit
+    case 2: return address + ((count - 1) << 2);   //32-bit
+    default: return address;                       //no increment
+  }
+}
+
+void uDMA_SetTransfer( uint8_t channel, uint8_t alt, volatile void * src, volatile void * dst,
+                       uint32_t control, uint16_t count )
+/*!\brief   Fill one control structure of a channel
+\param channel[in]: uDMA channel 0-31
+       alt[in]: UDMA_PRIMARY or UDMA_ALTERNATE
+       src[in]: first source address
+       dst[in]: first destination address
+       control[in]: UDMA_* increment, size, arbitration and mode bits
+       count[in]: items to transfer, 1 to UDMA_MAX_XFER
+\return none
+*/
+{
+  uDMAEntry_t * entry = &controlTable[(alt ? UDMA_NUM_CHANNELS : 0) + channel];
+
+  entry->srcEnd = uDMA_EndAddress(src, (control >> 26) & 0x03, count);
+  entry->dstEnd = uDMA_EndAddress(dst, (control >> 30) & 0x03, count);
+  entry->control = (control & ~UDMA_XFERSIZE_M) | (((uint32_t)(count - 1) << UDMA_XFERSIZE_S) & UDMA_XFERSIZE_M);
+}
+
+void uDMA_EnableChannel( uint8_t channel )
+/*!\brief   Start servicing requests on a channel
+\return none
+*/
+{
+  UDMA_ENASET_R = (1u << channel);
+}
+
+void uDMA_DisableChannel( uint8_t channel )
+/*!\brief   Stop servicing requests on a channel
+\return none
+*/
+{
+  UDMA_ENACLR_R = (1u << channel);
+}
+
+uint8_t uDMA_TransferDone( uint8_t channel, uint8_t alt )
+/*!\brief   Check whether a control structure has run to completion
+\details The controller sets the mode field to stop once the last item of a
+         structure has been moved
+\return 1 if done, 0 if still armed
+*/
+{
+  uDMAEntry_t * entry = &controlTable[(alt ? UDMA_NUM_CHANNELS : 0) + channel];
+  return ((entry->control & UDMA_MODE_M) == UDMA_MODE_STOP) ? 1 : 0;
+}
+
+uint16_t uDMA_Remaining( uint8_t channel, uint8_t alt )
+/*!\brief   Items left to move in a control structure
+\return remaining item count, 0 once the structure is done
+*/
+{
+  uDMAEntry_t * entry = &controlTable[(alt ? UDMA_NUM_CHANNELS : 0) + channel];
+  uint32_t control = entry->control;
+
+  if ((control & UDMA_MODE_M) == UDMA_MODE_STOP) return 0;
+  return (uint16_t)(((control & UDMA_XFERSIZE_M) >> UDMA_XFERSIZE_S) + 1);
+}
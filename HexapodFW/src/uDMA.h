@@ -0,0 +1,53 @@
+#if !defined(UDMA_H)
+#define UDMA_H
+
+#include <stdint.h>
+
+#define UDMA_NUM_CHANNELS  (32)
+#define UDMA_PRIMARY       (0)
+#define UDMA_ALTERNATE     (1)
+
+ // Channel control word fields, pg.616
+ #define UDMA_DST_INC_8    (0x0u << 30)
+ #define UDMA_DST_INC_16   (0x1u << 30)
+ #define UDMA_DST_INC_32   (0x2u << 30)
+ #define UDMA_DST_INC_NONE (0x3u << 30)
+ #define UDMA_DST_SIZE_8   (0x0u << 28)
+ #define UDMA_DST_SIZE_16  (0x1u << 28)
+ #define UDMA_DST_SIZE_32  (0x2u << 28)
+ #define UDMA_SRC_INC_8    (0x0u << 26)
+ #define UDMA_SRC_INC_16   (0x1u << 26)
+ #define UDMA_SRC_INC_32   (0x2u << 26)
+ #define UDMA_SRC_INC_NONE (0x3u << 26)
+ #define UDMA_SRC_SIZE_8   (0x0u << 24)
+ #define UDMA_SRC_SIZE_16  (0x1u << 24)
+ #define UDMA_SRC_SIZE_32  (0x2u << 24)
+ #define UDMA_ARB_1        (0x0u << 14)
+ #define UDMA_ARB_4        (0x2u << 14)
+ #define UDMA_ARB_8        (0x3u << 14)
+ #define UDMA_XFERSIZE_M   (0x3FFu << 4)
+ #define UDMA_XFERSIZE_S   (4)
+ #define UDMA_MODE_M       (0x07u)
+ #define UDMA_MODE_STOP    (0x00u)
+ #define UDMA_MODE_BASIC   (0x01u)
+ #define UDMA_MODE_PINGPONG (0x03u)
+ #define UDMA_MAX_XFER     (1024)
+
+typedef struct uDMAEntry
+{
+  volatile uint32_t srcEnd;    //!<Address of the last source item
+  volatile uint32_t dstEnd;    //!<Address of the last destination item
+  volatile uint32_t control;   //!<Channel control word
+  uint32_t spare;
+} uDMAEntry_t;
+
+void uDMA_Init( void );
+void uDMA_AssignChannel( uint8_t channel, uint8_t encoding );
+void uDMA_SetTransfer( uint8_t channel, uint8_t alt, volatile void * src, volatile void * dst,
+                       uint32_t control, uint16_t count );
+void uDMA_EnableChannel( uint8_t channel );
+void uDMA_DisableChannel( uint8_t channel );
+uint8_t uDMA_TransferDone( uint8_t channel, uint8_t alt );
+uint16_t uDMA_Remaining( uint8_t channel, uint8_t alt );
+
+#endif